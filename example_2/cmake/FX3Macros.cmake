@@ -25,6 +25,8 @@ macro(fx3_show_config)
     message(STATUS "  Werror: ${ENABLE_WERROR}")
     message(STATUS "  Build demo_c: ${BUILD_DEMO_C}")
     message(STATUS "  Build demo_cpp: ${BUILD_DEMO_CPP}")
+    message(STATUS "  Generated memory map: ${FX3_GENERATE_MEMORY_MAP}")
+    message(STATUS "  C++ new/delete: ${FX3_CXX_NEW}")
 
     if(CMAKE_OBJCOPY)
         message(STATUS "  OBJCOPY: ${CMAKE_OBJCOPY}")
@@ -158,56 +158,200 @@ set(FX3_STDC_LIBS
 set(FX3_STDCXX_LIBS
         stdc++)
 
+# -----------------------------------------------------------------------------
+# Memory map generation
+# -----------------------------------------------------------------------------
+# Directory holding the linker script and cyfxtx_memmap.h templates
+set(FX3_CMAKE_DIR "${CMAKE_CURRENT_LIST_DIR}")
+
+# Generates the linker script and the cyfxtx_memmap.h header for a target into
+# <binary dir>/<target>_memmap, and returns that directory in out_dir_var.
+# The code, data, (C++ only) exception and runtime heap, and driver heap regions follow
+# each other from the end of the descriptor area; the buffer heap takes up the rest of
+# the RAM up to SYS_MEM_TOP. Sizes left empty take the values of the SDK memory maps.
+function(fx3_generate_memory_map target_name enable_cxx out_dir_var)
+    set(_names CODE_SIZE DATA_SIZE EXCEPTION_SIZE RUNTIME_HEAP_SIZE MEM_HEAP_SIZE SYS_MEM_TOP)
+    cmake_parse_arguments(MM "" "${_names}" "" ${ARGN})
+
+    if(enable_cxx)
+        set(_defaults 0x40000 0x5000 0x8000 0x8000 0x8000 0x40080000)
+        set(_default_buf_size 0x20000)
+        set(_template "${FX3_CMAKE_DIR}/fx3cpp.ld.in")
+        set(_script fx3cpp.ld)
+    else()
+        if(MM_EXCEPTION_SIZE OR MM_RUNTIME_HEAP_SIZE)
+            message(FATAL_ERROR "fx3_add_firmware(): EXCEPTION_SIZE and RUNTIME_HEAP_SIZE require ENABLE_CXX")
+        endif()
+        set(_defaults 0x2D000 0x8000 0 0 0x8000 0x40078000)
+        set(_default_buf_size 0x38000)
+        set(_template "${FX3_CMAKE_DIR}/fx3.ld.in")
+        set(_script fx3.ld)
+    endif()
+
+    # Apply the defaults and check that all regions keep the buffer heap cache line aligned
+    set(_idx 0)
+    foreach(_name IN LISTS _names)
+        if(NOT MM_${_name})
+            list(GET _defaults ${_idx} MM_${_name})
+        endif()
+        math(EXPR MM_${_name} "${MM_${_name}}")
+        math(EXPR _rem "${MM_${_name}} % 32")
+        if(NOT _rem EQUAL 0)
+            message(FATAL_ERROR "fx3_add_firmware(): ${_name} must be a multiple of 32 bytes")
+        endif()
+        math(EXPR _idx "${_idx} + 1")
+    endforeach()
+
+    # Region layout
+    math(EXPR _code_base "0x40003000")
+    math(EXPR _data_base "${_code_base} + ${MM_CODE_SIZE}")
+    math(EXPR _exc_base "${_data_base} + ${MM_DATA_SIZE}")
+    math(EXPR _rt_heap_base "${_exc_base} + ${MM_EXCEPTION_SIZE}")
+    math(EXPR _mem_heap_base "${_rt_heap_base} + ${MM_RUNTIME_HEAP_SIZE}")
+    math(EXPR _buf_base "${_mem_heap_base} + ${MM_MEM_HEAP_SIZE}")
+    math(EXPR _buf_size "${MM_SYS_MEM_TOP} - ${_buf_base}")
+    math(EXPR _ram_top "0x40080000")
+    if(MM_SYS_MEM_TOP GREATER _ram_top)
+        message(FATAL_ERROR "fx3_add_firmware(): SYS_MEM_TOP is beyond the end of the 512 KB System RAM")
+    endif()
+    if(_buf_size LESS 4096)
+        message(FATAL_ERROR "fx3_add_firmware(): the memory regions of ${target_name} leave no space for the buffer heap")
+    endif()
+    math(EXPR _reserved_size "${_ram_top} - ${MM_SYS_MEM_TOP}")
+
+    # Template variables
+    set(FX3_MM_TARGET "${target_name}")
+    foreach(_pair
+            CODE_BASE:_code_base CODE_SIZE:MM_CODE_SIZE
+            DATA_BASE:_data_base DATA_SIZE:MM_DATA_SIZE
+            EXCEPTION_BASE:_exc_base EXCEPTION_SIZE:MM_EXCEPTION_SIZE
+            RUNTIME_HEAP_BASE:_rt_heap_base RUNTIME_HEAP_SIZE:MM_RUNTIME_HEAP_SIZE
+            MEM_HEAP_BASE:_mem_heap_base MEM_HEAP_SIZE:MM_MEM_HEAP_SIZE
+            BUFFER_HEAP_BASE:_buf_base BUFFER_HEAP_SIZE:_buf_size
+            SYS_MEM_TOP:MM_SYS_MEM_TOP RESERVED_SIZE:_reserved_size)
+        string(REPLACE ":" ";" _pair "${_pair}")
+        list(GET _pair 0 _key)
+        list(GET _pair 1 _var)
+        math(EXPR FX3_MM_${_key} "${${_var}}" OUTPUT_FORMAT HEXADECIMAL)
+    endforeach()
+
+    set(_out_dir "${CMAKE_CURRENT_BINARY_DIR}/${target_name}_memmap")
+    configure_file("${_template}" "${_out_dir}/${_script}" @ONLY)
+    configure_file("${FX3_CMAKE_DIR}/cyfxtx_memmap.h.in" "${_out_dir}/cyfxtx_memmap.h" @ONLY)
+
+    # Report the change in buffer heap space against the default memory map
+    math(EXPR _buf_kb "${_buf_size} / 1024")
+    math(EXPR _gain_kb "(${_buf_size} - ${_default_buf_size}) / 1024")
+    if(_gain_kb GREATER_EQUAL 0)
+        set(_gain_kb "+${_gain_kb}")
+    endif()
+    message(STATUS "[FX3] Buffer heap: ${FX3_MM_BUFFER_HEAP_BASE}, ${_buf_kb} KB (${_gain_kb} KB against the default map)")
+
+    set(${out_dir_var} "${_out_dir}" PARENT_SCOPE)
+endfunction()
+
 # -----------------------------------------------------------------------------
 # Default source collection
 # -----------------------------------------------------------------------------
+# The heap manager (cyfxtx) sources are taken from FX3_TX_SOURCE_DIR if it is set,
+# and from the SDK otherwise.
 function(fx3_get_default_sources out_var enable_cxx)
     set(_startup "${FX3_FIRMWARE_COMMON_ROOT}/cyfx_gcc_startup.S")
+    if(FX3_TX_SOURCE_DIR)
+        set(_tx_root "${FX3_TX_SOURCE_DIR}")
+    else()
+        set(_tx_root "${FX3_FIRMWARE_COMMON_ROOT}")
+    endif()
     if(enable_cxx)
         set(_core
-                ${FX3_FIRMWARE_COMMON_ROOT}/cyfxtx.cpp
+                ${_tx_root}/cyfxtx.cpp
                 ${FX3_FIRMWARE_COMMON_ROOT}/cyfxcppsyscall.cpp)
     else()
-        set(_core ${FX3_FIRMWARE_COMMON_ROOT}/cyfxtx.c)
+        set(_core ${_tx_root}/cyfxtx.c)
     endif()
     set(${out_var} ${_startup} ${_core} PARENT_SCOPE)
 endfunction()
 function(fx3_add_firmware target_name)
     # Parameter definition
-    set(_opts ENABLE_CXX ENABLE_STDC NO_STDCXX MAP_FILE LTO KEEP_VECTORLOAD)
-    set(_singles LINKER_SCRIPT OUTPUT_DIRECTORY OUTPUT_IMG I2C_CONF)
+    set(_opts ENABLE_CXX ENABLE_STDC NO_STDCXX MAP_FILE LTO KEEP_VECTORLOAD MEMORY_MAP)
+    set(_mm_singles CODE_SIZE DATA_SIZE EXCEPTION_SIZE RUNTIME_HEAP_SIZE MEM_HEAP_SIZE SYS_MEM_TOP)
+    set(_singles LINKER_SCRIPT OUTPUT_DIRECTORY OUTPUT_IMG I2C_CONF CXX_NEW ${_mm_singles})
     set(_multis SOURCES INCLUDE_DIRS DEFINES LIB_DIRS LIBS COMPILE_OPTIONS LINK_OPTIONS)
 
-    # Parameter parsing and validation
-    cmake_parse_arguments(FX3 "${_opts}" "${_singles}" "${_multis}" ${ARGN})
-    if(FX3_UNPARSED_ARGUMENTS)
-        message(FATAL_ERROR "fx3_add_firmware(): Unknown args: ${FX3_UNPARSED_ARGUMENTS}")
+    # Parameter parsing and validation. The FW_ prefix keeps the parsed keywords apart from the FX3_*
+    # cache variables of the project: a keyword that is not passed leaves its variable undefined, and
+    # an FX3_CXX_NEW or FX3_CODE_SIZE cache entry would otherwise be read in its place.
+    cmake_parse_arguments(FW "${_opts}" "${_singles}" "${_multis}" ${ARGN})
+    if(FW_UNPARSED_ARGUMENTS)
+        message(FATAL_ERROR "fx3_add_firmware(): Unknown args: ${FW_UNPARSED_ARGUMENTS}")
     endif()
-    if(NOT FX3_SOURCES)
+    if(NOT FW_SOURCES)
         message(FATAL_ERROR "fx3_add_firmware(): please provide at least one source via SOURCES")
     endif()
 
+    # C++ operator new/delete backend: NEWLIB (libstdc++ and newlib malloc), MEMALLOC (CyU3PMemAlloc)
+    # or POOL (fixed block pool for small objects, CyU3PMemAlloc for the rest)
+    if(NOT FW_CXX_NEW)
+        set(FW_CXX_NEW NEWLIB)
+    endif()
+    string(TOUPPER "${FW_CXX_NEW}" FW_CXX_NEW)
+    if(NOT FW_CXX_NEW MATCHES "^(NEWLIB|MEMALLOC|POOL)$")
+        message(FATAL_ERROR "fx3_add_firmware(): CXX_NEW must be NEWLIB, MEMALLOC or POOL, got ${FW_CXX_NEW}")
+    endif()
+    if(NOT FW_CXX_NEW STREQUAL "NEWLIB")
+        if(NOT FW_ENABLE_CXX)
+            message(FATAL_ERROR "fx3_add_firmware(): CXX_NEW requires ENABLE_CXX")
+        endif()
+        if(NOT FX3_TX_SOURCE_DIR OR NOT EXISTS "${FX3_TX_SOURCE_DIR}/cyfxcppnew.cpp")
+            message(FATAL_ERROR "fx3_add_firmware(): CXX_NEW ${FW_CXX_NEW} requires cyfxcppnew.cpp in FX3_TX_SOURCE_DIR")
+        endif()
+    endif()
+
     # Unified selection and validation of linker script
-    if(NOT FX3_LINKER_SCRIPT)
-        if(FX3_ENABLE_CXX)
-            set(FX3_LINKER_SCRIPT "${FX3_FIRMWARE_COMMON_ROOT}/fx3cpp.ld")
+    if(FW_MEMORY_MAP)
+        if(FW_LINKER_SCRIPT)
+            message(FATAL_ERROR "fx3_add_firmware(): LINKER_SCRIPT cannot be combined with MEMORY_MAP")
+        endif()
+        set(_mm_args)
+        foreach(_name IN LISTS _mm_singles)
+            list(APPEND _mm_args ${_name} "${FW_${_name}}")
+        endforeach()
+        fx3_generate_memory_map(${target_name} "${FW_ENABLE_CXX}" _memmap_dir ${_mm_args})
+        if(FW_ENABLE_CXX)
+            set(FW_LINKER_SCRIPT "${_memmap_dir}/fx3cpp.ld")
+        else()
+            set(FW_LINKER_SCRIPT "${_memmap_dir}/fx3.ld")
+        endif()
+    else()
+        foreach(_name IN LISTS _mm_singles)
+            if(FW_${_name})
+                message(FATAL_ERROR "fx3_add_firmware(): ${_name} requires MEMORY_MAP")
+            endif()
+        endforeach()
+    endif()
+    if(NOT FW_LINKER_SCRIPT)
+        if(FW_ENABLE_CXX)
+            set(FW_LINKER_SCRIPT "${FX3_FIRMWARE_COMMON_ROOT}/fx3cpp.ld")
         else()
-            set(FX3_LINKER_SCRIPT "${FX3_FIRMWARE_COMMON_ROOT}/fx3.ld")
+            set(FW_LINKER_SCRIPT "${FX3_FIRMWARE_COMMON_ROOT}/fx3.ld")
         endif()
     endif()
-    if(NOT EXISTS "${FX3_LINKER_SCRIPT}")
-        message(FATAL_ERROR "Linker script not found: ${FX3_LINKER_SCRIPT}")
+    if(NOT EXISTS "${FW_LINKER_SCRIPT}")
+        message(FATAL_ERROR "Linker script not found: ${FW_LINKER_SCRIPT}")
     endif()
 
     # Get default sources
-    fx3_get_default_sources(_core_src ${FX3_ENABLE_CXX})
+    fx3_get_default_sources(_core_src ${FW_ENABLE_CXX})
+    if(NOT FW_CXX_NEW STREQUAL "NEWLIB")
+        list(APPEND _core_src "${FX3_TX_SOURCE_DIR}/cyfxcppnew.cpp")
+    endif()
 
     # Create target
-    add_executable(${target_name} ${FX3_SOURCES} ${_core_src})
+    add_executable(${target_name} ${FW_SOURCES} ${_core_src})
     set_target_properties(${target_name} PROPERTIES OUTPUT_NAME "${target_name}.elf")
-    if(FX3_OUTPUT_DIRECTORY)
+    if(FW_OUTPUT_DIRECTORY)
         set_target_properties(${target_name} PROPERTIES
-                RUNTIME_OUTPUT_DIRECTORY "${FX3_OUTPUT_DIRECTORY}")
+                RUNTIME_OUTPUT_DIRECTORY "${FW_OUTPUT_DIRECTORY}")
     endif()
 
     # Compilation and link options collection
@@ -215,21 +359,21 @@ function(fx3_add_firmware target_name)
     set(_link_opts)
 
     # LTO support
-    if(FX3_LTO)
+    if(FW_LTO)
         list(APPEND _compile_opts -flto)
         list(APPEND _link_opts -flto)
     endif()
 
     # User-defined options
-    if(FX3_COMPILE_OPTIONS)
-        list(APPEND _compile_opts ${FX3_COMPILE_OPTIONS})
+    if(FW_COMPILE_OPTIONS)
+        list(APPEND _compile_opts ${FW_COMPILE_OPTIONS})
     endif()
-    if(FX3_LINK_OPTIONS)
-        list(APPEND _link_opts ${FX3_LINK_OPTIONS})
+    if(FW_LINK_OPTIONS)
+        list(APPEND _link_opts ${FW_LINK_OPTIONS})
     endif()
 
     # MAP file generation
-    if(FX3_MAP_FILE)
+    if(FW_MAP_FILE)
         list(APPEND _link_opts "LINKER:-Map=${target_name}.map")
     endif()
 
@@ -239,7 +383,7 @@ function(fx3_add_firmware target_name)
     endif()
 
     target_link_options(${target_name} PRIVATE
-            "LINKER:--script=${FX3_LINKER_SCRIPT}"
+            "LINKER:--script=${FW_LINKER_SCRIPT}"
             "LINKER:--gc-sections"
             "LINKER:--no-wchar-size-warning"
             "LINKER:--entry=CyU3PFirmwareEntry"
@@ -249,7 +393,7 @@ function(fx3_add_firmware target_name)
 
     # Libraries, headers and macro definitions
     # Choose SDK library version
-    if(FX3_ENABLE_CXX)
+    if(FW_ENABLE_CXX)
         target_link_libraries(${target_name} PRIVATE fx3_sdk_cpp)
         set(_sdk_name "fx3_sdk_cpp")
     else()
@@ -258,19 +402,36 @@ function(fx3_add_firmware target_name)
     endif()
 
     # User additional libraries
-    if(FX3_LIBS)
-        target_link_libraries(${target_name} PRIVATE ${FX3_LIBS})
+    if(FW_LIBS)
+        target_link_libraries(${target_name} PRIVATE ${FW_LIBS})
+    endif()
+
+    # Heap manager header (cyfxtx.h)
+    if(FX3_TX_SOURCE_DIR)
+        target_include_directories(${target_name} PRIVATE ${FX3_TX_SOURCE_DIR})
+    endif()
+
+    # Generated memory map header (cyfxtx_memmap.h)
+    if(FW_MEMORY_MAP)
+        target_include_directories(${target_name} PRIVATE ${_memmap_dir})
+        target_compile_definitions(${target_name} PRIVATE CYFXTX_USE_MEMMAP=1)
+        set_target_properties(${target_name} PROPERTIES LINK_DEPENDS "${FW_LINKER_SCRIPT}")
+    endif()
+
+    # Fixed block pool for operator new
+    if(FW_CXX_NEW STREQUAL "POOL")
+        target_compile_definitions(${target_name} PRIVATE CYFXCPP_NEW_USE_POOL=1)
     endif()
 
     # User additional configuration
-    if(FX3_INCLUDE_DIRS)
-        target_include_directories(${target_name} PRIVATE ${FX3_INCLUDE_DIRS})
+    if(FW_INCLUDE_DIRS)
+        target_include_directories(${target_name} PRIVATE ${FW_INCLUDE_DIRS})
     endif()
-    if(FX3_DEFINES)
-        target_compile_definitions(${target_name} PRIVATE ${FX3_DEFINES})
+    if(FW_DEFINES)
+        target_compile_definitions(${target_name} PRIVATE ${FW_DEFINES})
     endif()
-    if(FX3_LIB_DIRS)
-        target_link_directories(${target_name} PRIVATE ${FX3_LIB_DIRS})
+    if(FW_LIB_DIRS)
+        target_link_directories(${target_name} PRIVATE ${FW_LIB_DIRS})
     endif()
 
     # Size statistics
@@ -281,19 +442,19 @@ function(fx3_add_firmware target_name)
     # Convert to .img file
     if(ELF2IMG_TOOL)
         # Determine output path
-        if(FX3_OUTPUT_IMG)
-            set(_img_output "${FX3_OUTPUT_IMG}")
+        if(FW_OUTPUT_IMG)
+            set(_img_output "${FW_OUTPUT_IMG}")
         else()
             set(_img_output "${target_name}.img")
         endif()
 
         # Build elf2img command arguments
         set(_elf2img_args -i $<TARGET_FILE:${target_name}> -o ${_img_output})
-        if(FX3_KEEP_VECTORLOAD)
+        if(FW_KEEP_VECTORLOAD)
             list(APPEND _elf2img_args -vectorload yes)
         endif()
-        if(FX3_I2C_CONF)
-            list(APPEND _elf2img_args -i2cconf "${FX3_I2C_CONF}")
+        if(FW_I2C_CONF)
+            list(APPEND _elf2img_args -i2cconf "${FW_I2C_CONF}")
         endif()
 
         add_custom_command(TARGET ${target_name} POST_BUILD
@@ -304,12 +465,19 @@ function(fx3_add_firmware target_name)
 
     # Unified status printing
     message(STATUS "[FX3] Target: ${target_name}")
-    message(STATUS "[FX3] Linker: ${FX3_LINKER_SCRIPT}")
-    message(STATUS "[FX3] C++: ${FX3_ENABLE_CXX}")
-    message(STATUS "[FX3] STD C: ${FX3_ENABLE_STDC}")
-    message(STATUS "[FX3] LTO: ${FX3_LTO}")
-    message(STATUS "[FX3] Map: ${FX3_MAP_FILE}")
+    message(STATUS "[FX3] Linker: ${FW_LINKER_SCRIPT}")
+    message(STATUS "[FX3] Memory map: ${FW_MEMORY_MAP}")
+    message(STATUS "[FX3] C++: ${FW_ENABLE_CXX}")
+    if(FW_ENABLE_CXX)
+        message(STATUS "[FX3] C++ new: ${FW_CXX_NEW}")
+    endif()
+    message(STATUS "[FX3] STD C: ${FW_ENABLE_STDC}")
+    message(STATUS "[FX3] LTO: ${FW_LTO}")
+    message(STATUS "[FX3] Map: ${FW_MAP_FILE}")
     message(STATUS "[FX3] SDK: ${_sdk_name}")
+    if(FX3_TX_SOURCE_DIR)
+        message(STATUS "[FX3] Heap: ${FX3_TX_SOURCE_DIR}")
+    endif()
 endfunction()
 
 # -----------------------------------------------------------------------------
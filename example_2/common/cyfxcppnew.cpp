@@ -0,0 +1,412 @@
+/*
+ ## Cypress USB 3.0 Platform source file (cyfxcppnew.cpp)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+/*
+ * This file replaces the global C++ operator new and operator delete functions from libstdc++.
+ * The default implementations go through the newlib malloc and the _sbrk stub in cyfxcppsyscall.cpp,
+ * which pull the newlib allocator into the image and have no locking against the other threads.
+ *
+ * By default, all allocations are made from the driver heap using CyU3PMemAlloc. If the
+ * CYFXCPP_NEW_USE_POOL definition is enabled, small objects are served from a fixed block pool
+ * instead, and only the larger requests go to CyU3PMemAlloc.
+ *
+ * The throwing versions of operator new must not return NULL, and the compiler is free to skip the
+ * NULL check on their result. As std::bad_alloc is not thrown by this firmware, these versions stop
+ * in the undefined instruction handler (CyU3PUndefinedHandler in cyfxtx) when the memory cannot be
+ * allocated. Code that can handle the failure should use the nothrow versions, which return NULL.
+ */
+
+#include <stddef.h>
+#include <cyu3types.h>
+#include <cyu3os.h>
+#include <new>
+
+/* #define CYFXCPP_NEW_USE_POOL */
+
+#ifdef CYFXCPP_NEW_USE_POOL
+
+/* Size of each block in the fixed block pool. Must be a multiple of 8 bytes. */
+#ifndef CYFXCPP_NEW_POOL_BLOCK_SIZE
+#define CYFXCPP_NEW_POOL_BLOCK_SIZE     (64)
+#endif
+
+/* Number of blocks in the fixed block pool. */
+#ifndef CYFXCPP_NEW_POOL_BLOCKS
+#define CYFXCPP_NEW_POOL_BLOCKS         (32)
+#endif
+
+#if ((CYFXCPP_NEW_POOL_BLOCK_SIZE % 8) != 0)
+#error "CYFXCPP_NEW_POOL_BLOCK_SIZE must be a multiple of 8"
+#endif
+
+/* Storage for the fixed block pool. Blocks which have never been used are taken in address order
+   using glCppPoolNext, and freed blocks are kept on a singly linked list. This avoids having to
+   initialize the pool before the first allocation, which can happen from a static constructor. */
+static uint64_t glCppPool[CYFXCPP_NEW_POOL_BLOCKS * CYFXCPP_NEW_POOL_BLOCK_SIZE / 8];
+static uint32_t glCppPoolNext = 0;
+static void    *glCppPoolFreeList = 0;
+
+/* Function    : CyFxCppNewIrqLock
+ * Description : Disable the IRQ and FIQ interrupts and return the previous CPSR value.
+ *               The pool is only locked for a few instructions, and objects may be deleted
+ *               from callbacks running in interrupt context.
+ */
+static inline uint32_t
+CyFxCppNewIrqLock (
+        void)
+{
+#if defined (__arm__)
+    uint32_t cpsr, tmp;
+
+    __asm__ __volatile__ (
+            "mrs %0, cpsr\n\t"
+            "orr %1, %0, #0xC0\n\t"
+            "msr cpsr_c, %1"
+            : "=r" (cpsr), "=r" (tmp) : : "memory");
+    return cpsr;
+#else
+    /* Host builds of the allocation benchmark have no interrupts to lock out. */
+    return 0;
+#endif
+}
+
+/* Function    : CyFxCppNewIrqUnlock
+ * Description : Restore the interrupt state saved by CyFxCppNewIrqLock.
+ */
+static inline void
+CyFxCppNewIrqUnlock (
+        uint32_t cpsr)
+{
+#if defined (__arm__)
+    __asm__ __volatile__ ("msr cpsr_c, %0" : : "r" (cpsr) : "memory");
+#else
+    (void) cpsr;
+#endif
+}
+
+#endif /* CYFXCPP_NEW_USE_POOL */
+
+/* Function    : CyFxCppNewAlloc
+ * Description : Common allocation function for all of the operator new variants.
+ * Parameters  :
+ *               size : Size of the object in bytes.
+ * Return Value: Pointer to the allocated memory, or NULL on failure.
+ */
+static void *
+CyFxCppNewAlloc (
+        size_t size)
+{
+#ifdef CYFXCPP_NEW_USE_POOL
+    void     *ptr = 0;
+    uint32_t  intMask;
+
+    if (size <= CYFXCPP_NEW_POOL_BLOCK_SIZE)
+    {
+        intMask = CyFxCppNewIrqLock ();
+        if (glCppPoolFreeList != 0)
+        {
+            ptr = glCppPoolFreeList;
+            glCppPoolFreeList = *((void **)ptr);
+        }
+        else if (glCppPoolNext < CYFXCPP_NEW_POOL_BLOCKS)
+        {
+            ptr = (uint8_t *)glCppPool + (glCppPoolNext * CYFXCPP_NEW_POOL_BLOCK_SIZE);
+            glCppPoolNext++;
+        }
+        CyFxCppNewIrqUnlock (intMask);
+
+        if (ptr != 0)
+        {
+            return ptr;
+        }
+    }
+#endif
+
+    /* Zero sized objects still need a unique address. */
+    return CyU3PMemAlloc ((size != 0) ? size : 1);
+}
+
+/* Function    : CyFxCppNewFree
+ * Description : Common free function for all of the operator delete variants.
+ * Parameters  :
+ *               ptr : Pointer returned by CyFxCppNewAlloc. Can be NULL.
+ * Return Value: None
+ */
+static void
+CyFxCppNewFree (
+        void *ptr)
+{
+    if (ptr == 0)
+    {
+        return;
+    }
+
+#ifdef CYFXCPP_NEW_USE_POOL
+    if (((uint8_t *)ptr >= (uint8_t *)glCppPool) && ((uint8_t *)ptr < (uint8_t *)glCppPool + sizeof (glCppPool)))
+    {
+        uint32_t intMask = CyFxCppNewIrqLock ();
+        *((void **)ptr)   = glCppPoolFreeList;
+        glCppPoolFreeList = ptr;
+        CyFxCppNewIrqUnlock (intMask);
+        return;
+    }
+#endif
+
+    CyU3PMemFree (ptr);
+}
+
+/* Function    : CyFxCppNewCheck
+ * Description : Check the result of a throwing operator new, and trap if the allocation failed.
+ * Parameters  :
+ *               ptr : Pointer returned by the allocation function.
+ * Return Value: ptr, which is never NULL.
+ */
+static inline void *
+CyFxCppNewCheck (
+        void *ptr)
+{
+    if (ptr == 0)
+    {
+        __builtin_trap ();
+    }
+
+    return ptr;
+}
+
+void *
+operator new (
+        size_t size)
+{
+    return CyFxCppNewCheck (CyFxCppNewAlloc (size));
+}
+
+void *
+operator new[] (
+        size_t size)
+{
+    return CyFxCppNewCheck (CyFxCppNewAlloc (size));
+}
+
+void *
+operator new (
+        size_t size,
+        const std::nothrow_t &)
+{
+    return CyFxCppNewAlloc (size);
+}
+
+void *
+operator new[] (
+        size_t size,
+        const std::nothrow_t &)
+{
+    return CyFxCppNewAlloc (size);
+}
+
+void
+operator delete (
+        void *ptr)
+{
+    CyFxCppNewFree (ptr);
+}
+
+void
+operator delete[] (
+        void *ptr)
+{
+    CyFxCppNewFree (ptr);
+}
+
+void
+operator delete (
+        void *ptr,
+        const std::nothrow_t &)
+{
+    CyFxCppNewFree (ptr);
+}
+
+void
+operator delete[] (
+        void *ptr,
+        const std::nothrow_t &)
+{
+    CyFxCppNewFree (ptr);
+}
+
+/* Sized deallocation (C++14). The size is not needed, as both the pool and the driver heap can
+   find the block from the pointer alone. These are also provided for C++11 builds, as libraries
+   compiled with a later standard may refer to them. */
+void
+operator delete (
+        void *ptr,
+        size_t)
+{
+    CyFxCppNewFree (ptr);
+}
+
+void
+operator delete[] (
+        void *ptr,
+        size_t)
+{
+    CyFxCppNewFree (ptr);
+}
+
+#ifdef __cpp_aligned_new
+
+/* Function    : CyFxCppNewAlignedAlloc
+ * Description : Allocation function for over-aligned objects (C++17). The object is placed at
+ *               the first suitably aligned address in a larger block, and the address of the
+ *               block is saved in the word just before the object.
+ * Parameters  :
+ *               size  : Size of the object in bytes.
+ *               align : Required alignment in bytes. Must be a power of two.
+ * Return Value: Pointer to the aligned object, or NULL on failure.
+ */
+static void *
+CyFxCppNewAlignedAlloc (
+        size_t size,
+        size_t align)
+{
+    uint8_t  *blk_p;
+    uint32_t  addr;
+
+    if (align < sizeof (void *))
+    {
+        align = sizeof (void *);
+    }
+
+    blk_p = (uint8_t *)CyU3PMemAlloc (size + align + sizeof (void *));
+    if (blk_p == 0)
+    {
+        return 0;
+    }
+
+    addr = ((uint32_t)blk_p + sizeof (void *) + align - 1) & ~(align - 1);
+    ((void **)addr)[-1] = blk_p;
+    return (void *)addr;
+}
+
+/* Function    : CyFxCppNewAlignedFree
+ * Description : Free an object allocated by CyFxCppNewAlignedAlloc.
+ * Parameters  :
+ *               ptr : Pointer to the aligned object. Can be NULL.
+ * Return Value: None
+ */
+static void
+CyFxCppNewAlignedFree (
+        void *ptr)
+{
+    if (ptr != 0)
+    {
+        CyU3PMemFree (((void **)ptr)[-1]);
+    }
+}
+
+void *
+operator new (
+        size_t size,
+        std::align_val_t align)
+{
+    return CyFxCppNewCheck (CyFxCppNewAlignedAlloc (size, (size_t)align));
+}
+
+void *
+operator new[] (
+        size_t size,
+        std::align_val_t align)
+{
+    return CyFxCppNewCheck (CyFxCppNewAlignedAlloc (size, (size_t)align));
+}
+
+void *
+operator new (
+        size_t size,
+        std::align_val_t align,
+        const std::nothrow_t &)
+{
+    return CyFxCppNewAlignedAlloc (size, (size_t)align);
+}
+
+void *
+operator new[] (
+        size_t size,
+        std::align_val_t align,
+        const std::nothrow_t &)
+{
+    return CyFxCppNewAlignedAlloc (size, (size_t)align);
+}
+
+void
+operator delete (
+        void *ptr,
+        std::align_val_t)
+{
+    CyFxCppNewAlignedFree (ptr);
+}
+
+void
+operator delete[] (
+        void *ptr,
+        std::align_val_t)
+{
+    CyFxCppNewAlignedFree (ptr);
+}
+
+void
+operator delete (
+        void *ptr,
+        std::align_val_t,
+        const std::nothrow_t &)
+{
+    CyFxCppNewAlignedFree (ptr);
+}
+
+void
+operator delete[] (
+        void *ptr,
+        std::align_val_t,
+        const std::nothrow_t &)
+{
+    CyFxCppNewAlignedFree (ptr);
+}
+
+void
+operator delete (
+        void *ptr,
+        size_t,
+        std::align_val_t)
+{
+    CyFxCppNewAlignedFree (ptr);
+}
+
+void
+operator delete[] (
+        void *ptr,
+        size_t,
+        std::align_val_t)
+{
+    CyFxCppNewAlignedFree (ptr);
+}
+
+#endif /* __cpp_aligned_new */
+
+/*[]*/
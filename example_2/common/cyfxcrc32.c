@@ -0,0 +1,96 @@
+/*
+ ## Cypress FX3 Firmware Source File (cyfxcrc32.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Slice-by-4 CRC32.
+ *
+ * glCrc32Table[0] is the usual byte-at-a-time table. glCrc32Table[k][n] is the CRC of byte n followed
+ * by k zero bytes, so that the four bytes of a little-endian data word XORed into the CRC can be looked
+ * up independently and combined with three XORs. This processes a word with four loads from the tables
+ * instead of four dependent table steps.
+ */
+
+#include "cyu3types.h"
+#include "cyfxcrc32.h"
+
+#define CY_FX_CRC32_POLY        (0xEDB88320)
+
+static uint32_t glCrc32Table[4][256];
+
+void
+CyFxCrc32Init (
+        void)
+{
+    uint32_t i, j, crc;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = i;
+        for (j = 0; j < 8; j++)
+            crc = (crc & 1) ? ((crc >> 1) ^ CY_FX_CRC32_POLY) : (crc >> 1);
+        glCrc32Table[0][i] = crc;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = glCrc32Table[0][i];
+        for (j = 1; j < 4; j++)
+        {
+            crc = glCrc32Table[0][crc & 0xFF] ^ (crc >> 8);
+            glCrc32Table[j][i] = crc;
+        }
+    }
+}
+
+uint32_t
+CyFxCrc32Update (
+        uint32_t       crc,
+        const uint8_t *data_p,
+        uint32_t       len)
+{
+    crc = ~crc;
+
+    /* Leading bytes up to the first word boundary. */
+    while ((len != 0) && (((uint32_t)data_p & 3) != 0))
+    {
+        crc = glCrc32Table[0][(crc ^ *data_p++) & 0xFF] ^ (crc >> 8);
+        len--;
+    }
+
+    while (len >= 4)
+    {
+        crc ^= *((const uint32_t *)data_p);
+        crc  = glCrc32Table[3][crc & 0xFF] ^ glCrc32Table[2][(crc >> 8) & 0xFF] ^
+            glCrc32Table[1][(crc >> 16) & 0xFF] ^ glCrc32Table[0][crc >> 24];
+        data_p += 4;
+        len    -= 4;
+    }
+
+    while (len != 0)
+    {
+        crc = glCrc32Table[0][(crc ^ *data_p++) & 0xFF] ^ (crc >> 8);
+        len--;
+    }
+
+    return ~crc;
+}
+
+/*[]*/
@@ -0,0 +1,51 @@
+/*
+ ## Cypress FX3 Firmware Header File (cyfxcrc32.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the definitions for the table driven CRC32 routines. The CRC is the standard
+ * IEEE 802.3 / zlib CRC32 (reflected polynomial 0xEDB88320, initial value and final XOR 0xFFFFFFFF),
+ * computed four bytes at a time using the slice-by-4 method.
+ */
+
+#ifndef _INCLUDED_CYFXCRC32_H_
+#define _INCLUDED_CYFXCRC32_H_
+
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+/* Build the 4 KB of lookup tables. Must be called once before any CRC is computed. */
+extern void
+CyFxCrc32Init (
+        void);
+
+/* Update a running CRC32 with len bytes of data. Start with crc = 0 for a new CRC; the value returned
+   is the CRC of all of the data seen so far. Word aligned data is processed four bytes at a time. */
+extern uint32_t
+CyFxCrc32Update (
+        uint32_t       crc,
+        const uint8_t *data_p,
+        uint32_t       len);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYFXCRC32_H_ */
+
+/*[]*/
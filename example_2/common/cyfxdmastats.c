@@ -0,0 +1,346 @@
+/*
+ ## Cypress FX3 Firmware Source File (cyfxdmastats.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* DMA channel statistics module.
+ *
+ * The data path only ever increments free running counters (xferBytes and starveCnt), and the
+ * sampling timer works out what has changed since the previous tick. The timer is the only writer
+ * of the derived statistics, and updates a sequence number around each update so that readers
+ * can take a consistent snapshot without locking out the timer.
+ *
+ * The timer only runs while at least one channel is being tracked, so that an idle device does not
+ * take an interrupt every millisecond for nothing.
+ */
+
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+#include "cyu3utils.h"
+#include "cyfxdmastats.h"
+
+/* Number of 1 ms samples in the 100 ms window, and of 100 ms samples in the 1 s window. */
+#define CY_FX_DMA_STATS_MS_SAMPLES      (100)
+#define CY_FX_DMA_STATS_DS_SAMPLES      (10)
+
+/* Tracking information for one channel. */
+typedef struct CyFxDmaStatsChannel_t
+{
+    volatile CyBool_t  enabled;                 /* Whether the channel is being tracked. */
+    volatile CyBool_t  clearReq;                /* Request to the timer to clear the statistics. */
+    CyU3PDmaChannel   *poll_p;                  /* AUTO channel to be polled, or NULL. */
+    uint32_t           capacity;                /* Total buffer space of a polled channel. */
+    uint32_t           pollCount;               /* Producer transfer count at the previous poll. */
+    volatile uint32_t  resetGen;                /* Channel reset generation: odd while a reset is in progress. */
+    uint32_t           pollGen;                 /* resetGen value at the previous poll. */
+
+    volatile uint32_t  xferBytes;               /* Free running byte count, updated by the data path. */
+    volatile uint32_t  starveCnt;               /* Free running starvation count, updated by the data path. */
+    volatile uint32_t  seq;                     /* Update sequence number: odd while the timer is updating. */
+
+    uint32_t           lastXferBytes;           /* xferBytes value at the previous tick. */
+    uint32_t           lastStarveCnt;           /* starveCnt value at the previous tick. */
+    uint32_t           msRing[CY_FX_DMA_STATS_MS_SAMPLES];     /* Bytes moved in each of the last 100 ms. */
+    uint32_t           dsRing[CY_FX_DMA_STATS_DS_SAMPLES];     /* Bytes moved in each of the last ten 100 ms periods. */
+    uint16_t           msIdx;                   /* Next entry in msRing. */
+    uint16_t           dsIdx;                   /* Next entry in dsRing. */
+    uint32_t           msSum;                   /* Sum of msRing. */
+    uint32_t           dsSum;                   /* Sum of dsRing. */
+
+    CyFxDmaStats_t     stats;                   /* Statistics reported to the application. */
+} CyFxDmaStatsChannel_t;
+
+static CyFxDmaStatsChannel_t glDmaStats[CY_FX_DMA_STATS_MAX_CHANNELS];
+static CyU3PTimer            glDmaStatsTimer;
+static CyU3PMutex            glDmaStatsLock;            /* Serializes the enabling and disabling of channels. */
+static uint32_t              glDmaStatsActive = 0;      /* Bit mask of the channels being tracked. */
+static CyBool_t              glDmaStatsStarted = CyFalse;
+
+/* Clear the statistics and sampling history for a channel. Only called from the timer, or while
+   the channel is not being tracked. */
+static void
+CyFxDmaStatsClear (
+        CyFxDmaStatsChannel_t *ch_p)
+{
+    CyU3PMemSet ((uint8_t *)ch_p->msRing, 0, sizeof (ch_p->msRing));
+    CyU3PMemSet ((uint8_t *)ch_p->dsRing, 0, sizeof (ch_p->dsRing));
+    CyU3PMemSet ((uint8_t *)&ch_p->stats, 0, sizeof (ch_p->stats));
+    ch_p->msIdx = 0;
+    ch_p->dsIdx = 0;
+    ch_p->msSum = 0;
+    ch_p->dsSum = 0;
+    ch_p->lastXferBytes = ch_p->xferBytes;
+    ch_p->lastStarveCnt = ch_p->starveCnt;
+}
+
+/* Get the data moved by a polled channel since the previous tick. The producer count is used as the
+   channel throughput, as the consumer count is not updated for buffers discarded by the CPU. The
+   channel is starved if all of its buffers are waiting to be consumed.
+   The transfer counts are free running and may wrap, so the difference is taken modulo 2^32. They
+   only go back to zero when the channel is reset, which the application reports through
+   CyFxDmaStatsResetBegin/End; the channel is not polled while a reset is in progress. */
+static void
+CyFxDmaStatsPoll (
+        CyFxDmaStatsChannel_t *ch_p)
+{
+    CyU3PDmaState_t state;
+    uint32_t prodCount, consCount, gen;
+
+    gen = ch_p->resetGen;
+    if ((gen & 1) != 0)
+        return;
+
+    if (CyU3PDmaChannelGetStatus (ch_p->poll_p, &state, &prodCount, &consCount) != CY_U3P_SUCCESS)
+        return;
+
+    if (gen != ch_p->pollGen)
+    {
+        ch_p->pollGen   = gen;
+        ch_p->pollCount = 0;
+    }
+
+    ch_p->xferBytes += (prodCount - ch_p->pollCount);
+    ch_p->pollCount  = prodCount;
+
+    if ((ch_p->capacity != 0) && ((prodCount - consCount) >= ch_p->capacity))
+        ch_p->starveCnt++;
+}
+
+/* Timer callback: take a 1 ms sample for every tracked channel. */
+static void
+CyFxDmaStatsTimerCb (
+        uint32_t arg)
+{
+    CyFxDmaStatsChannel_t *ch_p;
+    uint32_t i, bytes, starve, xferBytes;
+
+    (void)arg;
+
+    for (i = 0; i < CY_FX_DMA_STATS_MAX_CHANNELS; i++)
+    {
+        ch_p = &glDmaStats[i];
+        if (!ch_p->enabled)
+            continue;
+
+        if (ch_p->poll_p != NULL)
+            CyFxDmaStatsPoll (ch_p);
+
+        ch_p->seq++;
+
+        if (ch_p->clearReq)
+        {
+            CyFxDmaStatsClear (ch_p);
+            ch_p->clearReq = CyFalse;
+        }
+
+        xferBytes = ch_p->xferBytes;
+        bytes     = xferBytes - ch_p->lastXferBytes;
+        ch_p->lastXferBytes = xferBytes;
+
+        starve = ch_p->starveCnt;
+        ch_p->stats.starveCnt += (starve - ch_p->lastStarveCnt);
+        ch_p->lastStarveCnt = starve;
+
+        ch_p->stats.bytesLo += bytes;
+        if (ch_p->stats.bytesLo < bytes)
+            ch_p->stats.bytesHi++;
+        ch_p->stats.activeMs++;
+        if (bytes == 0)
+            ch_p->stats.idleMs++;
+
+        /* 1 ms and 100 ms windows. */
+        ch_p->msSum += bytes - ch_p->msRing[ch_p->msIdx];
+        ch_p->msRing[ch_p->msIdx] = bytes;
+        ch_p->stats.rate1ms   = bytes * 1000;
+        ch_p->stats.rate100ms = ch_p->msSum * 10;
+        if (ch_p->stats.rate100ms > ch_p->stats.peakRate100ms)
+            ch_p->stats.peakRate100ms = ch_p->stats.rate100ms;
+
+        /* The 1 s window moves on each time the 100 ms ring wraps around. */
+        if (++ch_p->msIdx == CY_FX_DMA_STATS_MS_SAMPLES)
+        {
+            ch_p->msIdx = 0;
+            ch_p->dsSum += ch_p->msSum - ch_p->dsRing[ch_p->dsIdx];
+            ch_p->dsRing[ch_p->dsIdx] = ch_p->msSum;
+            ch_p->stats.rate1s = ch_p->dsSum;
+            if (++ch_p->dsIdx == CY_FX_DMA_STATS_DS_SAMPLES)
+                ch_p->dsIdx = 0;
+        }
+
+        ch_p->seq++;
+    }
+}
+
+CyU3PReturnStatus_t
+CyFxDmaStatsInit (
+        void)
+{
+    CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
+
+    if (!glDmaStatsStarted)
+    {
+        CyU3PMemSet ((uint8_t *)glDmaStats, 0, sizeof (glDmaStats));
+        glDmaStatsActive = 0;
+
+        /* The timer is started when the first channel is enabled. */
+        status = CyU3PMutexCreate (&glDmaStatsLock, CYU3P_NO_INHERIT);
+        if (status != CY_U3P_SUCCESS)
+            return status;
+
+        status = CyU3PTimerCreate (&glDmaStatsTimer, CyFxDmaStatsTimerCb, 0, 1, 1, CYU3P_NO_ACTIVATE);
+        if (status == CY_U3P_SUCCESS)
+            glDmaStatsStarted = CyTrue;
+        else
+            CyU3PMutexDestroy (&glDmaStatsLock);
+    }
+
+    return status;
+}
+
+CyU3PReturnStatus_t
+CyFxDmaStatsEnable (
+        uint8_t          chId,
+        CyU3PDmaChannel *poll_p,
+        uint32_t         capacity)
+{
+    CyFxDmaStatsChannel_t *ch_p;
+
+    if (chId >= CY_FX_DMA_STATS_MAX_CHANNELS)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    if (!glDmaStatsStarted)
+        return CY_U3P_ERROR_NOT_STARTED;
+
+    CyU3PMutexGet (&glDmaStatsLock, CYU3P_WAIT_FOREVER);
+
+    ch_p = &glDmaStats[chId];
+    ch_p->enabled  = CyFalse;
+    ch_p->poll_p   = poll_p;
+    ch_p->capacity = capacity;
+    ch_p->clearReq = CyFalse;
+
+    /* Polled channels start with zero transfer counts when the channel is created. */
+    ch_p->pollCount = 0;
+    ch_p->pollGen   = ch_p->resetGen;
+
+    ch_p->seq++;
+    CyFxDmaStatsClear (ch_p);
+    ch_p->seq++;
+
+    ch_p->enabled = CyTrue;
+
+    /* Start sampling with the first channel. */
+    if (glDmaStatsActive == 0)
+        CyU3PTimerStart (&glDmaStatsTimer);
+    glDmaStatsActive |= (1 << chId);
+
+    CyU3PMutexPut (&glDmaStatsLock);
+    return CY_U3P_SUCCESS;
+}
+
+void
+CyFxDmaStatsDisable (
+        uint8_t chId)
+{
+    if ((chId >= CY_FX_DMA_STATS_MAX_CHANNELS) || (!glDmaStatsStarted))
+        return;
+
+    CyU3PMutexGet (&glDmaStatsLock, CYU3P_WAIT_FOREVER);
+
+    glDmaStats[chId].enabled = CyFalse;
+    glDmaStats[chId].poll_p  = NULL;
+
+    /* Stop sampling once no channel is left. */
+    if (glDmaStatsActive & (1 << chId))
+    {
+        glDmaStatsActive &= ~(1 << chId);
+        if (glDmaStatsActive == 0)
+            CyU3PTimerStop (&glDmaStatsTimer);
+    }
+
+    CyU3PMutexPut (&glDmaStatsLock);
+}
+
+void
+CyFxDmaStatsResetBegin (
+        uint8_t chId)
+{
+    if ((chId < CY_FX_DMA_STATS_MAX_CHANNELS) && ((glDmaStats[chId].resetGen & 1) == 0))
+        glDmaStats[chId].resetGen++;
+}
+
+void
+CyFxDmaStatsResetEnd (
+        uint8_t chId)
+{
+    if ((chId < CY_FX_DMA_STATS_MAX_CHANNELS) && ((glDmaStats[chId].resetGen & 1) != 0))
+        glDmaStats[chId].resetGen++;
+}
+
+void
+CyFxDmaStatsAddBytes (
+        uint8_t  chId,
+        uint32_t count)
+{
+    if (chId < CY_FX_DMA_STATS_MAX_CHANNELS)
+        glDmaStats[chId].xferBytes += count;
+}
+
+void
+CyFxDmaStatsStarve (
+        uint8_t chId)
+{
+    if (chId < CY_FX_DMA_STATS_MAX_CHANNELS)
+        glDmaStats[chId].starveCnt++;
+}
+
+CyU3PReturnStatus_t
+CyFxDmaStatsGet (
+        uint8_t         chId,
+        CyFxDmaStats_t *stats_p,
+        CyBool_t        clear)
+{
+    CyFxDmaStatsChannel_t *ch_p;
+    uint32_t seq;
+
+    if ((chId >= CY_FX_DMA_STATS_MAX_CHANNELS) || (stats_p == NULL))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    /* Retry the copy if the timer updated the channel while it was being read. */
+    ch_p = &glDmaStats[chId];
+    do
+    {
+        seq = ch_p->seq;
+        CyU3PMemCopy ((uint8_t *)stats_p, (uint8_t *)&ch_p->stats, sizeof (CyFxDmaStats_t));
+    } while ((seq & 1) || (seq != ch_p->seq));
+
+    if (clear)
+    {
+        if (ch_p->enabled)
+            ch_p->clearReq = CyTrue;
+        else
+            CyFxDmaStatsClear (ch_p);
+    }
+
+    return CY_U3P_SUCCESS;
+}
+
+/*[]*/
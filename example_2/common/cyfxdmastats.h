@@ -0,0 +1,114 @@
+/*
+ ## Cypress FX3 Firmware Header File (cyfxdmastats.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the definitions for the DMA channel statistics module. Byte counts are
+ * sampled by a 1 ms timer, and turned into transfer rates over sliding 1 ms, 100 ms and 1 s windows.
+ *
+ * Channels with CPU involvement (MANUAL channels) report their data from the DMA callback using
+ * CyFxDmaStatsAddBytes. AUTO channels, and channels whose buffers are not seen by a callback, are
+ * polled by the timer using CyU3PDmaChannelGetStatus.
+ */
+
+#ifndef _INCLUDED_CYFXDMASTATS_H_
+#define _INCLUDED_CYFXDMASTATS_H_
+
+#include "cyu3types.h"
+#include "cyu3dma.h"
+#include "cyu3externcstart.h"
+
+/* Maximum number of channels that can be tracked. */
+#ifndef CY_FX_DMA_STATS_MAX_CHANNELS
+#define CY_FX_DMA_STATS_MAX_CHANNELS    (4)
+#endif
+
+/* Statistics for one DMA channel. This structure is also sent to the host as it is, as nine
+   little-endian 32 bit words. All rates are in bytes per second. */
+typedef struct CyFxDmaStats_t
+{
+    uint32_t bytesLo;                   /* Total bytes transferred: low word. */
+    uint32_t bytesHi;                   /* Total bytes transferred: high word. */
+    uint32_t rate1ms;                   /* Rate over the last 1 ms. */
+    uint32_t rate100ms;                 /* Rate over the last 100 ms. */
+    uint32_t rate1s;                    /* Rate over the last second, updated every 100 ms. */
+    uint32_t peakRate100ms;             /* Highest 100 ms rate seen. */
+    uint32_t starveCnt;                 /* Number of times the producer found no free buffer. */
+    uint32_t idleMs;                    /* Number of 1 ms periods in which the channel moved no data. */
+    uint32_t activeMs;                  /* Number of 1 ms periods for which the channel has been tracked. */
+} CyFxDmaStats_t;
+
+/* Create the 1 ms sampling timer. Called once during application initialization, before any channel is
+   enabled. The timer only runs while at least one channel is enabled. */
+extern CyU3PReturnStatus_t
+CyFxDmaStatsInit (
+        void);
+
+/* Start tracking a channel, clearing its statistics. poll_p should point to the channel handle for
+   polled channels, and be NULL for channels that report their data through CyFxDmaStatsAddBytes.
+   capacity is the total buffer space of a polled channel, and is used to detect starvation.
+   The sampling timer is started with the first channel. Must be called from thread context. */
+extern CyU3PReturnStatus_t
+CyFxDmaStatsEnable (
+        uint8_t          chId,
+        CyU3PDmaChannel *poll_p,
+        uint32_t         capacity);
+
+/* Stop tracking a channel. The statistics are kept until the channel is enabled again. The sampling
+   timer is stopped with the last channel. Must be called from thread context. */
+extern void
+CyFxDmaStatsDisable (
+        uint8_t chId);
+
+/* Report that a polled channel is about to be reset (CyU3PDmaChannelReset, or destroyed and created
+   again), which sets its transfer counts back to zero. The channel is not polled until
+   CyFxDmaStatsResetEnd is called after the reset, and its counts are then taken to start from zero. */
+extern void
+CyFxDmaStatsResetBegin (
+        uint8_t chId);
+
+/* Report that the reset started with CyFxDmaStatsResetBegin is complete. */
+extern void
+CyFxDmaStatsResetEnd (
+        uint8_t chId);
+
+/* Report data moved by a channel. Can be called from the DMA callback. */
+extern void
+CyFxDmaStatsAddBytes (
+        uint8_t  chId,
+        uint32_t count);
+
+/* Report that the producer of a channel found no free buffer. Can be called from the DMA callback. */
+extern void
+CyFxDmaStatsStarve (
+        uint8_t chId);
+
+/* Get a consistent snapshot of the statistics for a channel, and optionally clear the counters. */
+extern CyU3PReturnStatus_t
+CyFxDmaStatsGet (
+        uint8_t         chId,
+        CyFxDmaStats_t *stats_p,
+        CyBool_t        clear);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYFXDMASTATS_H_ */
+
+/*[]*/
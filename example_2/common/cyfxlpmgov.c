@@ -0,0 +1,68 @@
+/*
+ ## Cypress FX3 Firmware Source File (cyfxlpmgov.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* LPM governor, see cyfxlpmgov.h. */
+
+#include "cyu3types.h"
+#include "cyfxlpmgov.h"
+
+void
+CyFxLpmGovInit (
+        CyFxLpmGov_t *gov_p,
+        uint32_t      period,
+        uint32_t      idleTimeout)
+{
+    gov_p->activity    = CyFalse;
+    gov_p->blocked     = CyFalse;
+    gov_p->idleTime    = 0;
+    gov_p->period      = period;
+    gov_p->idleTimeout = idleTimeout;
+}
+
+uint32_t
+CyFxLpmGovTick (
+        CyFxLpmGov_t *gov_p)
+{
+    if (gov_p->activity)
+    {
+        gov_p->activity = CyFalse;
+        gov_p->idleTime = 0;
+        if (!gov_p->blocked)
+        {
+            gov_p->blocked = CyTrue;
+            return CY_FX_LPM_GOV_BLOCK;
+        }
+    }
+    else if (gov_p->blocked)
+    {
+        gov_p->idleTime += gov_p->period;
+        if (gov_p->idleTime >= gov_p->idleTimeout)
+        {
+            gov_p->blocked = CyFalse;
+            return CY_FX_LPM_GOV_ALLOW;
+        }
+    }
+
+    return CY_FX_LPM_GOV_NONE;
+}
+
+/*[]*/
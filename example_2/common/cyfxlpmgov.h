@@ -0,0 +1,73 @@
+/*
+ ## Cypress FX3 Firmware Header File (cyfxlpmgov.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the definitions for the LPM governor. The data path only records that there has been
+ * DMA activity, and a periodic timer calls CyFxLpmGovTick to decide when the U1/U2 transitions should be
+ * blocked or allowed again. The governor only makes the decision: the caller issues CyU3PUsbLPMDisable or
+ * CyU3PUsbLPMEnable when a tick returns CY_FX_LPM_GOV_BLOCK or CY_FX_LPM_GOV_ALLOW.
+ *
+ * The transitions are blocked on the first tick which sees activity, and allowed again on the first tick
+ * at which no activity has been seen for idleTimeout ms. Idle time is counted in whole periods, so the
+ * timeout is rounded up to a multiple of the tick period.
+ */
+
+#ifndef _INCLUDED_CYFXLPMGOV_H_
+#define _INCLUDED_CYFXLPMGOV_H_
+
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+/* Actions returned by CyFxLpmGovTick. */
+#define CY_FX_LPM_GOV_NONE              (0)     /* Nothing to do. */
+#define CY_FX_LPM_GOV_BLOCK             (1)     /* Block the LPM transitions (CyU3PUsbLPMDisable). */
+#define CY_FX_LPM_GOV_ALLOW             (2)     /* Allow the LPM transitions again (CyU3PUsbLPMEnable). */
+
+/* Governor state. */
+typedef struct CyFxLpmGov_t
+{
+    volatile CyBool_t activity;         /* Whether a DMA buffer has been handled since the last tick. */
+    CyBool_t          blocked;          /* Whether LPM transitions are currently blocked. */
+    uint32_t          idleTime;         /* Time in ms for which no activity has been seen. */
+    uint32_t          period;           /* Tick period in ms. */
+    uint32_t          idleTimeout;      /* Idle time in ms after which the transitions are allowed again. */
+} CyFxLpmGov_t;
+
+/* Record DMA activity. Can be called from the DMA callback. */
+#define CyFxLpmGovActivity(gov_p)       ((gov_p)->activity = CyTrue)
+
+/* Start the governor with the transitions allowed, for a tick every period ms. */
+extern void
+CyFxLpmGovInit (
+        CyFxLpmGov_t *gov_p,
+        uint32_t      period,
+        uint32_t      idleTimeout);
+
+/* Take one governor tick, and return the CY_FX_LPM_GOV_* action to be taken. */
+extern uint32_t
+CyFxLpmGovTick (
+        CyFxLpmGov_t *gov_p);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYFXLPMGOV_H_ */
+
+/*[]*/
@@ -0,0 +1,124 @@
+/*
+ ## Cypress FX3 Firmware Source File (cyfxpattern.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Source data patterns, see cyfxpattern.h. */
+
+#include "cyu3types.h"
+#include "cyu3os.h"
+#include "cyfxpattern.h"
+
+void
+CyFxPatternInit (
+        CyFxPatternGen_t *gen_p,
+        uint32_t          pattern,
+        uint8_t           constByte)
+{
+    gen_p->pattern   = pattern;
+    gen_p->count     = 0;
+    gen_p->prbs      = CY_FX_PATTERN_PRBS_SEED;
+    gen_p->seqNum    = 0;
+    gen_p->constByte = constByte;
+}
+
+/* Bit i of the state holds the bit generated i + 1 steps ago, so that eight new bits can be computed at
+ * once from the x^31 and x^28 taps. */
+uint8_t
+CyFxPatternPrbsStep (
+        uint32_t *prbs_p)
+{
+    uint32_t v = (((*prbs_p) ^ ((*prbs_p) >> 3)) >> 20) & 0xFF;
+
+    *prbs_p = (((*prbs_p) << 8) | v) & 0x7FFFFFFF;
+    return (uint8_t)v;
+}
+
+void
+CyFxPatternFill (
+        CyFxPatternGen_t *gen_p,
+        uint8_t          *buffer,
+        uint32_t          size)
+{
+    uint32_t i;
+
+    switch (gen_p->pattern)
+    {
+    case CY_FX_PATTERN_COUNTER:
+        for (i = 0; i < (size >> 2); i++)
+            ((uint32_t *)buffer)[i] = gen_p->count++;
+        break;
+
+    case CY_FX_PATTERN_PRBS31:
+        for (i = 0; i < size; i++)
+            buffer[i] = CyFxPatternPrbsStep (&gen_p->prbs);
+        break;
+
+    default:
+        CyU3PMemSet (buffer, gen_p->constByte, size);
+        break;
+    }
+}
+
+void
+CyFxPatternStamp (
+        CyFxPatternGen_t *gen_p,
+        uint8_t          *buffer)
+{
+    uint32_t seq = gen_p->seqNum++;
+
+    switch (gen_p->pattern)
+    {
+    case CY_FX_PATTERN_SEQNUM:
+        ((uint32_t *)buffer)[0] = seq;
+        ((uint32_t *)buffer)[1] = ~seq;
+        break;
+
+    case CY_FX_PATTERN_PRBS31:
+        ((uint32_t *)buffer)[0] = seq;
+        break;
+
+    default:
+        break;
+    }
+}
+
+uint32_t
+CyFxPatternPrbsCheck (
+        const uint8_t *buffer,
+        uint32_t       count)
+{
+    uint32_t prbs, i;
+
+    if (count <= 8)
+        return CY_FX_PATTERN_CHECK_GOOD;
+
+    prbs = (((uint32_t)buffer[4] << 24) | ((uint32_t)buffer[5] << 16) | ((uint32_t)buffer[6] << 8) |
+            buffer[7]) & 0x7FFFFFFF;
+    for (i = 8; i < count; i++)
+    {
+        if (buffer[i] != CyFxPatternPrbsStep (&prbs))
+            return i;
+    }
+
+    return CY_FX_PATTERN_CHECK_GOOD;
+}
+
+/*[]*/
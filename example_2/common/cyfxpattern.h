@@ -0,0 +1,100 @@
+/*
+ ## Cypress FX3 Firmware Header File (cyfxpattern.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the definitions for the source data patterns. A generator fills each DMA buffer with
+ * the body of the selected pattern once, when the buffers are first filled, and only writes a small header
+ * with CyFxPatternStamp each time a buffer is committed again. The buffers must be word aligned.
+ *
+ * CONST   : Every byte is the constant byte given to CyFxPatternInit. Nothing is written per commit.
+ * COUNTER : Incrementing little-endian 32 bit counter, continuing from one buffer to the next. Nothing is
+ *           written per commit.
+ * SEQNUM  : Constant bytes, with a header holding the 32 bit buffer sequence number followed by its
+ *           complement. Two words are written per commit.
+ * PRBS31  : PRBS-31 (x^31 + x^28 + 1) bit stream, MSB first in each byte and continuing from one buffer
+ *           to the next, with the first word replaced by the 32 bit buffer sequence number. One word is
+ *           written per commit. The second word then seeds CyFxPatternPrbsCheck on the receiving side.
+ */
+
+#ifndef _INCLUDED_CYFXPATTERN_H_
+#define _INCLUDED_CYFXPATTERN_H_
+
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+#define CY_FX_PATTERN_CONST             (0)
+#define CY_FX_PATTERN_COUNTER           (1)
+#define CY_FX_PATTERN_SEQNUM            (2)
+#define CY_FX_PATTERN_PRBS31            (3)
+#define CY_FX_PATTERN_COUNT             (4)
+
+#define CY_FX_PATTERN_PRBS_SEED         (0x7FFFFFFF)    /* PRBS31 state at the start of the sequence. */
+#define CY_FX_PATTERN_CHECK_GOOD        (0xFFFFFFFF)    /* CyFxPatternPrbsCheck: no mismatch found. */
+
+/* Generator state. */
+typedef struct CyFxPatternGen_t
+{
+    uint32_t pattern;                   /* Pattern generated: CY_FX_PATTERN_*. */
+    uint32_t count;                     /* Next COUNTER value. */
+    uint32_t prbs;                      /* PRBS31 state: bit i holds the bit generated i + 1 steps ago. */
+    uint32_t seqNum;                    /* Sequence number for the next stamped buffer. */
+    uint8_t  constByte;                 /* Byte value used by the CONST and SEQNUM patterns. */
+} CyFxPatternGen_t;
+
+/* Start the given pattern from the beginning of its sequence. */
+extern void
+CyFxPatternInit (
+        CyFxPatternGen_t *gen_p,
+        uint32_t          pattern,
+        uint8_t           constByte);
+
+/* Fill the body of a buffer, continuing the sequence from the previous buffer. For COUNTER, size is
+ * rounded down to a multiple of four. */
+extern void
+CyFxPatternFill (
+        CyFxPatternGen_t *gen_p,
+        uint8_t          *buffer,
+        uint32_t          size);
+
+/* Write the per-commit header of a buffer filled earlier, and move on to the next sequence number. */
+extern void
+CyFxPatternStamp (
+        CyFxPatternGen_t *gen_p,
+        uint8_t          *buffer);
+
+/* Get the next eight bits of the PRBS31 sequence, MSB first. */
+extern uint8_t
+CyFxPatternPrbsStep (
+        uint32_t *prbs_p);
+
+/* Check a received PRBS31 buffer: the first word is skipped and the second word seeds the checker. Returns
+ * the offset of the first byte that does not match, or CY_FX_PATTERN_CHECK_GOOD. Buffers of up to eight
+ * bytes hold no checked data and are good. */
+extern uint32_t
+CyFxPatternPrbsCheck (
+        const uint8_t *buffer,
+        uint32_t       count);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYFXPATTERN_H_ */
+
+/*[]*/
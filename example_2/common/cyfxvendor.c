@@ -0,0 +1,131 @@
+/*
+ ## Cypress FX3 Firmware Source File (cyfxvendor.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Table driven vendor request dispatcher. */
+
+#include "cyu3system.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+#include "cyfxvendor.h"
+
+const CyFxVendorRqt_t *
+CyFxVendorFind (
+        const CyFxVendorRqt_t *table_p,
+        uint16_t               count,
+        uint8_t                bRequest)
+{
+    uint16_t lo = 0, hi = count, mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) >> 1;
+        if (table_p[mid].bRequest == bRequest)
+            return &table_p[mid];
+
+        if (table_p[mid].bRequest < bRequest)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return NULL;
+}
+
+void
+CyFxVendorDispatch (
+        const CyFxVendorRqt_t *rqt_p,
+        uint32_t               setupdat0,
+        uint32_t               setupdat1,
+        uint8_t               *ep0Buf_p,
+        uint16_t               ep0BufSize)
+{
+    CyFxVendorSetup_t   setup;
+    CyU3PReturnStatus_t status;
+    uint8_t            *data_p = ep0Buf_p;
+    uint16_t            length;
+
+    if (rqt_p == NULL)
+    {
+        CyU3PUsbStall (0, CyTrue, CyFalse);
+        return;
+    }
+
+    setup.bRequest = (uint8_t)((setupdat0 & CY_U3P_USB_REQUEST_MASK) >> CY_U3P_USB_REQUEST_POS);
+    setup.wValue   = (uint16_t)((setupdat0 & CY_U3P_USB_VALUE_MASK) >> CY_U3P_USB_VALUE_POS);
+    setup.wIndex   = (uint16_t)((setupdat1 & CY_U3P_USB_INDEX_MASK) >> CY_U3P_USB_INDEX_POS);
+    setup.wLength  = (uint16_t)((setupdat1 & CY_U3P_USB_LENGTH_MASK) >> CY_U3P_USB_LENGTH_POS);
+    length = (setup.wLength < rqt_p->maxLength) ? setup.wLength : rqt_p->maxLength;
+
+    switch (rqt_p->dir)
+    {
+    case CY_FX_VENDOR_DIR_IN:
+        status = rqt_p->handler (&setup, &data_p, &length);
+        if (status != CY_U3P_SUCCESS)
+            CyU3PUsbStall (0, CyTrue, CyFalse);
+        else if (setup.wLength == 0)
+            CyU3PUsbAckSetup ();
+        else
+        {
+            /* An empty response is still sent as a zero length data phase: the host expects an IN
+               data stage whenever wLength is not zero. */
+            CyU3PUsbSendEP0Data ((length < setup.wLength) ? length : setup.wLength, data_p);
+        }
+        break;
+
+    case CY_FX_VENDOR_DIR_OUT:
+        /* The whole data phase has to fit in the scratch buffer. */
+        if ((setup.wLength > rqt_p->maxLength) || (setup.wLength > ep0BufSize))
+        {
+            CyU3PUsbStall (0, CyTrue, CyFalse);
+            break;
+        }
+
+        if (setup.wLength != 0)
+        {
+            if (CyU3PUsbGetEP0Data (setup.wLength, ep0Buf_p, &length) != CY_U3P_SUCCESS)
+                break;
+        }
+        else
+            CyU3PUsbAckSetup ();
+
+        /* The request has been completed by the data phase, so the status is not used. */
+        rqt_p->handler (&setup, &data_p, &length);
+        break;
+
+    default:
+        if (rqt_p->flags & CY_FX_VENDOR_ACK_FIRST)
+        {
+            CyU3PUsbAckSetup ();
+            rqt_p->handler (&setup, &data_p, &length);
+        }
+        else
+        {
+            if (rqt_p->handler (&setup, &data_p, &length) == CY_U3P_SUCCESS)
+                CyU3PUsbAckSetup ();
+            else
+                CyU3PUsbStall (0, CyTrue, CyFalse);
+        }
+        break;
+    }
+}
+
+/*[]*/
@@ -0,0 +1,112 @@
+/*
+ ## Cypress FX3 Firmware Header File (cyfxvendor.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the definitions for the table driven vendor request dispatcher.
+ *
+ * The application describes each of its vendor requests with a CyFxVendorRqt_t entry in a table sorted by
+ * bRequest. The entry gives the direction and maximum length of the data phase, whether the handler can run
+ * directly in the USB setup callback or has to be deferred to the application thread, and the handler. The
+ * dispatcher looks up the request, moves the data phase and completes or stalls the request, so that the
+ * handlers only deal with the request itself.
+ */
+
+#ifndef _INCLUDED_CYFXVENDOR_H_
+#define _INCLUDED_CYFXVENDOR_H_
+
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+/* Direction of the data phase. */
+#define CY_FX_VENDOR_DIR_NONE           (0)     /* No data phase: the request is ACKed. */
+#define CY_FX_VENDOR_DIR_IN             (1)     /* Device to host. A request with wLength = 0 is ACKed, an empty response
+                                                   to one with wLength > 0 is sent as a ZLP. */
+#define CY_FX_VENDOR_DIR_OUT            (2)     /* Host to device. */
+
+/* Context in which the handler runs. */
+#define CY_FX_VENDOR_CTX_CALLBACK       (0)     /* In the USB setup callback: the handler must not block. */
+#define CY_FX_VENDOR_CTX_THREAD         (1)     /* In the application thread. */
+
+/* Flags. */
+#define CY_FX_VENDOR_ACK_FIRST          (0x01)  /* Complete a request without data phase before calling the
+                                                   handler, for handlers that do not return straight away. */
+
+/* Decoded setup packet passed to the handlers. */
+typedef struct CyFxVendorSetup_t
+{
+    uint8_t  bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} CyFxVendorSetup_t;
+
+/* Vendor request handler. On entry *data_p points to the EP0 scratch buffer, and *length_p holds the length
+   of the data phase, limited to the maxLength of the table entry.
+
+   For IN requests, the handler either writes the response into the scratch buffer, or points *data_p at the
+   response so that it is sent without being copied. Such a response must be in DMA-able memory, 32 byte
+   aligned if the data cache is enabled, and must not change until the data phase is complete. *length_p is
+   set to the length of the response, which is cut down to wLength by the dispatcher.
+
+   For OUT requests, the data has already been received into the scratch buffer when the handler is called,
+   and *length_p holds the number of bytes received.
+
+   Returning an error stalls EP0, unless the request has already been completed. */
+typedef CyU3PReturnStatus_t (*CyFxVendorHandler_t) (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p);
+
+/* Vendor request table entry. */
+typedef struct CyFxVendorRqt_t
+{
+    uint8_t             bRequest;               /* Request code: the table is sorted on this field. */
+    uint8_t             dir;                    /* Data phase direction: CY_FX_VENDOR_DIR_*. */
+    uint8_t             context;                /* Handler context: CY_FX_VENDOR_CTX_*. */
+    uint8_t             flags;                  /* CY_FX_VENDOR_ACK_FIRST or 0. */
+    uint16_t            maxLength;              /* Longest data phase. OUT requests are limited to the size of
+                                                   the scratch buffer as well. */
+    CyFxVendorHandler_t handler;                /* Request handler. */
+} CyFxVendorRqt_t;
+
+/* Look up a request in a table sorted by bRequest, using a binary search. Returns NULL if the request is not
+   in the table. */
+extern const CyFxVendorRqt_t *
+CyFxVendorFind (
+        const CyFxVendorRqt_t *table_p,
+        uint16_t               count,
+        uint8_t                bRequest);
+
+/* Run a request: move the data phase, call the handler and complete the request, or stall EP0 if the request
+   is not valid. ep0Buf_p is the scratch buffer of ep0BufSize bytes, which must be 32 byte aligned. */
+extern void
+CyFxVendorDispatch (
+        const CyFxVendorRqt_t *rqt_p,
+        uint32_t               setupdat0,
+        uint32_t               setupdat1,
+        uint8_t               *ep0Buf_p,
+        uint16_t               ep0BufSize);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYFXVENDOR_H_ */
+
+/*[]*/
@@ -41,7 +41,8 @@
 
    The DMA buffer size is defined based on the USB speed. 64 for full speed, 512 for high speed
    and 1024 for super speed. CY_FX_BULKSRCSINK_DMA_BUF_COUNT in the header file defines the
-   number of DMA buffers.
+   number of DMA buffers. The burst length, buffer size multiplier and buffer count can also be
+   changed at runtime using vendor request 0x86, without re-enumerating the device.
    
    For performance optimizations refer the readme.txt
  */
@@ -55,6 +56,11 @@
 #include "cyu3uart.h"
 #include "cyu3gpio.h"
 #include "cyu3utils.h"
+#include "cyfxtx.h"
+#include "cyfxdmastats.h"
+#include "cyfxcrc32.h"
+#include "cyfxvendor.h"
+#include "cyfxlpmgov.h"
 
 CyU3PThread     bulkSrcSinkAppThread;    /* Application thread structure */
 CyU3PDmaChannel glChHandleBulkSink;      /* DMA MANUAL_IN channel handle.          */
@@ -65,25 +71,119 @@ uint32_t glDMARxCount = 0;               /* Counter to track the number of buffe
 uint32_t glDMATxCount = 0;               /* Counter to track the number of buffers transmitted. */
 CyBool_t glDataTransStarted = CyFalse;   /* Whether DMA transfer has been started after enumeration. */
 CyBool_t StandbyModeEnable  = CyFalse;   /* Whether standby mode entry is enabled. */
-CyBool_t TriggerStandbyMode = CyFalse;   /* Request to initiate standby entry. */
 CyBool_t glForceLinkU2      = CyFalse;   /* Whether the device should try to initiate U2 mode. */
 
+/* Current DMA channel geometry. Starts with the build time values and can be changed through vendor request 0x86. */
+CyFxBulkSrcSinkGeometry_t glDmaGeometry = {
+    CY_FX_EP_BURST_LENGTH, CY_FX_DMA_SIZE_MULTIPLIER, CY_FX_BULKSRCSINK_DMA_BUF_COUNT, 0, 0
+};
+
+/* Channel numbers used for the DMA statistics, which can be read through vendor request 0x88. */
+#define CY_FX_STATS_CH_SINK             (0)
+#define CY_FX_STATS_CH_SRC              (1)
+
+/* Source data pattern state. */
+uint8_t  glSrcPattern = CY_FX_SRC_PATTERN_CONST;        /* Pattern selected by vendor request 0x89. */
+CyFxPatternGen_t glSrcGen;                              /* Generator of the source buffer contents. */
+
+/* Sink data verification state, controlled by vendor request 0x8A. */
+CyFxSinkVerifyStats_t glSinkVerify = {
+    CY_FX_SINK_VERIFY_OFF, 0, 0, 0xFFFFFFFF, 0xFFFFFFFF
+};
+volatile uint32_t glSinkVerifyGen = 0;  /* Incremented each time the results are cleared. */
+
+/* Histogram of the number of source buffers committed per recycle pass. */
+uint32_t glSrcRecycleHist[CY_FX_SRC_RECYCLE_HIST_SIZE];
+uint32_t glSrcRecycleLate = 0;          /* Recycle timer ticks which found the previous recycle still pending. */
+
+#if (CY_FX_SRC_RECYCLE_POLL_PERIOD != 0)
+CyU3PTimer glSrcRecycleTimer;           /* Timer used to recycle the source buffers in polled mode. */
+volatile CyBool_t glSrcRecyclePending = CyFalse;   /* Whether the application thread has a recycle to do. */
+#endif
+#if (CY_FX_SINK_DISCARD_POLL_PERIOD != 0)
+CyU3PTimer glSinkDiscardTimer;          /* Timer used to discard the sink buffers in polled mode. */
+#endif
+
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+/* Heap scrub thread and results, read using vendor request 0x8D. The thread updates the results with
+   glHeapScrubLock held, so that the request always returns a consistent set. */
+CyU3PThread           glHeapScrubThread;
+CyU3PMutex            glHeapScrubLock;
+CyFxHeapScrubReport_t glHeapScrub;
+volatile uint32_t     glHeapScrubBadAddr = 0;   /* Last block reported by the corruption callback. */
+#endif
+
+CyFxAppWakeStats_t glAppWake;                   /* Application thread wakeup counters, see vendor request 0x8E. */
+
 volatile uint32_t glEp0StatCount = 0;           /* Number of EP0 status events received. */
-uint8_t glEp0Buffer[32] __attribute__ ((aligned (32))); /* Local buffer used for vendor command handling. */
+uint8_t glEp0Buffer[64] __attribute__ ((aligned (32))); /* Local buffer used for vendor command handling. */
 
 /* Control request related variables. */
 CyU3PEvent glBulkLpEvent;       /* Event group used to signal the thread that there is a pending request. */
 uint32_t   gl_setupdat0;        /* Variable that holds the setupdat0 value (bmRequestType, bRequest and wValue). */
 uint32_t   gl_setupdat1;        /* Variable that holds the setupdat1 value (wIndex and wLength). */
+const CyFxVendorRqt_t *glVendorRqt_p = NULL;  /* Vendor request deferred to the application thread. */
+uint8_t    glVendorRqtCnt = 0;  /* Number of vendor requests 0x76 received. */
+extern const CyFxVendorRqt_t glVendorRqtTable[];
+extern const uint16_t glVendorRqtCount;
 #define CYFX_USB_CTRL_TASK      (1 << 0)        /* Event that indicates that there is a pending USB control request. */
 #define CYFX_USB_HOSTWAKE_TASK  (1 << 1)        /* Event that indicates the a Remote Wake should be attempted. */
+#define CYFX_USB_EP_RECOVER_TASK (1 << 2)       /* Event that indicates that an endpoint is ready to be reset. */
+#define CYFX_USB_EP_FLUSH_TASK  (1 << 3)        /* Event that indicates that the IN endpoint hit a retry case. */
+#define CYFX_USB_FORCE_U2_TASK  (1 << 4)        /* Event that indicates that the link should be pushed into U2. */
+#define CYFX_USB_STANDBY_TASK   (1 << 5)        /* Event that indicates that standby mode should be entered. */
+#define CYFX_USB_LOG_TASK       (1 << 6)        /* Event that indicates that the USB driver log may have changed. */
+#define CYFX_SINK_DISCARD_TASK  (1 << 7)        /* Event that indicates that the full sink buffers should be discarded. */
+#define CYFX_SRC_RECYCLE_TASK   (1 << 8)        /* Event that indicates that the free source buffers should be recycled. */
+
+/* Link state polling interval used while the link is being pushed into U2. There is no event for the link
+   returning to U0, so the application thread waits with this timeout instead of blocking until an event. */
+#define CYFX_FORCE_U2_POLL_PERIOD       (10)
+
+/* CLEAR_FEATURE(EP_HALT) recovery state machine. The setup callback NAKs the endpoint and starts the recovery
+   timer (WAIT). When the timer expires the application thread is signalled (RESET), and the thread resets the
+   DMA channel and endpoint, re-arms the channel and completes the control request (IDLE). */
+#define CY_FX_EP_RECOVER_IDLE   (0)             /* No recovery in progress. */
+#define CY_FX_EP_RECOVER_WAIT   (1)             /* Endpoint NAKed, waiting for the NAK to take effect. */
+#define CY_FX_EP_RECOVER_RESET  (2)             /* Endpoint to be reset by the application thread. */
+#define CY_FX_EP_RECOVER_TICKS  (2)             /* Recovery wait: at least one full 1 ms tick. */
+CyU3PTimer        glEpRecoverTimer;             /* One-shot timer for the recovery wait. */
+volatile uint8_t  glEpRecoverState = CY_FX_EP_RECOVER_IDLE;
+uint16_t          glEpRecoverEp    = 0;         /* Endpoint being recovered. */
 
 /* Buffer used for USB event logs. */
 uint8_t *gl_UsbLogBuffer = NULL;
 #define CYFX_USBLOG_SIZE        (0x1000)
 
-/* Timer Instance */
-CyU3PTimer glLpmTimer;
+/* USB driver log streaming state, see vendor request 0x8B. The log positions count the bytes written by the
+   driver since boot, and glUsbLogIndex is the driver log index matching glUsbLogWritePos. The oldest
+   CYFX_USBLOG_GUARD bytes of the ring are not returned, as the driver may be overwriting them.
+   The driver index only gives the number of bytes logged modulo the ring size, so the LPM governor timer
+   reads it on every tick. While the index has not moved since the last update (glUsbLogQuiet), nothing has
+   been logged and the timer only refreshes glUsbLogUpdateTime; once it moves, the timer signals the
+   application thread on every tick until the thread has accounted for the new bytes. If the updates are
+   still more than CYFX_USBLOG_MAX_GAP ms apart (e.g. while the application thread is busy), whole rings
+   may have been logged in between. The bytes logged before such an update are dropped, and the next read
+   from a position before it reports an unknown lostCnt.
+   The driver logs a few bytes per USB event, which takes well over a second to fill the ring even with a
+   stream of control requests, so the index cannot move by a whole ring between two timer ticks, and
+   CYFX_USBLOG_MAX_GAP leaves an order of magnitude of margin. */
+uint32_t glUsbLogWritePos   = 0;        /* Log position of the next byte to be written by the driver. */
+uint32_t glUsbLogStartPos   = 0;        /* Oldest log position whose bytes are known to be in the ring. */
+uint16_t glUsbLogIndex      = 0;        /* Driver log index at the last update. */
+uint32_t glUsbLogUpdateTime = 0;        /* Time in ticks of the last update. */
+volatile CyBool_t glUsbLogQuiet = CyFalse;  /* Whether the driver index has been seen unchanged on every
+                                               timer tick since the last update. */
+uint32_t glUsbLogGapPos     = 0;        /* Log position at which bytes may have been missed. */
+CyBool_t glUsbLogGap        = CyFalse;  /* Whether glUsbLogGapPos is still to be reported to the host. */
+#define CYFX_USBLOG_GUARD       (64)
+#define CYFX_USBLOG_MAX_GAP     (100)
+uint8_t glUsbLogChunk[sizeof (CyFxUsbLogChunkHdr_t) + CY_FX_USBLOG_CHUNK_SIZE] __attribute__ ((aligned (32)));
+
+/* LPM governor state. The DMA callback only records that there has been activity, and the periodic
+   governor timer decides when to block or allow the LPM transitions. */
+CyU3PTimer   glLpmTimer;
+CyFxLpmGov_t glLpmGov;
 
 /* GPIO used for testing IO state retention when switching from boot firmware to full firmware. */
 #define FX3_GPIO_TEST_OUT               (50)
@@ -109,6 +209,83 @@ CyFxAppErrorHandler (
     }
 }
 
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+/* Start the free running GPIO timer used to time the heap scrub steps. The pin is only used for its timer:
+   it is not driven and its input is not sampled. */
+static void
+CyFxBulkSrcSinkHeapScrubTimerInit (
+        CyU3PGpioClock_t *gpioClock_p)
+{
+    CyU3PGpioComplexConfig_t gpioConfig;
+    CyU3PReturnStatus_t      apiRetStatus;
+    uint32_t                 sysClk = 0;
+
+    CyU3PMemSet ((uint8_t *)&gpioConfig, 0, sizeof (gpioConfig));
+    gpioConfig.outValue    = CyFalse;
+    gpioConfig.driveLowEn  = CyFalse;
+    gpioConfig.driveHighEn = CyFalse;
+    gpioConfig.inputEn     = CyFalse;
+    gpioConfig.pinMode     = CY_U3P_GPIO_MODE_STATIC;
+    gpioConfig.intrMode    = CY_U3P_GPIO_NO_INTR;
+    gpioConfig.timerMode   = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+    gpioConfig.timer       = 0;
+    gpioConfig.period      = 0xFFFFFFFF;
+    gpioConfig.threshold   = 0xFFFFFFFF;
+    apiRetStatus = CyU3PGpioSetComplexConfig (CY_FX_HEAP_SCRUB_TIMER_GPIO, &gpioConfig);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "Heap scrub timer config failed, Error code = %d\n", apiRetStatus);
+        return;
+    }
+
+    /* The GPIO block is clocked from SYS_CLK / 2. */
+    if (CyU3PDeviceGetSysClkFreq (&sysClk) == CY_U3P_SUCCESS)
+        glHeapScrub.tickHz = sysClk / 2 / gpioClock_p->fastClkDiv;
+}
+
+/* Callback from cyfxtx when a corrupted heap block is found. This can be called from any context, so
+   only the block address is recorded. */
+static void
+CyFxBulkSrcSinkHeapBadCb (
+        void *mem_p)
+{
+    glHeapScrubBadAddr = (uint32_t)mem_p;
+}
+
+/* Entry function for the heap scrub thread. Each heap is checked a few blocks at a time, so that the
+   interrupt lockout of the driver heap step stays short, and each step is timed. */
+static void
+CyFxBulkSrcSinkHeapScrubThread_Entry (
+        uint32_t input)
+{
+    uint32_t t0 = 0, t1 = 0, t2 = 0;
+
+    for (;;)
+    {
+        CyU3PThreadSleep (CY_FX_HEAP_SCRUB_PERIOD);
+
+        CyU3PGpioComplexSampleNow (CY_FX_HEAP_SCRUB_TIMER_GPIO, &t0);
+        CyU3PMemScrubStep (CY_FX_HEAP_SCRUB_BLOCKS);
+        CyU3PGpioComplexSampleNow (CY_FX_HEAP_SCRUB_TIMER_GPIO, &t1);
+        CyU3PBufScrubStep (CY_FX_HEAP_SCRUB_BLOCKS);
+        CyU3PGpioComplexSampleNow (CY_FX_HEAP_SCRUB_TIMER_GPIO, &t2);
+
+        CyU3PMutexGet (&glHeapScrubLock, CYU3P_WAIT_FOREVER);
+        glHeapScrub.steps++;
+        glHeapScrub.memTicks += (t1 - t0);
+        if ((t1 - t0) > glHeapScrub.memMaxTicks)
+            glHeapScrub.memMaxTicks = t1 - t0;
+        glHeapScrub.bufTicks += (t2 - t1);
+        if ((t2 - t1) > glHeapScrub.bufMaxTicks)
+            glHeapScrub.bufMaxTicks = t2 - t1;
+        CyU3PMemGetScrubStats (&glHeapScrub.memStats);
+        CyU3PBufGetScrubStats (&glHeapScrub.bufStats);
+        glHeapScrub.badAddr = glHeapScrubBadAddr;
+        CyU3PMutexPut (&glHeapScrubLock);
+    }
+}
+#endif
+
 /* This function initializes the debug module. The debug prints
  * are routed to the UART and can be seen using a UART console
  * running at 115200 baud rate. */
@@ -142,6 +319,10 @@ CyFxBulkSrcSinkApplnDebugInit (void)
         apiRetStatus = CyU3PGpioSetSimpleConfig (FX3_GPIO_TEST_OUT, &testConf);
         if (apiRetStatus != 0)
             CyFxAppErrorHandler (apiRetStatus);
+
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+        CyFxBulkSrcSinkHeapScrubTimerInit (&gpioClock);
+#endif
     }
 
     /* Initialize the UART for printing debug messages */
@@ -193,12 +374,263 @@ CyFxApplnLPMRqtCB (
     return CyTrue;
 }
 
-/* Callback funtion for the timer expiry notification. */
+/* Callback function for the LPM governor timer, called every CY_FX_LPM_GOVERNOR_PERIOD ms. LPM is
+   disabled as soon as there is DMA activity, and enabled again once the channels have been idle for
+   CY_FX_LPM_IDLE_TIMEOUT ms. The USB driver is only called when the state actually changes. */
 void TimerCb(void)
 {
-    /* Enable the low power mode transition on timer expiry */
-    CyU3PUsbLPMEnable();
+    /* Have the application thread check the USB driver log if it has changed, so that it is never left for
+       a whole ring. If nothing has been logged, the log is known to be up to date without waking the thread. */
+    if (gl_UsbLogBuffer != NULL)
+    {
+        if ((glUsbLogQuiet) && (CyU3PUsbGetEventLogIndex () == glUsbLogIndex))
+        {
+            glUsbLogUpdateTime = CyU3PGetTime ();
+        }
+        else
+        {
+            glUsbLogQuiet = CyFalse;
+            CyU3PEventSet (&glBulkLpEvent, CYFX_USB_LOG_TASK, CYU3P_EVENT_OR);
+        }
+    }
+
+    switch (CyFxLpmGovTick (&glLpmGov))
+    {
+    case CY_FX_LPM_GOV_BLOCK:
+        CyU3PUsbLPMDisable ();
+        break;
+
+    case CY_FX_LPM_GOV_ALLOW:
+        CyU3PUsbLPMEnable ();
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Callback function for the endpoint recovery timer. The endpoint NAK has taken effect, so the
+   application thread can now reset the endpoint. */
+static void
+CyFxBulkSrcSinkEpRecoverTimerCb (
+        uint32_t arg)
+{
+    (void)arg;
+
+    if (glEpRecoverState == CY_FX_EP_RECOVER_WAIT)
+    {
+        glEpRecoverState = CY_FX_EP_RECOVER_RESET;
+        CyU3PEventSet (&glBulkLpEvent, CYFX_USB_EP_RECOVER_TASK, CYU3P_EVENT_OR);
+    }
+}
+
+/* Disable the IRQ and FIQ interrupts and return the previous CPSR value. Used to update the sink verification
+   results, which are written both by the verifier and by vendor request 0x8A in the setup callback. */
+static inline uint32_t
+CyFxBulkSrcSinkIrqLock (
+        void)
+{
+#if defined (__arm__)
+    uint32_t cpsr, tmp;
+
+    __asm__ __volatile__ (
+            "mrs %0, cpsr\n\t"
+            "orr %1, %0, #0xC0\n\t"
+            "msr cpsr_c, %1"
+            : "=r" (cpsr), "=r" (tmp) : : "memory");
+    return cpsr;
+#else
+    return 0;
+#endif
+}
+
+/* Restore the interrupt state saved by CyFxBulkSrcSinkIrqLock. */
+static inline void
+CyFxBulkSrcSinkIrqUnlock (
+        uint32_t cpsr)
+{
+#if defined (__arm__)
+    __asm__ __volatile__ ("msr cpsr_c, %0" : : "r" (cpsr) : "memory");
+#else
+    (void)cpsr;
+#endif
+}
+
+/* Verify a buffer received on the sink endpoint using the selected method, and update the results. The check
+   itself runs with interrupts enabled; the results are updated with interrupts locked out, and only if they
+   have not been cleared by vendor request 0x8A in the meantime. */
+static void
+CyFxBulkSrcSinkVerifyBuffer (
+        const uint8_t *buffer,
+        uint32_t       count)
+{
+    uint32_t offset = 0xFFFFFFFF, crc, gen, intMask;
+
+    gen = glSinkVerifyGen;
+    switch (glSinkVerify.mode)
+    {
+    case CY_FX_SINK_VERIFY_CRC32:
+        if (count < 4)
+            offset = 0;
+        else
+        {
+            crc = (uint32_t)buffer[count - 4] | ((uint32_t)buffer[count - 3] << 8) |
+                ((uint32_t)buffer[count - 2] << 16) | ((uint32_t)buffer[count - 1] << 24);
+            if (CyFxCrc32Update (0, buffer, count - 4) != crc)
+                offset = count - 4;
+        }
+        break;
+
+    case CY_FX_SINK_VERIFY_PRBS31:
+        offset = CyFxPatternPrbsCheck (buffer, count);
+        break;
+
+    default:
+        return;
+    }
+
+    intMask = CyFxBulkSrcSinkIrqLock ();
+    if (glSinkVerifyGen == gen)
+    {
+        if (offset == 0xFFFFFFFF)
+            glSinkVerify.goodCnt++;
+        else
+        {
+            if (glSinkVerify.badCnt == 0)
+            {
+                glSinkVerify.firstErrBuf    = glSinkVerify.goodCnt;
+                glSinkVerify.firstErrOffset = offset;
+            }
+            glSinkVerify.badCnt++;
+        }
+    }
+    CyFxBulkSrcSinkIrqUnlock (intMask);
+}
+
+/* Commit every source buffer that the host has consumed, up to the number of buffers in the channel,
+ * so that a delayed callback refills the whole channel at once instead of a single buffer. The data
+ * is preloaded into the buffers at the start, so the buffers are committed as they are. */
+static void
+CyFxBulkSrcSinkRecycleSrc (
+        void)
+{
+    CyU3PDmaBuffer_t buf_p;
+    CyU3PReturnStatus_t status;
+    uint32_t committed = 0, bytes = 0;
+
+    while (committed < glDmaGeometry.bufCount)
+    {
+        status = CyU3PDmaChannelGetBuffer (&glChHandleBulkSrc, &buf_p, CYU3P_NO_WAIT);
+        if (status != CY_U3P_SUCCESS)
+            break;
+
+        /* Commit the full buffer with default status. */
+        CyFxPatternStamp (&glSrcGen, buf_p.buffer);
+        status = CyU3PDmaChannelCommitBuffer (&glChHandleBulkSrc, buf_p.size, 0);
+        if (status != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PDmaChannelCommitBuffer failed, Error code = %d\n", status);
+            break;
+        }
+
+        committed++;
+        bytes += buf_p.size;
+    }
+
+    if (committed == 0)
+        CyFxDmaStatsStarve (CY_FX_STATS_CH_SRC);
+
+    /* Increment the counters. */
+    glSrcRecycleHist[(committed < CY_FX_SRC_RECYCLE_HIST_SIZE) ? committed : (CY_FX_SRC_RECYCLE_HIST_SIZE - 1)]++;
+    CyFxDmaStatsAddBytes (CY_FX_STATS_CH_SRC, bytes);
+    glDMATxCount += committed;
+}
+
+#if (CY_FX_SRC_RECYCLE_POLL_PERIOD != 0)
+/* Timer callback used to recycle the source buffers in polled mode. As with the sink discard, the DMA channel
+ * is not touched from the timer context, where it could race with the channel being reconfigured or reset by
+ * the application thread: the thread is signalled, and recycles the buffers. A tick which finds the previous
+ * recycle still pending is counted, as the thread has then fallen a whole period behind. */
+static void
+CyFxBulkSrcSinkRecycleTimerCb (
+        uint32_t arg)
+{
+    (void)arg;
+
+    if (glIsApplnActive)
+    {
+        if (glSrcRecyclePending)
+            glSrcRecycleLate++;
+        glSrcRecyclePending = CyTrue;
+        CyU3PEventSet (&glBulkLpEvent, CYFX_SRC_RECYCLE_TASK, CYU3P_EVENT_OR);
+    }
+}
+
+/* Recycle the source buffers in polled mode, called from the application thread. */
+static void
+CyFxBulkSrcSinkRecycleSrcPoll (
+        void)
+{
+    glSrcRecyclePending = CyFalse;
+    if (!glIsApplnActive)
+        return;
+
+    glDataTransStarted = CyTrue;
+    CyFxLpmGovActivity (&glLpmGov);
+    CyFxBulkSrcSinkRecycleSrc ();
+}
+#endif
+
+#if (CY_FX_SINK_DISCARD_POLL_PERIOD != 0)
+/* Timer callback used to discard the sink buffers in polled mode. The DMA channel is not touched from the
+ * timer context: the application thread is signalled, and discards the buffers in the same way as it
+ * handles the endpoint halt recovery. */
+static void
+CyFxBulkSrcSinkDiscardTimerCb (
+        uint32_t arg)
+{
+    (void)arg;
+
+    if (glIsApplnActive)
+        CyU3PEventSet (&glBulkLpEvent, CYFX_SINK_DISCARD_TASK, CYU3P_EVENT_OR);
+}
+
+/* Discard the full sink buffers in polled mode, called from the application thread. All full buffers
+ * are discarded in one pass, each one being fetched first so that the discard always matches a buffer
+ * that has been received. If every buffer in the channel was full, the USB producer has probably been
+ * held off. */
+static void
+CyFxBulkSrcSinkDiscardSink (
+        void)
+{
+    CyU3PDmaBuffer_t buf_p;
+    uint32_t discarded = 0;
+
+    if (!glIsApplnActive)
+        return;
+
+    while (discarded < glDmaGeometry.bufCount)
+    {
+        if (CyU3PDmaChannelGetBuffer (&glChHandleBulkSink, &buf_p, CYU3P_NO_WAIT) != CY_U3P_SUCCESS)
+            break;
+        if (glSinkVerify.mode != CY_FX_SINK_VERIFY_OFF)
+            CyFxBulkSrcSinkVerifyBuffer (buf_p.buffer, buf_p.count);
+
+        if (CyU3PDmaChannelDiscardBuffer (&glChHandleBulkSink) != CY_U3P_SUCCESS)
+            break;
+        discarded++;
+    }
+
+    if (discarded != 0)
+    {
+        glDataTransStarted = CyTrue;
+        glDMARxCount      += discarded;
+        CyFxLpmGovActivity (&glLpmGov);
+        if (discarded == glDmaGeometry.bufCount)
+            CyFxDmaStatsStarve (CY_FX_STATS_CH_SINK);
+    }
 }
+#endif
 
 /* Callback funtion for the DMA event notification. */
 void
@@ -207,60 +639,45 @@ CyFxBulkSrcSinkDmaCallback (
         CyU3PDmaCbType_t  type,      /* Callback type.             */
         CyU3PDmaCBInput_t *input)    /* Callback status.           */
 {
-    CyU3PDmaBuffer_t buf_p;
     CyU3PReturnStatus_t status = CY_U3P_SUCCESS;
 
     glDataTransStarted = CyTrue;
 
-    /** Start/restart the timer and disable LPM **/
-    CyU3PUsbLPMDisable();
-    CyU3PTimerStop (&glLpmTimer);
-    CyU3PTimerModify(&glLpmTimer, 100, 0);
-    CyU3PTimerStart(&glLpmTimer);
+    /* Let the LPM governor know that data is moving. */
+    CyFxLpmGovActivity (&glLpmGov);
 
     if (type == CY_U3P_DMA_CB_PROD_EVENT)
     {
         /* This is a produce event notification to the CPU. This notification is 
          * received upon reception of every buffer. We have to discard the buffer
-         * as soon as it is received to implement the data sink. */
+         * as soon as it is received to implement the data sink, after checking
+         * its contents if verification is enabled. */
+        if (glSinkVerify.mode != CY_FX_SINK_VERIFY_OFF)
+            CyFxBulkSrcSinkVerifyBuffer (input->buffer_p.buffer, input->buffer_p.count);
         status = CyU3PDmaChannelDiscardBuffer (chHandle);
         if (status != CY_U3P_SUCCESS)
         {
             CyU3PDebugPrint (4, "CyU3PDmaChannelDiscardBuffer failed, Error code = %d\n", status);
         }
 
-        /* Increment the counter. */
+        /* Increment the counters. */
+        CyFxDmaStatsAddBytes (CY_FX_STATS_CH_SINK, input->buffer_p.count);
         glDMARxCount++;
     }
     if (type == CY_U3P_DMA_CB_CONS_EVENT)
     {
         /* This is a consume event notification to the CPU. This notification is 
          * received when a buffer is sent out from the device. We have to commit
-         * a new buffer as soon as a buffer is available to implement the data
-         * source. The data is preloaded into the buffer at that start. So just
-         * commit the buffer. */
-        status = CyU3PDmaChannelGetBuffer (chHandle, &buf_p, CYU3P_NO_WAIT);
-        if (status == CY_U3P_SUCCESS)
-        {
-            /* Commit the full buffer with default status. */
-            status = CyU3PDmaChannelCommitBuffer (chHandle, buf_p.size, 0);
-            if (status != CY_U3P_SUCCESS)
-            {
-                CyU3PDebugPrint (4, "CyU3PDmaChannelCommitBuffer failed, Error code = %d\n", status);
-            }
-        }
-        else
-        {
-            CyU3PDebugPrint (4, "CyU3PDmaChannelGetBuffer failed, Error code = %d\n", status);
-        }
-
-        /* Increment the counter. */
-        glDMATxCount++;
+         * new buffers as soon as they are available to implement the data
+         * source. Earlier notifications may have been delayed, so commit all
+         * of the buffers that are free now. */
+        CyFxBulkSrcSinkRecycleSrc ();
     }
 }
 
 /*
  * Fill all DMA buffers on the IN endpoint with data. This gets data moving after an endpoint reset.
+ * The body of each buffer is computed here for the selected pattern, and the sequence numbers restart.
  */
 static void
 CyFxBulkSrcSinkFillInBuffers (
@@ -270,8 +687,10 @@ CyFxBulkSrcSinkFillInBuffers (
     CyU3PDmaBuffer_t    buf_p;
     uint16_t            index = 0;
 
+    CyFxPatternInit (&glSrcGen, glSrcPattern, CY_FX_BULKSRCSINK_PATTERN);
+
     /* Now preload all buffers in the MANUAL_OUT pipe with the required data. */
-    for (index = 0; index < CY_FX_BULKSRCSINK_DMA_BUF_COUNT; index++)
+    for (index = 0; index < glDmaGeometry.bufCount; index++)
     {
         stat = CyU3PDmaChannelGetBuffer (&glChHandleBulkSrc, &buf_p, CYU3P_NO_WAIT);
         if (stat != CY_U3P_SUCCESS)
@@ -280,7 +699,8 @@ CyFxBulkSrcSinkFillInBuffers (
             CyFxAppErrorHandler(stat);
         }
 
-        CyU3PMemSet (buf_p.buffer, CY_FX_BULKSRCSINK_PATTERN, buf_p.size);
+        CyFxPatternFill (&glSrcGen, buf_p.buffer, buf_p.size);
+        CyFxPatternStamp (&glSrcGen, buf_p.buffer);
         stat = CyU3PDmaChannelCommitBuffer (&glChHandleBulkSrc, buf_p.size, 0);
         if (stat != CY_U3P_SUCCESS)
         {
@@ -290,8 +710,6 @@ CyFxBulkSrcSinkFillInBuffers (
     }
 }
 
-static volatile CyBool_t glSrcEpFlush = CyFalse;
-
 void
 CyFxBulkSrcSinkApplnEpEvtCB (
         CyU3PUsbEpEvtType evtype,
@@ -301,8 +719,123 @@ CyFxBulkSrcSinkApplnEpEvtCB (
     /* Hit an endpoint retry case. Need to stall and flush the endpoint for recovery. */
     if (evtype == CYU3P_USBEP_SS_RETRY_EVT)
     {
-        glSrcEpFlush = CyTrue;
+        CyU3PEventSet (&glBulkLpEvent, CYFX_USB_EP_FLUSH_TASK, CYU3P_EVENT_OR);
+    }
+}
+
+/* Create the DMA MANUAL_IN and MANUAL_OUT channels using the current channel geometry, and start
+ * the transfers on them. Both channels are left destroyed if any step fails. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkChannelCreate (
+        void)
+{
+    CyU3PDmaChannelConfig_t dmaCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    /* Create a DMA MANUAL_IN channel for the producer socket. */
+    CyU3PMemSet ((uint8_t *)&dmaCfg, 0, sizeof (dmaCfg));
+    /* The buffer size will be same as packet size for the
+     * full speed, high speed and super speed non-burst modes.
+     * For super speed burst mode of operation, the buffers will be
+     * 1024 * burst length so that a full burst can be completed.
+     * This will mean that a buffer will be available only after it
+     * has been filled or when a short packet is received. */
+    dmaCfg.size  = (glDmaGeometry.pktSize * glDmaGeometry.burstLen);
+    /* Multiply the buffer size with the multiplier
+     * for performance improvement. */
+    dmaCfg.size *= glDmaGeometry.sizeMult;
+    dmaCfg.count = glDmaGeometry.bufCount;
+    dmaCfg.prodSckId = CY_FX_EP_PRODUCER_SOCKET;
+    dmaCfg.consSckId = CY_U3P_CPU_SOCKET_CONS;
+    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
+#if (CY_FX_SINK_DISCARD_POLL_PERIOD != 0)
+    dmaCfg.notification = 0;
+#else
+    dmaCfg.notification = CY_U3P_DMA_CB_PROD_EVENT;
+#endif
+    dmaCfg.cb = CyFxBulkSrcSinkDmaCallback;
+    dmaCfg.prodHeader = 0;
+    dmaCfg.prodFooter = 0;
+    dmaCfg.consHeader = 0;
+    dmaCfg.prodAvailCount = 0;
+
+    glDmaGeometry.bufSize = 0;
+    apiRetStatus = CyU3PDmaChannelCreate (&glChHandleBulkSink,
+            CY_U3P_DMA_TYPE_MANUAL_IN, &dmaCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
+        return apiRetStatus;
+    }
+
+    /* Create a DMA MANUAL_OUT channel for the consumer socket. In polled mode, the consumed buffers
+     * are picked up by the recycle timer and no notifications are needed. */
+#if (CY_FX_SRC_RECYCLE_POLL_PERIOD != 0)
+    dmaCfg.notification = 0;
+#else
+    dmaCfg.notification = CY_U3P_DMA_CB_CONS_EVENT;
+#endif
+    dmaCfg.prodSckId = CY_U3P_CPU_SOCKET_PROD;
+    dmaCfg.consSckId = CY_FX_EP_CONSUMER_SOCKET;
+    apiRetStatus = CyU3PDmaChannelCreate (&glChHandleBulkSrc,
+            CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
+        CyU3PDmaChannelDestroy (&glChHandleBulkSink);
+        return apiRetStatus;
+    }
+
+    /* Set DMA Channel transfer size */
+    apiRetStatus = CyU3PDmaChannelSetXfer (&glChHandleBulkSink, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+    if (apiRetStatus == CY_U3P_SUCCESS)
+    {
+        apiRetStatus = CyU3PDmaChannelSetXfer (&glChHandleBulkSrc, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+    }
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PDmaChannelSetXfer failed, Error code = %d\n", apiRetStatus);
+        CyU3PDmaChannelDestroy (&glChHandleBulkSink);
+        CyU3PDmaChannelDestroy (&glChHandleBulkSrc);
+        return apiRetStatus;
+    }
+
+    glDmaGeometry.bufSize = dmaCfg.size;
+    return CY_U3P_SUCCESS;
+}
+
+/* Configure both endpoints using the current channel geometry. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkEpConfig (
+        void)
+{
+    CyU3PEpConfig_t epCfg;
+    CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+    CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
+    epCfg.enable = CyTrue;
+    epCfg.epType = CY_U3P_USB_EP_BULK;
+    epCfg.burstLen = (CyU3PUsbGetSpeed () == CY_U3P_SUPER_SPEED) ?
+        (glDmaGeometry.burstLen) : 1;
+    epCfg.streams = 0;
+    epCfg.pcktSize = glDmaGeometry.pktSize;
+
+    /* Producer endpoint configuration */
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
+        return apiRetStatus;
+    }
+
+    /* Consumer endpoint configuration */
+    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
     }
+
+    return apiRetStatus;
 }
 
 /* This function starts the application. This is called
@@ -313,8 +846,6 @@ CyFxBulkSrcSinkApplnStart (
         void)
 {
     uint16_t size = 0;
-    CyU3PEpConfig_t epCfg;
-    CyU3PDmaChannelConfig_t dmaCfg;
     CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
     CyU3PUSBSpeed_t usbSpeed = CyU3PUsbGetSpeed();
 
@@ -342,27 +873,14 @@ CyFxBulkSrcSinkApplnStart (
         break;
     }
 
-    CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
-    epCfg.enable = CyTrue;
-    epCfg.epType = CY_U3P_USB_EP_BULK;
-    epCfg.burstLen = (usbSpeed == CY_U3P_SUPER_SPEED) ?
-        (CY_FX_EP_BURST_LENGTH) : 1;
-    epCfg.streams = 0;
-    epCfg.pcktSize = size;
-
-    /* Producer endpoint configuration */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
-    {
-        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
-        CyFxAppErrorHandler (apiRetStatus);
-    }
-
-    /* Consumer endpoint configuration */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
+    /* A shorter burst set at high or full speed is not valid at super speed, where the endpoint burst has to
+       match the descriptors. */
+    glDmaGeometry.pktSize = size;
+    if (usbSpeed == CY_U3P_SUPER_SPEED)
+        glDmaGeometry.burstLen = CY_FX_EP_BURST_LENGTH;
+    apiRetStatus = CyFxBulkSrcSinkEpConfig ();
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
         CyFxAppErrorHandler (apiRetStatus);
     }
 
@@ -370,69 +888,153 @@ CyFxBulkSrcSinkApplnStart (
     CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
     CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
 
-    /* Create a DMA MANUAL_IN channel for the producer socket. */
-    CyU3PMemSet ((uint8_t *)&dmaCfg, 0, sizeof (dmaCfg));
-    /* The buffer size will be same as packet size for the
-     * full speed, high speed and super speed non-burst modes.
-     * For super speed burst mode of operation, the buffers will be
-     * 1024 * burst length so that a full burst can be completed.
-     * This will mean that a buffer will be available only after it
-     * has been filled or when a short packet is received. */
-    dmaCfg.size  = (size * CY_FX_EP_BURST_LENGTH);
-    /* Multiply the buffer size with the multiplier
-     * for performance improvement. */
-    dmaCfg.size *= CY_FX_DMA_SIZE_MULTIPLIER;
-    dmaCfg.count = CY_FX_BULKSRCSINK_DMA_BUF_COUNT;
-    dmaCfg.prodSckId = CY_FX_EP_PRODUCER_SOCKET;
-    dmaCfg.consSckId = CY_U3P_CPU_SOCKET_CONS;
-    dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
-    dmaCfg.notification = CY_U3P_DMA_CB_PROD_EVENT;
-    dmaCfg.cb = CyFxBulkSrcSinkDmaCallback;
-    dmaCfg.prodHeader = 0;
-    dmaCfg.prodFooter = 0;
-    dmaCfg.consHeader = 0;
-    dmaCfg.prodAvailCount = 0;
-
-    apiRetStatus = CyU3PDmaChannelCreate (&glChHandleBulkSink,
-            CY_U3P_DMA_TYPE_MANUAL_IN, &dmaCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
+    /* Create the channels. If a geometry selected by the host does not fit in the buffer heap,
+     * fall back to the build time defaults. */
+    apiRetStatus = CyFxBulkSrcSinkChannelCreate ();
+    if ((apiRetStatus != CY_U3P_SUCCESS) && (glDmaGeometry.bufCount != CY_FX_BULKSRCSINK_DMA_BUF_COUNT ||
+                glDmaGeometry.sizeMult != CY_FX_DMA_SIZE_MULTIPLIER || glDmaGeometry.burstLen != CY_FX_EP_BURST_LENGTH))
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        glDmaGeometry.burstLen = CY_FX_EP_BURST_LENGTH;
+        glDmaGeometry.sizeMult = CY_FX_DMA_SIZE_MULTIPLIER;
+        glDmaGeometry.bufCount = CY_FX_BULKSRCSINK_DMA_BUF_COUNT;
+        apiRetStatus = CyFxBulkSrcSinkEpConfig ();
+        if (apiRetStatus == CY_U3P_SUCCESS)
+            apiRetStatus = CyFxBulkSrcSinkChannelCreate ();
     }
-
-    /* Create a DMA MANUAL_OUT channel for the consumer socket. */
-    dmaCfg.notification = CY_U3P_DMA_CB_CONS_EVENT;
-    dmaCfg.prodSckId = CY_U3P_CPU_SOCKET_PROD;
-    dmaCfg.consSckId = CY_FX_EP_CONSUMER_SOCKET;
-    apiRetStatus = CyU3PDmaChannelCreate (&glChHandleBulkSrc,
-            CY_U3P_DMA_TYPE_MANUAL_OUT, &dmaCfg);
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
         CyFxAppErrorHandler(apiRetStatus);
     }
 
-    /* Set DMA Channel transfer size */
-    apiRetStatus = CyU3PDmaChannelSetXfer (&glChHandleBulkSink, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+    /* Both channels report their data from the DMA callback, except for the sink channel in polled mode
+       where the received byte count is sampled from the channel status. */
+#if (CY_FX_SINK_DISCARD_POLL_PERIOD != 0)
+    CyFxDmaStatsEnable (CY_FX_STATS_CH_SINK, &glChHandleBulkSink, 0);
+#else
+    CyFxDmaStatsEnable (CY_FX_STATS_CH_SINK, NULL, 0);
+#endif
+    CyFxDmaStatsEnable (CY_FX_STATS_CH_SRC, NULL, 0);
+
+    CyU3PUsbRegisterEpEvtCallback (CyFxBulkSrcSinkApplnEpEvtCB, CYU3P_USBEP_SS_RETRY_EVT, 0x00, 0x02);
+    CyFxBulkSrcSinkFillInBuffers ();
+
+    /* Update the flag so that the application thread is notified of this. */
+    glIsApplnActive = CyTrue;
+}
+
+/* Change the DMA channel geometry at runtime. If the application is active, the channels are
+ * re-created and the endpoints re-configured without a re-enumeration; the host should then clear
+ * the halt on both endpoints to re-synchronize the data toggles / sequence numbers. The request is
+ * rejected if the new buffers cannot fit in the buffer heap, and the previous geometry is restored
+ * if the channels cannot be created. Otherwise the new geometry is stored and applied at the next
+ * SET_CONFIGURATION. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkSetGeometry (
+        uint8_t  burstLen,
+        uint8_t  sizeMult,
+        uint16_t bufCount)
+{
+    CyFxBulkSrcSinkGeometry_t prevGeometry = glDmaGeometry;
+    CyU3PHeapStats_t bufStats;
+    CyU3PReturnStatus_t apiRetStatus;
+    uint32_t pktSize, bufSize, needed, held = 0;
+
+    /* The burst length cannot exceed the value in the SS endpoint companion descriptors. At super speed the
+       endpoint burst must match bMaxBurst exactly, as the host may send a full burst at any time; this also
+       applies when not connected, as the geometry is then used for the next connection. At high and full
+       speed the burst length only scales the DMA buffer size. */
+    if ((burstLen == 0) || (burstLen > CY_FX_EP_BURST_LENGTH) || (sizeMult == 0) || (bufCount == 0))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    if ((burstLen != CY_FX_EP_BURST_LENGTH) && ((!glIsApplnActive) || (CyU3PUsbGetSpeed () == CY_U3P_SUPER_SPEED)))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    pktSize = (glDmaGeometry.pktSize != 0) ? glDmaGeometry.pktSize : 1024;
+    bufSize = pktSize * burstLen * sizeMult;
+    if (bufSize > 0xFFFF)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    /* Both channels use bufCount buffers, rounded up to whole cache lines. The buffers held by the
+       current channels are freed before the new ones are allocated. */
+    needed = 2 * bufCount * ((bufSize + 31) & ~31U);
+    if (glIsApplnActive)
+        held = 2 * prevGeometry.bufCount * ((prevGeometry.bufSize + 31) & ~31U);
+
+    apiRetStatus = CyU3PBufGetStats (&bufStats);
     if (apiRetStatus != CY_U3P_SUCCESS)
+        return apiRetStatus;
+    if (needed > (bufStats.freeBytes + held))
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelSetXfer failed, Error code = %d\n", apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        CyU3PDebugPrint (4, "DMA geometry needs %d bytes, only %d available\r\n", needed, bufStats.freeBytes + held);
+        return CY_U3P_ERROR_MEMORY_ERROR;
     }
 
-    apiRetStatus = CyU3PDmaChannelSetXfer (&glChHandleBulkSrc, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+    glDmaGeometry.burstLen = burstLen;
+    glDmaGeometry.sizeMult = sizeMult;
+    glDmaGeometry.bufCount = bufCount;
+    if (!glIsApplnActive)
+        return CY_U3P_SUCCESS;
+
+    /* Stop the data flow and release the current channels. */
+    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER, CyTrue);
+    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyTrue);
+    CyU3PBusyWait (125);
+
+    CyFxDmaStatsResetBegin (CY_FX_STATS_CH_SINK);
+    CyU3PDmaChannelDestroy (&glChHandleBulkSink);
+    CyU3PDmaChannelDestroy (&glChHandleBulkSrc);
+    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
+    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+
+    apiRetStatus = CyFxBulkSrcSinkEpConfig ();
+    if (apiRetStatus == CY_U3P_SUCCESS)
+        apiRetStatus = CyFxBulkSrcSinkChannelCreate ();
     if (apiRetStatus != CY_U3P_SUCCESS)
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelSetXfer failed, Error code = %d\n", apiRetStatus);
-        CyFxAppErrorHandler(apiRetStatus);
+        /* The buffer heap is too fragmented for the new buffers. Go back to the previous geometry,
+           whose buffers have just been freed. */
+        glDmaGeometry = prevGeometry;
+        if ((CyFxBulkSrcSinkEpConfig () != CY_U3P_SUCCESS) || (CyFxBulkSrcSinkChannelCreate () != CY_U3P_SUCCESS))
+            CyFxAppErrorHandler (apiRetStatus);
     }
+    CyFxDmaStatsResetEnd (CY_FX_STATS_CH_SINK);
 
-    CyU3PUsbRegisterEpEvtCallback (CyFxBulkSrcSinkApplnEpEvtCB, CYU3P_USBEP_SS_RETRY_EVT, 0x00, 0x02);
+    CyU3PUsbResetEp (CY_FX_EP_PRODUCER);
+    CyU3PUsbResetEp (CY_FX_EP_CONSUMER);
+    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER, CyFalse);
+    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyFalse);
     CyFxBulkSrcSinkFillInBuffers ();
 
-    /* Update the flag so that the application thread is notified of this. */
-    glIsApplnActive = CyTrue;
+    CyU3PDebugPrint (4, "DMA geometry: burst %d, %d x %d byte buffers\r\n", glDmaGeometry.burstLen,
+            glDmaGeometry.bufCount, glDmaGeometry.bufSize);
+    return apiRetStatus;
+}
+
+/* Select the source data pattern. If the application is active, the source channel is reset and its
+ * buffers are filled again with the new pattern; the host should then clear the halt on the IN endpoint
+ * to re-synchronize the data toggle / sequence number. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkSetPattern (
+        uint8_t pattern)
+{
+    if (pattern >= CY_FX_SRC_PATTERN_COUNT)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    glSrcPattern = pattern;
+    if (glIsApplnActive)
+    {
+        CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyTrue);
+        CyU3PBusyWait (125);
+
+        CyU3PDmaChannelReset (&glChHandleBulkSrc);
+        CyU3PUsbFlushEp (CY_FX_EP_CONSUMER);
+        CyU3PUsbResetEp (CY_FX_EP_CONSUMER);
+        CyU3PDmaChannelSetXfer (&glChHandleBulkSrc, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+        CyFxBulkSrcSinkFillInBuffers ();
+
+        CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyFalse);
+    }
+
+    return CY_U3P_SUCCESS;
 }
 
 /* This function stops the application. This shall be called whenever a RESET
@@ -447,10 +1049,15 @@ CyFxBulkSrcSinkApplnStop (
 
     /* Update the flag so that the application thread is notified of this. */
     glIsApplnActive = CyFalse;
+    CyU3PTimerStop (&glEpRecoverTimer);
+    glEpRecoverState = CY_FX_EP_RECOVER_IDLE;
+    CyFxDmaStatsDisable (CY_FX_STATS_CH_SINK);
+    CyFxDmaStatsDisable (CY_FX_STATS_CH_SRC);
 
     /* Destroy the channels */
     CyU3PDmaChannelDestroy (&glChHandleBulkSink);
     CyU3PDmaChannelDestroy (&glChHandleBulkSrc);
+    glDmaGeometry.bufSize = 0;
 
     /* Flush the endpoint memory */
     CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
@@ -520,6 +1127,7 @@ CyFxBulkSrcSinkApplnUSBSetupCB (
                 {
                     glDataTransStarted = CyFalse;
                     glForceLinkU2      = CyTrue;
+                    CyU3PEventSet (&glBulkLpEvent, CYFX_USB_FORCE_U2_TASK, CYU3P_EVENT_OR);
                 }
                 else
                 {
@@ -541,57 +1149,50 @@ CyFxBulkSrcSinkApplnUSBSetupCB (
          * the EPs. The endpoint stall and toggle / sequence number is also expected to be
          * reset. Return CyFalse to make the library clear the stall and reset the endpoint
          * toggle. Or invoke the CyU3PUsbStall (ep, CyFalse, CyTrue) and return CyTrue.
-         * Here we are clearing the stall. */
+         *
+         * The reset is not done here, as it has to wait for the endpoint NAK to take effect.
+         * The endpoint is NAKed and the recovery timer is started; the application thread
+         * then resets the endpoint, clears the stall and completes the request. */
         if ((bTarget == CY_U3P_USB_TARGET_ENDPT) && (bRequest == CY_U3P_USB_SC_CLEAR_FEATURE)
                 && (wValue == CY_U3P_USBX_FS_EP_HALT))
         {
-            if (glIsApplnActive)
+            if ((glIsApplnActive) && (glEpRecoverState == CY_FX_EP_RECOVER_IDLE) &&
+                    ((wIndex == CY_FX_EP_PRODUCER) || (wIndex == CY_FX_EP_CONSUMER)))
             {
-                if (wIndex == CY_FX_EP_PRODUCER)
-                {
-                    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER, CyTrue);
-                    CyU3PBusyWait (125);
-
-                    CyU3PDmaChannelReset (&glChHandleBulkSink);
-                    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
-                    CyU3PUsbResetEp (CY_FX_EP_PRODUCER);
-                    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER, CyFalse);
-
-                    CyU3PDmaChannelSetXfer (&glChHandleBulkSink, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
-                    CyU3PUsbStall (wIndex, CyFalse, CyTrue);
-                    isHandled = CyTrue;
-                    CyU3PUsbAckSetup ();
-                }
-
-                if (wIndex == CY_FX_EP_CONSUMER)
-                {
-                    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyTrue);
-                    CyU3PBusyWait (125);
-
-                    CyU3PDmaChannelReset (&glChHandleBulkSrc);
-                    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
-                    CyU3PUsbResetEp (CY_FX_EP_CONSUMER);
-                    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyFalse);
-
-                    CyU3PDmaChannelSetXfer (&glChHandleBulkSrc, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
-                    CyU3PUsbStall (wIndex, CyFalse, CyTrue);
-                    isHandled = CyTrue;
-                    CyU3PUsbAckSetup ();
-
-                    CyFxBulkSrcSinkFillInBuffers ();
-                }
+                CyU3PUsbSetEpNak (wIndex, CyTrue);
+
+                glEpRecoverEp    = wIndex;
+                glEpRecoverState = CY_FX_EP_RECOVER_WAIT;
+                CyU3PTimerStop (&glEpRecoverTimer);
+                CyU3PTimerModify (&glEpRecoverTimer, CY_FX_EP_RECOVER_TICKS, 0);
+                CyU3PTimerStart (&glEpRecoverTimer);
+                isHandled = CyTrue;
             }
         }
     }
 
     if ((bType == CY_U3P_USB_VENDOR_RQT) && (bTarget == CY_U3P_USB_TARGET_DEVICE))
     {
-        /* We set an event here and let the application thread below handle these requests.
-         * isHandled needs to be set to True, so that the driver does not stall EP0. */
-        isHandled = CyTrue;
-        gl_setupdat0 = setupdat0;
-        gl_setupdat1 = setupdat1;
-        CyU3PEventSet (&glBulkLpEvent, CYFX_USB_CTRL_TASK, CYU3P_EVENT_OR);
+        /* Requests which are not in the table are left unhandled, so that the driver stalls EP0. Requests
+         * which can be completed without blocking are handled here; the others are passed to the application
+         * thread. isHandled needs to be set to True, so that the driver does not stall EP0. */
+        const CyFxVendorRqt_t *rqt_p = CyFxVendorFind (glVendorRqtTable, glVendorRqtCount, bRequest);
+
+        if (rqt_p != NULL)
+        {
+            isHandled = CyTrue;
+            if (rqt_p->context == CY_FX_VENDOR_CTX_CALLBACK)
+            {
+                CyFxVendorDispatch (rqt_p, setupdat0, setupdat1, glEp0Buffer, sizeof (glEp0Buffer));
+            }
+            else
+            {
+                gl_setupdat0  = setupdat0;
+                gl_setupdat1  = setupdat1;
+                glVendorRqt_p = rqt_p;
+                CyU3PEventSet (&glBulkLpEvent, CYFX_USB_CTRL_TASK, CYU3P_EVENT_OR);
+            }
+        }
     }
 
     return isHandled;
@@ -606,6 +1207,9 @@ CyFxBulkSrcSinkApplnUSBEventCB (
 {
     CyU3PDebugPrint (2, "USB EVENT: %d %d\r\n", evtype, evdata);
 
+    /* The USB driver logs its state changes along with the events, so check the log for new entries. */
+    CyU3PEventSet (&glBulkLpEvent, CYFX_USB_LOG_TASK, CYU3P_EVENT_OR);
+
     switch (evtype)
     {
     case CY_U3P_USB_EVENT_CONNECT:
@@ -643,8 +1247,8 @@ CyFxBulkSrcSinkApplnUSBEventCB (
     case CY_U3P_USB_EVENT_VBUS_REMOVED:
         if (StandbyModeEnable)
         {
-            TriggerStandbyMode = CyTrue;
-            StandbyModeEnable  = CyFalse;
+            StandbyModeEnable = CyFalse;
+            CyU3PEventSet (&glBulkLpEvent, CYFX_USB_STANDBY_TASK, CYU3P_EVENT_OR);
         }
         break;
 
@@ -668,6 +1272,38 @@ CyFxBulkSrcSinkApplntCB (
     return CyTrue;
 }
 
+/* Advance the USB driver log write position by the number of bytes logged since the last call. This is
+   called from the application thread when the LPM governor timer has seen the driver log index move, and
+   before each log read. If the previous update is too long ago to rule out a wrap of the ring, a gap is
+   recorded at the current write position. */
+static void
+CyFxBulkSrcSinkUsbLogUpdate (
+        void)
+{
+    uint32_t now;
+    uint16_t index;
+
+    if (gl_UsbLogBuffer == NULL)
+        return;
+
+    now   = CyU3PGetTime ();
+    index = CyU3PUsbGetEventLogIndex ();
+    /* The governor timer can refresh the update time after now was read, so the difference can be negative. */
+    if ((int32_t)(now - glUsbLogUpdateTime) > CYFX_USBLOG_MAX_GAP)
+    {
+        /* The ring may have been overwritten any number of times: only the bytes counted from here on
+           are known to match their positions. */
+        glUsbLogStartPos = glUsbLogWritePos;
+        glUsbLogGapPos   = glUsbLogWritePos;
+        glUsbLogGap      = CyTrue;
+    }
+
+    glUsbLogWritePos  += (uint16_t)((index + CYFX_USBLOG_SIZE - glUsbLogIndex) % CYFX_USBLOG_SIZE);
+    glUsbLogIndex      = index;
+    glUsbLogUpdateTime = now;
+    glUsbLogQuiet      = CyTrue;
+}
+
 /* This function initializes the USB Module, sets the enumeration descriptors.
  * This function does not start the bulk streaming and this is done only when
  * SET_CONF event is received. */
@@ -783,10 +1419,21 @@ CyFxBulkSrcSinkApplnInit (void)
         CyFxAppErrorHandler(apiRetStatus);
     }
 
-    /* Register a buffer into which the USB driver can log relevant events. */
-    gl_UsbLogBuffer = (uint8_t *)CyU3PDmaBufferAlloc (CYFX_USBLOG_SIZE);
+    /* Register a buffer into which the USB driver can log relevant events. The buffer is kept
+       across re-initialization, and is taken from the boot time arena when first allocated. */
+    if (gl_UsbLogBuffer == NULL)
+        gl_UsbLogBuffer = (uint8_t *)CyU3PMemArenaAlloc (CYFX_USBLOG_SIZE);
+    else
+        CyFxBulkSrcSinkUsbLogUpdate ();
     if (gl_UsbLogBuffer)
+    {
+        /* The driver starts again from the start of the buffer, so the log positions are carried over. */
         CyU3PUsbInitEventLog (gl_UsbLogBuffer, CYFX_USBLOG_SIZE);
+        glUsbLogIndex      = 0;
+        glUsbLogStartPos   = glUsbLogWritePos;
+        glUsbLogUpdateTime = CyU3PGetTime ();
+        glUsbLogQuiet      = CyTrue;
+    }
 
     CyU3PDebugPrint (4, "About to connect to USB host\r\n");
 
@@ -825,28 +1472,584 @@ CyFxBulkSrcSinkApplnDeinit (
     CyU3PThreadSleep (1000);
 }
 
+/* Second half of the CLEAR_FEATURE(EP_HALT) handling, run by the application thread once the
+ * endpoint NAK has taken effect. The DMA channel and endpoint are reset, the channel is re-armed,
+ * the stall and data toggle / sequence number are cleared, and the control request is completed. */
+static void
+CyFxBulkSrcSinkEpRecover (
+        void)
+{
+    uint16_t ep = glEpRecoverEp;
+
+    if ((glEpRecoverState != CY_FX_EP_RECOVER_RESET) || (!glIsApplnActive))
+        return;
+
+    if (ep == CY_FX_EP_PRODUCER)
+    {
+        CyFxDmaStatsResetBegin (CY_FX_STATS_CH_SINK);
+        CyU3PDmaChannelReset (&glChHandleBulkSink);
+        CyFxDmaStatsResetEnd (CY_FX_STATS_CH_SINK);
+        CyU3PUsbFlushEp (CY_FX_EP_PRODUCER);
+        CyU3PUsbResetEp (CY_FX_EP_PRODUCER);
+        CyU3PDmaChannelSetXfer (&glChHandleBulkSink, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+    }
+    else
+    {
+        CyU3PDmaChannelReset (&glChHandleBulkSrc);
+        CyU3PUsbFlushEp (CY_FX_EP_CONSUMER);
+        CyU3PUsbResetEp (CY_FX_EP_CONSUMER);
+        CyU3PDmaChannelSetXfer (&glChHandleBulkSrc, CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+        CyFxBulkSrcSinkFillInBuffers ();
+    }
+
+    CyU3PUsbStall (ep, CyFalse, CyTrue);
+    CyU3PUsbSetEpNak (ep, CyFalse);
+    glEpRecoverState = CY_FX_EP_RECOVER_IDLE;
+    CyU3PUsbAckSetup ();
+}
+
+/* Vendor request handlers. See cyfxvendor.h for the handler interface; the table that follows the handlers
+ * gives the direction, maximum length and context of each request. */
+
+/* 0x76: Return a running count of these requests, its complement and a fixed signature. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtCount (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    (*data_p)[0] = glVendorRqtCnt;
+    (*data_p)[1] = ~glVendorRqtCnt;
+    (*data_p)[2] = 1;
+    (*data_p)[3] = 5;
+    *length_p    = 4;
+    glVendorRqtCnt++;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x77: Trigger remote wakeup. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtRemoteWake (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PEventSet (&glBulkLpEvent, CYFX_USB_HOSTWAKE_TASK, CYU3P_EVENT_OR);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x78: Get count of EP0 status events received. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtEp0StatCount (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    uint32_t count = glEp0StatCount;
+
+    CyU3PMemCopy (*data_p, (uint8_t *)&count, 4);
+    *length_p = 4;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x79: Request with no data phase. Insert a delay and then ACK the request. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtDelayedAck (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (5);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x80: Request with OUT data phase. The data is ignored. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtOutData (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x81: Get the current event log index. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtLogIndex (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    uint16_t index;
+
+    if (setup_p->wLength != 2)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    index = CyU3PUsbGetEventLogIndex ();
+    CyU3PMemCopy (*data_p, (uint8_t *)&index, 2);
+    *length_p = 2;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x82: Send the USB event log buffer content to the host, straight from the log buffer. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtLogRead (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    if (gl_UsbLogBuffer == NULL)
+        return CY_U3P_ERROR_NOT_STARTED;
+
+    *data_p = gl_UsbLogBuffer;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x8B: Read the USB driver log from the log position in wIndex:wValue, as a CyFxUsbLogChunkHdr_t followed
+   by the log bytes. See CY_FX_USBLOG_CHUNK_SIZE for the read protocol. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtLogStream (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyFxUsbLogChunkHdr_t *hdr_p = (CyFxUsbLogChunkHdr_t *)glUsbLogChunk;
+    uint32_t pos, reqPos, oldest, count, first;
+    uint16_t index;
+
+    if ((gl_UsbLogBuffer == NULL) || (*length_p < sizeof (CyFxUsbLogChunkHdr_t)))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    CyFxBulkSrcSinkUsbLogUpdate ();
+
+    /* Find the oldest byte that can still be returned. */
+    oldest = glUsbLogStartPos;
+    if ((glUsbLogWritePos - oldest) > (CYFX_USBLOG_SIZE - CYFX_USBLOG_GUARD))
+        oldest = glUsbLogWritePos - (CYFX_USBLOG_SIZE - CYFX_USBLOG_GUARD);
+
+    /* Restart from the oldest byte if the requested position is not in the log. */
+    reqPos = ((uint32_t)setup_p->wIndex << 16) | (uint32_t)setup_p->wValue;
+    pos    = reqPos;
+    hdr_p->lostCnt = 0;
+    if ((glUsbLogWritePos - pos) > (glUsbLogWritePos - oldest))
+    {
+        if ((int32_t)(glUsbLogWritePos - pos) > 0)
+            hdr_p->lostCnt = oldest - pos;
+        pos = oldest;
+    }
+
+    /* A read from a position up to a recorded gap cannot tell how many bytes were missed. The gap is
+       reported once, so that a reader which has caught up with the log does not see it again. */
+    if ((glUsbLogGap) && ((int32_t)(glUsbLogWritePos - reqPos) >= 0) && ((int32_t)(glUsbLogGapPos - reqPos) >= 0))
+    {
+        hdr_p->lostCnt = CY_FX_USBLOG_LOST_UNKNOWN;
+        glUsbLogGap    = CyFalse;
+    }
+
+    /* Copy the log bytes out of the ring, which may wrap once. */
+    count = glUsbLogWritePos - pos;
+    if (count > (uint32_t)(*length_p - sizeof (CyFxUsbLogChunkHdr_t)))
+        count = *length_p - sizeof (CyFxUsbLogChunkHdr_t);
+
+    index = (uint16_t)((glUsbLogIndex + CYFX_USBLOG_SIZE - (glUsbLogWritePos - pos)) % CYFX_USBLOG_SIZE);
+    first = ((uint32_t)(CYFX_USBLOG_SIZE - index) < count) ? (uint32_t)(CYFX_USBLOG_SIZE - index) : count;
+    CyU3PMemCopy (glUsbLogChunk + sizeof (CyFxUsbLogChunkHdr_t), gl_UsbLogBuffer + index, first);
+    if (count > first)
+        CyU3PMemCopy (glUsbLogChunk + sizeof (CyFxUsbLogChunkHdr_t) + first, gl_UsbLogBuffer, count - first);
+
+    hdr_p->readPos  = pos;
+    hdr_p->writePos = glUsbLogWritePos;
+    hdr_p->length   = count;
+
+    *data_p   = glUsbLogChunk;
+    *length_p = (uint16_t)(sizeof (CyFxUsbLogChunkHdr_t) + count);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x83: Read the device register at address (wValue << 16) | wIndex. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtRegRead (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    uint32_t addr = ((uint32_t)setup_p->wValue << 16) | (uint32_t)setup_p->wIndex;
+
+    CyU3PReadDeviceRegisters ((uvint32_t *)addr, 1, (uint32_t *)*data_p);
+    *length_p = 4;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x84: Get the boot firmware version as three bytes: major, minor and patch. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtBooterVersion (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    uint8_t major, minor, patch;
+
+    if (CyU3PUsbGetBooterVersion (&major, &minor, &patch) != CY_U3P_SUCCESS)
+        return CY_U3P_ERROR_FAILURE;
+
+    (*data_p)[0] = major;
+    (*data_p)[1] = minor;
+    (*data_p)[2] = patch;
+    *length_p    = 3;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x85: Send the driver heap and buffer heap usage statistics to the host. The response holds two
+   CyU3PHeapStats_t structures (driver heap first), each consisting of seven little-endian 32 bit words. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtHeapStats (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PHeapStats_t *heapStats = (CyU3PHeapStats_t *)*data_p;
+
+    if ((setup_p->wLength == 0) || (CyU3PMemGetStats (&heapStats[0]) != CY_U3P_SUCCESS) ||
+            (CyU3PBufGetStats (&heapStats[1]) != CY_U3P_SUCCESS))
+        return CY_U3P_ERROR_FAILURE;
+
+    *length_p = 2 * sizeof (CyU3PHeapStats_t);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x86: Change the DMA channel geometry: wValue = (size multiplier << 8) | burst length, wIndex = number of
+   buffers per channel. The geometry in effect after the request is returned as a CyFxBulkSrcSinkGeometry_t.
+   EP0 is stalled and the previous geometry kept if the request is invalid or does not fit in the buffer heap. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtSetGeometry (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    if ((setup_p->wLength == 0) || (CyFxBulkSrcSinkSetGeometry ((uint8_t)(setup_p->wValue & 0xFF),
+                    (uint8_t)(setup_p->wValue >> 8), setup_p->wIndex) != CY_U3P_SUCCESS))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    CyU3PMemCopy (*data_p, (uint8_t *)&glDmaGeometry, sizeof (glDmaGeometry));
+    *length_p = sizeof (glDmaGeometry);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x87: Get the current DMA channel geometry as a CyFxBulkSrcSinkGeometry_t. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtGetGeometry (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PMemCopy (*data_p, (uint8_t *)&glDmaGeometry, sizeof (glDmaGeometry));
+    *length_p = sizeof (glDmaGeometry);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x88: Read the DMA statistics for the channel selected by wIndex (0 = sink, 1 = source) as a CyFxDmaStats_t:
+   nine little-endian 32 bit words. The statistics are cleared after the read if bit 0 of wValue is set. EP0 is
+   stalled for an invalid channel. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtDmaStats (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    if ((setup_p->wLength == 0) || (CyFxDmaStatsGet ((uint8_t)setup_p->wIndex, (CyFxDmaStats_t *)*data_p,
+                    (CyBool_t)(setup_p->wValue & 0x01)) != CY_U3P_SUCCESS))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    *length_p = sizeof (CyFxDmaStats_t);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x89: Select the source data pattern (CY_FX_SRC_PATTERN_*) using wValue. The selected pattern is returned
+   as a single byte if there is a data phase. EP0 is stalled if the pattern is not valid. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtSrcPattern (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    if ((setup_p->wValue >= CY_FX_SRC_PATTERN_COUNT) ||
+            (CyFxBulkSrcSinkSetPattern ((uint8_t)setup_p->wValue) != CY_U3P_SUCCESS))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    (*data_p)[0] = glSrcPattern;
+    *length_p    = 1;
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x8A: Sink data verification. If wIndex is 1, the verification mode is set to wValue (CY_FX_SINK_VERIFY_*)
+   and the results are cleared; if wIndex is 0 the results are only read. The results are returned as a
+   CyFxSinkVerifyStats_t. EP0 is stalled if the mode is not valid. The results are cleared and copied with
+   interrupts locked out, so that a buffer being verified in the DMA callback is either counted in full
+   before the clear, or not counted at all. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtSinkVerify (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    uint32_t intMask;
+
+    if ((setup_p->wIndex == 1) && (setup_p->wValue >= CY_FX_SINK_VERIFY_COUNT))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    intMask = CyFxBulkSrcSinkIrqLock ();
+    if (setup_p->wIndex == 1)
+    {
+        glSinkVerify.mode           = setup_p->wValue;
+        glSinkVerify.goodCnt        = 0;
+        glSinkVerify.badCnt         = 0;
+        glSinkVerify.firstErrBuf    = 0xFFFFFFFF;
+        glSinkVerify.firstErrOffset = 0xFFFFFFFF;
+        glSinkVerifyGen++;
+    }
+
+    CyU3PMemCopy (*data_p, (uint8_t *)&glSinkVerify, sizeof (glSinkVerify));
+    CyFxBulkSrcSinkIrqUnlock (intMask);
+
+    *length_p = sizeof (glSinkVerify);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x8C: Read the histogram of source buffers committed per recycle pass: an array of CY_FX_SRC_RECYCLE_HIST_SIZE
+   little-endian 32 bit counts, followed by the number of polled mode recycle ticks which found the previous
+   recycle still pending. The counts are cleared after the read if bit 0 of wValue is set. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtRecycleHist (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PMemCopy (*data_p, (uint8_t *)glSrcRecycleHist, sizeof (glSrcRecycleHist));
+    CyU3PMemCopy (*data_p + sizeof (glSrcRecycleHist), (uint8_t *)&glSrcRecycleLate, sizeof (glSrcRecycleLate));
+    if (setup_p->wValue & 0x01)
+    {
+        CyU3PMemSet ((uint8_t *)glSrcRecycleHist, 0, sizeof (glSrcRecycleHist));
+        glSrcRecycleLate = 0;
+    }
+
+    *length_p = sizeof (glSrcRecycleHist) + sizeof (glSrcRecycleLate);
+    return CY_U3P_SUCCESS;
+}
+
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+/* 0x8D: Read the heap scrub results as a CyFxHeapScrubReport_t. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtHeapScrub (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PMutexGet (&glHeapScrubLock, CYU3P_WAIT_FOREVER);
+    CyU3PMemCopy (*data_p, (uint8_t *)&glHeapScrub, sizeof (glHeapScrub));
+    CyU3PMutexPut (&glHeapScrubLock);
+
+    *length_p = sizeof (glHeapScrub);
+    return CY_U3P_SUCCESS;
+}
+#endif
+
+/* 0x8E: Read the application thread wakeup counters as a CyFxAppWakeStats_t. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtAppWake (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    glAppWake.uptime = CyU3PGetTime ();
+    CyU3PMemCopy (*data_p, (uint8_t *)&glAppWake, sizeof (glAppWake));
+
+    *length_p = sizeof (glAppWake);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0x90: Switch control back to the boot firmware. Does not return. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtJumpToBooter (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (10);
+
+    /* Get rid of the DMA channels and EP configuration. */
+    CyFxBulkSrcSinkApplnStop ();
+
+    /* De-initialize the Debug and UART modules. */
+    CyU3PDebugDeInit ();
+    CyU3PUartDeInit ();
+
+    /* Now jump back to the boot firmware image. */
+    CyU3PUsbSetBooterSwitch (CyTrue);
+    CyU3PUsbJumpBackToBooter (0x40078000);
+    while (1)
+        CyU3PThreadSleep (100);
+
+    return CY_U3P_SUCCESS;
+}
+
+/* 0xB1: Switch to a USB 2.0 Connection. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtUsb2Connect (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (1000);
+    CyFxBulkSrcSinkApplnStop ();
+    CyU3PConnectState (CyFalse, CyTrue);
+    CyU3PThreadSleep (100);
+    CyU3PConnectState (CyTrue, CyFalse);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0xB2: Switch to a USB 3.0 connection. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtUsb3Connect (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (100);
+    CyFxBulkSrcSinkApplnStop ();
+    CyU3PConnectState (CyFalse, CyTrue);
+    CyU3PThreadSleep (10);
+    CyU3PConnectState (CyTrue, CyTrue);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0xB3: Stop and restart the USB block. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtUsbRestart (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (100);
+    CyFxBulkSrcSinkApplnDeinit ();
+    CyFxBulkSrcSinkApplnInit ();
+    return CY_U3P_SUCCESS;
+}
+
+/* 0xE0: Reset the FX3 device. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtDeviceReset (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (2000);
+    CyU3PConnectState (CyFalse, CyTrue);
+    CyU3PThreadSleep (1000);
+    CyU3PDeviceReset (CyFalse);
+    CyU3PThreadSleep (1000);
+    return CY_U3P_SUCCESS;
+}
+
+/* 0xE1: Place FX3 in standby when VBus is next disconnected. */
+static CyU3PReturnStatus_t
+CyFxBulkSrcSinkRqtStandbyEnable (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    StandbyModeEnable = CyTrue;
+    return CY_U3P_SUCCESS;
+}
+
+/* Vendor request table, sorted by bRequest. Requests which only read or update application state run in the
+ * setup callback; requests which sleep, call into the heap or reconfigure the channels, and requests with an
+ * OUT data phase, are deferred to the application thread. */
+const CyFxVendorRqt_t glVendorRqtTable[] = {
+    {0x76, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, 4, CyFxBulkSrcSinkRqtCount},
+    {0x77, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_CALLBACK, CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtRemoteWake},
+    {0x78, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, 4, CyFxBulkSrcSinkRqtEp0StatCount},
+    {0x79, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   0, 0, CyFxBulkSrcSinkRqtDelayedAck},
+    {0x80, CY_FX_VENDOR_DIR_OUT,  CY_FX_VENDOR_CTX_THREAD,   0, sizeof (glEp0Buffer), CyFxBulkSrcSinkRqtOutData},
+    {0x81, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, 2, CyFxBulkSrcSinkRqtLogIndex},
+    {0x82, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, CYFX_USBLOG_SIZE, CyFxBulkSrcSinkRqtLogRead},
+    {0x83, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, 4, CyFxBulkSrcSinkRqtRegRead},
+    {0x84, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_THREAD,   0, 3, CyFxBulkSrcSinkRqtBooterVersion},
+    {0x85, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_THREAD,   0, 2 * sizeof (CyU3PHeapStats_t), CyFxBulkSrcSinkRqtHeapStats},
+    {0x86, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_THREAD,   0, sizeof (CyFxBulkSrcSinkGeometry_t), CyFxBulkSrcSinkRqtSetGeometry},
+    {0x87, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (CyFxBulkSrcSinkGeometry_t), CyFxBulkSrcSinkRqtGetGeometry},
+    {0x88, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (CyFxDmaStats_t), CyFxBulkSrcSinkRqtDmaStats},
+    {0x89, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_THREAD,   0, 1, CyFxBulkSrcSinkRqtSrcPattern},
+    {0x8A, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (CyFxSinkVerifyStats_t), CyFxBulkSrcSinkRqtSinkVerify},
+    {0x8B, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_THREAD,   0, sizeof (CyFxUsbLogChunkHdr_t) + CY_FX_USBLOG_CHUNK_SIZE, CyFxBulkSrcSinkRqtLogStream},
+    {0x8C, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (glSrcRecycleHist) + sizeof (uint32_t), CyFxBulkSrcSinkRqtRecycleHist},
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+    {0x8D, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_THREAD,   0, sizeof (CyFxHeapScrubReport_t), CyFxBulkSrcSinkRqtHeapScrub},
+#endif
+    {0x8E, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (CyFxAppWakeStats_t), CyFxBulkSrcSinkRqtAppWake},
+    {0x90, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtJumpToBooter},
+    {0xB1, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtUsb2Connect},
+    {0xB2, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtUsb3Connect},
+    {0xB3, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtUsbRestart},
+    {0xE0, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtDeviceReset},
+    {0xE1, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_CALLBACK, CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkSrcSinkRqtStandbyEnable}
+};
+const uint16_t glVendorRqtCount = sizeof (glVendorRqtTable) / sizeof (glVendorRqtTable[0]);
+
 /* Entry function for the BulkSrcSinkAppThread. */
 void
 BulkSrcSinkAppThread_Entry (
         uint32_t input)
 {
     CyU3PReturnStatus_t stat;
-    uint32_t eventMask = CYFX_USB_CTRL_TASK | CYFX_USB_HOSTWAKE_TASK;   /* Events that we are interested in. */
+    uint32_t eventMask = CYFX_USB_CTRL_TASK | CYFX_USB_HOSTWAKE_TASK |
+        CYFX_USB_EP_RECOVER_TASK | CYFX_USB_EP_FLUSH_TASK | CYFX_USB_FORCE_U2_TASK |
+        CYFX_USB_STANDBY_TASK | CYFX_USB_LOG_TASK | CYFX_SINK_DISCARD_TASK |
+        CYFX_SRC_RECYCLE_TASK;                                          /* Events that we are interested in. */
     uint32_t eventStat;                                                 /* Current status of the events. */
-    uint8_t  vendorRqtCnt = 0;
-
-    uint16_t prevUsbLogIndex = 0, tmp1, tmp2;
+    uint32_t logPos;
     CyU3PUsbLinkPowerMode curState;
 
     /* Initialize the debug module */
     CyFxBulkSrcSinkApplnDebugInit();
     CyU3PDebugPrint (1, "\n\ndebug initialized\r\n");
 
+    /* Create the 1 ms sampling timer for the DMA statistics. This has to be done before the device connects,
+       as the channels are enabled for tracking on SET_CONFIGURATION; the timer only runs while they are. */
+    stat = CyFxDmaStatsInit ();
+    if (stat != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "DMA statistics timer create failed, Error code = %d\n", stat);
+    }
+
     /* Initialize the application */
     CyFxBulkSrcSinkApplnInit();
 
-    /* Create a timer with 100 ms expiry to enable/disable LPM transitions */ 
-    CyU3PTimerCreate (&glLpmTimer, TimerCb, 0, 100, 100, CYU3P_NO_ACTIVATE);
+    /* Build the CRC32 tables used by the sink data verification. */
+    CyFxCrc32Init ();
+
+    /* All permanent allocations have been made. Return the unused arena space to the buffer heap. */
+    CyU3PDebugPrint (4, "Boot arena size = %d bytes\r\n", CyU3PMemArenaSeal ());
+
+    /* Create the periodic LPM governor timer which enables/disables LPM transitions based on the DMA activity. */
+    CyFxLpmGovInit (&glLpmGov, CY_FX_LPM_GOVERNOR_PERIOD, CY_FX_LPM_IDLE_TIMEOUT);
+    CyU3PTimerCreate (&glLpmTimer, TimerCb, 0, CY_FX_LPM_GOVERNOR_PERIOD, CY_FX_LPM_GOVERNOR_PERIOD,
+            CYU3P_AUTO_ACTIVATE);
+
+    /* Create the one-shot timer used for the CLEAR_FEATURE(EP_HALT) recovery. It is started by the setup callback. */
+    CyU3PTimerCreate (&glEpRecoverTimer, CyFxBulkSrcSinkEpRecoverTimerCb, 0, CY_FX_EP_RECOVER_TICKS, 0,
+            CYU3P_NO_ACTIVATE);
+
+#if (CY_FX_SRC_RECYCLE_POLL_PERIOD != 0)
+    /* Create the timer used to recycle the source buffers. */
+    CyU3PTimerCreate (&glSrcRecycleTimer, CyFxBulkSrcSinkRecycleTimerCb, 0, CY_FX_SRC_RECYCLE_POLL_PERIOD,
+            CY_FX_SRC_RECYCLE_POLL_PERIOD, CYU3P_AUTO_ACTIVATE);
+#endif
+
+#if (CY_FX_SINK_DISCARD_POLL_PERIOD != 0)
+    /* Create the timer used to discard the sink buffers. */
+    CyU3PTimerCreate (&glSinkDiscardTimer, CyFxBulkSrcSinkDiscardTimerCb, 0, CY_FX_SINK_DISCARD_POLL_PERIOD,
+            CY_FX_SINK_DISCARD_POLL_PERIOD, CYU3P_AUTO_ACTIVATE);
+#endif
 
     for (;;)
     {
@@ -854,12 +2057,27 @@ BulkSrcSinkAppThread_Entry (
            The eventStat variable will hold the events that were active at the time of returning from this API.
            The CLEAR flag means that all events will be atomically cleared before this function returns.
 
-           We cause this event wait to time out every 10 milli-seconds, so that we can periodically get the FX3
-           device out of low power modes.
+           Every action taken by this thread is signalled through the event group, so the thread blocks until
+           there is something to do: the governor timer only signals the USB driver log task when the driver
+           has logged new events. The only timeout is used while the link is being pushed into U2, so that the
+           link state can be checked again.
            */
-        stat = CyU3PEventGet (&glBulkLpEvent, eventMask, CYU3P_EVENT_OR_CLEAR, &eventStat, 10);
-        if (stat == CY_U3P_SUCCESS)
+        eventStat = 0;
+        stat = CyU3PEventGet (&glBulkLpEvent, eventMask, CYU3P_EVENT_OR_CLEAR, &eventStat,
+                (glForceLinkU2) ? CYFX_FORCE_U2_POLL_PERIOD : CYU3P_WAIT_FOREVER);
+        glAppWake.wakeups++;
+        if (stat != CY_U3P_SUCCESS)
         {
+            glAppWake.timeouts++;
+            eventStat = (glForceLinkU2) ? CYFX_USB_FORCE_U2_TASK : 0;
+        }
+
+        if (eventStat & (CYFX_USB_CTRL_TASK | CYFX_USB_HOSTWAKE_TASK | CYFX_USB_EP_RECOVER_TASK))
+        {
+            /* Complete any pending endpoint halt recovery first, as the host is waiting for it. */
+            if (eventStat & CYFX_USB_EP_RECOVER_TASK)
+                CyFxBulkSrcSinkEpRecover ();
+
             /* If the HOSTWAKE task is set, send a DEV_NOTIFICATION (FUNCTION_WAKE) or remote wakeup signalling
                based on the USB connection speed. */
             if (eventStat & CYFX_USB_HOSTWAKE_TASK)
@@ -874,188 +2092,31 @@ BulkSrcSinkAppThread_Entry (
                     CyU3PDebugPrint (2, "Remote wake attempt failed with code: %d\r\n", stat);
             }
 
-            /* If there is a pending control request, handle it here. */
+            /* If there is a pending vendor request, handle it here. */
             if (eventStat & CYFX_USB_CTRL_TASK)
-            {
-                uint8_t  bRequest, bReqType;
-                uint16_t wLength, temp;
-                uint16_t wValue, wIndex;
-
-                /* Decode the fields from the setup request. */
-                bReqType = (gl_setupdat0 & CY_U3P_USB_REQUEST_TYPE_MASK);
-                bRequest = ((gl_setupdat0 & CY_U3P_USB_REQUEST_MASK) >> CY_U3P_USB_REQUEST_POS);
-                wLength  = ((gl_setupdat1 & CY_U3P_USB_LENGTH_MASK)  >> CY_U3P_USB_LENGTH_POS);
-                wValue   = ((gl_setupdat0 & CY_U3P_USB_VALUE_MASK) >> CY_U3P_USB_VALUE_POS);
-                wIndex   = ((gl_setupdat1 & CY_U3P_USB_INDEX_MASK) >> CY_U3P_USB_INDEX_POS);
-
-                if ((bReqType & CY_U3P_USB_TYPE_MASK) == CY_U3P_USB_VENDOR_RQT)
-                {
-                    switch (bRequest)
-                    {
-                    case 0x76:
-                        glEp0Buffer[0] = vendorRqtCnt;
-                        glEp0Buffer[1] = ~vendorRqtCnt;
-                        glEp0Buffer[2] = 1;
-                        glEp0Buffer[3] = 5;
-                        CyU3PUsbSendEP0Data (wLength, glEp0Buffer);
-                        vendorRqtCnt++;
-                        break;
-
-                    case 0x77:      /* Trigger remote wakeup. */
-                        CyU3PUsbAckSetup ();
-                        CyU3PEventSet (&glBulkLpEvent, CYFX_USB_HOSTWAKE_TASK, CYU3P_EVENT_OR);
-                        break;
-
-                    case 0x78:      /* Get count of EP0 status events received. */
-                        CyU3PMemCopy ((uint8_t *)glEp0Buffer, ((uint8_t *)&glEp0StatCount), 4);
-                        CyU3PUsbSendEP0Data (4, glEp0Buffer);
-                        break;
-
-                    case 0x79:      /* Request with no data phase. Insert a delay and then ACK the request. */
-                        CyU3PThreadSleep (5);
-                        CyU3PUsbAckSetup ();
-                        break;
-
-                    case 0x80:      /* Request with OUT data phase. Just get the data and ignore it for now. */
-                        CyU3PUsbGetEP0Data (sizeof (glEp0Buffer), (uint8_t *)glEp0Buffer, &wLength);
-                        break;
-
-                    case 0x81:
-                        /* Get the current event log index and send it to the host. */
-                        if (wLength == 2)
-                        {
-                            temp = CyU3PUsbGetEventLogIndex ();
-                            CyU3PMemCopy ((uint8_t *)glEp0Buffer, (uint8_t *)&temp, 2);
-                            CyU3PUsbSendEP0Data (2, glEp0Buffer);
-                        }
-                        else
-                            CyU3PUsbStall (0, CyTrue, CyFalse);
-                        break;
-
-                    case 0x82:
-                        /* Send the USB event log buffer content to the host. */
-                        if (wLength != 0)
-                        {
-                            if (wLength < CYFX_USBLOG_SIZE)
-                                CyU3PUsbSendEP0Data (wLength, gl_UsbLogBuffer);
-                            else
-                                CyU3PUsbSendEP0Data (CYFX_USBLOG_SIZE, gl_UsbLogBuffer);
-                        }
-                        else
-                            CyU3PUsbAckSetup ();
-                        break;
-
-                    case 0x83:
-                        {
-                            uint32_t addr = ((uint32_t)wValue << 16) | (uint32_t)wIndex;
-                            CyU3PReadDeviceRegisters ((uvint32_t *)addr, 1, (uint32_t *)glEp0Buffer);
-                            CyU3PUsbSendEP0Data (4, glEp0Buffer);
-                        }
-                        break;
-
-                    case 0x84:
-                        {
-                            uint8_t major, minor, patch;
-
-                            if (CyU3PUsbGetBooterVersion (&major, &minor, &patch) == CY_U3P_SUCCESS)
-                            {
-                                glEp0Buffer[0] = major;
-                                glEp0Buffer[1] = minor;
-                                glEp0Buffer[2] = patch;
-                                CyU3PUsbSendEP0Data (3, glEp0Buffer);
-                            }
-                            else
-                                CyU3PUsbStall (0, CyTrue, CyFalse);
-                        }
-                        break;
-
-                    case 0x90:
-                        /* Request to switch control back to the boot firmware. */
-
-                        /* Complete the control request. */
-                        CyU3PUsbAckSetup ();
-                        CyU3PThreadSleep (10);
-
-                        /* Get rid of the DMA channels and EP configuration. */
-                        CyFxBulkSrcSinkApplnStop ();
-
-                        /* De-initialize the Debug and UART modules. */
-                        CyU3PDebugDeInit ();
-                        CyU3PUartDeInit ();
-
-                        /* Now jump back to the boot firmware image. */
-                        CyU3PUsbSetBooterSwitch (CyTrue);
-                        CyU3PUsbJumpBackToBooter (0x40078000);
-                        while (1)
-                            CyU3PThreadSleep (100);
-                        break;
-
-                    case 0xB1:
-                        /* Switch to a USB 2.0 Connection. */
-                        CyU3PUsbAckSetup ();
-                        CyU3PThreadSleep (1000);
-                        CyFxBulkSrcSinkApplnStop ();
-                        CyU3PConnectState (CyFalse, CyTrue);
-                        CyU3PThreadSleep (100);
-                        CyU3PConnectState (CyTrue, CyFalse);
-                        break;
-
-                    case 0xB2:
-                        /* Switch to a USB 3.0 connection. */
-                        CyU3PUsbAckSetup ();
-                        CyU3PThreadSleep (100);
-                        CyFxBulkSrcSinkApplnStop ();
-                        CyU3PConnectState (CyFalse, CyTrue);
-                        CyU3PThreadSleep (10);
-                        CyU3PConnectState (CyTrue, CyTrue);
-                        break;
-
-                    case 0xB3:
-                        /* Stop and restart the USB block. */
-                        CyU3PUsbAckSetup ();
-                        CyU3PThreadSleep (100);
-                        CyFxBulkSrcSinkApplnDeinit ();
-                        CyFxBulkSrcSinkApplnInit ();
-                        break;
-
-                    case 0xE0:
-                        /* Request to reset the FX3 device. */
-                        CyU3PUsbAckSetup ();
-                        CyU3PThreadSleep (2000);
-                        CyU3PConnectState (CyFalse, CyTrue);
-                        CyU3PThreadSleep (1000);
-                        CyU3PDeviceReset (CyFalse);
-                        CyU3PThreadSleep (1000);
-                        break;
-
-                    case 0xE1:
-                        /* Request to place FX3 in standby when VBus is next disconnected. */
-                        StandbyModeEnable = CyTrue;
-                        CyU3PUsbAckSetup ();
-                        break;
-
-                    default:        /* Unknown request. Stall EP0. */
-                        CyU3PUsbStall (0, CyTrue, CyFalse);
-                        break;
-                    }
-                }
-                else
-                {
-                    /* Only vendor requests are to be handled here. */
-                    CyU3PUsbStall (0, CyTrue, CyFalse);
-                }
-            }
+                CyFxVendorDispatch (glVendorRqt_p, gl_setupdat0, gl_setupdat1, glEp0Buffer, sizeof (glEp0Buffer));
         }
 
-        if (glSrcEpFlush)
+#if (CY_FX_SRC_RECYCLE_POLL_PERIOD != 0)
+        /* Recycle the source buffers consumed since the last timer tick. */
+        if (eventStat & CYFX_SRC_RECYCLE_TASK)
+            CyFxBulkSrcSinkRecycleSrcPoll ();
+#endif
+
+#if (CY_FX_SINK_DISCARD_POLL_PERIOD != 0)
+        /* Discard the sink buffers received since the last timer tick. */
+        if (eventStat & CYFX_SINK_DISCARD_TASK)
+            CyFxBulkSrcSinkDiscardSink ();
+#endif
+
+        if (eventStat & CYFX_USB_EP_FLUSH_TASK)
         {
             /* Stall the endpoint, so that the host can reset the pipe and continue. */
-            glSrcEpFlush = CyFalse;
             CyU3PUsbStall (CY_FX_EP_CONSUMER, CyTrue, CyFalse);
         }
 
         /* Force the USB 3.0 link to U2. */
-        if (glForceLinkU2)
+        if ((eventStat & CYFX_USB_FORCE_U2_TASK) && (glForceLinkU2))
         {
             stat = CyU3PUsbGetLinkPowerState (&curState);
             while ((glForceLinkU2) && (stat == CY_U3P_SUCCESS) && (curState == CyU3PUsbLPM_U0))
@@ -1067,10 +2128,8 @@ BulkSrcSinkAppThread_Entry (
             }
         }
 
-        if (TriggerStandbyMode)
+        if (eventStat & CYFX_USB_STANDBY_TASK)
         {
-            TriggerStandbyMode = CyFalse;
-
             CyU3PConnectState (CyFalse, CyTrue);
             CyU3PUsbStop ();
             CyU3PDebugDeInit ();
@@ -1096,24 +2155,16 @@ BulkSrcSinkAppThread_Entry (
                will never be executed. */
             CyFxAppErrorHandler (1);
         }
-        else
+        else if (eventStat & CYFX_USB_LOG_TASK)
         {
-            /* Compare the current USB driver log index against the previous value. */
-            tmp1 = CyU3PUsbGetEventLogIndex ();
-            if (tmp1 != prevUsbLogIndex)
-            {
-                tmp2 = prevUsbLogIndex;
-                while (tmp2 != tmp1)
-                {
-                    CyU3PDebugPrint (4, "USB LOG: %x\r\n", gl_UsbLogBuffer[tmp2]);
-                    tmp2++;
-                    if (tmp2 == CYFX_USBLOG_SIZE)
-                        tmp2 = 0;
-                }
-            }
-
-            /* Store the current log index. */
-            prevUsbLogIndex = tmp1;
+            /* Account for the new USB driver log entries. The host reads the log through vendor request 0x8B,
+               so that the debug UART is only used for readable messages. */
+            logPos = glUsbLogWritePos;
+            CyFxBulkSrcSinkUsbLogUpdate ();
+
+            glAppWake.logWakeups++;
+            if (glUsbLogWritePos == logPos)
+                glAppWake.idleLogWakeups++;
         }
     }
 }
@@ -1134,8 +2185,10 @@ CyFxApplicationDefine (
         while (1);
     }
 
-    /* Allocate the memory for the threads */
-    ptr = CyU3PMemAlloc (CY_FX_BULKSRCSINK_THREAD_STACK);
+    /* Allocate the memory for the threads. The stack is never freed, so take it from the boot time arena. */
+    ptr = CyU3PMemArenaAlloc (CY_FX_BULKSRCSINK_THREAD_STACK);
+    if (ptr == NULL)
+        ptr = CyU3PMemAlloc (CY_FX_BULKSRCSINK_THREAD_STACK);
 
     /* Create the thread for the application */
     ret = CyU3PThreadCreate (&bulkSrcSinkAppThread,                /* App thread structure */
@@ -1161,6 +2214,23 @@ CyFxApplicationDefine (
         /* Loop indefinitely */
         while(1);
     }
+
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+    /* Create the heap scrub thread, at a lower priority than the application thread. */
+    ret = CyU3PMutexCreate (&glHeapScrubLock, CYU3P_INHERIT);
+    if (ret != 0)
+        while (1);
+
+    ptr = CyU3PMemArenaAlloc (CY_FX_HEAP_SCRUB_THREAD_STACK);
+    if (ptr == NULL)
+        ptr = CyU3PMemAlloc (CY_FX_HEAP_SCRUB_THREAD_STACK);
+
+    ret = CyU3PThreadCreate (&glHeapScrubThread, "22:Heap_scrub", CyFxBulkSrcSinkHeapScrubThread_Entry, 0, ptr,
+            CY_FX_HEAP_SCRUB_THREAD_STACK, CY_FX_HEAP_SCRUB_THREAD_PRIORITY, CY_FX_HEAP_SCRUB_THREAD_PRIORITY,
+            CYU3P_NO_TIME_SLICE, CYU3P_AUTO_START);
+    if (ret != 0)
+        while (1);
+#endif
 }
 
 /*
@@ -1213,13 +2283,23 @@ main (void)
     io_cfg.gpioSimpleEn[0]  = 0;
     io_cfg.gpioSimpleEn[1]  = FX3_GPIO_TO_HIFLAG(FX3_GPIO_TEST_OUT);
     io_cfg.gpioComplexEn[0] = 0;
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+    io_cfg.gpioComplexEn[1] = FX3_GPIO_TO_HIFLAG(CY_FX_HEAP_SCRUB_TIMER_GPIO);   /* Heap scrub step timer */
+#else
     io_cfg.gpioComplexEn[1] = 0;
+#endif
     status = CyU3PDeviceConfigureIOMatrix (&io_cfg);
     if (status != CY_U3P_SUCCESS)
     {
         goto handle_fatal_error;
     }
 
+#if (CY_FX_HEAP_SCRUB_PERIOD != 0)
+    /* The heap checks have to be enabled before the heaps are initialized by the kernel. */
+    CyU3PMemEnableChecks (CyTrue, CyFxBulkSrcSinkHeapBadCb);
+    CyU3PBufEnableChecks (CyTrue, CyFxBulkSrcSinkHeapBadCb);
+#endif
+
     /* This is a non returnable call for initializing the RTOS kernel */
     CyU3PKernelEntry ();
 
@@ -27,6 +27,8 @@
 
 #include "cyu3types.h"
 #include "cyu3usbconst.h"
+#include "cyfxtx.h"
+#include "cyfxpattern.h"
 #include "cyu3externcstart.h"
 
 /* Endpoint and socket definitions for the bulk source sink application */
@@ -83,9 +85,154 @@
 
 #endif
 
+/* LPM (U1/U2) transitions are blocked while data is moving, and allowed again once no DMA buffer
+ * has been handled for CY_FX_LPM_IDLE_TIMEOUT ms. The activity is checked every CY_FX_LPM_GOVERNOR_PERIOD ms,
+ * so the idle threshold is rounded up to a multiple of this period. */
+#ifndef CY_FX_LPM_IDLE_TIMEOUT
+#define CY_FX_LPM_IDLE_TIMEOUT               (100)
+#endif
+#ifndef CY_FX_LPM_GOVERNOR_PERIOD
+#define CY_FX_LPM_GOVERNOR_PERIOD            (10)
+#endif
+
+/* Number of bins in the histogram of source buffers committed per recycle pass, read using vendor
+ * request 0x8C. Bin n counts the passes which committed n buffers, and the last bin also counts all
+ * larger batches. Bin 0 counts the passes which found no free buffer. */
+#define CY_FX_SRC_RECYCLE_HIST_SIZE          (8)
+
+/* When set to a non-zero value, the consume event notification is turned off for the source channel,
+ * and a timer signals the application thread every CY_FX_SRC_RECYCLE_POLL_PERIOD ms to recycle the free
+ * source buffers instead. This removes the per-buffer callbacks at the cost of latency, and needs enough
+ * buffers to cover one polling period at the expected data rate. Vendor request 0x8C also reports how many
+ * timer ticks found the thread still behind on the previous recycle. */
+#ifndef CY_FX_SRC_RECYCLE_POLL_PERIOD
+#define CY_FX_SRC_RECYCLE_POLL_PERIOD        (0)
+#endif
+
+/* When set to a non-zero value, the produce event notification is turned off for the sink channel,
+ * and a timer signals the application thread every CY_FX_SINK_DISCARD_POLL_PERIOD ms to discard the
+ * received buffers in a batch.
+ * The received byte count is then sampled from the channel status instead of being counted in the
+ * callback. As with the polled source mode, the channel needs enough buffers to cover one period. */
+#ifndef CY_FX_SINK_DISCARD_POLL_PERIOD
+#define CY_FX_SINK_DISCARD_POLL_PERIOD       (0)
+#endif
+
+/* When set to a non-zero value, the driver heap and buffer heap corruption checks are enabled, and a low
+ * priority thread checks CY_FX_HEAP_SCRUB_BLOCKS in-use blocks of each heap every CY_FX_HEAP_SCRUB_PERIOD ms
+ * using CyU3PMemScrubStep and CyU3PBufScrubStep. Each step is timed with a complex GPIO timer left free
+ * running on CY_FX_HEAP_SCRUB_TIMER_GPIO (the pin itself is not driven), and the results can be read using
+ * vendor request 0x8D. Only the driver heap step runs with interrupts locked out, so its time is the cost
+ * of the check alone; the buffer heap step can be pre-empted, and its maximum includes the time spent in
+ * higher priority threads and interrupts. Both times include one timer sample.
+ * Needs an SDK version for which cyfxtx.c supports the memory checks (CYFXTX_ERRORDETECTION). */
+#ifndef CY_FX_HEAP_SCRUB_PERIOD
+#define CY_FX_HEAP_SCRUB_PERIOD              (0)
+#endif
+#define CY_FX_HEAP_SCRUB_BLOCKS              (16)       /* Blocks checked in each heap per step. */
+#define CY_FX_HEAP_SCRUB_THREAD_STACK        (0x400)    /* Heap scrub thread stack size */
+#define CY_FX_HEAP_SCRUB_THREAD_PRIORITY     (15)       /* Heap scrub thread priority: below all other threads */
+#define CY_FX_HEAP_SCRUB_TIMER_GPIO          (51)       /* GPIO used for the free running step timer */
+
+/* Heap scrub results. This structure is also the 60 byte response (little-endian) of vendor request 0x8D. */
+typedef struct CyFxHeapScrubReport_t
+{
+    uint32_t              tickHz;       /* Frequency of the step timer in Hz. */
+    uint32_t              steps;        /* Number of steps taken in each heap. */
+    uint32_t              memTicks;     /* Total time of the driver heap steps, in timer ticks. */
+    uint32_t              memMaxTicks;  /* Longest driver heap step, in timer ticks. */
+    uint32_t              bufTicks;     /* Total time of the buffer heap steps, in timer ticks. */
+    uint32_t              bufMaxTicks;  /* Longest buffer heap step, in timer ticks. */
+    CyU3PHeapScrubStats_t memStats;     /* Driver heap scrub statistics. */
+    CyU3PHeapScrubStats_t bufStats;     /* Buffer heap scrub statistics. */
+    uint32_t              badAddr;      /* Address of the last corrupted block reported, or 0. */
+} CyFxHeapScrubReport_t;
+
 /* Byte value that is filled into the source buffers that FX3 sends out. */
 #define CY_FX_BULKSRCSINK_PATTERN            (0xAA)
 
+/* Data patterns for the source buffers, selected using vendor request 0x89. The patterns are generated
+ * by common/cyfxpattern.c (see cyfxpattern.h), with CY_FX_BULKSRCSINK_PATTERN as the constant byte. */
+#define CY_FX_SRC_PATTERN_CONST              (CY_FX_PATTERN_CONST)
+#define CY_FX_SRC_PATTERN_COUNTER            (CY_FX_PATTERN_COUNTER)
+#define CY_FX_SRC_PATTERN_SEQNUM             (CY_FX_PATTERN_SEQNUM)
+#define CY_FX_SRC_PATTERN_PRBS31             (CY_FX_PATTERN_PRBS31)
+#define CY_FX_SRC_PATTERN_COUNT              (CY_FX_PATTERN_COUNT)
+
+/* Optional verification of the data received on the sink endpoint, selected using vendor request 0x8A.
+ * Each DMA buffer received is checked before it is discarded.
+ *
+ * CRC32   : The last four bytes of the buffer hold the little-endian CRC32 (IEEE 802.3) of the rest of
+ *           the buffer. The error offset reported is that of the CRC.
+ * PRBS31  : The buffer holds the PRBS31 pattern generated by the source (CY_FX_SRC_PATTERN_PRBS31). The
+ *           first word is not checked, the second word seeds the checker and the rest is compared.
+ *           The error offset reported is that of the first byte which does not match.
+ */
+#define CY_FX_SINK_VERIFY_OFF                (0)
+#define CY_FX_SINK_VERIFY_CRC32              (1)
+#define CY_FX_SINK_VERIFY_PRBS31             (2)
+#define CY_FX_SINK_VERIFY_COUNT              (3)
+
+/* Sink data verification results. This structure is also the 20 byte response (little-endian) of
+ * vendor request 0x8A. */
+typedef struct CyFxSinkVerifyStats_t
+{
+    uint32_t mode;                      /* Verification mode: CY_FX_SINK_VERIFY_*. */
+    uint32_t goodCnt;                   /* Number of buffers that passed the check. */
+    uint32_t badCnt;                    /* Number of buffers that failed the check. */
+    uint32_t firstErrBuf;               /* Index of the first failed buffer among those checked, or 0xFFFFFFFF. */
+    uint32_t firstErrOffset;            /* Byte offset of the error in the first failed buffer, or 0xFFFFFFFF. */
+} CyFxSinkVerifyStats_t;
+
+/* DMA channel geometry used for the source and sink channels. The build time values above are used
+ * by default, and can be changed at runtime using vendor request 0x86. This structure is also the
+ * 8 byte response (little-endian) of vendor requests 0x86 and 0x87. */
+typedef struct CyFxBulkSrcSinkGeometry_t
+{
+    uint8_t  burstLen;                  /* Endpoint burst length. Must equal the CY_FX_EP_BURST_LENGTH value
+                                           reported in the descriptors at super speed or when not connected;
+                                           at high and full speed it can be lower, and only scales the buffers. */
+    uint8_t  sizeMult;                  /* DMA buffer size as a multiple of the burst size. */
+    uint16_t bufCount;                  /* Number of DMA buffers in each channel. */
+    uint16_t bufSize;                   /* DMA buffer size in bytes. 0 if the channels have not been created. */
+    uint16_t pktSize;                   /* Endpoint packet size for the current connection speed. */
+} CyFxBulkSrcSinkGeometry_t;
+
+/* USB driver event log streaming. The driver writes one byte per logged event into a ring buffer. The
+ * firmware counts the bytes written since boot, and the host reads the log in chunks with vendor request
+ * 0x8B, passing in wIndex:wValue (high:low) the log position it wants to read from: 0 for the first read,
+ * then the readPos + length of the previous response. The response is a CyFxUsbLogChunkHdr_t followed by
+ * up to CY_FX_USBLOG_CHUNK_SIZE log bytes, limited by wLength. If the position has already been overwritten
+ * the read starts at the oldest byte held and the skipped bytes are reported in lostCnt; a position ahead
+ * of the log (e.g. after a device reset) also restarts from the oldest byte held. The firmware checks the
+ * driver log every CY_FX_LPM_GOVERNOR_PERIOD ms; if it could not do so for long enough that the driver
+ * may have wrapped the ring, the number of bytes missed is not known, and the next read from a position
+ * before that point reports CY_FX_USBLOG_LOST_UNKNOWN in lostCnt. host/fx3usblog decodes the responses. */
+#define CY_FX_USBLOG_CHUNK_SIZE              (512)
+#define CY_FX_USBLOG_LOST_UNKNOWN            (0xFFFFFFFF)
+
+/* Response header (16 bytes, little-endian) of vendor request 0x8B. */
+typedef struct CyFxUsbLogChunkHdr_t
+{
+    uint32_t readPos;                   /* Log position of the first data byte. */
+    uint32_t writePos;                  /* Log position of the next byte to be written by the driver. */
+    uint32_t lostCnt;                   /* Number of bytes skipped since the requested position, or
+                                           CY_FX_USBLOG_LOST_UNKNOWN if it cannot be known. */
+    uint32_t length;                    /* Number of log bytes following the header. */
+} CyFxUsbLogChunkHdr_t;
+
+/* Application thread wakeup counters. This structure is also the 20 byte response (little-endian) of vendor
+ * request 0x8E, which is handled in the setup callback so that reading the counters does not wake the thread.
+ * Reading them twice and dividing the differences by the uptime difference gives the wakeup rates. */
+typedef struct CyFxAppWakeStats_t
+{
+    uint32_t uptime;                    /* Time since boot in ticks (1 ms), when the request was handled. */
+    uint32_t wakeups;                   /* Number of returns from the event wait. */
+    uint32_t timeouts;                  /* Number of those which timed out (only while the link is pushed into U2). */
+    uint32_t logWakeups;                /* Number of wakeups for the USB driver log task. */
+    uint32_t idleLogWakeups;            /* Number of those which found no new log bytes. */
+} CyFxAppWakeStats_t;
+
 /* Extern definitions for the USB Descriptors */
 extern const uint8_t CyFxUSB20DeviceDscr[];
 extern const uint8_t CyFxUSB30DeviceDscr[];
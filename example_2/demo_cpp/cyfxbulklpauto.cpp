@@ -33,7 +33,21 @@
    CPU is not involved in the data transfer.
 
    The DMA buffer size is defined based on the USB speed. 64 for full speed, 512 for high speed and 1024
-   for super speed. CY_FX_BULKLP_DMA_BUF_COUNT in the header file defines the number of DMA buffers.
+   for super speed, multiplied by CY_FX_EP_BURST_LENGTH and CY_FX_DMA_SIZE_MULTIPLIER so that each
+   buffer holds several bursts. CY_FX_BULKLP_DMA_BUF_COUNT in the header file defines the number of
+   DMA buffers. A buffer is only sent back once it is full or ends with a short packet, so a single full
+   sized packet is not echoed on its own unless the buffer holds one packet (see the header file).
+
+   CY_FX_BULKLP_NUM_PAIRS independent endpoint pairs can be used, each with its own DMA AUTO channel,
+   so that the host can keep several pipes busy in parallel. The DMA buffers are shared between the pairs.
+
+  With CY_FX_BULKLP_NUM_STREAMS set, the endpoints support USB 3.0 bulk streams at super speed. Each
+  stream is looped back through its own DMA AUTO channel, so the host can keep transfers outstanding on
+  several streams of the same endpoint without one of them blocking the rest.
+
+  With CY_FX_BULKLP_LATENCY_MODE set, MANUAL channels with single packet buffers are used instead, and
+  the firmware stamps a free running timer value into the header of each echoed transfer so that the
+  host can work out the round trip and device residence times.
  */
 #include "cyu3system.h"
 #include "cyu3os.h"
@@ -42,16 +56,27 @@
 #include "cyfxbulklpauto.h"
 #include "cyu3usb.h"
 #include "cyu3uart.h"
+#include "cyu3gpio.h"
 #include "cyu3utils.h"
+#include "cyfxtx.h"
+#include "cyfxdmastats.h"
+#include "cyfxvendor.h"
 #include <cstddef>
 
 /* Class definition */
 class CyFxBulkLoopApplication {
 public:
     CyFxBulkLoopApplication ();         /* Constructor */
-    CyU3PDmaChannel chHandleBulkLp;   /* DMA Channel handle */
+    CyU3PDmaChannel chHandleBulkLp[CY_FX_BULKLP_NUM_CHANNELS];   /* DMA Channel handle for each pair or stream */
     static CyBool_t isApplnActive;    /* Whether the application is active or not. */
+    static uint8_t  streamCount;      /* Number of bulk streams in use: 0 if streams are not used. */
+    CyU3PEvent appEvent;              /* Event group used to signal the application thread. */
+    CyU3PTimer epRecoverTimer;        /* One-shot timer for the CLEAR_FEATURE(EP_HALT) recovery wait. */
+    static volatile uint8_t epRecoverState;     /* State of the endpoint halt recovery. */
+    static uint16_t epRecoverEp;                /* Endpoint being recovered. */
     void CyFxAppErrorHandler (CyU3PReturnStatus_t apiRetStatus);
+    void CyFxBulkLpApplnEpRecover (void);
+    static void CyFxBulkLpApplnEpRecoverTimerCb (uint32_t arg);
     static CyBool_t CyFxBulkLpApplnUSBSetupCB (uint32_t setupdat0, uint32_t setupdat1);
     static void CyFxBulkLpApplnUSBEventCB (CyU3PUsbEventType_t evtype, uint16_t evdata);
     static CyBool_t CyFxBulkLpApplnLPMRqtCB (CyU3PUsbLinkPowerMode link_mode);
@@ -75,9 +100,46 @@ void CyFxBulkLoopApplication::CyFxAppErrorHandler (
 }
 
 CyBool_t CyFxBulkLoopApplication::isApplnActive = CyFalse;
+uint8_t  CyFxBulkLoopApplication::streamCount   = 0;
+
+/* CLEAR_FEATURE(EP_HALT) recovery state machine. The setup callback NAKs the endpoints and starts the recovery
+   timer (WAIT). When the timer expires the application thread is signalled (RESET), and the thread resets the
+   DMA channels and endpoints, re-arms the channels and completes the control request (IDLE). */
+#define CY_FX_EP_RECOVER_IDLE           (0)     /* No recovery in progress. */
+#define CY_FX_EP_RECOVER_WAIT           (1)     /* Endpoints NAKed, waiting for the NAK to take effect. */
+#define CY_FX_EP_RECOVER_RESET          (2)     /* Endpoints to be reset by the application thread. */
+#define CY_FX_EP_RECOVER_TICKS          (2)     /* Recovery wait: at least one full 1 ms tick. */
+#define CY_FX_EP_RECOVER_EVENT          (1 << 0)        /* Event: an endpoint is ready to be reset. */
+#define CY_FX_VENDOR_RQT_EVENT          (1 << 1)        /* Event: a vendor request is to be handled. */
+
+volatile uint8_t CyFxBulkLoopApplication::epRecoverState = CY_FX_EP_RECOVER_IDLE;
+uint16_t         CyFxBulkLoopApplication::epRecoverEp    = 0;
+
+/* The loop back channel statistics for pair n use DMA statistics channel n, and can be read through vendor
+   request 0x88. */
+
+/* Buffer used to send vendor request responses. */
+static uint8_t glEp0Buffer[64] __attribute__ ((aligned (32)));
 CyFxBulkLoopApplication *glBulkLoop_p;
 CyU3PThread     BulkLpAppThread;	 /* Bulk loop application thread structure */
 
+#if CY_FX_BULKLP_LATENCY_MODE
+/* Latency mode state for one loop back channel. The receive times of the buffers which have not been
+   sent to the host yet are kept in rxTicks, indexed by the low bits of the sequence number. */
+typedef struct CyFxBulkLpLatChannel_t
+{
+    uint32_t seqNum;                                    /* Sequence number for the next received buffer. */
+    uint32_t doneNext;                                  /* Sequence number of the next buffer to be sent. */
+    uint32_t doneSeqNum;                                /* Sequence number of the latest buffer sent. */
+    uint32_t doneTicks;                                 /* Device residence time of that buffer. */
+    uint32_t rxTicks[CY_FX_BULKLP_LAT_BUF_COUNT];       /* Receive times of the buffers in flight. */
+} CyFxBulkLpLatChannel_t;
+
+static CyFxBulkLpLatChannel_t glLatChannel[CY_FX_BULKLP_NUM_CHANNELS];
+static uint32_t glLatSizeHist[CY_FX_BULKLP_LAT_NUM_BUCKETS];   /* Transfer counts by size */
+static uint32_t glLatTickHz = 0;                                /* Timer frequency */
+#endif
+
 /* This function initializes the debug module. The debug prints
  * are routed to the UART and can be seen using a UART console
  * running at 115200 baud rate. */
@@ -130,6 +192,152 @@ CyFxBulkLpApplnDebugInit (void)
     CyU3PDebugPreamble (CyFalse);
 }
 
+#if CY_FX_BULKLP_LATENCY_MODE
+/* Start the free running GPIO timer used for the latency mode timestamps. The timer counts the GPIO
+ * fast clock, SYS_CLK / 2, and wraps around after 2^32 ticks, so only differences between timestamps
+ * taken within a few seconds of each other are meaningful. */
+static void
+CyFxBulkLpApplnLatTimerInit (
+        void)
+{
+    CyU3PGpioClock_t         gpioClock;
+    CyU3PGpioComplexConfig_t gpioConfig;
+    CyU3PReturnStatus_t      apiRetStatus;
+    uint32_t                 sysClk = 0;
+
+    gpioClock.fastClkDiv = 2;
+    gpioClock.slowClkDiv = 32;
+    gpioClock.simpleDiv  = CY_U3P_GPIO_SIMPLE_DIV_BY_16;
+    gpioClock.clkSrc     = CY_U3P_SYS_CLK;
+    gpioClock.halfDiv    = 0;
+    apiRetStatus = CyU3PGpioInit (&gpioClock, NULL);
+    if ((apiRetStatus != CY_U3P_SUCCESS) && (apiRetStatus != CY_U3P_ERROR_ALREADY_STARTED))
+    {
+        CyU3PDebugPrint (4, "CyU3PGpioInit failed, Error code = %d\n", apiRetStatus);
+        return;
+    }
+
+    /* The pin is only used for its timer: it is not driven and its input is not sampled. */
+    CyU3PMemSet ((uint8_t *)&gpioConfig, 0, sizeof (gpioConfig));
+    gpioConfig.outValue    = CyFalse;
+    gpioConfig.driveLowEn  = CyFalse;
+    gpioConfig.driveHighEn = CyFalse;
+    gpioConfig.inputEn     = CyFalse;
+    gpioConfig.pinMode     = CY_U3P_GPIO_MODE_STATIC;
+    gpioConfig.intrMode    = CY_U3P_GPIO_NO_INTR;
+    gpioConfig.timerMode   = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+    gpioConfig.timer       = 0;
+    gpioConfig.period      = 0xFFFFFFFF;
+    gpioConfig.threshold   = 0xFFFFFFFF;
+    apiRetStatus = CyU3PGpioSetComplexConfig (CY_FX_BULKLP_LAT_TIMER_GPIO, &gpioConfig);
+    if (apiRetStatus != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "CyU3PGpioSetComplexConfig failed, Error code = %d\n", apiRetStatus);
+        return;
+    }
+
+    if (CyU3PDeviceGetSysClkFreq (&sysClk) == CY_U3P_SUCCESS)
+        glLatTickHz = sysClk / gpioClock.fastClkDiv;
+}
+
+/* Clear the latency mode state of a loop back channel. Called whenever the channel is created or reset. */
+static void
+CyFxBulkLpApplnLatReset (
+        uint8_t ch)
+{
+    CyU3PMemSet ((uint8_t *)&glLatChannel[ch], 0, sizeof (CyFxBulkLpLatChannel_t));
+    glLatChannel[ch].doneSeqNum = 0xFFFFFFFF;
+    glLatChannel[ch].doneTicks  = 0xFFFFFFFF;
+}
+
+/* DMA callback for the latency mode MANUAL channels. Each received buffer is timestamped, stamped with a
+ * CyFxBulkLpLatHeader_t and sent straight back. The consume event of a buffer marks the end of its IN
+ * transfer, which gives the time that the buffer spent in the device. */
+static void
+CyFxBulkLpApplnLatencyCb (
+        CyU3PDmaChannel   *chHandle,            /* Handle to the DMA channel. */
+        CyU3PDmaCbType_t   type,                /* Callback type. */
+        CyU3PDmaCBInput_t *input)               /* Callback status. */
+{
+    CyFxBulkLpLatChannel_t *lat_p;
+    CyFxBulkLpLatHeader_t  *hdr_p;
+    uint32_t ticks = 0, size;
+    uint16_t count;
+    uint8_t  ch, bucket;
+
+    CyU3PGpioComplexSampleNow (CY_FX_BULKLP_LAT_TIMER_GPIO, &ticks);
+
+    ch = (uint8_t)(chHandle - glBulkLoop_p->chHandleBulkLp);
+    if (ch >= CY_FX_BULKLP_NUM_CHANNELS)
+        return;
+    lat_p = &glLatChannel[ch];
+
+    if (type == CY_U3P_DMA_CB_PROD_EVENT)
+    {
+        count = input->buffer_p.count;
+        lat_p->rxTicks[lat_p->seqNum & (CY_FX_BULKLP_LAT_BUF_COUNT - 1)] = ticks;
+
+        if (count >= sizeof (CyFxBulkLpLatHeader_t))
+        {
+            hdr_p = (CyFxBulkLpLatHeader_t *)input->buffer_p.buffer;
+            hdr_p->seqNum     = lat_p->seqNum;
+            hdr_p->rxTicks    = ticks;
+            hdr_p->doneSeqNum = lat_p->doneSeqNum;
+            hdr_p->doneTicks  = lat_p->doneTicks;
+        }
+        lat_p->seqNum++;
+
+        CyU3PDmaChannelCommitBuffer (chHandle, count, 0);
+
+        /* Bucket 0 holds the transfers that are too short to carry a header, and each following bucket
+           covers twice the sizes of the previous one. */
+        bucket = 0;
+        if (count >= sizeof (CyFxBulkLpLatHeader_t))
+        {
+            for (bucket = 1, size = count >> 5; (size != 0) && (bucket < (CY_FX_BULKLP_LAT_NUM_BUCKETS - 1)); size >>= 1)
+                bucket++;
+        }
+        glLatSizeHist[bucket]++;
+        CyFxDmaStatsAddBytes (ch, count);
+    }
+
+    if (type == CY_U3P_DMA_CB_CONS_EVENT)
+    {
+        lat_p->doneTicks  = ticks - lat_p->rxTicks[lat_p->doneNext & (CY_FX_BULKLP_LAT_BUF_COUNT - 1)];
+        lat_p->doneSeqNum = lat_p->doneNext++;
+    }
+}
+#endif
+
+/* Work out the DMA buffer count for each loop back channel. The CY_FX_BULKLP_DMA_BUF_COUNT buffers are
+ * shared between the channels, with at least two buffers per channel. The count is reduced if the buffers
+ * for all channels do not fit in the free buffer heap, and the buffer size is then reduced to a single
+ * burst if two buffers per channel still do not fit. */
+static uint16_t
+CyFxBulkLpApplnBufCount (
+        uint16_t *size_p,                       /* Buffer size: updated if it has to be reduced. */
+        uint16_t  minSize,                      /* Smallest usable buffer size: one burst. */
+        uint8_t   chCount)                      /* Number of loop back channels. */
+{
+    CyU3PHeapStats_t bufStats;
+    uint32_t count = CY_FX_BULKLP_DMA_BUF_COUNT / chCount;
+
+    if (count < 2)
+        count = 2;
+
+    if (CyU3PBufGetStats (&bufStats) == CY_U3P_SUCCESS)
+    {
+        while ((count > 2) &&
+                ((chCount * count * ((*size_p + 31) & ~31U)) > bufStats.freeBytes))
+            count--;
+
+        if ((chCount * count * ((*size_p + 31) & ~31U)) > bufStats.freeBytes)
+            *size_p = minSize;
+    }
+
+    return (uint16_t)count;
+}
+
 /* This function starts the bulk loop application. This is called
  * when a SET_CONF event is received from the USB host. The endpoints
  * are configured and the DMA pipe is setup in this function. */
@@ -138,6 +346,7 @@ CyFxBulkLpApplnStart (
         void)
 {
     uint16_t size = 0;
+    uint8_t  pair, ch, chCount;
     CyU3PEpConfig_t epCfg;
     CyU3PDmaChannelConfig_t dmaCfg;
     CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
@@ -170,58 +379,106 @@ CyFxBulkLpApplnStart (
     CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
     epCfg.enable   = CyTrue;
     epCfg.epType   = CY_U3P_USB_EP_BULK;
-    epCfg.burstLen = 1;
-    epCfg.streams  = 0;
+    epCfg.burstLen = (usbSpeed == CY_U3P_SUPER_SPEED) ? (CY_FX_BULKLP_DSCR_BURST) : 1;
     epCfg.pcktSize = size;
 
-    /* Producer endpoint configuration */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
-    {
-        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
-        glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
-    }
-
-    /* Consumer endpoint configuration */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
-    {
-        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
-        glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
-    }
-
-    /* Create a DMA Auto Channel between two sockets of the U port.
-     * DMA buffer size is set based on the USB speed. */
+    /* Bulk streams are only supported at super speed. Each stream gets its own channel, otherwise
+     * there is one channel per endpoint pair. */
+    glBulkLoop_p->streamCount = (usbSpeed == CY_U3P_SUPER_SPEED) ? CY_FX_BULKLP_NUM_STREAMS : 0;
+    epCfg.streams  = glBulkLoop_p->streamCount;
+    chCount = (glBulkLoop_p->streamCount != 0) ? glBulkLoop_p->streamCount : CY_FX_BULKLP_NUM_PAIRS;
+
+    /* Create a DMA Auto Channel between two sockets of the U port for each pair or stream.
+     * DMA buffer size is set based on the USB speed, and holds CY_FX_DMA_SIZE_MULTIPLIER
+     * bursts so that the channel does not stall the endpoint between bursts. */
+#if CY_FX_BULKLP_LATENCY_MODE
+    /* In latency mode, each buffer holds a single packet and is sent back by the DMA callback. */
     dmaCfg.size           = size;
-    dmaCfg.count          = CY_FX_BULKLP_DMA_BUF_COUNT;
-    dmaCfg.prodSckId      = CY_FX_EP_PRODUCER_SOCKET;
-    dmaCfg.consSckId      = CY_FX_EP_CONSUMER_SOCKET;
+    dmaCfg.count          = CY_FX_BULKLP_LAT_BUF_COUNT;
+    dmaCfg.dmaMode        = CY_U3P_DMA_MODE_BYTE;
+    dmaCfg.notification   = CY_U3P_DMA_CB_PROD_EVENT | CY_U3P_DMA_CB_CONS_EVENT;
+    dmaCfg.cb             = CyFxBulkLpApplnLatencyCb;
+#else
+    dmaCfg.size           = (size * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER);
+    dmaCfg.count          = CyFxBulkLpApplnBufCount (&dmaCfg.size, size * CY_FX_EP_BURST_LENGTH, chCount);
     dmaCfg.dmaMode        = CY_U3P_DMA_MODE_BYTE;
     dmaCfg.notification   = 0;
     dmaCfg.cb             = NULL;
+#endif
     dmaCfg.prodHeader     = 0;
     dmaCfg.prodFooter     = 0;
     dmaCfg.consHeader     = 0;
     dmaCfg.prodAvailCount = 0;
 
-    apiRetStatus = CyU3PDmaChannelCreate (&glBulkLoop_p->chHandleBulkLp,
-            CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
+    for (pair = 0; pair < CY_FX_BULKLP_NUM_PAIRS; pair++)
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
-        glBulkLoop_p->CyFxAppErrorHandler(apiRetStatus);
-    }
+        /* Producer endpoint configuration */
+        apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER_N (pair), &epCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
+            glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
+        }
 
-    /* Flush the Endpoint memory */
-    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
-    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+        /* Consumer endpoint configuration */
+        apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER_N (pair), &epCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
+            glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
+        }
 
-    /* Set DMA Channel transfer size */
-    apiRetStatus = CyU3PDmaChannelSetXfer (&glBulkLoop_p->chHandleBulkLp, CY_FX_BULKLP_DMA_TX_SIZE);
-    if (apiRetStatus != CY_U3P_SUCCESS)
+        /* Flush the Endpoint memory */
+        CyU3PUsbFlushEp(CY_FX_EP_PRODUCER_N (pair));
+        CyU3PUsbFlushEp(CY_FX_EP_CONSUMER_N (pair));
+    }
+
+    for (ch = 0; ch < chCount; ch++)
     {
-        CyU3PDebugPrint (4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n", apiRetStatus);
-        glBulkLoop_p->CyFxAppErrorHandler(apiRetStatus);
+        dmaCfg.prodSckId = CY_FX_EP_PRODUCER_SOCKET_N (ch);
+        dmaCfg.consSckId = CY_FX_EP_CONSUMER_SOCKET_N (ch);
+#if CY_FX_BULKLP_LATENCY_MODE
+        CyFxBulkLpApplnLatReset (ch);
+        apiRetStatus = CyU3PDmaChannelCreate (&glBulkLoop_p->chHandleBulkLp[ch],
+                CY_U3P_DMA_TYPE_MANUAL, &dmaCfg);
+#else
+        apiRetStatus = CyU3PDmaChannelCreate (&glBulkLoop_p->chHandleBulkLp[ch],
+                CY_U3P_DMA_TYPE_AUTO, &dmaCfg);
+#endif
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
+            glBulkLoop_p->CyFxAppErrorHandler(apiRetStatus);
+        }
+
+        /* Stream IDs start from 1. Map stream (ch + 1) of both endpoints to the sockets of this channel. */
+        if (glBulkLoop_p->streamCount != 0)
+        {
+            apiRetStatus = CyU3PUsbMapStream (CY_FX_EP_PRODUCER, (uint8_t)(dmaCfg.prodSckId & 0xFF), ch + 1);
+            if (apiRetStatus == CY_U3P_SUCCESS)
+                apiRetStatus = CyU3PUsbMapStream (CY_FX_EP_CONSUMER, (uint8_t)(dmaCfg.consSckId & 0xFF), ch + 1);
+            if (apiRetStatus != CY_U3P_SUCCESS)
+            {
+                CyU3PDebugPrint (4, "CyU3PUsbMapStream failed, Error code = %d\n", apiRetStatus);
+                glBulkLoop_p->CyFxAppErrorHandler(apiRetStatus);
+            }
+        }
+
+        /* Set DMA Channel transfer size */
+        apiRetStatus = CyU3PDmaChannelSetXfer (&glBulkLoop_p->chHandleBulkLp[ch], CY_FX_BULKLP_DMA_TX_SIZE);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PDmaChannelSetXfer Failed, Error code = %d\n", apiRetStatus);
+            glBulkLoop_p->CyFxAppErrorHandler(apiRetStatus);
+        }
+
+#if CY_FX_BULKLP_LATENCY_MODE
+        /* The MANUAL channel reports its data from the DMA callback. */
+        CyFxDmaStatsEnable (ch, NULL, 0);
+#else
+        /* The AUTO channel does not involve the CPU, so the statistics are collected by polling the channel. */
+        CyFxDmaStatsEnable (ch, &glBulkLoop_p->chHandleBulkLp[ch], dmaCfg.size * dmaCfg.count);
+#endif
     }
 
     /* Update the status flag. */
@@ -237,38 +494,178 @@ CyFxBulkLpApplnStop (
 {
     CyU3PEpConfig_t epCfg;
     CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+    uint8_t pair, ch, chCount;
 
-    /* Update the flag. */
+    /* Update the flag and cancel any pending endpoint halt recovery. */
     glBulkLoop_p->isApplnActive = CyFalse;
-
-    /* Flush the endpoint memory */
-    CyU3PUsbFlushEp(CY_FX_EP_PRODUCER);
-    CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
-
-    /* Destroy the channel */
-    CyU3PDmaChannelDestroy (&glBulkLoop_p->chHandleBulkLp);
+    CyU3PTimerStop (&glBulkLoop_p->epRecoverTimer);
+    glBulkLoop_p->epRecoverState = CY_FX_EP_RECOVER_IDLE;
 
     /* Disable endpoints. */
     CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
     epCfg.enable = CyFalse;
 
-    /* Producer endpoint configuration. */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER, &epCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
+    /* Destroy the channels */
+    chCount = (glBulkLoop_p->streamCount != 0) ? glBulkLoop_p->streamCount : CY_FX_BULKLP_NUM_PAIRS;
+    for (ch = 0; ch < chCount; ch++)
     {
-        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
-        glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
+        CyFxDmaStatsDisable (ch);
+        CyU3PDmaChannelDestroy (&glBulkLoop_p->chHandleBulkLp[ch]);
     }
+    glBulkLoop_p->streamCount = 0;
 
-    /* Consumer endpoint configuration. */
-    apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
-    if (apiRetStatus != CY_U3P_SUCCESS)
+    for (pair = 0; pair < CY_FX_BULKLP_NUM_PAIRS; pair++)
     {
-        CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
-        glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
+        /* Flush the endpoint memory */
+        CyU3PUsbFlushEp(CY_FX_EP_PRODUCER_N (pair));
+        CyU3PUsbFlushEp(CY_FX_EP_CONSUMER_N (pair));
+
+        /* Producer endpoint configuration. */
+        apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_PRODUCER_N (pair), &epCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
+            glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
+        }
+
+        /* Consumer endpoint configuration. */
+        apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER_N (pair), &epCfg);
+        if (apiRetStatus != CY_U3P_SUCCESS)
+        {
+            CyU3PDebugPrint (4, "CyU3PSetEpConfig failed, Error code = %d\n", apiRetStatus);
+            glBulkLoop_p->CyFxAppErrorHandler (apiRetStatus);
+        }
     }
 }
 
+/* Callback function for the endpoint recovery timer. The endpoint NAK has taken effect, so the
+ * application thread can now reset the endpoints. */
+void CyFxBulkLoopApplication::CyFxBulkLpApplnEpRecoverTimerCb (
+        uint32_t arg)
+{
+    (void)arg;
+
+    if (epRecoverState == CY_FX_EP_RECOVER_WAIT)
+    {
+        epRecoverState = CY_FX_EP_RECOVER_RESET;
+        CyU3PEventSet (&glBulkLoop_p->appEvent, CY_FX_EP_RECOVER_EVENT, CYU3P_EVENT_OR);
+    }
+}
+
+/* Second half of the CLEAR_FEATURE(EP_HALT) handling, run by the application thread once the
+ * endpoint NAK has taken effect. */
+void CyFxBulkLoopApplication::CyFxBulkLpApplnEpRecover (
+        void)
+{
+    uint8_t pair, ch, chFirst, chLast;
+
+    if ((epRecoverState != CY_FX_EP_RECOVER_RESET) || (!isApplnActive))
+        return;
+
+    /* Reset the DMA channel and reset/flush the endpoints. Both endpoints are reset because
+     * they are connected to the same DMA channel. With bulk streams, the endpoints are shared
+     * by the channels of all the streams, so all of them are reset.
+     */
+    pair    = (uint8_t)((epRecoverEp & 0x7F) - (CY_FX_EP_PRODUCER & 0x7F));
+    chFirst = (streamCount != 0) ? 0 : pair;
+    chLast  = (streamCount != 0) ? streamCount : (pair + 1);
+    for (ch = chFirst; ch < chLast; ch++)
+    {
+        CyFxDmaStatsResetBegin (ch);
+        CyU3PDmaChannelReset (&chHandleBulkLp[ch]);
+        CyFxDmaStatsResetEnd (ch);
+#if CY_FX_BULKLP_LATENCY_MODE
+        CyFxBulkLpApplnLatReset (ch);
+#endif
+    }
+    CyU3PUsbFlushEp (CY_FX_EP_PRODUCER_N (pair));
+    CyU3PUsbFlushEp (CY_FX_EP_CONSUMER_N (pair));
+    CyU3PUsbResetEp (CY_FX_EP_PRODUCER_N (pair));
+    CyU3PUsbResetEp (CY_FX_EP_CONSUMER_N (pair));
+    for (ch = chFirst; ch < chLast; ch++)
+        CyU3PDmaChannelSetXfer (&chHandleBulkLp[ch], CY_FX_BULKLP_DMA_TX_SIZE);
+    CyU3PUsbStall (epRecoverEp, CyFalse, CyTrue);
+
+    /* Un-NAK the endpoints and complete the CLEAR_FEATURE request. */
+    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER_N (pair), CyFalse);
+    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER_N (pair), CyFalse);
+    epRecoverState = CY_FX_EP_RECOVER_IDLE;
+    CyU3PUsbAckSetup ();
+}
+
+/* Vendor request handlers. See cyfxvendor.h for the handler interface. */
+
+/* 0x88: Read the loop back channel statistics as a CyFxDmaStats_t: nine little-endian 32 bit words.
+   wIndex selects the endpoint pair, or the stream (0 based) when bulk streams are in use, and the
+   statistics are cleared after the read if bit 0 of wValue is set. */
+static CyU3PReturnStatus_t
+CyFxBulkLpRqtDmaStats (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    uint8_t chLast = (glBulkLoop_p->streamCount != 0) ? glBulkLoop_p->streamCount : CY_FX_BULKLP_NUM_PAIRS;
+
+    if ((setup_p->wLength == 0) || (setup_p->wIndex >= chLast) || (CyFxDmaStatsGet ((uint8_t)setup_p->wIndex,
+                    (CyFxDmaStats_t *)*data_p, (CyBool_t)(setup_p->wValue & 0x01)) != CY_U3P_SUCCESS))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    *length_p = sizeof (CyFxDmaStats_t);
+    return CY_U3P_SUCCESS;
+}
+
+#if CY_FX_BULKLP_LATENCY_MODE
+/* 0x8D: Read the latency mode statistics as a CyFxBulkLpLatStats_t: the timer frequency followed by the
+   transfer size histogram. The histogram is cleared after the read if bit 0 of wValue is set. */
+static CyU3PReturnStatus_t
+CyFxBulkLpRqtLatStats (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyFxBulkLpLatStats_t *latStats_p = (CyFxBulkLpLatStats_t *)*data_p;
+
+    if (setup_p->wLength == 0)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    latStats_p->tickHz = glLatTickHz;
+    CyU3PMemCopy ((uint8_t *)latStats_p->sizeHist, (uint8_t *)glLatSizeHist, sizeof (glLatSizeHist));
+    if (setup_p->wValue & 0x01)
+        CyU3PMemSet ((uint8_t *)glLatSizeHist, 0, sizeof (glLatSizeHist));
+
+    *length_p = sizeof (CyFxBulkLpLatStats_t);
+    return CY_U3P_SUCCESS;
+}
+#endif
+
+/* 0xE0: Reset the FX3 device. */
+static CyU3PReturnStatus_t
+CyFxBulkLpRqtDeviceReset (
+        const CyFxVendorSetup_t *setup_p,
+        uint8_t                **data_p,
+        uint16_t                *length_p)
+{
+    CyU3PThreadSleep (100);
+    CyU3PDeviceReset (CyFalse);
+    return CY_U3P_SUCCESS;
+}
+
+/* Vendor request table, sorted by bRequest. The statistics reads are answered from the setup callback; the
+ * device reset sleeps, and is passed to the application thread. */
+static constexpr CyFxVendorRqt_t glVendorRqtTable[] = {
+    {0x88, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (CyFxDmaStats_t), CyFxBulkLpRqtDmaStats},
+#if CY_FX_BULKLP_LATENCY_MODE
+    {0x8D, CY_FX_VENDOR_DIR_IN,   CY_FX_VENDOR_CTX_CALLBACK, 0, sizeof (CyFxBulkLpLatStats_t), CyFxBulkLpRqtLatStats},
+#endif
+    {0xE0, CY_FX_VENDOR_DIR_NONE, CY_FX_VENDOR_CTX_THREAD,   CY_FX_VENDOR_ACK_FIRST, 0, CyFxBulkLpRqtDeviceReset}
+};
+static constexpr uint16_t glVendorRqtCount = sizeof (glVendorRqtTable) / sizeof (glVendorRqtTable[0]);
+
+/* Vendor request passed to the application thread, and its setup data. */
+static const CyFxVendorRqt_t *glVendorRqt_p = NULL;
+static uint32_t glVendorSetupdat0 = 0;
+static uint32_t glVendorSetupdat1 = 0;
+
 /* Callback to handle the USB setup requests. */
 CyBool_t CyFxBulkLoopApplication::CyFxBulkLpApplnUSBSetupCB (
         uint32_t setupdat0, /* SETUP Data 0 */
@@ -282,6 +679,7 @@ CyBool_t CyFxBulkLoopApplication::CyFxBulkLpApplnUSBSetupCB (
     uint8_t  bRequest, bReqType;
     uint8_t  bType, bTarget;
     uint16_t wValue, wIndex;
+    uint8_t  pair;
     CyBool_t isHandled = CyFalse;
 
     /* Decode the fields from the setup request. */
@@ -317,38 +715,28 @@ CyBool_t CyFxBulkLoopApplication::CyFxBulkLpApplnUSBSetupCB (
          * the EPs. The endpoint stall and toggle / sequence number is also expected to be
          * reset. Return CyFalse to make the library clear the stall and reset the endpoint
          * toggle. Or invoke the CyU3PUsbStall (ep, CyFalse, CyTrue) and return CyTrue.
-         * Here we are clearing the stall. */
+         *
+         * The reset is not done here, as it has to wait for the endpoint NAK to take effect.
+         * Both endpoints of the pair are NAKed and the recovery timer is started; the application
+         * thread then resets the endpoints, clears the stall and completes the request. */
         if ((bTarget == CY_U3P_USB_TARGET_ENDPT) && (bRequest == CY_U3P_USB_SC_CLEAR_FEATURE)
                 && (wValue == CY_U3P_USBX_FS_EP_HALT))
         {
-            if ((wIndex == CY_FX_EP_PRODUCER) || (wIndex == CY_FX_EP_CONSUMER))
+            /* Find the loop back pair that the endpoint belongs to. */
+            pair = (uint8_t)((wIndex & 0x7F) - (CY_FX_EP_PRODUCER & 0x7F));
+            if ((pair < CY_FX_BULKLP_NUM_PAIRS) &&
+                    ((wIndex == CY_FX_EP_PRODUCER_N (pair)) || (wIndex == CY_FX_EP_CONSUMER_N (pair))))
             {
-                if (glBulkLoop_p->isApplnActive)
+                if ((glBulkLoop_p->isApplnActive) && (epRecoverState == CY_FX_EP_RECOVER_IDLE))
                 {
-                    /* We NAK both the endpoints and allow some delay to let the NAK take effect. This has to
-                     * be done before resetting the DMA channel.
-                     */
-
-                    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER, CyTrue);
-                    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyTrue);
-                    CyU3PBusyWait (125);
-
-                    /* Reset the DMA channel and reset/flush the endpoints. Both endpoints are reset because
-                     * they are connected to the same DMA channel.
-                     */
-                    CyU3PDmaChannelReset (&glBulkLoop_p->chHandleBulkLp);
-                    CyU3PUsbFlushEp (CY_FX_EP_PRODUCER);
-                    CyU3PUsbFlushEp (CY_FX_EP_CONSUMER);
-                    CyU3PUsbResetEp (CY_FX_EP_PRODUCER);
-                    CyU3PUsbResetEp (CY_FX_EP_CONSUMER);
-                    CyU3PDmaChannelSetXfer (&glBulkLoop_p->chHandleBulkLp, CY_FX_BULKLP_DMA_TX_SIZE);
-                    CyU3PUsbStall (wIndex, CyFalse, CyTrue);
-
-                    /* Un-NAK the endpoints. */
-                    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER, CyFalse);
-                    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER, CyFalse);
-
-                    CyU3PUsbAckSetup ();
+                    CyU3PUsbSetEpNak (CY_FX_EP_PRODUCER_N (pair), CyTrue);
+                    CyU3PUsbSetEpNak (CY_FX_EP_CONSUMER_N (pair), CyTrue);
+
+                    epRecoverEp    = wIndex;
+                    epRecoverState = CY_FX_EP_RECOVER_WAIT;
+                    CyU3PTimerStop (&glBulkLoop_p->epRecoverTimer);
+                    CyU3PTimerModify (&glBulkLoop_p->epRecoverTimer, CY_FX_EP_RECOVER_TICKS, 0);
+                    CyU3PTimerStart (&glBulkLoop_p->epRecoverTimer);
                     isHandled = CyTrue;
                 }
             }
@@ -357,12 +745,23 @@ CyBool_t CyFxBulkLoopApplication::CyFxBulkLpApplnUSBSetupCB (
 
     if (bType == CY_U3P_USB_VENDOR_RQT)
     {
-        if (bRequest == 0xE0)
+        /* Requests which are not in the table are left unhandled, so that the driver stalls EP0. */
+        const CyFxVendorRqt_t *rqt_p = CyFxVendorFind (glVendorRqtTable, glVendorRqtCount, bRequest);
+
+        if (rqt_p != NULL)
         {
             isHandled = CyTrue;
-            CyU3PUsbAckSetup ();
-            CyU3PThreadSleep (100);
-            CyU3PDeviceReset (CyFalse);
+            if (rqt_p->context == CY_FX_VENDOR_CTX_CALLBACK)
+            {
+                CyFxVendorDispatch (rqt_p, setupdat0, setupdat1, glEp0Buffer, sizeof (glEp0Buffer));
+            }
+            else
+            {
+                glVendorSetupdat0 = setupdat0;
+                glVendorSetupdat1 = setupdat1;
+                glVendorRqt_p     = rqt_p;
+                CyU3PEventSet (&glBulkLoop_p->appEvent, CY_FX_VENDOR_RQT_EVENT, CYU3P_EVENT_OR);
+            }
         }
     }
 
@@ -539,7 +938,33 @@ CyFxBulkLpApplnInit (void)
 
 CyFxBulkLoopApplication::CyFxBulkLoopApplication (void)
 {
+    CyU3PReturnStatus_t status;
+
     CyFxBulkLpApplnDebugInit ();
+
+    /* Create the 1 ms sampling timer for the DMA statistics. It runs while channels are being tracked. */
+    status = CyFxDmaStatsInit ();
+    if (status != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "DMA statistics timer create failed, Error code = %d\n", status);
+    }
+
+#if CY_FX_BULKLP_LATENCY_MODE
+    CyFxBulkLpApplnLatTimerInit ();
+#endif
+
+    /* Create the event group for the application thread, and the one-shot timer used for the endpoint
+     * halt recovery. The timer is started by the setup callback. */
+    status = CyU3PEventCreate (&appEvent);
+    if (status == CY_U3P_SUCCESS)
+        status = CyU3PTimerCreate (&epRecoverTimer, CyFxBulkLpApplnEpRecoverTimerCb, 0, CY_FX_EP_RECOVER_TICKS, 0,
+                CYU3P_NO_ACTIVATE);
+    if (status != CY_U3P_SUCCESS)
+    {
+        CyU3PDebugPrint (4, "Event or timer create failed, Error code = %d\n", status);
+        CyFxAppErrorHandler (status);
+    }
+
     CyFxBulkLpApplnInit ();
 }
 
@@ -548,11 +973,26 @@ void
 BulkLpAppThread_Entry (
         uint32_t input)
 {
+    uint32_t eventStat;
+
     glBulkLoop_p = new CyFxBulkLoopApplication;
 
+    /* All permanent allocations have been made. Return the unused arena space to the buffer heap. */
+    CyU3PDebugPrint (4, "Boot arena size = %d bytes\r\n", CyU3PMemArenaSeal ());
+
     for (;;)
     {
-        CyU3PThreadSleep (1000);
+        /* Wait for work from the USB callbacks. */
+        if (CyU3PEventGet (&glBulkLoop_p->appEvent, CY_FX_EP_RECOVER_EVENT | CY_FX_VENDOR_RQT_EVENT,
+                    CYU3P_EVENT_OR_CLEAR, &eventStat, CYU3P_WAIT_FOREVER) == CY_U3P_SUCCESS)
+        {
+            if (eventStat & CY_FX_EP_RECOVER_EVENT)
+                glBulkLoop_p->CyFxBulkLpApplnEpRecover ();
+
+            if (eventStat & CY_FX_VENDOR_RQT_EVENT)
+                CyFxVendorDispatch (glVendorRqt_p, glVendorSetupdat0, glVendorSetupdat1, glEp0Buffer,
+                        sizeof (glEp0Buffer));
+        }
     }
 }
 
@@ -564,8 +1004,10 @@ CyFxApplicationDefine (
     void *ptr = NULL;
     uint32_t retThrdCreate = CY_U3P_SUCCESS;
 
-    /* Allocate the memory for the threads */
-    ptr = (void *)new uint8_t[CY_FX_BULKLP_THREAD_STACK];
+    /* Allocate the memory for the threads. The stack is never freed, so take it from the boot time arena. */
+    ptr = CyU3PMemArenaAlloc (CY_FX_BULKLP_THREAD_STACK);
+    if (ptr == NULL)
+        ptr = (void *)new uint8_t[CY_FX_BULKLP_THREAD_STACK];
 
     /* Create the thread for the application */
     retThrdCreate = CyU3PThreadCreate (&BulkLpAppThread,           /* Bulk loop App Thread structure */
@@ -631,7 +1073,11 @@ main (void)
     io_cfg.gpioSimpleEn[0]  = 0;
     io_cfg.gpioSimpleEn[1]  = 0;
     io_cfg.gpioComplexEn[0] = 0;
+#if CY_FX_BULKLP_LATENCY_MODE
+    io_cfg.gpioComplexEn[1] = (1 << (CY_FX_BULKLP_LAT_TIMER_GPIO - 32));    /* Latency mode timer */
+#else
     io_cfg.gpioComplexEn[1] = 0;
+#endif
 
     status = CyU3PDeviceConfigureIOMatrix (&io_cfg);
     if (status != CY_U3P_SUCCESS)
@@ -29,7 +29,6 @@
 #include "cyu3usbconst.h"
 #include "cyu3externcstart.h"
 
-#define CY_FX_BULKLP_DMA_BUF_COUNT      (8)                       /* Bulk loop channel buffer count */
 #define CY_FX_BULKLP_DMA_TX_SIZE        (0)                       /* DMA transfer size is set to infinite */
 #define CY_FX_BULKLP_THREAD_STACK       (0x1000)                  /* Bulk loop application thread stack size */
 #define CY_FX_BULKLP_THREAD_PRIORITY    (8)                       /* Bulk loop application thread priority */
@@ -51,6 +50,146 @@
 #define CY_FX_EP_PRODUCER_SOCKET        CY_U3P_UIB_SOCKET_PROD_1    /* Socket 1 is producer */
 #define CY_FX_EP_CONSUMER_SOCKET        CY_U3P_UIB_SOCKET_CONS_1    /* Socket 1 is consumer */
 
+/* Number of independent loopback endpoint pairs, each with its own DMA AUTO channel. Pair n uses
+ * EP (n + 1) OUT and EP (n + 1) IN on UIB sockets (n + 1), starting from the endpoints above. The
+ * value can be overridden from the build, e.g. -DCY_FX_BULKLP_NUM_PAIRS=4. */
+#ifndef CY_FX_BULKLP_NUM_PAIRS
+#define CY_FX_BULKLP_NUM_PAIRS          (1)
+#endif
+
+#if ((CY_FX_BULKLP_NUM_PAIRS < 1) || (CY_FX_BULKLP_NUM_PAIRS > 4))
+#error "CY_FX_BULKLP_NUM_PAIRS must be between 1 and 4"
+#endif
+
+/* Number of USB 3.0 bulk streams on the loopback endpoints: 0 (no streams), 2 or 4. Stream s (1 based)
+ * of the OUT endpoint is looped back to stream s of the IN endpoint through its own DMA AUTO channel,
+ * on UIB sockets s, so that a stalled stream does not hold up the others. Streams use the sockets of
+ * the other endpoint pairs, and can only be enabled with a single pair. Streams are only available at
+ * super speed; a single channel is used at high and full speed.
+ * The value can be overridden from the build, e.g. -DCY_FX_BULKLP_NUM_STREAMS=4. */
+#ifndef CY_FX_BULKLP_NUM_STREAMS
+#define CY_FX_BULKLP_NUM_STREAMS        (0)
+#endif
+
+/* MaxStreams field of the SS endpoint companion descriptor: the stream count as a power of 2. */
+#if (CY_FX_BULKLP_NUM_STREAMS == 0)
+#define CY_FX_BULKLP_STREAMS_EXP        (0)
+#elif (CY_FX_BULKLP_NUM_STREAMS == 2)
+#define CY_FX_BULKLP_STREAMS_EXP        (1)
+#elif (CY_FX_BULKLP_NUM_STREAMS == 4)
+#define CY_FX_BULKLP_STREAMS_EXP        (2)
+#else
+#error "CY_FX_BULKLP_NUM_STREAMS must be 0, 2 or 4"
+#endif
+
+#if ((CY_FX_BULKLP_NUM_STREAMS != 0) && (CY_FX_BULKLP_NUM_PAIRS != 1))
+#error "Bulk streams can only be used with CY_FX_BULKLP_NUM_PAIRS = 1"
+#endif
+
+/* Maximum number of loop back DMA channels: one per stream, or one per endpoint pair. */
+#if (CY_FX_BULKLP_NUM_STREAMS != 0)
+#define CY_FX_BULKLP_NUM_CHANNELS       (CY_FX_BULKLP_NUM_STREAMS)
+#else
+#define CY_FX_BULKLP_NUM_CHANNELS       (CY_FX_BULKLP_NUM_PAIRS)
+#endif
+
+#define CY_FX_EP_PRODUCER_N(n)          (CY_FX_EP_PRODUCER + (n))
+#define CY_FX_EP_CONSUMER_N(n)          (CY_FX_EP_CONSUMER + (n))
+#define CY_FX_EP_PRODUCER_SOCKET_N(n)   ((CyU3PDmaSocketId_t)(CY_FX_EP_PRODUCER_SOCKET + (n)))
+#define CY_FX_EP_CONSUMER_SOCKET_N(n)   ((CyU3PDmaSocketId_t)(CY_FX_EP_CONSUMER_SOCKET + (n)))
+
+/* Burst length, DMA buffer size multiplier and DMA buffer count for the loopback channel.
+ * Each DMA buffer holds (packet size * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER) bytes.
+ * With several endpoint pairs, CY_FX_BULKLP_DMA_BUF_COUNT is the total number of buffers, which
+ * is shared between the pairs.
+ * The defaults can be overridden from the build, e.g. -DCY_FX_EP_BURST_LENGTH=8.
+ *
+ * The DMA AUTO channel only passes a buffer on to the IN endpoint when the buffer is full, or when a
+ * short packet or a zero length packet is received. A single full sized OUT packet, or any transfer that
+ * is a multiple of the packet size and smaller than the buffer, is therefore held until more data, a
+ * short packet or a ZLP arrives. Hosts that expect every packet to be echoed on its own should end each
+ * transfer with a short packet or a ZLP, or build with CY_FX_EP_BURST_LENGTH = 1 and
+ * CY_FX_DMA_SIZE_MULTIPLIER = 1, which gives one packet per buffer at the cost of throughput. */
+
+#ifdef CYMEM_256K
+
+/* Only 32 KB of DMA buffers are available on the CYUSB3011/CYUSB3012 parts. */
+#ifndef CY_FX_EP_BURST_LENGTH
+#define CY_FX_EP_BURST_LENGTH           (4)                       /* Burst length in packets, USB 3.0 only */
+#endif
+#ifndef CY_FX_DMA_SIZE_MULTIPLIER
+#define CY_FX_DMA_SIZE_MULTIPLIER       (1)                       /* Buffer size in bursts */
+#endif
+#ifndef CY_FX_BULKLP_DMA_BUF_COUNT
+#define CY_FX_BULKLP_DMA_BUF_COUNT      (2)                       /* Bulk loop buffer count, all channels */
+#endif
+
+#else
+
+#ifndef CY_FX_EP_BURST_LENGTH
+#define CY_FX_EP_BURST_LENGTH           (16)                      /* Burst length in packets, USB 3.0 only */
+#endif
+#ifndef CY_FX_DMA_SIZE_MULTIPLIER
+#define CY_FX_DMA_SIZE_MULTIPLIER       (2)                       /* Buffer size in bursts */
+#endif
+#ifndef CY_FX_BULKLP_DMA_BUF_COUNT
+#define CY_FX_BULKLP_DMA_BUF_COUNT      (4)                       /* Bulk loop buffer count, all channels */
+#endif
+
+#endif
+
+#if ((CY_FX_EP_BURST_LENGTH < 1) || (CY_FX_EP_BURST_LENGTH > 16))
+#error "CY_FX_EP_BURST_LENGTH must be between 1 and 16"
+#endif
+#if ((CY_FX_DMA_SIZE_MULTIPLIER < 1) || ((1024 * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER) > 0xFFFF))
+#error "The DMA buffer size (1024 * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER) must be less than 64 KB"
+#endif
+
+/* Round trip latency measurement mode. When enabled, the loop back channels are MANUAL channels with
+ * single packet buffers, so that data is not held back waiting for a buffer to fill. The firmware stamps
+ * a CyFxBulkLpLatHeader_t over the first 16 bytes of each echoed transfer, and counts the transfers in
+ * CY_FX_BULKLP_LAT_NUM_BUCKETS size buckets which can be read with vendor request 0x8D. Transfers shorter
+ * than the header are echoed as they are, and are counted in bucket 0.
+ * The timestamps are taken from a complex GPIO timer which is left free running on
+ * CY_FX_BULKLP_LAT_TIMER_GPIO. The pin itself is not driven.
+ * The mode can be enabled from the build, e.g. -DCY_FX_BULKLP_LATENCY_MODE=1. */
+#ifndef CY_FX_BULKLP_LATENCY_MODE
+#define CY_FX_BULKLP_LATENCY_MODE       (0)
+#endif
+
+/* Burst length used on the loopback endpoints at super speed, and advertised as bMaxBurst + 1 in the SS
+ * endpoint companion descriptors. Latency mode uses single packet bursts to match its single packet buffers,
+ * so that the host does not send a burst which the channel cannot take. */
+#if CY_FX_BULKLP_LATENCY_MODE
+#define CY_FX_BULKLP_DSCR_BURST         (1)
+#else
+#define CY_FX_BULKLP_DSCR_BURST         (CY_FX_EP_BURST_LENGTH)
+#endif
+
+#define CY_FX_BULKLP_LAT_BUF_COUNT      (4)                       /* Buffers per channel: power of 2 */
+#define CY_FX_BULKLP_LAT_TIMER_GPIO     (51)                      /* GPIO used for the free running timer */
+#define CY_FX_BULKLP_LAT_NUM_BUCKETS    (8)                       /* Number of transfer size buckets */
+
+/* Header written over the start of each echoed transfer in latency mode, as little-endian 32 bit words.
+   The residence time of a buffer is only known once the host has read it, so each header carries the
+   residence time of the latest buffer on the channel which has been fully sent to the host. */
+typedef struct CyFxBulkLpLatHeader_t
+{
+    uint32_t seqNum;                    /* Sequence number of this buffer on the channel, from 0. */
+    uint32_t rxTicks;                   /* Timer value when the firmware received the OUT data. */
+    uint32_t doneSeqNum;                /* Sequence number of the latest buffer sent to the host. */
+    uint32_t doneTicks;                 /* Time spent in the device by that buffer, from rxTicks to the
+                                           end of the IN transfer. 0xFFFFFFFF if no buffer is done yet. */
+} CyFxBulkLpLatHeader_t;
+
+/* Latency mode statistics returned by vendor request 0x8D, as little-endian 32 bit words. */
+typedef struct CyFxBulkLpLatStats_t
+{
+    uint32_t tickHz;                    /* Timer frequency in Hz. */
+    uint32_t sizeHist[CY_FX_BULKLP_LAT_NUM_BUCKETS];   /* Transfer counts by size: < 16, 16-31, 32-63,
+                                           64-127, 128-255, 256-511, 512-1023 and 1024 bytes or more. */
+} CyFxBulkLpLatStats_t;
+
 /* Extern definitions for the USB Descriptors */
 extern const uint8_t CyFxUSB20DeviceDscr[];
 extern const uint8_t CyFxUSB30DeviceDscr[];
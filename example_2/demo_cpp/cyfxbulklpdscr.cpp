@@ -34,6 +34,62 @@
 
 #include "cyfxbulklpauto.h"
 
+/* Endpoint descriptors for loopback pair n. The super speed version includes the endpoint companion
+ * descriptors. One set is added to the configuration descriptors for each of the CY_FX_BULKLP_NUM_PAIRS
+ * pairs, and the total length and endpoint count are derived from the number of pairs. */
+#define CY_FX_SS_EP_PAIR_DSCR(n)                                                                        \
+    /* Endpoint descriptor for producer EP */                                                           \
+    0x07,                           /* Descriptor size */                                               \
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */                                      \
+    CY_FX_EP_PRODUCER_N(n),         /* Endpoint address and description */                              \
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */                                            \
+    0x00,0x04,                      /* Max packet size = 1024 bytes */                                  \
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */            \
+                                                                                                        \
+    /* Super speed endpoint companion descriptor for producer EP */                                     \
+    0x06,                           /* Descriptor size */                                               \
+    CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */                         \
+    (CY_FX_BULKLP_DSCR_BURST - 1),  /* Max no. of packets in a burst(0-15) - 0: burst 1 packet at a time */ \
+    CY_FX_BULKLP_STREAMS_EXP,       /* Max streams for bulk EP = 2 ^ CY_FX_BULKLP_STREAMS_EXP, 0: no streams */ \
+    0x00,0x00,                      /* Service interval for the EP : 0 for bulk */                      \
+                                                                                                        \
+    /* Endpoint descriptor for consumer EP */                                                           \
+    0x07,                           /* Descriptor size */                                               \
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */                                      \
+    CY_FX_EP_CONSUMER_N(n),         /* Endpoint address and description */                              \
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */                                            \
+    0x00,0x04,                      /* Max packet size = 1024 bytes */                                  \
+    0x00,                           /* Servicing interval for data transfers : 0 for Bulk */            \
+                                                                                                        \
+    /* Super speed endpoint companion descriptor for consumer EP */                                     \
+    0x06,                           /* Descriptor size */                                               \
+    CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */                         \
+    (CY_FX_BULKLP_DSCR_BURST - 1),  /* Max no. of packets in a burst(0-15) - 0: burst 1 packet at a time */ \
+    CY_FX_BULKLP_STREAMS_EXP,       /* Max streams for bulk EP = 2 ^ CY_FX_BULKLP_STREAMS_EXP, 0: no streams */ \
+    0x00,0x00,                      /* Service interval for the EP : 0 for bulk */
+
+#define CY_FX_EP_PAIR_DSCR(n, lsb, msb)                                                                 \
+    /* Endpoint descriptor for producer EP */                                                           \
+    0x07,                           /* Descriptor size */                                               \
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */                                      \
+    CY_FX_EP_PRODUCER_N(n),         /* Endpoint address and description */                              \
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */                                            \
+    lsb,msb,                        /* Max packet size */                                               \
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */            \
+                                                                                                        \
+    /* Endpoint descriptor for consumer EP */                                                           \
+    0x07,                           /* Descriptor size */                                               \
+    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */                                      \
+    CY_FX_EP_CONSUMER_N(n),         /* Endpoint address and description */                              \
+    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */                                            \
+    lsb,msb,                        /* Max packet size */                                               \
+    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
+
+/* Total length of the configuration descriptors: configuration and interface descriptors, followed
+ * by two endpoint descriptors (plus companion descriptors at super speed) for each pair. */
+#define CY_FX_SS_CONFIG_DSCR_LEN        (9 + 9 + (CY_FX_BULKLP_NUM_PAIRS * 2 * (7 + 6)))
+#define CY_FX_HS_CONFIG_DSCR_LEN        (9 + 9 + (CY_FX_BULKLP_NUM_PAIRS * 2 * 7))
+
 /* Standard device descriptor for USB 3.0 */
 const uint8_t CyFxUSB30DeviceDscr[] __attribute__ ((aligned (32))) =
 {
@@ -118,7 +174,8 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     /* Configuration descriptor */
     0x09,                           /* Descriptor size */
     CY_U3P_USB_CONFIG_DESCR,        /* Configuration descriptor type */
-    0x2C,0x00,                      /* Length of this descriptor and all sub descriptors */
+    (CY_FX_SS_CONFIG_DSCR_LEN & 0xFF), /* Length of this descriptor and all sub descriptors */
+    (CY_FX_SS_CONFIG_DSCR_LEN >> 8),
     0x01,                           /* Number of interfaces */
     0x01,                           /* Configuration number */
     0x00,                           /* COnfiguration string index */
@@ -130,41 +187,22 @@ const uint8_t CyFxUSBSSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_INTRFC_DESCR,        /* Interface Descriptor type */
     0x00,                           /* Interface number */
     0x00,                           /* Alternate setting number */
-    0x02,                           /* Number of end points */
+    (2 * CY_FX_BULKLP_NUM_PAIRS),   /* Number of end points */
     0xFF,                           /* Interface class */
     0x00,                           /* Interface sub class */
     0x00,                           /* Interface protocol code */
     0x00,                           /* Interface descriptor string index */
 
-    /* Endpoint descriptor for producer EP */
-    0x07,                           /* Descriptor size */
-    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
-    CY_FX_EP_PRODUCER,              /* Endpoint address and description */
-    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x04,                      /* Max packet size = 1024 bytes */
-    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
-
-    /* Super speed endpoint companion descriptor for producer EP */
-    0x06,                           /* Descriptor size */
-    CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
-    0x00,                           /* Max no. of packets in a burst : 0: burst 1 packet at a time */
-    0x00,                           /* Max streams for bulk EP = 0 (No streams) */
-    0x00,0x00,                      /* Service interval for the EP : 0 for bulk */
-
-    /* Endpoint descriptor for consumer EP */
-    0x07,                           /* Descriptor size */
-    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
-    CY_FX_EP_CONSUMER,              /* Endpoint address and description */
-    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x04,                      /* Max packet size = 1024 bytes */
-    0x00,                           /* Servicing interval for data transfers : 0 for Bulk */
-
-    /* Super speed endpoint companion descriptor for consumer EP */
-    0x06,                           /* Descriptor size */
-    CY_U3P_SS_EP_COMPN_DESCR,       /* SS endpoint companion descriptor type */
-    0x00,                           /* Max no. of packets in a burst : 0: burst 1 packet at a time */
-    0x00,                           /* Max streams for bulk EP = 0 (No streams) */
-    0x00,0x00                       /* Service interval for the EP : 0 for bulk */
+    CY_FX_SS_EP_PAIR_DSCR (0)
+#if (CY_FX_BULKLP_NUM_PAIRS > 1)
+    CY_FX_SS_EP_PAIR_DSCR (1)
+#endif
+#if (CY_FX_BULKLP_NUM_PAIRS > 2)
+    CY_FX_SS_EP_PAIR_DSCR (2)
+#endif
+#if (CY_FX_BULKLP_NUM_PAIRS > 3)
+    CY_FX_SS_EP_PAIR_DSCR (3)
+#endif
 };
 
 /* Standard high speed configuration descriptor */
@@ -173,7 +211,8 @@ const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
     /* Configuration descriptor */
     0x09,                           /* Descriptor size */
     CY_U3P_USB_CONFIG_DESCR,        /* Configuration descriptor type */
-    0x20,0x00,                      /* Length of this descriptor and all sub descriptors */
+    (CY_FX_HS_CONFIG_DSCR_LEN & 0xFF), /* Length of this descriptor and all sub descriptors */
+    (CY_FX_HS_CONFIG_DSCR_LEN >> 8),
     0x01,                           /* Number of interfaces */
     0x01,                           /* Configuration number */
     0x00,                           /* COnfiguration string index */
@@ -185,27 +224,22 @@ const uint8_t CyFxUSBHSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_INTRFC_DESCR,        /* Interface Descriptor type */
     0x00,                           /* Interface number */
     0x00,                           /* Alternate setting number */
-    0x02,                           /* Number of endpoints */
+    (2 * CY_FX_BULKLP_NUM_PAIRS),   /* Number of endpoints */
     0xFF,                           /* Interface class */
     0x00,                           /* Interface sub class */
     0x00,                           /* Interface protocol code */
     0x00,                           /* Interface descriptor string index */
 
-    /* Endpoint descriptor for producer EP */
-    0x07,                           /* Descriptor size */
-    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
-    CY_FX_EP_PRODUCER,              /* Endpoint address and description */
-    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x02,                      /* Max packet size = 512 bytes */
-    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
-
-    /* Endpoint descriptor for consumer EP */
-    0x07,                           /* Descriptor size */
-    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
-    CY_FX_EP_CONSUMER,              /* Endpoint address and description */
-    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x00,0x02,                      /* Max packet size = 512 bytes */
-    0x00                            /* Servicing interval for data transfers : 0 for bulk */
+    CY_FX_EP_PAIR_DSCR (0, 0x00, 0x02)
+#if (CY_FX_BULKLP_NUM_PAIRS > 1)
+    CY_FX_EP_PAIR_DSCR (1, 0x00, 0x02)
+#endif
+#if (CY_FX_BULKLP_NUM_PAIRS > 2)
+    CY_FX_EP_PAIR_DSCR (2, 0x00, 0x02)
+#endif
+#if (CY_FX_BULKLP_NUM_PAIRS > 3)
+    CY_FX_EP_PAIR_DSCR (3, 0x00, 0x02)
+#endif
 };
 
 /* Standard full speed configuration descriptor */
@@ -214,7 +248,8 @@ const uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
     /* Configuration descriptor */
     0x09,                           /* Descriptor size */
     CY_U3P_USB_CONFIG_DESCR,        /* Configuration descriptor type */
-    0x20,0x00,                      /* Length of this descriptor and all sub descriptors */
+    (CY_FX_HS_CONFIG_DSCR_LEN & 0xFF), /* Length of this descriptor and all sub descriptors */
+    (CY_FX_HS_CONFIG_DSCR_LEN >> 8),
     0x01,                           /* Number of interfaces */
     0x01,                           /* Configuration number */
     0x00,                           /* COnfiguration string index */
@@ -226,27 +261,22 @@ const uint8_t CyFxUSBFSConfigDscr[] __attribute__ ((aligned (32))) =
     CY_U3P_USB_INTRFC_DESCR,        /* Interface descriptor type */
     0x00,                           /* Interface number */
     0x00,                           /* Alternate setting number */
-    0x02,                           /* Number of endpoints */
+    (2 * CY_FX_BULKLP_NUM_PAIRS),   /* Number of endpoints */
     0xFF,                           /* Interface class */
     0x00,                           /* Interface sub class */
     0x00,                           /* Interface protocol code */
     0x00,                           /* Interface descriptor string index */
 
-    /* Endpoint descriptor for producer EP */
-    0x07,                           /* Descriptor size */
-    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
-    CY_FX_EP_PRODUCER,              /* Endpoint address and description */
-    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x40,0x00,                      /* Max packet size = 64 bytes */
-    0x00,                           /* Servicing interval for data transfers : 0 for bulk */
-
-    /* Endpoint descriptor for consumer EP */
-    0x07,                           /* Descriptor size */
-    CY_U3P_USB_ENDPNT_DESCR,        /* Endpoint descriptor type */
-    CY_FX_EP_CONSUMER,              /* Endpoint address and description */
-    CY_U3P_USB_EP_BULK,             /* Bulk endpoint type */
-    0x40,0x00,                      /* Max packet size = 64 bytes */
-    0x00                            /* Servicing interval for data transfers : 0 for bulk */
+    CY_FX_EP_PAIR_DSCR (0, 0x40, 0x00)
+#if (CY_FX_BULKLP_NUM_PAIRS > 1)
+    CY_FX_EP_PAIR_DSCR (1, 0x40, 0x00)
+#endif
+#if (CY_FX_BULKLP_NUM_PAIRS > 2)
+    CY_FX_EP_PAIR_DSCR (2, 0x40, 0x00)
+#endif
+#if (CY_FX_BULKLP_NUM_PAIRS > 3)
+    CY_FX_EP_PAIR_DSCR (3, 0x40, 0x00)
+#endif
 };
 
 /* Standard language ID string descriptor */
@@ -0,0 +1,258 @@
+/*
+ ## Cypress FX3 Host Test Source File (bench_cppnew.cpp)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test and benchmark for the C++ operator new/delete replacement in cyfxcppnew.cpp.
+ *
+ * The test is built three times, matching the FX3_CXX_NEW options of fx3_add_firmware:
+ *   MEMALLOC : cyfxcppnew.cpp on top of CyU3PMemAlloc (the byte pool model in fx3hoststub.c).
+ *   POOL     : cyfxcppnew.cpp with CYFXCPP_NEW_USE_POOL, small objects from the fixed block pool.
+ *   LIBC     : cyfxcppnew.cpp left out, so that new/delete go to the host C library malloc. This only
+ *              stands in for the newlib allocator used by the NEWLIB option, and its latency is not
+ *              representative of newlib on the ARM926.
+ * Each build runs the same seeded workload of object sized allocations with random lifetimes, and
+ * reports the new and delete latency. The cyfxcppnew.cpp builds also check that the nothrow versions
+ * return NULL when the heap is exhausted, and that the throwing versions trap instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <new>
+
+#include "fx3hoststub.h"
+#include "cyu3os.h"
+
+#ifdef CY_FX_BENCH_USE_CPPNEW
+#include "cyfxcppnew.cpp"
+#endif
+
+#define CY_FX_BENCH_SLOTS               (64)            /* Number of objects that can be held at a time. */
+#define CY_FX_BENCH_OPS                 (1000000)       /* Number of new/delete operations. */
+#define CY_FX_BENCH_HIST_BINS           (10000)         /* Latency histogram bins of 10 ns each. */
+
+#if !defined (CY_FX_BENCH_USE_CPPNEW)
+#define CY_FX_BENCH_NEW_NAME            "libc"
+#elif defined (CYFXCPP_NEW_USE_POOL)
+#define CY_FX_BENCH_NEW_NAME            "pool"
+#else
+#define CY_FX_BENCH_NEW_NAME            "memalloc"
+#endif
+
+/* An object held by the workload. */
+typedef struct CyFxBenchSlot_t
+{
+    uint8_t  *mem_p;                    /* Object pointer, or NULL if the slot is empty. */
+    uint32_t  size;                     /* Requested size. */
+    uint8_t   fill;                     /* Byte value filled into the object. */
+} CyFxBenchSlot_t;
+
+/* Latency statistics for one operation type. */
+typedef struct CyFxBenchLatency_t
+{
+    uint64_t count;                     /* Number of operations timed. */
+    uint64_t totalNs;                   /* Total time taken. */
+    uint64_t maxNs;                     /* Longest time taken. */
+    uint32_t hist[CY_FX_BENCH_HIST_BINS];
+} CyFxBenchLatency_t;
+
+static CyFxBenchSlot_t    glBenchSlot[CY_FX_BENCH_SLOTS];
+static CyFxBenchLatency_t glBenchNew;
+static CyFxBenchLatency_t glBenchDelete;
+
+static void
+CyFxBenchRecord (
+        CyFxBenchLatency_t *lat_p,
+        uint64_t            ns)
+{
+    uint64_t bin = ns / 10;
+
+    lat_p->count++;
+    lat_p->totalNs += ns;
+    if (ns > lat_p->maxNs)
+        lat_p->maxNs = ns;
+    lat_p->hist[(bin < CY_FX_BENCH_HIST_BINS) ? bin : (CY_FX_BENCH_HIST_BINS - 1)]++;
+}
+
+/* Latency in ns below which the given fraction (in parts per million) of the operations completed. */
+static uint64_t
+CyFxBenchPercentile (
+        const CyFxBenchLatency_t *lat_p,
+        uint32_t                  ppm)
+{
+    uint64_t limit = (lat_p->count * ppm) / 1000000;
+    uint64_t sum   = 0;
+    uint32_t bin;
+
+    for (bin = 0; bin < CY_FX_BENCH_HIST_BINS; bin++)
+    {
+        sum += lat_p->hist[bin];
+        if (sum > limit)
+            break;
+    }
+
+    return ((uint64_t)(bin + 1) * 10);
+}
+
+static void
+CyFxBenchPrint (
+        const char               *name,
+        const CyFxBenchLatency_t *lat_p)
+{
+    printf ("%-8s %-6s mean %6.1f ns  p99 %6llu ns  p99.9 %6llu ns  max %8llu ns\n", CY_FX_BENCH_NEW_NAME,
+            name, (lat_p->count != 0) ? ((double)lat_p->totalNs / lat_p->count) : 0.0,
+            (unsigned long long)CyFxBenchPercentile (lat_p, 990000),
+            (unsigned long long)CyFxBenchPercentile (lat_p, 999000), (unsigned long long)lat_p->maxNs);
+}
+
+/* Object size for the workload: mostly small objects that fit in a pool block, with some larger
+   objects and arrays. */
+static uint32_t
+CyFxBenchSize (
+        void)
+{
+    uint32_t sel = (uint32_t)rand () % 100;
+
+    if (sel < 85)
+        return (4 + ((uint32_t)rand () % 61));
+    return (65 + ((uint32_t)rand () % 448));
+}
+
+#ifdef CY_FX_BENCH_USE_CPPNEW
+
+/* Exhaust the driver heap with nothrow allocations, which must return NULL at the end, then check
+   that a throwing allocation traps. The trap is taken in a child process, as it ends the process. */
+static int
+CyFxBenchCheckFailure (
+        void)
+{
+    void    *list_p = 0;
+    void    *obj_p;
+    uint32_t count = 0;
+    pid_t    pid;
+    int      status;
+
+    while ((obj_p = operator new (512, std::nothrow)) != 0)
+    {
+        *(void **)obj_p = list_p;
+        list_p = obj_p;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        printf ("FAIL: no nothrow allocation succeeded\n");
+        return 1;
+    }
+
+    pid = fork ();
+    if (pid == 0)
+    {
+        obj_p = operator new (512);
+        _exit ((obj_p == 0) ? 2 : 3);
+    }
+
+    if ((pid < 0) || (waitpid (pid, &status, 0) != pid) || !WIFSIGNALED (status) ||
+            ((WTERMSIG (status) != SIGILL) && (WTERMSIG (status) != SIGTRAP)))
+    {
+        printf ("FAIL: throwing operator new did not trap on an exhausted heap\n");
+        return 1;
+    }
+
+    while (list_p != 0)
+    {
+        obj_p  = list_p;
+        list_p = *(void **)obj_p;
+        operator delete (obj_p);
+    }
+
+    return 0;
+}
+
+#endif
+
+int
+main (
+        void)
+{
+    CyFxBenchSlot_t *slot_p;
+    uint32_t         op, i;
+    uint64_t         t0, t1;
+
+    CyFxHostRamMap ();
+    CyU3PMemInit ();
+    srand (10);
+
+    for (op = 0; op < CY_FX_BENCH_OPS; op++)
+    {
+        slot_p = &glBenchSlot[(uint32_t)rand () % CY_FX_BENCH_SLOTS];
+        if (slot_p->mem_p == 0)
+        {
+            slot_p->size = CyFxBenchSize ();
+            t0 = CyFxHostTimeNs ();
+            slot_p->mem_p = new uint8_t[slot_p->size];
+            t1 = CyFxHostTimeNs ();
+            CyFxBenchRecord (&glBenchNew, t1 - t0);
+
+            slot_p->fill = (uint8_t)rand ();
+            memset (slot_p->mem_p, slot_p->fill, slot_p->size);
+        }
+        else
+        {
+            for (i = 0; i < slot_p->size; i++)
+            {
+                if (slot_p->mem_p[i] != slot_p->fill)
+                {
+                    printf ("FAIL: object %p of %u bytes modified at offset %u\n", slot_p->mem_p, slot_p->size, i);
+                    return 1;
+                }
+            }
+
+            t0 = CyFxHostTimeNs ();
+            delete[] slot_p->mem_p;
+            t1 = CyFxHostTimeNs ();
+            CyFxBenchRecord (&glBenchDelete, t1 - t0);
+            slot_p->mem_p = 0;
+        }
+    }
+
+    CyFxBenchPrint ("new", &glBenchNew);
+    CyFxBenchPrint ("delete", &glBenchDelete);
+
+    for (slot_p = glBenchSlot; slot_p < &glBenchSlot[CY_FX_BENCH_SLOTS]; slot_p++)
+    {
+        delete[] slot_p->mem_p;
+        slot_p->mem_p = 0;
+    }
+
+#ifdef CY_FX_BENCH_USE_CPPNEW
+    if (CyFxBenchCheckFailure () != 0)
+        return 1;
+#endif
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
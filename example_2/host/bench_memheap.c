@@ -0,0 +1,290 @@
+/*
+ ## Cypress FX3 Host Test Source File (bench_memheap.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host stress test and benchmark for the driver heap in cyfxtx.
+ *
+ * The test is built twice: with the default ThreadX byte pool (modelled in fx3hoststub.c) and with
+ * CYFXTX_MEM_USE_TLSF. Both builds run the same seeded workload of small, medium and thread stack
+ * sized blocks with random lifetimes on the 32 KB driver heap, and report the alloc and free latency,
+ * the fragmentation index and the number of failed allocations. The contents of each block are
+ * checked before it is freed.
+ *
+ * When run with the "checks" argument, the memory leak and corruption checks are enabled as well,
+ * the heap is checked periodically with CyU3PMemCorruptionCheck, and a corrupted block footer must
+ * be reported through the corruption callback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx3hoststub.h"
+
+#include "cyfxtx.c"
+
+#define CY_FX_BENCH_SLOTS               (128)           /* Number of blocks that can be held at a time. */
+#define CY_FX_BENCH_OPS                 (1000000)       /* Number of alloc/free operations. */
+#define CY_FX_BENCH_STATS_PERIOD        (1000)          /* Operations between heap statistics samples. */
+#define CY_FX_BENCH_CHECK_PERIOD        (10000)         /* Operations between corruption checks. */
+#define CY_FX_BENCH_HIST_BINS           (10000)         /* Latency histogram bins of 10 ns each. */
+
+#ifdef CYFXTX_MEM_USE_TLSF
+#define CY_FX_BENCH_HEAP_NAME           "tlsf"
+#else
+#define CY_FX_BENCH_HEAP_NAME           "bytepool"
+#endif
+
+/* A block held by the workload. */
+typedef struct CyFxBenchSlot_t
+{
+    uint8_t  *mem_p;                    /* Block pointer, or NULL if the slot is empty. */
+    uint32_t  size;                     /* Requested size. */
+    uint8_t   fill;                     /* Byte value filled into the block. */
+} CyFxBenchSlot_t;
+
+/* Latency statistics for one operation type. */
+typedef struct CyFxBenchLatency_t
+{
+    uint64_t count;                     /* Number of operations timed. */
+    uint64_t totalNs;                   /* Total time taken. */
+    uint64_t maxNs;                     /* Longest time taken. */
+    uint32_t hist[CY_FX_BENCH_HIST_BINS];
+} CyFxBenchLatency_t;
+
+static CyFxBenchSlot_t    glBenchSlot[CY_FX_BENCH_SLOTS];
+static CyFxBenchLatency_t glBenchAlloc;
+static CyFxBenchLatency_t glBenchFree;
+static void              *glBenchBadBlock = 0;          /* Block reported by the corruption callback. */
+
+static void
+CyFxBenchRecord (
+        CyFxBenchLatency_t *lat_p,
+        uint64_t            ns)
+{
+    uint64_t bin = ns / 10;
+
+    lat_p->count++;
+    lat_p->totalNs += ns;
+    if (ns > lat_p->maxNs)
+        lat_p->maxNs = ns;
+    lat_p->hist[(bin < CY_FX_BENCH_HIST_BINS) ? bin : (CY_FX_BENCH_HIST_BINS - 1)]++;
+}
+
+/* Latency in ns below which the given fraction (in parts per million) of the operations completed. */
+static uint64_t
+CyFxBenchPercentile (
+        const CyFxBenchLatency_t *lat_p,
+        uint32_t                  ppm)
+{
+    uint64_t limit = (lat_p->count * ppm) / 1000000;
+    uint64_t sum   = 0;
+    uint32_t bin;
+
+    for (bin = 0; bin < CY_FX_BENCH_HIST_BINS; bin++)
+    {
+        sum += lat_p->hist[bin];
+        if (sum > limit)
+            break;
+    }
+
+    return ((uint64_t)(bin + 1) * 10);
+}
+
+static void
+CyFxBenchPrint (
+        const char               *name,
+        const CyFxBenchLatency_t *lat_p)
+{
+    printf ("%-8s %-5s mean %6.1f ns  p99 %6llu ns  p99.9 %6llu ns  max %8llu ns\n", CY_FX_BENCH_HEAP_NAME,
+            name, (lat_p->count != 0) ? ((double)lat_p->totalNs / lat_p->count) : 0.0,
+            (unsigned long long)CyFxBenchPercentile (lat_p, 990000),
+            (unsigned long long)CyFxBenchPercentile (lat_p, 999000), (unsigned long long)lat_p->maxNs);
+}
+
+/* Corruption callback registered when the checks are enabled. */
+static void
+CyFxBenchCorruptCb (
+        void *mem_p)
+{
+    glBenchBadBlock = mem_p;
+}
+
+/* Block size for the workload: mostly small objects, with some medium sized buffers and a few
+   thread stack sized blocks. */
+static uint32_t
+CyFxBenchSize (
+        void)
+{
+    uint32_t sel = (uint32_t)rand () % 100;
+
+    if (sel < 70)
+        return (8 + ((uint32_t)rand () % 121));
+    if (sel < 92)
+        return (128 + ((uint32_t)rand () % 897));
+    return (1024 + ((uint32_t)rand () % 3073));
+}
+
+static int
+CyFxBenchVerify (
+        const CyFxBenchSlot_t *slot_p)
+{
+    uint32_t i;
+
+    for (i = 0; i < slot_p->size; i++)
+    {
+        if (slot_p->mem_p[i] != slot_p->fill)
+        {
+            printf ("FAIL: block %p of %u bytes modified at offset %u\n", slot_p->mem_p, slot_p->size, i);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int
+main (
+        int   argc,
+        char *argv[])
+{
+    CyFxBenchSlot_t  *slot_p;
+    CyU3PHeapStats_t  stats;
+    CyBool_t          checks = ((argc > 1) && (strcmp (argv[1], "checks") == 0));
+    uint32_t          op, maxFrag = 0, sumFrag = 0, samples = 0, allocCnt, freeCnt;
+    uint64_t          t0, t1;
+
+    CyFxHostRamMap ();
+    if (checks)
+        CyU3PMemEnableChecks (CyTrue, CyFxBenchCorruptCb);
+    CyU3PMemInit ();
+    srand (4);
+
+    for (op = 0; op < CY_FX_BENCH_OPS; op++)
+    {
+        slot_p = &glBenchSlot[(uint32_t)rand () % CY_FX_BENCH_SLOTS];
+        if (slot_p->mem_p == 0)
+        {
+            slot_p->size = CyFxBenchSize ();
+            t0 = CyFxHostTimeNs ();
+            slot_p->mem_p = (uint8_t *)CyU3PMemAlloc (slot_p->size);
+            t1 = CyFxHostTimeNs ();
+            CyFxBenchRecord (&glBenchAlloc, t1 - t0);
+
+            if (slot_p->mem_p != 0)
+            {
+                if (((uint32_t)(uintptr_t)slot_p->mem_p < CY_U3P_MEM_HEAP_BASE) ||
+                        (((uint32_t)(uintptr_t)slot_p->mem_p + slot_p->size) > CY_U3P_BUFFER_HEAP_BASE) ||
+                        (((uintptr_t)slot_p->mem_p & 3) != 0))
+                {
+                    printf ("FAIL: block %p of %u bytes outside the heap\n", slot_p->mem_p, slot_p->size);
+                    return 1;
+                }
+
+                slot_p->fill = (uint8_t)rand ();
+                memset (slot_p->mem_p, slot_p->fill, slot_p->size);
+            }
+        }
+        else
+        {
+            if (CyFxBenchVerify (slot_p) != 0)
+                return 1;
+
+            t0 = CyFxHostTimeNs ();
+            CyU3PMemFree (slot_p->mem_p);
+            t1 = CyFxHostTimeNs ();
+            CyFxBenchRecord (&glBenchFree, t1 - t0);
+            slot_p->mem_p = 0;
+        }
+
+        if ((op % CY_FX_BENCH_STATS_PERIOD) == 0)
+        {
+            CyU3PMemGetStats (&stats);
+            sumFrag += stats.fragPermille;
+            samples++;
+            if (stats.fragPermille > maxFrag)
+                maxFrag = stats.fragPermille;
+        }
+
+        if (checks && ((op % CY_FX_BENCH_CHECK_PERIOD) == 0) && (CyU3PMemCorruptionCheck () != CY_U3P_SUCCESS))
+        {
+            printf ("FAIL: corruption check failed after %u operations\n", op);
+            return 1;
+        }
+    }
+
+    CyU3PMemGetStats (&stats);
+    CyFxBenchPrint ("alloc", &glBenchAlloc);
+    CyFxBenchPrint ("free", &glBenchFree);
+    printf ("%-8s fragmentation mean %u max %u permille, %u of %llu allocations failed, peak %u of %u bytes\n",
+            CY_FX_BENCH_HEAP_NAME, sumFrag / samples, maxFrag, stats.failCnt,
+            (unsigned long long)glBenchAlloc.count, stats.peakBytes, stats.heapSize);
+
+    if (checks)
+    {
+        /* Overwrite the footer of one of the blocks held, and check that it is reported. */
+        for (slot_p = glBenchSlot; slot_p->mem_p == 0; slot_p++)
+            ;
+        slot_p->mem_p[ROUND_UP (slot_p->size, 4)] ^= 0xFF;
+        if ((CyU3PMemCorruptionCheck () == CY_U3P_SUCCESS) || (glBenchBadBlock != slot_p->mem_p))
+        {
+            printf ("FAIL: corrupted block %p was not reported\n", slot_p->mem_p);
+            return 1;
+        }
+        slot_p->mem_p[ROUND_UP (slot_p->size, 4)] ^= 0xFF;
+    }
+
+    /* Free everything: the heap must then be empty and unfragmented. */
+    for (slot_p = glBenchSlot; slot_p < &glBenchSlot[CY_FX_BENCH_SLOTS]; slot_p++)
+    {
+        if (slot_p->mem_p != 0)
+        {
+            if (CyFxBenchVerify (slot_p) != 0)
+                return 1;
+            CyU3PMemFree (slot_p->mem_p);
+            slot_p->mem_p = 0;
+        }
+    }
+
+    CyU3PMemGetStats (&stats);
+    if ((stats.curBytes != 0) || (stats.fragPermille != 0))
+    {
+        printf ("FAIL: %u bytes still allocated, fragmentation %u permille after freeing all blocks\n",
+                stats.curBytes, stats.fragPermille);
+        return 1;
+    }
+
+    if (checks)
+    {
+        CyU3PMemGetCounts (&allocCnt, &freeCnt);
+        if ((allocCnt != freeCnt) || (CyU3PMemGetActiveList () != 0))
+        {
+            printf ("FAIL: %u allocs and %u frees counted, active list %p\n", allocCnt, freeCnt,
+                    (void *)CyU3PMemGetActiveList ());
+            return 1;
+        }
+    }
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
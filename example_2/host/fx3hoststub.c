@@ -0,0 +1,290 @@
+/*
+ ## Cypress FX3 Host Test Source File (fx3hoststub.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host implementation of the SDK services used by the FX3 heap and utility tests.
+ *
+ * The RTOS services are reduced to what a single threaded test needs. The byte pool follows the
+ * ThreadX byte pool algorithm, as the driver heap statistics and fragmentation behaviour depend on
+ * it: blocks are found with a first fit search starting from a roving search pointer, adjacent free
+ * blocks are only merged during the search, and a released block becomes the new search pointer.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "fx3hoststub.h"
+
+#define CY_FX_HOST_POOL_HDR             (8)             /* Size of the byte pool block header. */
+#define CY_FX_HOST_POOL_FREE            (0xFFFFEEEEU)   /* Owner word of a free block. */
+#define CY_FX_HOST_POOL_MIN             (20)            /* Smallest remainder split off a block. */
+
+/* Access a word of the FX3 RAM through its 32 bit address. */
+#define CY_FX_HOST_WORD(addr)           (((volatile uint32_t *)(uintptr_t)(addr))[0])
+
+static CyBool_t       glHostIsThread = CyTrue;          /* Whether thread context is reported. */
+static uint32_t       glHostMutexGet = 0;               /* Number of CyU3PMutexGet calls. */
+static uint32_t       glHostMutexPut = 0;               /* Number of CyU3PMutexPut calls. */
+static CyU3PBytePool *glHostPool     = 0;               /* The byte pool: only one is supported. */
+
+void
+CyFxHostRamMap (
+        void)
+{
+    void *mem_p;
+
+    mem_p = mmap ((void *)(uintptr_t)CY_FX_HOST_RAM_BASE, CY_FX_HOST_RAM_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (mem_p != (void *)(uintptr_t)CY_FX_HOST_RAM_BASE)
+    {
+        fprintf (stderr, "Failed to map the FX3 RAM at 0x%08X\n", CY_FX_HOST_RAM_BASE);
+        exit (2);
+    }
+}
+
+void
+CyFxHostSetThread (
+        CyBool_t isThread)
+{
+    glHostIsThread = isThread;
+}
+
+uint64_t
+CyFxHostTimeNs (
+        void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+void
+CyFxHostMutexCounts (
+        uint32_t *getCnt_p,
+        uint32_t *putCnt_p)
+{
+    *getCnt_p = glHostMutexGet;
+    *putCnt_p = glHostMutexPut;
+}
+
+void
+CyU3PApplicationDefine (
+        void)
+{
+}
+
+void *
+CyU3PThreadIdentify (
+        void)
+{
+    /* Any non-NULL value identifies thread context. */
+    return (glHostIsThread) ? (void *)&glHostIsThread : 0;
+}
+
+uint32_t
+CyU3PThreadSleep (
+        uint32_t sleepTime)
+{
+    /* There are no other threads to give way to. */
+    (void) sleepTime;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PMutexCreate (
+        CyU3PMutex *mutex_p,
+        uint32_t    priorityInherit)
+{
+    (void) priorityInherit;
+    mutex_p->getCnt = 0;
+    mutex_p->putCnt = 0;
+    mutex_p->held   = CyFalse;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PMutexDestroy (
+        CyU3PMutex *mutex_p)
+{
+    (void) mutex_p;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PMutexGet (
+        CyU3PMutex *mutex_p,
+        uint32_t    waitOption)
+{
+    if ((mutex_p->held) && (waitOption == CYU3P_NO_WAIT))
+        return CY_U3P_ERROR_TIMEOUT;
+
+    mutex_p->held = CyTrue;
+    mutex_p->getCnt++;
+    glHostMutexGet++;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PMutexPut (
+        CyU3PMutex *mutex_p)
+{
+    mutex_p->held = CyFalse;
+    mutex_p->putCnt++;
+    glHostMutexPut++;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PBytePoolCreate (
+        CyU3PBytePool *pool_p,
+        void          *poolStart,
+        uint32_t       poolSize)
+{
+    uint32_t start = (uint32_t)(uintptr_t)poolStart;
+    uint32_t last;
+
+    if ((glHostPool != 0) || ((uintptr_t)poolStart != start) || (poolSize < 100))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    start    = (start + 3) & ~3U;
+    poolSize = poolSize & ~3U;
+    last     = start + poolSize - CY_FX_HOST_POOL_HDR;
+
+    /* One free block spanning the pool, followed by an allocated block which links back to the start. */
+    CY_FX_HOST_WORD (start)     = last;
+    CY_FX_HOST_WORD (start + 4) = CY_FX_HOST_POOL_FREE;
+    CY_FX_HOST_WORD (last)      = start;
+    CY_FX_HOST_WORD (last + 4)  = (uint32_t)(uintptr_t)pool_p;
+
+    pool_p->start     = start;
+    pool_p->size      = poolSize;
+    pool_p->search    = start;
+    pool_p->fragments = 2;
+    pool_p->available = poolSize - 2 * CY_FX_HOST_POOL_HDR;
+
+    glHostPool = pool_p;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PBytePoolDestroy (
+        CyU3PBytePool *pool_p)
+{
+    if (pool_p != glHostPool)
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    glHostPool = 0;
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PByteAlloc (
+        CyU3PBytePool *pool_p,
+        void         **mem_p,
+        uint32_t       memSize,
+        uint32_t       waitOption)
+{
+    uint32_t block, next, size, examine;
+
+    (void) waitOption;
+    *mem_p = 0;
+
+    if ((pool_p != glHostPool) || (memSize == 0))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    memSize = (memSize + 3) & ~3U;
+    if (memSize > pool_p->available)
+        return CY_U3P_ERROR_MEMORY_ERROR;
+
+    /* First fit search from the search pointer, merging free neighbours on the way. */
+    block   = pool_p->search;
+    examine = pool_p->fragments + 1;
+    while (examine != 0)
+    {
+        next = CY_FX_HOST_WORD (block);
+        if (CY_FX_HOST_WORD (block + 4) == CY_FX_HOST_POOL_FREE)
+        {
+            size = next - block - CY_FX_HOST_POOL_HDR;
+            if (size >= memSize)
+                break;
+
+            if (CY_FX_HOST_WORD (next + 4) == CY_FX_HOST_POOL_FREE)
+            {
+                /* Merge the next block into this one, and examine this block again. */
+                CY_FX_HOST_WORD (block) = CY_FX_HOST_WORD (next);
+                pool_p->fragments--;
+                pool_p->available += CY_FX_HOST_POOL_HDR;
+                if (pool_p->search == next)
+                    pool_p->search = block;
+                continue;
+            }
+        }
+
+        block = next;
+        examine--;
+    }
+
+    if (examine == 0)
+        return CY_U3P_ERROR_MEMORY_ERROR;
+
+    /* Split off the rest of the block if it is large enough to be useful. */
+    next = CY_FX_HOST_WORD (block);
+    size = next - block - CY_FX_HOST_POOL_HDR;
+    if ((size - memSize) >= CY_FX_HOST_POOL_MIN)
+    {
+        CY_FX_HOST_WORD (block + CY_FX_HOST_POOL_HDR + memSize)     = next;
+        CY_FX_HOST_WORD (block + CY_FX_HOST_POOL_HDR + memSize + 4) = CY_FX_HOST_POOL_FREE;
+        CY_FX_HOST_WORD (block) = block + CY_FX_HOST_POOL_HDR + memSize;
+        pool_p->fragments++;
+        pool_p->available -= CY_FX_HOST_POOL_HDR;
+        size = memSize;
+    }
+
+    CY_FX_HOST_WORD (block + 4) = (uint32_t)(uintptr_t)pool_p;
+    pool_p->available -= size;
+    pool_p->search     = CY_FX_HOST_WORD (block);
+
+    *mem_p = (void *)(uintptr_t)(block + CY_FX_HOST_POOL_HDR);
+    return CY_U3P_SUCCESS;
+}
+
+uint32_t
+CyU3PByteFree (
+        void *mem_p)
+{
+    uint32_t block = (uint32_t)(uintptr_t)mem_p - CY_FX_HOST_POOL_HDR;
+
+    if ((glHostPool == 0) || (mem_p == 0) || (CY_FX_HOST_WORD (block + 4) == CY_FX_HOST_POOL_FREE))
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+
+    CY_FX_HOST_WORD (block + 4) = CY_FX_HOST_POOL_FREE;
+    glHostPool->available += CY_FX_HOST_WORD (block) - block - CY_FX_HOST_POOL_HDR;
+    glHostPool->search     = block;
+    return CY_U3P_SUCCESS;
+}
+
+/*[]*/
@@ -0,0 +1,64 @@
+/*
+ ## Cypress FX3 Host Test Header File (fx3hoststub.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Helpers used by the host builds of the FX3 heap and utility tests. The SDK functions used by the
+ * sources under test are implemented in fx3hoststub.c, on top of the stand-in headers in sdkstub. */
+
+#ifndef _INCLUDED_FX3HOSTSTUB_H_
+#define _INCLUDED_FX3HOSTSTUB_H_
+
+#include <stdint.h>
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+/* Base and size of the FX3 system RAM. */
+#define CY_FX_HOST_RAM_BASE             (0x40000000U)
+#define CY_FX_HOST_RAM_SIZE             (0x80000U)
+
+/* Map host memory at the FX3 system RAM address, so that the heap addresses used by cyfxtx are
+   valid and fit in 32 bits. Exits the test if the mapping fails. */
+extern void
+CyFxHostRamMap (
+        void);
+
+/* Select whether the RTOS wrappers report thread context (the default) or interrupt context. */
+extern void
+CyFxHostSetThread (
+        CyBool_t isThread);
+
+/* Monotonic time stamp in nanoseconds. */
+extern uint64_t
+CyFxHostTimeNs (
+        void);
+
+/* Number of mutex Get and Put calls made on all mutexes. The tests check that these are equal
+   whenever no allocator call is in progress. */
+extern void
+CyFxHostMutexCounts (
+        uint32_t *getCnt_p,
+        uint32_t *putCnt_p);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_FX3HOSTSTUB_H_ */
+
+/*[]*/
@@ -0,0 +1,872 @@
+/*
+ ## Cypress FX3 Host Tool Source File (fx3lpbench.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host side benchmark for the bulk loop firmware (demo_cpp, example_c and example_cpp), using libusb-1.0.
+ *
+ * fx3lpbench [options] throughput
+ *     Keeps a queue of OUT and IN transfers busy on the loopback endpoints for the test duration, and
+ *     reports the echoed data rate in MB/s (10^6 bytes per second). The transfer size should be a
+ *     multiple of the firmware DMA buffer size: the DMA AUTO channel only sends a buffer back once it is
+ *     full or ends with a short packet. With -p, the test is run with 1 to the given number of endpoint
+ *     pairs active at the same time, and the rate of each pair and the aggregate rate are reported for
+ *     each step, showing how the throughput scales with the number of pairs.
+ *
+ * fx3lpbench [options] latency
+ *     Sends small transfers on the first endpoint pair, each one followed by an IN transfer for its echo,
+ *     keeping the given number of transfers in flight. The round trip time of each transfer, from the
+ *     OUT submission to the IN completion, is collected, and the p50, p99, p99.9 and maximum values are
+ *     reported. With -S, the transfers in flight are interleaved over the bulk streams of the endpoints
+ *     (firmware built with CY_FX_BULKLP_NUM_STREAMS); without it they are all queued on the endpoints
+ *     themselves. Running the test on both builds with the same -q compares the latency of interleaved
+ *     small transfers with and without streams. The transfer size must be less than the packet size, so
+ *     that the short packet makes the DMA AUTO channel send each transfer back on its own.
+ *
+ *     If the firmware is built in latency mode (CY_FX_BULKLP_LATENCY_MODE), which is detected by vendor
+ *     request 0x8D, the CyFxBulkLpLatHeader_t at the start of each echo is decoded as well. Each header
+ *     carries the device residence time of the latest buffer fully sent on its channel, in ticks of the
+ *     tickHz timer reported by 0x8D, and each buffer is counted once. The p50, p99 and p99.9 device
+ *     residence times are then reported next to the round trip times, followed by the transfer size
+ *     histogram kept by the firmware. The transfer size must be at least 16 bytes for the header.
+ *
+ * fx3lpbench [options] halt
+ *     Runs repeated halt and clear cycles on the first endpoint pair. Each cycle halts the OUT and the IN
+ *     endpoint with SET_FEATURE(ENDPOINT_HALT), clears both with CLEAR_FEATURE(ENDPOINT_HALT) and then
+ *     checks that a transfer is echoed again. Three times are collected for each cycle: the EP0 turnaround
+ *     of the SET_FEATURE requests, the time taken by the CLEAR_FEATURE requests, which the firmware only
+ *     completes once it has reset the endpoints and their DMA channel, and the recovery time from the start
+ *     of the first CLEAR_FEATURE to the end of the echo. Their p50, p99 and p99.9 values are reported.
+ *     The transfer size must be less than the packet size, as for the latency test.
+ *
+ * Options:
+ *     -t <seconds>   Test duration, for each step (default 5).
+ *     -s <bytes>     Transfer size (default 65536 for throughput, 64 for latency).
+ *     -q <count>     Number of transfers queued in each direction, on each pair (default 8).
+ *     -p <count>     Number of endpoint pairs in the firmware, CY_FX_BULKLP_NUM_PAIRS (default 1).
+ *     -n <count>     Number of transfers timed by the latency test, or of halt test cycles (default 10000).
+ *     -S <count>     Number of bulk streams to use in the latency test: 0, 2 or 4 (default 0).
+ *
+ * The packet size and the burst length advertised by the device are printed with the results, so that the
+ * runs for different firmware builds (CY_FX_EP_BURST_LENGTH, CY_FX_DMA_SIZE_MULTIPLIER and
+ * CY_FX_BULKLP_DMA_BUF_COUNT) can be told apart.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <libusb-1.0/libusb.h>
+
+#define CY_FX_LP_VID                    (0x04B4)        /* Vendor ID of the bulk loop firmware. */
+#define CY_FX_LP_PID                    (0x00F0)        /* Product ID of the bulk loop firmware. */
+#define CY_FX_LP_EP_OUT                 (0x01)          /* First loopback OUT endpoint. */
+#define CY_FX_LP_EP_IN                  (0x81)          /* First loopback IN endpoint. */
+#define CY_FX_LP_MAX_PAIRS              (4)             /* Maximum number of loopback endpoint pairs. */
+#define CY_FX_LP_MAX_QUEUE              (64)            /* Maximum number of queued transfers per direction. */
+#define CY_FX_LP_XFER_TIMEOUT           (5000)          /* Bulk transfer timeout in ms. */
+#define CY_FX_LP_RQT_LAT_STATS          (0x8D)          /* Vendor request: latency mode statistics. */
+#define CY_FX_LP_LAT_HDR_SIZE           (16)            /* Size of the latency mode echo header. */
+#define CY_FX_LP_LAT_NUM_BUCKETS        (8)             /* Number of transfer size buckets in 0x8D. */
+
+/* One direction of a loopback endpoint pair, with its queue of transfers. */
+typedef struct CyFxLpPipe_t
+{
+    uint8_t                 ep;                         /* Endpoint address. */
+    uint32_t                pending;                    /* Number of transfers submitted and not yet returned. */
+    uint64_t                bytes;                      /* Bytes transferred. */
+    int                     error;                      /* First transfer status other than COMPLETED, or 0. */
+    struct libusb_transfer *xfer[CY_FX_LP_MAX_QUEUE];
+} CyFxLpPipe_t;
+
+static libusb_context       *glLpCtx    = NULL;
+static libusb_device_handle *glLpHandle = NULL;
+static volatile int          glLpStop   = 0;            /* Set to stop resubmitting the transfers. */
+
+/* Test options. */
+static uint32_t glLpSeconds  = 5;
+static uint32_t glLpXferSize = 0;
+static uint32_t glLpQueue    = 8;
+static uint32_t glLpPairs    = 1;
+static uint32_t glLpCount    = 10000;
+static uint32_t glLpStreams  = 0;
+
+static uint64_t
+CyFxLpTimeNs (
+        void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+
+static void
+CyFxLpUsage (
+        void)
+{
+    fprintf (stderr, "usage: fx3lpbench [-t seconds] [-s bytes] [-q count] [-p pairs] throughput\n"
+            "       fx3lpbench [-s bytes] [-q count] [-n count] [-S streams] latency\n"
+            "       fx3lpbench [-s bytes] [-n count] halt\n");
+    exit (2);
+}
+
+/* Completion callback for the throughput transfers: count the data and resubmit the transfer. */
+static void
+CyFxLpXferCb (
+        struct libusb_transfer *xfer_p)
+{
+    CyFxLpPipe_t *pipe_p = (CyFxLpPipe_t *)xfer_p->user_data;
+
+    if (xfer_p->status == LIBUSB_TRANSFER_COMPLETED)
+    {
+        pipe_p->bytes += (uint64_t)xfer_p->actual_length;
+        if ((!glLpStop) && (libusb_submit_transfer (xfer_p) == 0))
+            return;
+    }
+    else if ((xfer_p->status != LIBUSB_TRANSFER_CANCELLED) && (pipe_p->error == 0))
+    {
+        pipe_p->error = (int)xfer_p->status;
+    }
+
+    pipe_p->pending--;
+}
+
+/* Allocate the transfers of a pipe, and submit them. */
+static int
+CyFxLpPipeStart (
+        CyFxLpPipe_t *pipe_p,
+        uint8_t       ep)
+{
+    uint8_t  *buf_p;
+    uint32_t  i, j;
+    int       status;
+
+    memset (pipe_p, 0, sizeof (*pipe_p));
+    pipe_p->ep = ep;
+
+    for (i = 0; i < glLpQueue; i++)
+    {
+        buf_p = (uint8_t *)malloc (glLpXferSize);
+        pipe_p->xfer[i] = libusb_alloc_transfer (0);
+        if ((buf_p == NULL) || (pipe_p->xfer[i] == NULL))
+        {
+            fprintf (stderr, "out of memory\n");
+            return -1;
+        }
+
+        /* Incrementing byte pattern, so that a bus trace shows where each transfer starts. */
+        for (j = 0; j < glLpXferSize; j++)
+            buf_p[j] = (uint8_t)(i + j);
+
+        libusb_fill_bulk_transfer (pipe_p->xfer[i], glLpHandle, ep, buf_p, (int)glLpXferSize, CyFxLpXferCb,
+                pipe_p, CY_FX_LP_XFER_TIMEOUT);
+        pipe_p->xfer[i]->flags = LIBUSB_TRANSFER_FREE_BUFFER;
+    }
+
+    for (i = 0; i < glLpQueue; i++)
+    {
+        status = libusb_submit_transfer (pipe_p->xfer[i]);
+        if (status != 0)
+        {
+            fprintf (stderr, "EP 0x%02x: submit failed: %s\n", ep, libusb_error_name (status));
+            return -1;
+        }
+        pipe_p->pending++;
+    }
+
+    return 0;
+}
+
+/* Cancel the transfers still pending on the given pipes, wait for them to return, and free them. */
+static void
+CyFxLpPipeStop (
+        CyFxLpPipe_t *pipes_p,
+        uint32_t      count)
+{
+    struct timeval tv = {0, 100000};
+    uint32_t       p, i, pending;
+
+    glLpStop = 1;
+    for (p = 0; p < count; p++)
+    {
+        for (i = 0; i < glLpQueue; i++)
+        {
+            if (pipes_p[p].xfer[i] != NULL)
+                libusb_cancel_transfer (pipes_p[p].xfer[i]);
+        }
+    }
+
+    do
+    {
+        libusb_handle_events_timeout_completed (glLpCtx, &tv, NULL);
+        for (p = 0, pending = 0; p < count; p++)
+            pending += pipes_p[p].pending;
+    } while (pending != 0);
+
+    for (p = 0; p < count; p++)
+    {
+        for (i = 0; i < glLpQueue; i++)
+        {
+            if (pipes_p[p].xfer[i] != NULL)
+                libusb_free_transfer (pipes_p[p].xfer[i]);
+            pipes_p[p].xfer[i] = NULL;
+        }
+    }
+    glLpStop = 0;
+}
+
+/* Print the packet size and burst length of the given endpoint. */
+static void
+CyFxLpPrintEp (
+        uint8_t ep)
+{
+    struct libusb_config_descriptor                *cfg_p;
+    struct libusb_ss_endpoint_companion_descriptor *comp_p;
+    const struct libusb_interface_descriptor       *intf_p;
+    int                                             i, burst = 0;
+
+    if (libusb_get_active_config_descriptor (libusb_get_device (glLpHandle), &cfg_p) != 0)
+        return;
+
+    intf_p = &cfg_p->interface[0].altsetting[0];
+    for (i = 0; i < intf_p->bNumEndpoints; i++)
+    {
+        if (intf_p->endpoint[i].bEndpointAddress != ep)
+            continue;
+
+        if (libusb_get_ss_endpoint_companion_descriptor (glLpCtx, &intf_p->endpoint[i], &comp_p) == 0)
+        {
+            burst = comp_p->bMaxBurst + 1;
+            libusb_free_ss_endpoint_companion_descriptor (comp_p);
+        }
+        printf ("EP 0x%02x: packet size %u, burst %d\n", ep, intf_p->endpoint[i].wMaxPacketSize, burst);
+    }
+
+    libusb_free_config_descriptor (cfg_p);
+}
+
+/* Throughput test step: keep the OUT and IN queues of the first npairs endpoint pairs busy for the test
+   duration. pipes[2n] is the OUT pipe of pair n, and pipes[2n + 1] the IN pipe. */
+static int
+CyFxLpThroughputStep (
+        uint32_t npairs)
+{
+    static CyFxLpPipe_t pipes[2 * CY_FX_LP_MAX_PAIRS];
+    struct timeval      tv = {0, 100000};
+    uint64_t            t0, t1, end, total = 0;
+    double              secs;
+    uint32_t            p, error = 0;
+    int                 running = 1;
+
+    memset (pipes, 0, sizeof (pipes));
+    for (p = 0; p < npairs; p++)
+    {
+        if ((CyFxLpPipeStart (&pipes[2 * p], (uint8_t)(CY_FX_LP_EP_OUT + p)) != 0) ||
+                (CyFxLpPipeStart (&pipes[2 * p + 1], (uint8_t)(CY_FX_LP_EP_IN + p)) != 0))
+        {
+            CyFxLpPipeStop (pipes, 2 * npairs);
+            return 1;
+        }
+    }
+
+    t0  = CyFxLpTimeNs ();
+    end = t0 + (uint64_t)glLpSeconds * 1000000000ULL;
+    while ((running) && (CyFxLpTimeNs () < end))
+    {
+        libusb_handle_events_timeout_completed (glLpCtx, &tv, NULL);
+        for (p = 0; p < 2 * npairs; p++)
+        {
+            if (pipes[p].pending == 0)
+                running = 0;
+        }
+    }
+    t1 = CyFxLpTimeNs ();
+    CyFxLpPipeStop (pipes, 2 * npairs);
+
+    secs = (double)(t1 - t0) / 1e9;
+    printf ("%u pair%s:", npairs, (npairs == 1) ? " " : "s");
+    for (p = 0; p < npairs; p++)
+    {
+        printf ("  EP %u %.1f MB/s", p + 1, (double)pipes[2 * p + 1].bytes / secs / 1e6);
+        total += pipes[2 * p + 1].bytes;
+        if ((pipes[2 * p].error != 0) || (pipes[2 * p + 1].error != 0))
+        {
+            fprintf (stderr, "pair %u transfer error: OUT status %d, IN status %d\n", p, pipes[2 * p].error,
+                    pipes[2 * p + 1].error);
+            error = 1;
+        }
+    }
+    printf ("  total %.1f MB/s\n", (double)total / secs / 1e6);
+
+    return (int)error;
+}
+
+/* Throughput test: one step for each number of active pairs, from 1 to glLpPairs. */
+static int
+CyFxLpThroughput (
+        void)
+{
+    uint32_t npairs;
+
+    CyFxLpPrintEp (CY_FX_LP_EP_OUT);
+    printf ("transfer %u bytes, queue %u\n", glLpXferSize, glLpQueue);
+    for (npairs = 1; npairs <= glLpPairs; npairs++)
+    {
+        if (CyFxLpThroughputStep (npairs) != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* A latency test channel: the loopback endpoints themselves, or one bulk stream on them. The echoed data
+   comes back in order on each channel, so the OUT submission times of the transfers in flight are kept in
+   a FIFO, and each IN completion is matched with the oldest one. */
+typedef struct CyFxLpLatChan_t
+{
+    uint32_t stream;                                    /* Stream ID, or 0 if streams are not used. */
+    int      doneValid;                                 /* Whether doneSeqNum holds a buffer already counted. */
+    uint32_t doneSeqNum;                                /* Latest buffer whose residence time was counted. */
+    uint32_t head;                                      /* FIFO index of the oldest transfer in flight. */
+    uint32_t tail;                                      /* FIFO index for the next transfer. */
+    uint64_t sentNs[CY_FX_LP_MAX_QUEUE];                /* OUT submission times of the transfers in flight. */
+} CyFxLpLatChan_t;
+
+/* One transfer in flight: the OUT transfer and the IN transfer which receives its echo. */
+typedef struct CyFxLpLatSlot_t
+{
+    CyFxLpLatChan_t        *chan_p;                     /* Channel used by the slot. */
+    struct libusb_transfer *out_p;                      /* OUT transfer. */
+    struct libusb_transfer *in_p;                       /* IN transfer. */
+    uint32_t                busy;                       /* Number of the two transfers not yet returned. */
+} CyFxLpLatSlot_t;
+
+static CyFxLpLatChan_t glLpLatChan[CY_FX_LP_MAX_QUEUE];
+static CyFxLpLatSlot_t glLpLatSlot[CY_FX_LP_MAX_QUEUE];
+static uint64_t       *glLpLatNs    = NULL;             /* Round trip times collected. */
+static uint32_t        glLpLatIssued = 0;               /* Number of transfers submitted. */
+static uint32_t        glLpLatDone   = 0;               /* Number of round trip times collected. */
+static int             glLpLatError  = 0;               /* First transfer error, or 0. */
+static uint32_t        glLpLatTickHz = 0;               /* Firmware timer frequency, or 0 if not in latency mode. */
+static uint64_t       *glLpResNs     = NULL;            /* Device residence times collected. */
+static uint32_t        glLpResDone   = 0;               /* Number of residence times collected. */
+
+static uint32_t
+CyFxLpGetLe32 (
+        const uint8_t *p)
+{
+    return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/* Read the latency mode statistics with vendor request 0x8D, clearing the histogram if clear is set.
+   Returns the timer frequency, or 0 if the firmware is not built in latency mode. */
+static uint32_t
+CyFxLpGetLatStats (
+        uint32_t *hist_p,
+        int       clear)
+{
+    uint8_t  buf[4 + 4 * CY_FX_LP_LAT_NUM_BUCKETS];
+    uint32_t i;
+
+    if (libusb_control_transfer (glLpHandle, LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE,
+                CY_FX_LP_RQT_LAT_STATS, (uint16_t)(clear ? 1 : 0), 0, buf, sizeof (buf), 1000) != (int)sizeof (buf))
+        return 0;
+
+    for (i = 0; (hist_p != NULL) && (i < CY_FX_LP_LAT_NUM_BUCKETS); i++)
+        hist_p[i] = CyFxLpGetLe32 (&buf[4 + 4 * i]);
+    return CyFxLpGetLe32 (buf);
+}
+
+static int
+CyFxLpCompareU64 (
+        const void *a_p,
+        const void *b_p)
+{
+    uint64_t a = *(const uint64_t *)a_p, b = *(const uint64_t *)b_p;
+
+    return ((a > b) - (a < b));
+}
+
+/* Sort the given times, and print their p50, p99, p99.9 and maximum values in us. */
+static void
+CyFxLpPrintPercentiles (
+        const char *name,
+        uint64_t   *ns_p,
+        uint32_t    count)
+{
+    if (count == 0)
+        return;
+
+    qsort (ns_p, count, sizeof (uint64_t), CyFxLpCompareU64);
+    printf ("%-16s p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us  max %8.1f us  (%u samples)\n", name,
+            (double)ns_p[(uint64_t)count * 500 / 1000] / 1e3, (double)ns_p[(uint64_t)count * 990 / 1000] / 1e3,
+            (double)ns_p[(uint64_t)count * 999 / 1000] / 1e3, (double)ns_p[count - 1] / 1e3, count);
+}
+
+/* Submit the OUT and IN transfers of a slot, if there are transfers left to be sent. */
+static void
+CyFxLpLatSlotStart (
+        CyFxLpLatSlot_t *slot_p)
+{
+    CyFxLpLatChan_t *chan_p = slot_p->chan_p;
+    int              status;
+
+    if ((glLpLatIssued >= glLpCount) || (glLpLatError != 0))
+        return;
+
+    /* The IN transfer is queued first, so that it is ready when the echo comes back. */
+    status = libusb_submit_transfer (slot_p->in_p);
+    if (status == 0)
+    {
+        slot_p->busy++;
+        chan_p->sentNs[chan_p->tail++ % CY_FX_LP_MAX_QUEUE] = CyFxLpTimeNs ();
+        status = libusb_submit_transfer (slot_p->out_p);
+        if (status == 0)
+            slot_p->busy++;
+    }
+
+    if (status != 0)
+    {
+        fprintf (stderr, "latency: submit failed: %s\n", libusb_error_name (status));
+        glLpLatError = LIBUSB_TRANSFER_ERROR;
+        return;
+    }
+
+    glLpLatIssued++;
+}
+
+/* Completion callback for the latency test transfers. */
+static void
+CyFxLpLatXferCb (
+        struct libusb_transfer *xfer_p)
+{
+    CyFxLpLatSlot_t *slot_p = (CyFxLpLatSlot_t *)xfer_p->user_data;
+    CyFxLpLatChan_t *chan_p = slot_p->chan_p;
+    uint64_t         now = CyFxLpTimeNs ();
+
+    if (xfer_p->status != LIBUSB_TRANSFER_COMPLETED)
+    {
+        if ((xfer_p->status != LIBUSB_TRANSFER_CANCELLED) && (glLpLatError == 0))
+            glLpLatError = (int)xfer_p->status;
+    }
+    else if (xfer_p == slot_p->in_p)
+    {
+        glLpLatNs[glLpLatDone++] = now - chan_p->sentNs[chan_p->head++ % CY_FX_LP_MAX_QUEUE];
+
+        /* Latency mode header: doneSeqNum, doneTicks at offsets 8 and 12. The same buffer is reported
+           by every echo until the next one is sent, so each one is only counted once. */
+        if ((glLpLatTickHz != 0) && (xfer_p->actual_length >= CY_FX_LP_LAT_HDR_SIZE))
+        {
+            uint32_t doneSeqNum = CyFxLpGetLe32 (&xfer_p->buffer[8]);
+            uint32_t doneTicks  = CyFxLpGetLe32 (&xfer_p->buffer[12]);
+
+            if ((doneTicks != 0xFFFFFFFF) && ((!chan_p->doneValid) || (doneSeqNum != chan_p->doneSeqNum)) &&
+                    (glLpResDone < glLpCount))
+            {
+                chan_p->doneValid  = 1;
+                chan_p->doneSeqNum = doneSeqNum;
+                glLpResNs[glLpResDone++] = (uint64_t)doneTicks * 1000000000ULL / glLpLatTickHz;
+            }
+        }
+    }
+
+    if (--slot_p->busy == 0)
+        CyFxLpLatSlotStart (slot_p);
+}
+
+/* Latency test: keep glLpQueue small transfers in flight, spread over the streams if they are used. */
+static int
+CyFxLpLatency (
+        void)
+{
+    static const char *name[] = {"round trip", "round trip, 2 streams", "", "", "round trip, 4 streams"};
+    unsigned char      eps[2] = {CY_FX_LP_EP_OUT, CY_FX_LP_EP_IN};
+    struct timeval     tv = {0, 100000};
+    uint32_t           i, nchan, pktSize;
+    int                status, ret = 0;
+
+    pktSize = (uint32_t)libusb_get_max_packet_size (libusb_get_device (glLpHandle), CY_FX_LP_EP_IN);
+    if ((glLpXferSize >= pktSize) || (glLpXferSize == 0))
+    {
+        fprintf (stderr, "latency: transfer size must be 1 to %u bytes\n", pktSize - 1);
+        return 2;
+    }
+
+    if (glLpStreams != 0)
+    {
+        status = libusb_alloc_streams (glLpHandle, glLpStreams, eps, 2);
+        if (status != (int)glLpStreams)
+        {
+            fprintf (stderr, "latency: cannot allocate %u streams: %s\n", glLpStreams,
+                    (status < 0) ? libusb_error_name (status) : "fewer streams allocated");
+            if (status > 0)
+                libusb_free_streams (glLpHandle, eps, 2);
+            return 1;
+        }
+    }
+
+    glLpLatNs = (uint64_t *)calloc (glLpCount, sizeof (uint64_t));
+    glLpResNs = (uint64_t *)calloc (glLpCount, sizeof (uint64_t));
+    if ((glLpLatNs == NULL) || (glLpResNs == NULL))
+    {
+        fprintf (stderr, "out of memory\n");
+        ret = 1;
+        goto done;
+    }
+
+    nchan = (glLpStreams != 0) ? glLpStreams : 1;
+    memset (glLpLatChan, 0, sizeof (glLpLatChan));
+    for (i = 0; i < nchan; i++)
+        glLpLatChan[i].stream = (glLpStreams != 0) ? (i + 1) : 0;
+
+    glLpLatIssued = 0;
+    glLpLatDone   = 0;
+    glLpLatError  = 0;
+    glLpResDone   = 0;
+    glLpLatTickHz = CyFxLpGetLatStats (NULL, 1);
+    if ((glLpLatTickHz != 0) && (glLpXferSize < CY_FX_LP_LAT_HDR_SIZE))
+        printf ("latency mode firmware: transfers shorter than %u bytes carry no header\n", CY_FX_LP_LAT_HDR_SIZE);
+    for (i = 0; i < glLpQueue; i++)
+    {
+        CyFxLpLatSlot_t *slot_p = &glLpLatSlot[i];
+        uint32_t         stream;
+
+        slot_p->chan_p = &glLpLatChan[i % nchan];
+        slot_p->busy   = 0;
+        slot_p->out_p  = libusb_alloc_transfer (0);
+        slot_p->in_p   = libusb_alloc_transfer (0);
+        if ((slot_p->out_p == NULL) || (slot_p->in_p == NULL))
+        {
+            fprintf (stderr, "out of memory\n");
+            glLpQueue = i + 1;
+            ret = 1;
+            goto done;
+        }
+
+        stream = slot_p->chan_p->stream;
+        if (stream != 0)
+        {
+            libusb_fill_bulk_stream_transfer (slot_p->out_p, glLpHandle, CY_FX_LP_EP_OUT, stream,
+                    (unsigned char *)calloc (1, glLpXferSize), (int)glLpXferSize, CyFxLpLatXferCb, slot_p,
+                    CY_FX_LP_XFER_TIMEOUT);
+            libusb_fill_bulk_stream_transfer (slot_p->in_p, glLpHandle, CY_FX_LP_EP_IN, stream,
+                    (unsigned char *)calloc (1, pktSize), (int)pktSize, CyFxLpLatXferCb, slot_p,
+                    CY_FX_LP_XFER_TIMEOUT);
+        }
+        else
+        {
+            libusb_fill_bulk_transfer (slot_p->out_p, glLpHandle, CY_FX_LP_EP_OUT,
+                    (unsigned char *)calloc (1, glLpXferSize), (int)glLpXferSize, CyFxLpLatXferCb, slot_p,
+                    CY_FX_LP_XFER_TIMEOUT);
+            libusb_fill_bulk_transfer (slot_p->in_p, glLpHandle, CY_FX_LP_EP_IN,
+                    (unsigned char *)calloc (1, pktSize), (int)pktSize, CyFxLpLatXferCb, slot_p,
+                    CY_FX_LP_XFER_TIMEOUT);
+        }
+        slot_p->out_p->flags = LIBUSB_TRANSFER_FREE_BUFFER;
+        slot_p->in_p->flags  = LIBUSB_TRANSFER_FREE_BUFFER;
+        if ((slot_p->out_p->buffer == NULL) || (slot_p->in_p->buffer == NULL))
+        {
+            fprintf (stderr, "out of memory\n");
+            glLpQueue = i + 1;
+            ret = 1;
+            goto done;
+        }
+    }
+
+    for (i = 0; i < glLpQueue; i++)
+        CyFxLpLatSlotStart (&glLpLatSlot[i]);
+
+    while ((glLpLatDone < glLpCount) && (glLpLatError == 0))
+        libusb_handle_events_timeout_completed (glLpCtx, &tv, NULL);
+
+    if (glLpLatError != 0)
+    {
+        fprintf (stderr, "latency: transfer status %d after %u transfers\n", glLpLatError, glLpLatDone);
+        ret = 1;
+    }
+
+    printf ("transfer %u bytes, %u in flight\n", glLpXferSize, glLpQueue);
+    CyFxLpPrintPercentiles (name[glLpStreams], glLpLatNs, glLpLatDone);
+    if (glLpLatTickHz != 0)
+    {
+        static const char *bucket[] = {"<16", "16-31", "32-63", "64-127", "128-255", "256-511", "512-1023", ">=1024"};
+        uint32_t           hist[CY_FX_LP_LAT_NUM_BUCKETS];
+
+        CyFxLpPrintPercentiles ("device residence", glLpResNs, glLpResDone);
+        if (CyFxLpGetLatStats (hist, 0) != 0)
+        {
+            printf ("firmware transfer sizes (%u Hz timer):", glLpLatTickHz);
+            for (i = 0; i < CY_FX_LP_LAT_NUM_BUCKETS; i++)
+                printf (" %s:%u", bucket[i], hist[i]);
+            printf ("\n");
+        }
+    }
+
+done:
+    /* Cancel anything still in flight after an error, and wait for all of the transfers to return. */
+    for (i = 0; i < glLpQueue; i++)
+    {
+        if (glLpLatSlot[i].busy != 0)
+        {
+            libusb_cancel_transfer (glLpLatSlot[i].out_p);
+            libusb_cancel_transfer (glLpLatSlot[i].in_p);
+        }
+    }
+    glLpLatError = (glLpLatError != 0) ? glLpLatError : LIBUSB_TRANSFER_CANCELLED;
+    for (;;)
+    {
+        uint32_t busy = 0;
+
+        for (i = 0; i < glLpQueue; i++)
+            busy += glLpLatSlot[i].busy;
+        if (busy == 0)
+            break;
+        libusb_handle_events_timeout_completed (glLpCtx, &tv, NULL);
+    }
+
+    for (i = 0; i < glLpQueue; i++)
+    {
+        if (glLpLatSlot[i].out_p != NULL)
+            libusb_free_transfer (glLpLatSlot[i].out_p);
+        if (glLpLatSlot[i].in_p != NULL)
+            libusb_free_transfer (glLpLatSlot[i].in_p);
+        glLpLatSlot[i].out_p = NULL;
+        glLpLatSlot[i].in_p  = NULL;
+    }
+
+    free (glLpLatNs);
+    free (glLpResNs);
+    glLpLatNs = NULL;
+    glLpResNs = NULL;
+    if (glLpStreams != 0)
+        libusb_free_streams (glLpHandle, eps, 2);
+    return ret;
+}
+
+/* Halt both endpoints of the first pair with SET_FEATURE(ENDPOINT_HALT), clear them again and check
+   that the loopback still works, timing each step. */
+static int
+CyFxLpHaltCycle (
+        uint8_t  *buf_p,
+        uint64_t *setNs_p,
+        uint64_t *clearNs_p,
+        uint64_t *recoverNs_p)
+{
+    static const uint8_t eps[2] = {CY_FX_LP_EP_OUT, CY_FX_LP_EP_IN};
+    uint64_t             t0, t1, t2, t3;
+    uint32_t             i;
+    int                  status, actual;
+
+    t0 = CyFxLpTimeNs ();
+    for (i = 0; i < 2; i++)
+    {
+        status = libusb_control_transfer (glLpHandle, LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_STANDARD |
+                LIBUSB_RECIPIENT_ENDPOINT, LIBUSB_REQUEST_SET_FEATURE, 0, eps[i], NULL, 0, 1000);
+        if (status < 0)
+        {
+            fprintf (stderr, "halt: SET_FEATURE(ENDPOINT_HALT) on EP 0x%02x failed: %s\n", eps[i],
+                    libusb_error_name (status));
+            return 1;
+        }
+    }
+
+    t1 = CyFxLpTimeNs ();
+    for (i = 0; i < 2; i++)
+    {
+        status = libusb_clear_halt (glLpHandle, eps[i]);
+        if (status < 0)
+        {
+            fprintf (stderr, "halt: CLEAR_FEATURE(ENDPOINT_HALT) on EP 0x%02x failed: %s\n", eps[i],
+                    libusb_error_name (status));
+            return 1;
+        }
+    }
+
+    t2 = CyFxLpTimeNs ();
+    status = libusb_bulk_transfer (glLpHandle, CY_FX_LP_EP_OUT, buf_p, (int)glLpXferSize, &actual,
+            CY_FX_LP_XFER_TIMEOUT);
+    if ((status == 0) && (actual == (int)glLpXferSize))
+        status = libusb_bulk_transfer (glLpHandle, CY_FX_LP_EP_IN, buf_p + glLpXferSize, (int)glLpXferSize,
+                &actual, CY_FX_LP_XFER_TIMEOUT);
+    t3 = CyFxLpTimeNs ();
+    if ((status != 0) || (actual != (int)glLpXferSize) || (memcmp (buf_p, buf_p + glLpXferSize, glLpXferSize) != 0))
+    {
+        fprintf (stderr, "halt: loopback failed after the clear: %s\n",
+                (status != 0) ? libusb_error_name (status) : "wrong data echoed");
+        return 1;
+    }
+
+    /* Both requests of a step are sent back to back, so each sample is the time for one request. */
+    *setNs_p     = (t1 - t0) / 2;
+    *clearNs_p   = (t2 - t1) / 2;
+    *recoverNs_p = t3 - t1;
+    return 0;
+}
+
+static int
+CyFxLpHalt (
+        void)
+{
+    uint64_t *setNs_p, *clearNs_p, *recoverNs_p;
+    uint8_t  *buf_p;
+    uint32_t  pktSize, i, done;
+    int       ret = 0;
+
+    pktSize = (uint32_t)libusb_get_max_packet_size (libusb_get_device (glLpHandle), CY_FX_LP_EP_IN);
+    if ((glLpXferSize >= pktSize) || (glLpXferSize == 0))
+    {
+        fprintf (stderr, "halt: transfer size must be 1 to %u bytes\n", pktSize - 1);
+        return 2;
+    }
+
+    setNs_p     = (uint64_t *)calloc (glLpCount, sizeof (uint64_t));
+    clearNs_p   = (uint64_t *)calloc (glLpCount, sizeof (uint64_t));
+    recoverNs_p = (uint64_t *)calloc (glLpCount, sizeof (uint64_t));
+    buf_p       = (uint8_t *)malloc (2 * glLpXferSize);
+    if ((setNs_p == NULL) || (clearNs_p == NULL) || (recoverNs_p == NULL) || (buf_p == NULL))
+    {
+        fprintf (stderr, "halt: out of memory\n");
+        ret = 1;
+        goto done;
+    }
+
+    for (done = 0; done < glLpCount; done++)
+    {
+        for (i = 0; i < glLpXferSize; i++)
+            buf_p[i] = (uint8_t)(done + i);
+        if (CyFxLpHaltCycle (buf_p, &setNs_p[done], &clearNs_p[done], &recoverNs_p[done]) != 0)
+        {
+            fprintf (stderr, "halt: cycle %u of %u failed\n", done + 1, glLpCount);
+            ret = 1;
+            break;
+        }
+    }
+
+    printf ("%u halt/clear cycles on EP 0x%02x/0x%02x, %u byte echo check\n", done, CY_FX_LP_EP_OUT,
+            CY_FX_LP_EP_IN, glLpXferSize);
+    CyFxLpPrintPercentiles ("set halt (EP0)", setNs_p, done);
+    CyFxLpPrintPercentiles ("clear halt (EP0)", clearNs_p, done);
+    CyFxLpPrintPercentiles ("recovery", recoverNs_p, done);
+
+done:
+    free (setNs_p);
+    free (clearNs_p);
+    free (recoverNs_p);
+    free (buf_p);
+    return ret;
+}
+
+int
+main (
+        int   argc,
+        char *argv[])
+{
+    static const char *speedName[] = {"unknown", "low", "full", "high", "super", "super plus"};
+    int                opt, speed, ret;
+
+    while ((opt = getopt (argc, argv, "t:s:q:p:n:S:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                glLpSeconds = (uint32_t)strtoul (optarg, NULL, 0);
+                break;
+            case 's':
+                glLpXferSize = (uint32_t)strtoul (optarg, NULL, 0);
+                break;
+            case 'q':
+                glLpQueue = (uint32_t)strtoul (optarg, NULL, 0);
+                break;
+            case 'p':
+                glLpPairs = (uint32_t)strtoul (optarg, NULL, 0);
+                break;
+            case 'n':
+                glLpCount = (uint32_t)strtoul (optarg, NULL, 0);
+                break;
+            case 'S':
+                glLpStreams = (uint32_t)strtoul (optarg, NULL, 0);
+                break;
+            default:
+                CyFxLpUsage ();
+        }
+    }
+
+    if ((optind != argc - 1) || (glLpSeconds == 0) || (glLpQueue == 0) || (glLpQueue > CY_FX_LP_MAX_QUEUE) ||
+            (glLpPairs == 0) || (glLpPairs > CY_FX_LP_MAX_PAIRS) || (glLpCount == 0) ||
+            ((glLpStreams != 0) && (glLpStreams != 2) && (glLpStreams != 4)))
+        CyFxLpUsage ();
+    if (glLpXferSize == 0)
+        glLpXferSize = (strcmp (argv[optind], "throughput") == 0) ? 65536 : 64;
+
+    if (libusb_init (&glLpCtx) != 0)
+    {
+        fprintf (stderr, "libusb_init failed\n");
+        return 1;
+    }
+
+    glLpHandle = libusb_open_device_with_vid_pid (glLpCtx, CY_FX_LP_VID, CY_FX_LP_PID);
+    if (glLpHandle == NULL)
+    {
+        fprintf (stderr, "no device %04x:%04x found\n", CY_FX_LP_VID, CY_FX_LP_PID);
+        libusb_exit (glLpCtx);
+        return 1;
+    }
+
+    libusb_set_auto_detach_kernel_driver (glLpHandle, 1);
+    if (libusb_claim_interface (glLpHandle, 0) != 0)
+    {
+        fprintf (stderr, "cannot claim interface 0\n");
+        libusb_close (glLpHandle);
+        libusb_exit (glLpCtx);
+        return 1;
+    }
+
+    speed = libusb_get_device_speed (libusb_get_device (glLpHandle));
+    printf ("device %04x:%04x, %s speed\n", CY_FX_LP_VID, CY_FX_LP_PID,
+            ((speed >= 0) && (speed <= LIBUSB_SPEED_SUPER_PLUS)) ? speedName[speed] : "unknown");
+
+    if (strcmp (argv[optind], "throughput") == 0)
+    {
+        ret = CyFxLpThroughput ();
+    }
+    else if (strcmp (argv[optind], "latency") == 0)
+    {
+        ret = CyFxLpLatency ();
+    }
+    else if (strcmp (argv[optind], "halt") == 0)
+    {
+        ret = CyFxLpHalt ();
+    }
+    else
+    {
+        ret = 2;
+        fprintf (stderr, "unknown test %s\n", argv[optind]);
+    }
+
+    libusb_release_interface (glLpHandle, 0);
+    libusb_close (glLpHandle);
+    libusb_exit (glLpCtx);
+    return ret;
+}
+
+/*[]*/
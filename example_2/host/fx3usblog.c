@@ -0,0 +1,281 @@
+/*
+ ## Cypress FX3 Host Tool Source File (fx3usblog.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host side reader for the USB driver log of the bulk source sink firmware (demo_c), using libusb-1.0.
+ *
+ * fx3usblog [-f] [-w file]
+ *     Reads the log with vendor request 0x8B until it has caught up with the device, and prints the log
+ *     bytes with their log positions. With -f, the log is polled every 100 ms until interrupted. With -w,
+ *     the raw responses are also written to the given file.
+ *
+ * fx3usblog -r file
+ *     Decodes the responses saved with -w, without a device.
+ *
+ * The log bytes are the CYU3P_USB_LOG_* event codes of the FX3 SDK (cyu3usb.h), printed in hex. Any
+ * discontinuity in the log is printed on its own line: bytes overwritten before they could be read, a
+ * gap of unknown size where the firmware could not rule out a wrap of its ring, or a restart of the
+ * device log. The totals are printed at the end.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <libusb-1.0/libusb.h>
+
+#include "fx3usblogdec.h"
+
+#define CY_FX_USBLOG_VID                (0x04B4)        /* Vendor ID of the bulk source sink firmware. */
+#define CY_FX_USBLOG_PID                (0x00F1)        /* Product ID of the bulk source sink firmware. */
+#define CY_FX_USBLOG_RQT_STREAM         (0x8B)          /* Vendor request: read the USB driver log. */
+#define CY_FX_USBLOG_RSP_SIZE           (CY_FX_USBLOG_HDR_SIZE + 512)
+#define CY_FX_USBLOG_POLL_US            (100000)        /* Polling period with -f. */
+
+static volatile int glUsbLogStop = 0;
+
+static void
+CyFxUsbLogSignal (
+        int sig)
+{
+    (void)sig;
+    glUsbLogStop = 1;
+}
+
+static void
+CyFxUsbLogUsage (
+        void)
+{
+    fprintf (stderr, "usage: fx3usblog [-f] [-w file]\n"
+            "       fx3usblog -r file\n");
+    exit (2);
+}
+
+/* Decode and print one response. */
+static int
+CyFxUsbLogPrintChunk (
+        CyFxUsbLogDecoder_t *dec_p,
+        const uint8_t       *rsp_p,
+        uint32_t             rspLen)
+{
+    CyFxUsbLogChunk_t chunk;
+    uint32_t          i;
+
+    if (CyFxUsbLogDecodeChunk (dec_p, rsp_p, rspLen, &chunk) != 0)
+    {
+        fprintf (stderr, "malformed log response of %u bytes\n", rspLen);
+        return 1;
+    }
+
+    switch (chunk.gap)
+    {
+        case CY_FX_USBLOG_GAP_LOST:
+            printf ("-- %u bytes lost before position %u\n", chunk.lostCnt, chunk.readPos);
+            break;
+        case CY_FX_USBLOG_GAP_UNKNOWN:
+            printf ("-- unknown number of bytes lost before position %u\n", chunk.readPos);
+            break;
+        case CY_FX_USBLOG_GAP_RESTART:
+            printf ("-- device log restarted at position %u\n", chunk.readPos);
+            break;
+        default:
+            break;
+    }
+
+    for (i = 0; i < chunk.length; i++)
+    {
+        if ((i % 16) == 0)
+            printf ("%s%10u:", (i != 0) ? "\n" : "", chunk.readPos + i);
+        printf (" %02x", chunk.data_p[i]);
+    }
+    if (chunk.length != 0)
+        printf ("\n");
+
+    return 0;
+}
+
+/* Decode a file of responses saved with -w. Each response holds its own length in the header. */
+static int
+CyFxUsbLogReadFile (
+        CyFxUsbLogDecoder_t *dec_p,
+        const char          *name)
+{
+    uint8_t  rsp[CY_FX_USBLOG_RSP_SIZE];
+    uint32_t length;
+    FILE    *fp = fopen (name, "rb");
+    int      ret = 0;
+
+    if (fp == NULL)
+    {
+        fprintf (stderr, "cannot open %s\n", name);
+        return 1;
+    }
+
+    while (fread (rsp, 1, CY_FX_USBLOG_HDR_SIZE, fp) == CY_FX_USBLOG_HDR_SIZE)
+    {
+        length = (uint32_t)rsp[12] | ((uint32_t)rsp[13] << 8) | ((uint32_t)rsp[14] << 16) | ((uint32_t)rsp[15] << 24);
+        if ((length > CY_FX_USBLOG_RSP_SIZE - CY_FX_USBLOG_HDR_SIZE) ||
+                (fread (rsp + CY_FX_USBLOG_HDR_SIZE, 1, length, fp) != length))
+        {
+            fprintf (stderr, "%s: truncated log response\n", name);
+            ret = 1;
+            break;
+        }
+
+        /* The saved responses were requested from the positions the decoder expects. */
+        if (CyFxUsbLogPrintChunk (dec_p, rsp, CY_FX_USBLOG_HDR_SIZE + length) != 0)
+        {
+            ret = 1;
+            break;
+        }
+    }
+
+    fclose (fp);
+    return ret;
+}
+
+/* Read the log from the device until it has caught up, or until interrupted with -f. */
+static int
+CyFxUsbLogReadDevice (
+        CyFxUsbLogDecoder_t *dec_p,
+        int                  follow,
+        FILE                *dump_p)
+{
+    libusb_context       *ctx = NULL;
+    libusb_device_handle *handle;
+    uint8_t               rsp[CY_FX_USBLOG_RSP_SIZE];
+    int                   status, ret = 0;
+
+    if (libusb_init (&ctx) != 0)
+    {
+        fprintf (stderr, "libusb_init failed\n");
+        return 1;
+    }
+
+    handle = libusb_open_device_with_vid_pid (ctx, CY_FX_USBLOG_VID, CY_FX_USBLOG_PID);
+    if (handle == NULL)
+    {
+        fprintf (stderr, "no device %04x:%04x found\n", CY_FX_USBLOG_VID, CY_FX_USBLOG_PID);
+        libusb_exit (ctx);
+        return 1;
+    }
+
+    while (!glUsbLogStop)
+    {
+        status = libusb_control_transfer (handle, LIBUSB_ENDPOINT_IN | LIBUSB_REQUEST_TYPE_VENDOR |
+                LIBUSB_RECIPIENT_DEVICE, CY_FX_USBLOG_RQT_STREAM, (uint16_t)dec_p->nextPos,
+                (uint16_t)(dec_p->nextPos >> 16), rsp, sizeof (rsp), 1000);
+        if (status < 0)
+        {
+            fprintf (stderr, "log read failed: %s\n", libusb_error_name (status));
+            ret = 1;
+            break;
+        }
+
+        if ((dump_p != NULL) && (fwrite (rsp, 1, (size_t)status, dump_p) != (size_t)status))
+        {
+            fprintf (stderr, "cannot write the log dump\n");
+            ret = 1;
+            break;
+        }
+
+        if (CyFxUsbLogPrintChunk (dec_p, rsp, (uint32_t)status) != 0)
+        {
+            ret = 1;
+            break;
+        }
+
+        /* A chunk shorter than the buffer means that the log has been read up to the write position. */
+        if (status < (int)sizeof (rsp))
+        {
+            if (!follow)
+                break;
+            fflush (stdout);
+            usleep (CY_FX_USBLOG_POLL_US);
+        }
+    }
+
+    libusb_close (handle);
+    libusb_exit (ctx);
+    return ret;
+}
+
+int
+main (
+        int   argc,
+        char *argv[])
+{
+    CyFxUsbLogDecoder_t dec;
+    const char         *readName = NULL, *dumpName = NULL;
+    FILE               *dump_p = NULL;
+    int                 opt, follow = 0, ret;
+
+    while ((opt = getopt (argc, argv, "fw:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                follow = 1;
+                break;
+            case 'w':
+                dumpName = optarg;
+                break;
+            case 'r':
+                readName = optarg;
+                break;
+            default:
+                CyFxUsbLogUsage ();
+        }
+    }
+
+    if ((optind != argc) || ((readName != NULL) && ((follow) || (dumpName != NULL))))
+        CyFxUsbLogUsage ();
+
+    CyFxUsbLogDecoderInit (&dec);
+    if (readName != NULL)
+    {
+        ret = CyFxUsbLogReadFile (&dec, readName);
+    }
+    else
+    {
+        if (dumpName != NULL)
+        {
+            dump_p = fopen (dumpName, "wb");
+            if (dump_p == NULL)
+            {
+                fprintf (stderr, "cannot create %s\n", dumpName);
+                return 1;
+            }
+        }
+
+        signal (SIGINT, CyFxUsbLogSignal);
+        ret = CyFxUsbLogReadDevice (&dec, follow, dump_p);
+        if (dump_p != NULL)
+            fclose (dump_p);
+    }
+
+    printf ("%llu log bytes, %llu bytes lost, %u gaps of unknown size, %u device log restarts\n",
+            (unsigned long long)dec.bytes, (unsigned long long)dec.lostBytes, dec.unknownGaps, dec.restarts);
+    return ret;
+}
+
+/*[]*/
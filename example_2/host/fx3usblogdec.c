@@ -0,0 +1,93 @@
+/*
+ ## Cypress FX3 Host Tool Source File (fx3usblogdec.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Decoder for the USB driver log chunks of vendor request 0x8B, see fx3usblogdec.h. */
+
+#include <string.h>
+
+#include "fx3usblogdec.h"
+
+static uint32_t
+CyFxUsbLogGetLe32 (
+        const uint8_t *p)
+{
+    return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+void
+CyFxUsbLogDecoderInit (
+        CyFxUsbLogDecoder_t *dec_p)
+{
+    memset (dec_p, 0, sizeof (CyFxUsbLogDecoder_t));
+}
+
+int
+CyFxUsbLogDecodeChunk (
+        CyFxUsbLogDecoder_t *dec_p,
+        const uint8_t       *rsp_p,
+        uint32_t             rspLen,
+        CyFxUsbLogChunk_t   *chunk_p)
+{
+    if (rspLen < CY_FX_USBLOG_HDR_SIZE)
+        return -1;
+
+    chunk_p->readPos  = CyFxUsbLogGetLe32 (rsp_p);
+    chunk_p->writePos = CyFxUsbLogGetLe32 (rsp_p + 4);
+    chunk_p->lostCnt  = CyFxUsbLogGetLe32 (rsp_p + 8);
+    chunk_p->length   = CyFxUsbLogGetLe32 (rsp_p + 12);
+    chunk_p->data_p   = rsp_p + CY_FX_USBLOG_HDR_SIZE;
+
+    /* The data must fill the rest of the response, and may not go past the write position. */
+    if ((chunk_p->length != rspLen - CY_FX_USBLOG_HDR_SIZE) ||
+            (chunk_p->length > chunk_p->writePos - chunk_p->readPos))
+        return -1;
+
+    if (chunk_p->lostCnt == CY_FX_USBLOG_LOST_UNKNOWN)
+    {
+        chunk_p->gap = CY_FX_USBLOG_GAP_UNKNOWN;
+        dec_p->unknownGaps++;
+    }
+    else if (chunk_p->lostCnt != 0)
+    {
+        /* The device skipped from the requested position to the oldest byte it still holds. */
+        if (chunk_p->readPos - dec_p->nextPos != chunk_p->lostCnt)
+            return -1;
+        chunk_p->gap = CY_FX_USBLOG_GAP_LOST;
+        dec_p->lostBytes += chunk_p->lostCnt;
+    }
+    else if (chunk_p->readPos != dec_p->nextPos)
+    {
+        /* The requested position is ahead of the device log, which has started counting again. */
+        chunk_p->gap = CY_FX_USBLOG_GAP_RESTART;
+        dec_p->restarts++;
+    }
+    else
+    {
+        chunk_p->gap = CY_FX_USBLOG_GAP_NONE;
+    }
+
+    dec_p->nextPos = chunk_p->readPos + chunk_p->length;
+    dec_p->bytes  += chunk_p->length;
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,79 @@
+/*
+ ## Cypress FX3 Host Tool Header File (fx3usblogdec.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Decoder for the USB driver log chunks streamed by the demo_c firmware with vendor request 0x8B. See
+ * CY_FX_USBLOG_CHUNK_SIZE in demo_c/cyfxbulksrcsink.h for the protocol. The decoder keeps the position
+ * to read from next, checks each response against it, and tells the caller whether the log continues,
+ * whether a known or unknown number of bytes was missed, or whether the device log has restarted. */
+
+#ifndef _INCLUDED_FX3USBLOGDEC_H_
+#define _INCLUDED_FX3USBLOGDEC_H_
+
+#include <stdint.h>
+
+#define CY_FX_USBLOG_HDR_SIZE           (16)            /* Size of the CyFxUsbLogChunkHdr_t response header. */
+#define CY_FX_USBLOG_LOST_UNKNOWN       (0xFFFFFFFF)    /* lostCnt value when bytes may have been missed. */
+
+/* Continuity of a chunk with the data decoded before it. */
+#define CY_FX_USBLOG_GAP_NONE           (0)             /* The chunk follows on from the previous one. */
+#define CY_FX_USBLOG_GAP_LOST           (1)             /* lostCnt bytes were overwritten before being read. */
+#define CY_FX_USBLOG_GAP_UNKNOWN        (2)             /* An unknown number of bytes, possibly whole rings, was missed. */
+#define CY_FX_USBLOG_GAP_RESTART        (3)             /* The device log restarted (e.g. after a device reset). */
+
+/* Decoder state and totals. */
+typedef struct CyFxUsbLogDecoder_t
+{
+    uint32_t nextPos;                   /* Log position to request next. */
+    uint64_t bytes;                     /* Log bytes decoded. */
+    uint64_t lostBytes;                 /* Bytes known to be missed. */
+    uint32_t unknownGaps;               /* Number of gaps of unknown size. */
+    uint32_t restarts;                  /* Number of device log restarts. */
+} CyFxUsbLogDecoder_t;
+
+/* One decoded response. */
+typedef struct CyFxUsbLogChunk_t
+{
+    uint32_t       readPos;             /* Log position of the first data byte. */
+    uint32_t       writePos;            /* Device write position when the chunk was read. */
+    uint32_t       lostCnt;             /* Bytes missed before the chunk, as reported by the device. */
+    uint32_t       length;              /* Number of log bytes. */
+    uint32_t       gap;                 /* CY_FX_USBLOG_GAP_* before the chunk. */
+    const uint8_t *data_p;              /* Log bytes, pointing into the response. */
+} CyFxUsbLogChunk_t;
+
+/* Start decoding a log read from position 0. */
+extern void
+CyFxUsbLogDecoderInit (
+        CyFxUsbLogDecoder_t *dec_p);
+
+/* Decode a 0x8B response of rspLen bytes, which must have been read from dec_p->nextPos. Returns 0 and
+   advances nextPos, or -1 if the response is malformed or inconsistent with the request. */
+extern int
+CyFxUsbLogDecodeChunk (
+        CyFxUsbLogDecoder_t *dec_p,
+        const uint8_t       *rsp_p,
+        uint32_t             rspLen,
+        CyFxUsbLogChunk_t   *chunk_p);
+
+#endif /* _INCLUDED_FX3USBLOGDEC_H_ */
+
+/*[]*/
@@ -0,0 +1,35 @@
+/*
+ ## Cypress FX3 Host Test Header File (cyfxversion.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host stand-in for the SDK header of the same name. The heap tests are built as for SDK 1.3.4, so
+ * that the memory error detection code in cyfxtx is included. */
+
+#ifndef _INCLUDED_CYFXVERSION_H_
+#define _INCLUDED_CYFXVERSION_H_
+
+#define CYFX_VERSION_MAJOR              (1)
+#define CYFX_VERSION_MINOR              (3)
+#define CYFX_VERSION_PATCH              (4)
+
+#endif /* _INCLUDED_CYFXVERSION_H_ */
+
+/*[]*/
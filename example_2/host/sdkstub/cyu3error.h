@@ -0,0 +1,41 @@
+/*
+ ## Cypress FX3 Host Test Header File (cyu3error.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host stand-in for the SDK header of the same name, with only the error codes used by the sources
+ * under test. */
+
+#ifndef _INCLUDED_CYU3ERROR_H_
+#define _INCLUDED_CYU3ERROR_H_
+
+#define CY_U3P_SUCCESS                  (0x00)
+#define CY_U3P_ERROR_ALREADY_STARTED    (0x07)
+#define CY_U3P_ERROR_BAD_ARGUMENT       (0x40)
+#define CY_U3P_ERROR_NULL_POINTER       (0x41)
+#define CY_U3P_ERROR_MEMORY_ERROR       (0x43)
+#define CY_U3P_ERROR_TIMEOUT            (0x45)
+#define CY_U3P_ERROR_NOT_SUPPORTED      (0x47)
+#define CY_U3P_ERROR_NOT_STARTED        (0x49)
+#define CY_U3P_ERROR_FAILURE            (0x4D)
+
+#endif /* _INCLUDED_CYU3ERROR_H_ */
+
+/*[]*/
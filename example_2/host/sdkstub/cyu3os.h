@@ -0,0 +1,229 @@
+/*
+ ## Cypress FX3 Host Test Header File (cyu3os.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host stand-in for the SDK header of the same name. Only the RTOS wrappers and the allocator
+ * interfaces used by the cyfxtx source file are provided. The RTOS objects are implemented in
+ * fx3hoststub.c: the mutexes are no-ops, as the host tests are single threaded; and the byte pool
+ * is a model of the ThreadX byte pool. */
+
+#ifndef _INCLUDED_CYU3OS_H_
+#define _INCLUDED_CYU3OS_H_
+
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+#define CYU3P_NO_WAIT                   (0)
+#define CYU3P_WAIT_FOREVER              (0xFFFFFFFFU)
+#define CYU3P_NO_INHERIT                (0)
+#define CYU3P_INHERIT                   (1)
+
+/* Mutex. Counts the Get and Put calls so that the tests can check that they are paired. There is no
+   other thread to wait for, but a CYU3P_NO_WAIT Get made while the mutex is held fails, as it does in
+   an interrupt that preempts the holder. */
+typedef struct CyU3PMutex
+{
+    uint32_t          getCnt;           /* Number of successful CyU3PMutexGet calls. */
+    uint32_t          putCnt;           /* Number of CyU3PMutexPut calls. */
+    volatile CyBool_t held;             /* Whether the mutex is held. */
+} CyU3PMutex;
+
+/* Byte pool. The model uses the ThreadX block layout of the 32 bit target: each block has an 8 byte
+   header holding the address of the next block and an owner word, which is 0xFFFFEEEE for a free block.
+   The last block links back to the start of the pool. The pool memory has to lie in the lower 4 GB of
+   the address space, see CyFxHostRamMap. */
+typedef struct CyU3PBytePool
+{
+    uint32_t start;                     /* Address of the first block. */
+    uint32_t size;                      /* Size of the pool in bytes. */
+    uint32_t search;                    /* Block at which the next search starts. */
+    uint32_t fragments;                 /* Number of blocks in the pool. */
+    uint32_t available;                 /* Free bytes, excluding the block headers. */
+} CyU3PBytePool;
+
+/* Buffer manager state used by the DMA buffer allocator in cyfxtx. */
+typedef struct CyU3PDmaBufMgr_t
+{
+    CyU3PMutex  lock;                   /* Lock for the buffer manager. */
+    uint32_t    startAddr;              /* Start address of the buffer heap. */
+    uint32_t    regionSize;             /* Size of the buffer heap. */
+    uint32_t   *usedStatus;             /* Status bit array, one bit per cache line. */
+    uint32_t    statusSize;             /* Number of words in the status array. */
+    uint32_t    searchPos;              /* Word at which the next search starts. */
+} CyU3PDmaBufMgr_t;
+
+/* Header added to each block when the memory leak and corruption checks are enabled. */
+typedef struct MemBlockInfo
+{
+    uint32_t             alloc_id;      /* Sequence number of the allocation. */
+    uint32_t             alloc_size;    /* Size of the block including the header and footer. */
+    struct MemBlockInfo *prev_blk;      /* Previously allocated block in the in-use list. */
+    struct MemBlockInfo *next_blk;      /* Next allocated block in the in-use list. */
+    uint32_t             start_sig;     /* Start signature. */
+} MemBlockInfo;
+
+/* Callback for notification of a corrupted memory block. */
+typedef void (*CyU3PMemCorruptCallback) (
+        void *mem_p);
+
+extern void
+CyU3PApplicationDefine (
+        void);
+
+extern void *
+CyU3PThreadIdentify (
+        void);
+
+extern uint32_t
+CyU3PThreadSleep (
+        uint32_t sleepTime);
+
+extern uint32_t
+CyU3PMutexCreate (
+        CyU3PMutex *mutex_p,
+        uint32_t    priorityInherit);
+
+extern uint32_t
+CyU3PMutexDestroy (
+        CyU3PMutex *mutex_p);
+
+extern uint32_t
+CyU3PMutexGet (
+        CyU3PMutex *mutex_p,
+        uint32_t    waitOption);
+
+extern uint32_t
+CyU3PMutexPut (
+        CyU3PMutex *mutex_p);
+
+extern uint32_t
+CyU3PBytePoolCreate (
+        CyU3PBytePool *pool_p,
+        void          *poolStart,
+        uint32_t       poolSize);
+
+extern uint32_t
+CyU3PBytePoolDestroy (
+        CyU3PBytePool *pool_p);
+
+extern uint32_t
+CyU3PByteAlloc (
+        CyU3PBytePool *pool_p,
+        void         **mem_p,
+        uint32_t       memSize,
+        uint32_t       waitOption);
+
+extern uint32_t
+CyU3PByteFree (
+        void *mem_p);
+
+/* Allocator functions implemented in cyfxtx. */
+extern void
+CyU3PMemInit (
+        void);
+
+extern void *
+CyU3PMemAlloc (
+        uint32_t size);
+
+extern void
+CyU3PMemFree (
+        void *mem_p);
+
+extern void
+CyU3PMemSet (
+        uint8_t *ptr,
+        uint8_t  data,
+        uint32_t count);
+
+extern void
+CyU3PMemCopy (
+        uint8_t *dest,
+        uint8_t *src,
+        uint32_t count);
+
+extern int32_t
+CyU3PMemCmp (
+        const void *s1,
+        const void *s2,
+        uint32_t    n);
+
+extern void
+CyU3PDmaBufferInit (
+        void);
+
+extern void
+CyU3PDmaBufferDeInit (
+        void);
+
+extern void *
+CyU3PDmaBufferAlloc (
+        uint16_t size);
+
+extern int
+CyU3PDmaBufferFree (
+        void *buffer);
+
+extern void
+CyU3PFreeHeaps (
+        void);
+
+extern CyU3PReturnStatus_t
+CyU3PMemEnableChecks (
+        CyBool_t                enable,
+        CyU3PMemCorruptCallback cb);
+
+extern void
+CyU3PMemGetCounts (
+        uint32_t *allocCnt_p,
+        uint32_t *freeCnt_p);
+
+extern MemBlockInfo *
+CyU3PMemGetActiveList (
+        void);
+
+extern CyU3PReturnStatus_t
+CyU3PMemCorruptionCheck (
+        void);
+
+extern CyU3PReturnStatus_t
+CyU3PBufEnableChecks (
+        CyBool_t                enable,
+        CyU3PMemCorruptCallback cb);
+
+extern void
+CyU3PBufGetCounts (
+        uint32_t *allocCnt_p,
+        uint32_t *freeCnt_p);
+
+extern MemBlockInfo *
+CyU3PBufGetActiveList (
+        void);
+
+extern CyU3PReturnStatus_t
+CyU3PBufCorruptionCheck (
+        void);
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYU3OS_H_ */
+
+/*[]*/
@@ -0,0 +1,44 @@
+/*
+ ## Cypress FX3 Host Test Header File (cyu3types.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host stand-in for the SDK header of the same name, with only the definitions used by the sources
+ * under test. */
+
+#ifndef _INCLUDED_CYU3TYPES_H_
+#define _INCLUDED_CYU3TYPES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef volatile uint32_t uvint32_t;
+typedef uint32_t          CyBool_t;
+typedef uint32_t          CyU3PReturnStatus_t;
+
+#define CyTrue                          (1)
+#define CyFalse                         (0)
+
+#define CY_U3P_MIN(a,b)                 (((a) > (b)) ? (b) : (a))
+#define CY_U3P_MAX(a,b)                 (((a) > (b)) ? (a) : (b))
+
+#endif /* _INCLUDED_CYU3TYPES_H_ */
+
+/*[]*/
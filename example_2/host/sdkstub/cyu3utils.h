@@ -0,0 +1,32 @@
+/*
+ ## Cypress FX3 Host Test Header File (cyu3utils.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host stand-in for the SDK header of the same name. */
+
+#ifndef _INCLUDED_CYU3UTILS_H_
+#define _INCLUDED_CYU3UTILS_H_
+
+#include "cyu3types.h"
+
+#endif /* _INCLUDED_CYU3UTILS_H_ */
+
+/*[]*/
@@ -0,0 +1,267 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_bufalloc.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test and benchmark for the DMA buffer heap search in cyfxtx.
+ *
+ * CyU3PDmaBufferAlloc searches the cache line status array a word at a time. This test runs a random
+ * alloc/free workload on the buffer heap, and checks before each allocation that the block returned
+ * and the updated search position are the same as those found by the original search, which checked
+ * one status bit at a time. The time taken by both searches is then compared on a fragmented heap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fx3hoststub.h"
+
+/* The allocator is included directly so that its static state and helpers can be accessed. */
+#include "cyfxtx.c"
+
+#define CY_FX_TEST_MAX_BUFS             (4096)          /* Enough 64 byte buffers to fill the heap. */
+#define CY_FX_TEST_MAX_LIVE             (512)           /* Buffers held at a time by the random workload. */
+#define CY_FX_TEST_ITERATIONS           (200000)        /* Number of random alloc/free operations. */
+#define CY_FX_TEST_BENCH_LOOPS          (20000)         /* Number of searches timed per case. */
+
+static void     *glTestBuf[CY_FX_TEST_MAX_BUFS];        /* Buffers currently allocated. */
+static uint32_t  glTestBufCnt = 0;                      /* Number of entries in glTestBuf. */
+
+/* Function    : CyFxRefBufSearch
+ * Description : Search for numLines free cache lines using the original algorithm of
+ *               CyU3PDmaBufferAlloc, which checks one status bit at a time. The status
+ *               array and the search position are not changed.
+ * Return Value: CyTrue if a block was found. The first cache line of the block and the
+ *               search position for the next allocation are returned through the pointers.
+ */
+static CyBool_t
+CyFxRefBufSearch (
+        uint32_t  numLines,
+        uint32_t *start_p,
+        uint32_t *searchPos_p)
+{
+    uint32_t wordnum = glBufferManager.searchPos;
+    uint32_t bitnum  = 0;
+    uint32_t count   = 0;
+    uint32_t tmp     = 0;
+    uint32_t start   = 0;
+
+    while (tmp < glBufferManager.statusSize)
+    {
+        if ((glBufferManager.usedStatus[wordnum] & (1U << bitnum)) == 0)
+        {
+            if (count == 0)
+            {
+                start = (wordnum << 5) + bitnum + 1;
+            }
+            count++;
+            if (count == (numLines + 1))
+            {
+                *start_p     = start;
+                *searchPos_p = wordnum;
+                return CyTrue;
+            }
+        }
+        else
+        {
+            count = 0;
+        }
+
+        bitnum++;
+        if (bitnum == 32)
+        {
+            bitnum = 0;
+            wordnum++;
+            tmp++;
+            if (wordnum == glBufferManager.statusSize)
+            {
+                wordnum = 0;
+                count   = 0;
+            }
+        }
+    }
+
+    return CyFalse;
+}
+
+/* Number of cache lines used for a buffer of the given size, as computed by CyU3PDmaBufferAlloc. */
+static uint32_t
+CyFxTestBufLines (
+        uint32_t size)
+{
+    return ((size <= FX3_CACHE_LINE_SZ) ? 2 : ((size + FX3_CACHE_LINE_SZ - 1) / FX3_CACHE_LINE_SZ));
+}
+
+/* Random buffer size, weighted towards the sizes used by the DMA channels. */
+static uint16_t
+CyFxTestBufSize (
+        void)
+{
+    static const uint16_t sizes[] = {16, 64, 512, 1024, 4096, 16384};
+    uint32_t sel = (uint32_t)rand () % 8;
+
+    if (sel < 6)
+        return sizes[sel];
+    return (uint16_t)(1 + (rand () % 6000));
+}
+
+/* Run the random workload and compare each allocation against the reference search. */
+static int
+CyFxTestCompare (
+        void)
+{
+    uint32_t iter, idx, refStart = 0, refPos = 0, getCnt, putCnt;
+    uint32_t allocCnt = 0, failCnt = 0;
+    uint16_t size;
+    CyBool_t found;
+    void    *buf_p;
+
+    for (iter = 0; iter < CY_FX_TEST_ITERATIONS; iter++)
+    {
+        if ((glTestBufCnt < CY_FX_TEST_MAX_LIVE) && ((rand () % 5) < 3))
+        {
+            size  = CyFxTestBufSize ();
+            found = CyFxRefBufSearch (CyFxTestBufLines (size), &refStart, &refPos);
+            buf_p = CyU3PDmaBufferAlloc (size);
+
+            if (found != (buf_p != 0))
+            {
+                printf ("FAIL: iteration %u, size %u: reference %s, allocator %p\n", iter, size,
+                        found ? "found a block" : "found no block", buf_p);
+                return 1;
+            }
+
+            if (buf_p == 0)
+            {
+                failCnt++;
+                continue;
+            }
+
+            if (((uint32_t)(uintptr_t)buf_p != (glBufferManager.startAddr + (refStart << 5))) ||
+                    (glBufferManager.searchPos != refPos))
+            {
+                printf ("FAIL: iteration %u, size %u: block %p pos %u, reference 0x%08X pos %u\n", iter, size,
+                        buf_p, glBufferManager.searchPos, glBufferManager.startAddr + (refStart << 5), refPos);
+                return 1;
+            }
+
+            CyU3PMemSet ((uint8_t *)buf_p, 0x5A, size);
+            glTestBuf[glTestBufCnt++] = buf_p;
+            allocCnt++;
+        }
+        else if (glTestBufCnt != 0)
+        {
+            idx = (uint32_t)rand () % glTestBufCnt;
+            if (CyU3PDmaBufferFree (glTestBuf[idx]) != 0)
+            {
+                printf ("FAIL: iteration %u: free of %p failed\n", iter, glTestBuf[idx]);
+                return 1;
+            }
+            glTestBuf[idx] = glTestBuf[--glTestBufCnt];
+        }
+    }
+
+    CyFxHostMutexCounts (&getCnt, &putCnt);
+    if (getCnt != putCnt)
+    {
+        printf ("FAIL: %u mutex gets and %u puts\n", getCnt, putCnt);
+        return 1;
+    }
+
+    printf ("compare: %u allocations matched the reference search, %u failed in both\n", allocCnt, failCnt);
+    return 0;
+}
+
+/* Time the word and bit searches for numLines cache lines from the current heap state. */
+static void
+CyFxTestBench (
+        const char *name,
+        uint32_t    numLines)
+{
+    uint32_t searchPos = glBufferManager.searchPos;
+    uint32_t loop, start = 0, pos = 0;
+    volatile uint32_t sink = 0;
+    uint64_t t0, t1, t2;
+
+    t0 = CyFxHostTimeNs ();
+    for (loop = 0; loop < CY_FX_TEST_BENCH_LOOPS; loop++)
+    {
+        glBufferManager.searchPos = searchPos;
+        sink += CyU3PDmaBufMgrFindFree (numLines + 1, &start);
+    }
+    t1 = CyFxHostTimeNs ();
+    for (loop = 0; loop < CY_FX_TEST_BENCH_LOOPS; loop++)
+    {
+        glBufferManager.searchPos = searchPos;
+        sink += CyFxRefBufSearch (numLines, &start, &pos);
+    }
+    t2 = CyFxHostTimeNs ();
+
+    glBufferManager.searchPos = searchPos;
+    (void) sink;
+    printf ("bench %-28s word search %8.1f ns, bit search %8.1f ns\n", name,
+            (double)(t1 - t0) / CY_FX_TEST_BENCH_LOOPS, (double)(t2 - t1) / CY_FX_TEST_BENCH_LOOPS);
+}
+
+int
+main (
+        void)
+{
+    uint32_t i;
+    int      ret;
+
+    CyFxHostRamMap ();
+    CyU3PMemInit ();
+    CyU3PDmaBufferInit ();
+    srand (1);
+
+    ret = CyFxTestCompare ();
+    if (ret != 0)
+        return ret;
+
+    /* Release everything and time the searches on an empty heap. */
+    while (glTestBufCnt != 0)
+        CyU3PDmaBufferFree (glTestBuf[--glTestBufCnt]);
+    glBufferManager.searchPos = 0;
+    CyFxTestBench ("empty heap, 16 KB", CyFxTestBufLines (16384));
+
+    /* Fill the heap with 64 byte buffers. Searches then fail after scanning the whole array. */
+    while (glTestBufCnt < CY_FX_TEST_MAX_BUFS)
+    {
+        glTestBuf[glTestBufCnt] = CyU3PDmaBufferAlloc (64);
+        if (glTestBuf[glTestBufCnt] == 0)
+            break;
+        glTestBufCnt++;
+    }
+    glBufferManager.searchPos = 0;
+    CyFxTestBench ("full heap, 64 B", CyFxTestBufLines (64));
+
+    /* Free every other buffer. Large requests still fail, but every status word has free bits. */
+    for (i = 0; i < glTestBufCnt; i += 2)
+        CyU3PDmaBufferFree (glTestBuf[i]);
+    glBufferManager.searchPos = 0;
+    CyFxTestBench ("fragmented heap, 64 B", CyFxTestBufLines (64));
+    CyFxTestBench ("fragmented heap, 16 KB", CyFxTestBufLines (16384));
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
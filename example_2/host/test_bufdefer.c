@@ -0,0 +1,249 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_bufdefer.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test for the deferred DMA buffer frees in cyfxtx, with the frees made concurrently with the
+ * drain.
+ *
+ * A periodic POSIX timer signal stands in for an interrupt: its handler reports interrupt context and
+ * frees the buffers that the main loop has passed to it through a single producer ring. The main loop
+ * allocates and frees buffers of random sizes in thread context, so the signal often arrives while it
+ * holds the buffer manager lock, or while it is draining the deferred list. The frees made from the
+ * handler must then be deferred, and completed by a later call from the main loop.
+ *
+ * Every buffer holds a tag which is checked before it is freed, so that a buffer handed out twice, or a
+ * block freed twice and then handed out again, is caught. At the end, every free made from the handler
+ * has succeeded, the number of deferred frees matches the number drained, and the buffer heap is back
+ * to its initial state.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#include "fx3hoststub.h"
+
+/* The allocator is included directly so that the deferred list can be checked. */
+#include "cyfxtx.c"
+
+#define CY_FX_TEST_RING                 (64)            /* Entries in the ring passed to the handler. */
+#define CY_FX_TEST_HELD                 (32)            /* Buffers held by the main loop. */
+#define CY_FX_TEST_OPS                  (2000000)       /* Alloc/free operations in the main loop. */
+#define CY_FX_TEST_TIMER_NS             (20000)         /* Period of the timer signal. */
+#define CY_FX_TEST_ISR_FREES            (4)             /* Buffers freed by each signal, at most. */
+
+/* Ring of buffers passed to the handler. Only the main loop writes glTestHead, and only the handler
+   writes glTestTail. */
+static void * volatile   glTestRing[CY_FX_TEST_RING];
+static volatile uint32_t glTestHead = 0;
+static volatile uint32_t glTestTail = 0;
+
+static volatile uint32_t glTestIsrFrees  = 0;           /* Frees made from the handler. */
+static volatile uint32_t glTestIsrErrors = 0;           /* Frees from the handler that failed. */
+static volatile uint32_t glTestBadTags   = 0;           /* Buffers with a damaged tag. */
+static volatile uint32_t glTestLastBad   = 0;           /* Tag expected in the last damaged buffer. */
+
+/* Fill a buffer with its tag. The first word is left out: it links a deferred buffer into the list. */
+static void
+CyFxTestTag (
+        void     *mem_p,
+        uint32_t  size,
+        uint32_t  tag)
+{
+    uint32_t *word_p = (uint32_t *)mem_p, i;
+
+    word_p[1] = size;
+    for (i = 2; i < size / 4; i++)
+        word_p[i] = tag;
+}
+
+/* Check the tag of a buffer before it is freed. */
+static void
+CyFxTestCheckTag (
+        void *mem_p)
+{
+    uint32_t *word_p = (uint32_t *)mem_p, i, size = word_p[1];
+    uint32_t  tag = (size / 4 > 2) ? word_p[2] : 0;
+
+    for (i = 2; i < size / 4; i++)
+    {
+        if (word_p[i] != tag)
+        {
+            glTestLastBad = tag;
+            glTestBadTags++;
+            break;
+        }
+    }
+}
+
+/* The interrupt: free a few of the buffers passed by the main loop. */
+static void
+CyFxTestIsr (
+        int sig)
+{
+    void    *mem_p;
+    uint32_t n;
+
+    (void)sig;
+    CyFxHostSetThread (CyFalse);
+    for (n = 0; (n < CY_FX_TEST_ISR_FREES) && (glTestTail != glTestHead); n++)
+    {
+        mem_p = glTestRing[glTestTail % CY_FX_TEST_RING];
+        glTestTail++;
+
+        CyFxTestCheckTag (mem_p);
+        if (CyU3PDmaBufferFree (mem_p) != 0)
+            glTestIsrErrors++;
+        glTestIsrFrees++;
+    }
+    CyFxHostSetThread (CyTrue);
+}
+
+int
+main (
+        void)
+{
+    CyU3PHeapStats_t  before, after;
+    struct sigaction  action;
+    struct sigevent   event;
+    struct itimerspec period;
+    timer_t           timer;
+    void             *held[CY_FX_TEST_HELD];
+    uint32_t          deferred, drained, i, slot, size, tag = 1, allocs = 0, fails = 0, mainFrees = 0;
+
+    CyFxHostRamMap ();
+    CyU3PMemInit ();
+    CyU3PDmaBufferInit ();
+    CyU3PBufGetStats (&before);
+    memset (held, 0, sizeof (held));
+    srand (1);
+
+    memset (&action, 0, sizeof (action));
+    action.sa_handler = CyFxTestIsr;
+    sigemptyset (&action.sa_mask);
+    sigaction (SIGALRM, &action, NULL);
+
+    memset (&event, 0, sizeof (event));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo  = SIGALRM;
+    if (timer_create (CLOCK_MONOTONIC, &event, &timer) != 0)
+    {
+        printf ("FAIL: timer_create\n");
+        return 1;
+    }
+    period.it_interval.tv_sec  = 0;
+    period.it_interval.tv_nsec = CY_FX_TEST_TIMER_NS;
+    period.it_value            = period.it_interval;
+    timer_settime (timer, 0, &period, NULL);
+
+    for (i = 0; i < CY_FX_TEST_OPS; i++)
+    {
+        slot = (uint32_t)rand () % CY_FX_TEST_HELD;
+
+        /* Pass a held buffer on to the handler, or free it here if the ring is full. */
+        if (held[slot] != 0)
+        {
+            if (glTestHead - glTestTail < CY_FX_TEST_RING)
+            {
+                glTestRing[glTestHead % CY_FX_TEST_RING] = held[slot];
+                glTestHead++;
+            }
+            else
+            {
+                CyFxTestCheckTag (held[slot]);
+                CyU3PDmaBufferFree (held[slot]);
+                mainFrees++;
+            }
+            held[slot] = 0;
+        }
+
+        size = 16 + ((uint32_t)rand () % 2048);
+        held[slot] = CyU3PDmaBufferAlloc ((uint16_t)size);
+        if (held[slot] == 0)
+        {
+            fails++;
+            continue;
+        }
+        CyFxTestTag (held[slot], size, tag++);
+        allocs++;
+    }
+
+    /* Stop the interrupts, then hand the rest of the buffers back from thread context. The last free
+       drains whatever is still on the deferred list. */
+    period.it_interval.tv_nsec = 0;
+    period.it_value.tv_nsec    = 0;
+    timer_settime (timer, 0, &period, NULL);
+    timer_delete (timer);
+    signal (SIGALRM, SIG_IGN);
+
+    while (glTestTail != glTestHead)
+    {
+        CyFxTestCheckTag (glTestRing[glTestTail % CY_FX_TEST_RING]);
+        CyU3PDmaBufferFree (glTestRing[glTestTail % CY_FX_TEST_RING]);
+        glTestTail++;
+        mainFrees++;
+    }
+    for (slot = 0; slot < CY_FX_TEST_HELD; slot++)
+    {
+        if (held[slot] != 0)
+        {
+            CyFxTestCheckTag (held[slot]);
+            CyU3PDmaBufferFree (held[slot]);
+            mainFrees++;
+        }
+    }
+    CyU3PDmaBufferFree (CyU3PDmaBufferAlloc (64));
+
+    CyU3PBufGetDeferredCounts (&deferred, &drained);
+    CyU3PBufGetStats (&after);
+    printf ("%u allocations (%u failed), %u frees in the handler, %u in thread context, %u deferred\n", allocs,
+            fails, glTestIsrFrees, mainFrees, deferred);
+
+    if ((glTestBadTags != 0) || (glTestIsrErrors != 0))
+    {
+        printf ("FAIL: %u buffers with a damaged tag (last %u), %u failed frees in the handler\n", glTestBadTags,
+                glTestLastBad, glTestIsrErrors);
+        return 1;
+    }
+
+    if ((glTestIsrFrees == 0) || (deferred == 0) || (drained != deferred) || (glBufDeferredList != 0))
+    {
+        printf ("FAIL: %u frees in the handler, %u deferred, %u drained, list %08x\n", glTestIsrFrees, deferred,
+                drained, glBufDeferredList);
+        return 1;
+    }
+
+    if ((glTestIsrFrees + mainFrees != allocs) || (after.curBytes != 0) || (after.freeBytes != before.freeBytes) ||
+            (after.largestFree != before.largestFree))
+    {
+        printf ("FAIL: %u frees for %u allocations, %u bytes in use, %u of %u bytes free, largest %u of %u\n",
+                glTestIsrFrees + mainFrees, allocs, after.curBytes, after.freeBytes, before.freeBytes,
+                after.largestFree, before.largestFree);
+        return 1;
+    }
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
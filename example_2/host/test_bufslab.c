@@ -0,0 +1,380 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_bufslab.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test and benchmark for the DMA buffer slabs in cyfxtx (CYFXTX_BUF_SLAB_ENABLE).
+ *
+ * - The 64, 512 and 1024 byte classes are carved at init as separate regions of CY_U3P_BUF_SLAB_DEPTH
+ *   blocks, and the 16 KB and 32 KB classes are not carved by default.
+ * - For each carved class, the slab hands out every block of its region once, in both thread and
+ *   interrupt context, takes the freed blocks back and reuses them last in first out. Without the leak
+ *   checks, none of this takes the buffer manager lock. An allocation from an empty slab is served by
+ *   the heap and counted as a miss. The usage counters of the class and of the heap go back to where
+ *   they started.
+ * - Heap blocks never overlap a slab region. When the heap runs out, the regions of the slabs which
+ *   have all of their blocks free are returned to the heap, and the heap is then used up to its end.
+ * The time taken by an alloc/free pair of 512 bytes is then measured from the slab and from the heap.
+ *
+ * When run with the "checks" argument, the memory leak and corruption checks are enabled as well.
+ * The slab blocks are then allocated under the buffer manager lock, so that they can be linked into
+ * the in-use list, but are still returned to their slab.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx3hoststub.h"
+
+/* The allocator is included directly so that the slab regions and free lists can be checked. */
+#include "cyfxtx.c"
+
+#define CY_FX_TEST_MAX_BLOCKS           (512)           /* Blocks that can be held at a time. */
+#define CY_FX_TEST_BENCH_LOOPS          (1000000)       /* Number of alloc/free pairs timed. */
+
+static void    *glTestBlock[CY_FX_TEST_MAX_BLOCKS];     /* Blocks allocated by the test. */
+static CyBool_t glTestChecks = CyFalse;                 /* Whether the leak checks are enabled. */
+
+/* Start of the block holding the buffer at mem_p. */
+static uint32_t
+CyFxTestBlockStart (
+        void *mem_p)
+{
+    uint32_t addr = (uint32_t)mem_p;
+
+    if (glTestChecks)
+        addr -= sizeof (MemBlockInfo);
+    return addr;
+}
+
+/* Size class of the slab region holding the buffer at mem_p, or CY_U3P_BUF_SLAB_NUM_CLASSES. */
+static uint32_t
+CyFxTestRegion (
+        void *mem_p)
+{
+    uint32_t addr = CyFxTestBlockStart (mem_p), cls;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        if ((addr >= glBufSlab[cls].regionStart) && (addr < glBufSlab[cls].regionEnd))
+            break;
+    }
+    return cls;
+}
+
+/* Number of mutex Get calls made so far. */
+static uint32_t
+CyFxTestMutexGets (
+        void)
+{
+    uint32_t getCnt, putCnt;
+
+    CyFxHostMutexCounts (&getCnt, &putCnt);
+    if (getCnt != putCnt)
+    {
+        printf ("FAIL: %u mutex gets and %u puts\n", getCnt, putCnt);
+        exit (1);
+    }
+    return getCnt;
+}
+
+/* Current number of bytes allocated from the buffer heap. */
+static uint32_t
+CyFxTestCurBytes (
+        void)
+{
+    CyU3PHeapStats_t stats;
+
+    CyU3PBufGetStats (&stats);
+    return stats.curBytes;
+}
+
+static int
+CyFxTestCarve (
+        void)
+{
+    CyU3PBufSlabStats_t stats;
+    uint32_t            cls, other, lines;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        CyU3PBufGetSlabStats (cls, &stats);
+        lines = glBufSlab[cls].numLines * stats.carved;
+        if ((stats.carved != glBufSlabClassDepth[cls]) || (stats.cached != stats.carved) || (stats.inUse != 0) ||
+                (glBufSlab[cls].regionEnd - glBufSlab[cls].regionStart != lines * FX3_CACHE_LINE_SZ) ||
+                ((lines != 0) && ((glBufSlab[cls].regionStart < glBufferManager.startAddr) ||
+                                  (glBufSlab[cls].regionEnd > glBufferManager.startAddr + glBufferManager.regionSize))))
+        {
+            printf ("FAIL: %u byte class: %u blocks carved and %u cached, region %08x-%08x\n", stats.blkSize,
+                    stats.carved, stats.cached, glBufSlab[cls].regionStart, glBufSlab[cls].regionEnd);
+            return 1;
+        }
+
+        for (other = 0; (lines != 0) && (other < cls); other++)
+        {
+            if ((glBufSlab[cls].regionStart < glBufSlab[other].regionEnd) &&
+                    (glBufSlab[other].regionStart < glBufSlab[cls].regionEnd))
+            {
+                printf ("FAIL: regions of the %u and %u byte classes overlap\n", glBufSlabClassSize[other],
+                        glBufSlabClassSize[cls]);
+                return 1;
+            }
+        }
+    }
+
+    if ((glBufSlab[3].carved != 0) || (glBufSlab[4].carved != 0) || (CyFxTestCurBytes () != 0))
+    {
+        printf ("FAIL: burst classes carved by default, or carving counted as usage\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Allocate the whole slab of a class, one more block from the heap, and free them all again. */
+static int
+CyFxTestClass (
+        uint32_t cls,
+        CyBool_t isThread)
+{
+    CyU3PBufSlabStats_t before, after;
+    uint32_t            depth = glBufSlabClassDepth[cls], size = glBufSlabClassSize[cls];
+    uint32_t            i, j, gets, offset, blkBytes = glBufSlab[cls].numLines * FX3_CACHE_LINE_SZ;
+    uint32_t            minSize = blkBytes - FX3_CACHE_LINE_SZ + 1;
+    void               *extra_p;
+
+    /* Smallest size which still rounds up to the block size of the class. */
+    if (glTestChecks)
+        minSize -= sizeof (MemBlockInfo) + sizeof (uint32_t);
+
+    CyFxHostSetThread (isThread);
+    memset (&before, 0, sizeof (before));
+    CyU3PBufGetSlabStats (cls, &before);
+    gets = CyFxTestMutexGets ();
+
+    for (i = 0; i < depth; i++)
+    {
+        /* Sizes which round up to the same number of cache lines use the same class. */
+        glTestBlock[i] = CyU3PDmaBufferAlloc ((uint16_t)(((i & 1) != 0) ? minSize : size));
+        if ((glTestBlock[i] == 0) || (CyFxTestRegion (glTestBlock[i]) != cls))
+        {
+            printf ("FAIL: %u byte class: block %u at %p is not in the slab region\n", size, i, glTestBlock[i]);
+            return 1;
+        }
+
+        offset = CyFxTestBlockStart (glTestBlock[i]) - glBufSlab[cls].regionStart;
+        if ((offset % blkBytes) != 0)
+        {
+            printf ("FAIL: %u byte class: block %u at offset %u of the region\n", size, i, offset);
+            return 1;
+        }
+
+        for (j = 0; j < i; j++)
+        {
+            if (glTestBlock[j] == glTestBlock[i])
+            {
+                printf ("FAIL: %u byte class: block %u handed out twice\n", size, i);
+                return 1;
+            }
+        }
+
+        memset (glTestBlock[i], (int)i, minSize);
+    }
+
+    if ((CyFxTestMutexGets () - gets) != (glTestChecks ? depth : 0))
+    {
+        printf ("FAIL: %u byte class: %u mutex gets for %u slab allocations\n", size, CyFxTestMutexGets () - gets,
+                depth);
+        return 1;
+    }
+
+    /* The slab is empty: the next block comes from the heap. */
+    extra_p = CyU3PDmaBufferAlloc ((uint16_t)size);
+    CyU3PBufGetSlabStats (cls, &after);
+    if ((extra_p == 0) || (CyFxTestRegion (extra_p) != CY_U3P_BUF_SLAB_NUM_CLASSES) ||
+            (after.cached != 0) || (after.inUse != depth + 1) || (after.hits != before.hits + depth) ||
+            (after.misses != before.misses + 1) || (CyFxTestCurBytes () != (depth + 1) * blkBytes))
+    {
+        printf ("FAIL: %u byte class: heap block %p, %u cached, %u in use, %u hits, %u misses, %u bytes used\n",
+                size, extra_p, after.cached, after.inUse, after.hits - before.hits, after.misses - before.misses,
+                CyFxTestCurBytes ());
+        return 1;
+    }
+
+    /* Free in reverse order. The contents of the other blocks are not touched. */
+    gets = CyFxTestMutexGets ();
+    CyU3PDmaBufferFree (extra_p);
+    for (i = depth; i != 0; i--)
+    {
+        for (j = 0; j < minSize; j++)
+        {
+            if (((uint8_t *)glTestBlock[i - 1])[j] != (uint8_t)(i - 1))
+            {
+                printf ("FAIL: %u byte class: block %u overwritten at byte %u\n", size, i - 1, j);
+                return 1;
+            }
+        }
+
+        if (CyU3PDmaBufferFree (glTestBlock[i - 1]) != 0)
+        {
+            printf ("FAIL: %u byte class: free of block %u failed\n", size, i - 1);
+            return 1;
+        }
+    }
+
+    CyU3PBufGetSlabStats (cls, &after);
+    if (((CyFxTestMutexGets () - gets) != (glTestChecks ? depth + 1 : 1)) || (after.cached != depth) ||
+            (after.inUse != 0) || (CyFxTestCurBytes () != 0))
+    {
+        printf ("FAIL: %u byte class after the frees: %u mutex gets, %u cached, %u in use, %u bytes used\n", size,
+                CyFxTestMutexGets () - gets, after.cached, after.inUse, CyFxTestCurBytes ());
+        return 1;
+    }
+
+    /* The block freed last is handed out first. */
+    extra_p = CyU3PDmaBufferAlloc ((uint16_t)size);
+    if (extra_p != glTestBlock[0])
+    {
+        printf ("FAIL: %u byte class: %p reused instead of %p\n", size, extra_p, glTestBlock[0]);
+        return 1;
+    }
+    CyU3PDmaBufferFree (extra_p);
+
+    CyFxHostSetThread (CyTrue);
+    return 0;
+}
+
+/* Use up the heap with 2 KB blocks: the slab regions are given back when it runs out. */
+static int
+CyFxTestExhaust (
+        void)
+{
+    CyU3PHeapStats_t stats;
+    uint32_t         count, cls, carved = 0, lines = 0;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        carved += glBufSlab[cls].carved;
+        lines  += (glBufSlab[cls].regionEnd - glBufSlab[cls].regionStart) / FX3_CACHE_LINE_SZ;
+    }
+
+    for (count = 0; count < CY_FX_TEST_MAX_BLOCKS; count++)
+    {
+        glTestBlock[count] = CyU3PDmaBufferAlloc (2048);
+        if (glTestBlock[count] == 0)
+            break;
+
+        /* Until the regions are released, no heap block may overlap them. */
+        if ((glBufSlab[0].carved != 0) && (CyFxTestRegion (glTestBlock[count]) != CY_U3P_BUF_SLAB_NUM_CLASSES))
+        {
+            printf ("FAIL: heap block %u at %p is inside a slab region\n", count, glTestBlock[count]);
+            return 1;
+        }
+    }
+
+    CyU3PBufGetStats (&stats);
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        if ((glBufSlab[cls].carved != 0) || (glBufSlab[cls].freeList != 0) || (glBufSlab[cls].regionEnd != 0))
+        {
+            printf ("FAIL: %u byte slab not released when the heap ran out\n", glBufSlabClassSize[cls]);
+            return 1;
+        }
+    }
+
+    /* The released space was used: less than one block and its separator line is left over. */
+    if ((count == CY_FX_TEST_MAX_BLOCKS) || (carved == 0) || (stats.largestFree >= 2048 + 2 * FX3_CACHE_LINE_SZ))
+    {
+        printf ("FAIL: %u blocks allocated after releasing %u slab lines, %u bytes still free\n", count, lines,
+                stats.largestFree);
+        return 1;
+    }
+
+    while (count != 0)
+        CyU3PDmaBufferFree (glTestBlock[--count]);
+
+    if (CyFxTestCurBytes () != 0)
+    {
+        printf ("FAIL: %u bytes still in use after freeing all blocks\n", CyFxTestCurBytes ());
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Time alloc/free pairs of 512 bytes. */
+static double
+CyFxTestBench (
+        void)
+{
+    uint64_t t0, t1;
+    uint32_t i;
+    void    *mem_p;
+
+    t0 = CyFxHostTimeNs ();
+    for (i = 0; i < CY_FX_TEST_BENCH_LOOPS; i++)
+    {
+        mem_p = CyU3PDmaBufferAlloc (512);
+        CyU3PDmaBufferFree (mem_p);
+    }
+    t1 = CyFxHostTimeNs ();
+
+    return (double)(t1 - t0) / CY_FX_TEST_BENCH_LOOPS;
+}
+
+int
+main (
+        int   argc,
+        char *argv[])
+{
+    double   slabNs, heapNs;
+    uint32_t cls;
+
+    glTestChecks = ((argc > 1) && (strcmp (argv[1], "checks") == 0));
+
+    CyFxHostRamMap ();
+    if (glTestChecks)
+        CyU3PBufEnableChecks (CyTrue, 0);
+    CyU3PMemInit ();
+    CyU3PDmaBufferInit ();
+
+    if (CyFxTestCarve () != 0)
+        return 1;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        if ((glBufSlab[cls].carved != 0) &&
+                ((CyFxTestClass (cls, CyTrue) != 0) || (CyFxTestClass (cls, CyFalse) != 0)))
+            return 1;
+    }
+
+    slabNs = CyFxTestBench ();
+    if (CyFxTestExhaust () != 0)
+        return 1;
+    heapNs = CyFxTestBench ();
+
+    printf ("bench 512 byte alloc/free%s: %5.1f ns from the slab, %5.1f ns from the heap\n",
+            glTestChecks ? " with checks" : "", slabNs, heapNs);
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
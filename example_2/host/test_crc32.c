@@ -0,0 +1,183 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_crc32.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test and benchmark for the slice-by-4 CyFxCrc32Update in cyfxcrc32.c.
+ *
+ * The CRC is checked against the standard check value (0xCBF43926 for "123456789"), and against a bit
+ * at a time reference for every start alignment and for all short lengths, including lengths 0 to 7
+ * which do not reach a whole word. Random data is also split into chained updates at random points,
+ * which must give the same CRC as a single update. The slice-by-4 loop is then timed against the
+ * byte at a time table loop on a 16 KB buffer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx3hoststub.h"
+#include "cyfxcrc32.h"
+
+#define CY_FX_TEST_BUF_SIZE             (0x4000)        /* Size of the test buffer. */
+#define CY_FX_TEST_MAX_OFFSET           (8)             /* Start offsets checked: all word alignments, twice. */
+#define CY_FX_TEST_MAX_LEN              (67)            /* Lengths checked at every offset. */
+#define CY_FX_TEST_CHAINS               (20000)         /* Number of random chained update checks. */
+#define CY_FX_TEST_BENCH_ROUNDS         (2000)          /* Number of timed passes over the buffer. */
+
+static uint8_t glTestBuf[CY_FX_TEST_BUF_SIZE + CY_FX_TEST_MAX_OFFSET] __attribute__ ((aligned (32)));
+
+/* Bit at a time CRC32 (IEEE 802.3), used as the reference. */
+static uint32_t
+CyFxRefCrc32 (
+        uint32_t       crc,
+        const uint8_t *data_p,
+        uint32_t       len)
+{
+    uint32_t i;
+
+    crc = ~crc;
+    while (len-- != 0)
+    {
+        crc ^= *data_p++;
+        for (i = 0; i < 8; i++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+    }
+
+    return ~crc;
+}
+
+/* Byte at a time table CRC32, as used before the slice-by-4 version. Timed only. */
+static uint32_t glRefTable[256];
+
+static uint32_t
+CyFxRefCrc32Table (
+        uint32_t       crc,
+        const uint8_t *data_p,
+        uint32_t       len)
+{
+    crc = ~crc;
+    while (len-- != 0)
+        crc = glRefTable[(crc ^ *data_p++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+int
+main (
+        void)
+{
+    static const uint8_t check[] = "123456789";
+    uint32_t offset, len, split, i, crc, ref;
+    uint64_t t0, t1, t2;
+    volatile uint32_t sink = 0;
+
+    CyFxCrc32Init ();
+    srand (18);
+    for (i = 0; i < sizeof (glTestBuf); i++)
+        glTestBuf[i] = (uint8_t)rand ();
+
+    /* Standard check value, from an aligned and from an unaligned copy. */
+    for (offset = 0; offset < 4; offset++)
+    {
+        memcpy (&glTestBuf[offset], check, 9);
+        crc = CyFxCrc32Update (0, &glTestBuf[offset], 9);
+        if (crc != 0xCBF43926)
+        {
+            printf ("FAIL: CRC of \"123456789\" at offset %u is 0x%08X, expected 0xCBF43926\n", offset, crc);
+            return 1;
+        }
+    }
+
+    /* Every start alignment with every short length, including lengths 0 to 7. */
+    for (i = 0; i < sizeof (glTestBuf); i++)
+        glTestBuf[i] = (uint8_t)rand ();
+    for (offset = 0; offset < CY_FX_TEST_MAX_OFFSET; offset++)
+    {
+        for (len = 0; len <= CY_FX_TEST_MAX_LEN; len++)
+        {
+            crc = CyFxCrc32Update (0, &glTestBuf[offset], len);
+            ref = CyFxRefCrc32 (0, &glTestBuf[offset], len);
+            if (crc != ref)
+            {
+                printf ("FAIL: offset %u length %u: CRC 0x%08X, expected 0x%08X\n", offset, len, crc, ref);
+                return 1;
+            }
+        }
+    }
+
+    /* Chained updates split at random points, so that the later parts start at any alignment. */
+    for (i = 0; i < CY_FX_TEST_CHAINS; i++)
+    {
+        offset = (uint32_t)rand () % CY_FX_TEST_MAX_OFFSET;
+        len    = (uint32_t)rand () % 1024;
+        ref    = CyFxRefCrc32 (0, &glTestBuf[offset], len);
+
+        crc = 0;
+        for (split = 0; split < len; )
+        {
+            uint32_t part = 1 + ((uint32_t)rand () % (len - split));
+
+            if (((uint32_t)rand () & 1) != 0)
+                part = (part > 7) ? ((uint32_t)rand () % 8) : part;
+            crc    = CyFxCrc32Update (crc, &glTestBuf[offset + split], part);
+            split += part;
+        }
+
+        if (crc != ref)
+        {
+            printf ("FAIL: chained CRC of %u bytes at offset %u is 0x%08X, expected 0x%08X\n", len, offset, crc, ref);
+            return 1;
+        }
+    }
+
+    /* Time the slice-by-4 loop against the byte at a time table loop. */
+    for (i = 0; i < 256; i++)
+    {
+        crc = i;
+        for (len = 0; len < 8; len++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+        glRefTable[i] = crc;
+    }
+
+    t0 = CyFxHostTimeNs ();
+    for (i = 0; i < CY_FX_TEST_BENCH_ROUNDS; i++)
+        sink += CyFxRefCrc32Table (0, glTestBuf, CY_FX_TEST_BUF_SIZE);
+    t1 = CyFxHostTimeNs ();
+    for (i = 0; i < CY_FX_TEST_BENCH_ROUNDS; i++)
+        sink += CyFxCrc32Update (0, glTestBuf, CY_FX_TEST_BUF_SIZE);
+    t2 = CyFxHostTimeNs ();
+
+    if (CyFxRefCrc32Table (0, glTestBuf, CY_FX_TEST_BUF_SIZE) != CyFxCrc32Update (0, glTestBuf, CY_FX_TEST_BUF_SIZE))
+    {
+        printf ("FAIL: byte at a time table does not match\n");
+        return 1;
+    }
+
+    printf ("crc32 16 KB: byte table %.1f MB/s, slice-by-4 %.1f MB/s\n",
+            (double)CY_FX_TEST_BUF_SIZE * CY_FX_TEST_BENCH_ROUNDS * 1000.0 / (double)(t1 - t0),
+            (double)CY_FX_TEST_BUF_SIZE * CY_FX_TEST_BENCH_ROUNDS * 1000.0 / (double)(t2 - t1));
+    (void)sink;
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
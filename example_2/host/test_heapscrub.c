@@ -0,0 +1,300 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_heapscrub.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test and benchmark for the incremental heap corruption checks in cyfxtx.
+ *
+ * For both the driver heap (CyU3PMemScrubStep) and the buffer heap (CyU3PBufScrubStep):
+ * - each step checks the requested number of blocks, and leaves the cursor on the next block of the
+ *   in-use list, which is the block reached by following prev_blk from the list head;
+ * - freeing the block under the cursor moves the cursor on, and a pass then covers the remaining blocks;
+ * - a corrupted footer and a corrupted header are each reported once through the corruption callback
+ *   with the address of the bad block, and the next step starts again from the list head.
+ * The time taken by a step is then measured on a heap holding CY_FX_TEST_BLOCKS blocks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fx3hoststub.h"
+
+/* The allocator is included directly so that the scrub cursors and in-use lists can be checked. */
+#include "cyfxtx.c"
+
+#define CY_FX_TEST_BLOCKS               (64)            /* Blocks allocated in each heap. */
+#define CY_FX_TEST_SLICE                (16)            /* Blocks checked per step. */
+#define CY_FX_TEST_BENCH_LOOPS          (100000)        /* Number of steps timed. */
+
+/* Access to one of the two heaps. */
+typedef struct CyFxTestHeap_t
+{
+    const char           *name;
+    void               *(*alloc) (uint32_t size);
+    void                (*free) (void *mem_p);
+    CyU3PReturnStatus_t (*step) (uint32_t maxBlocks);
+    void                (*getStats) (CyU3PHeapScrubStats_t *stats_p);
+    MemBlockInfo        **cursor_p;                     /* Scrub cursor of the heap. */
+    MemBlockInfo        **list_p;                       /* Head of the in-use list of the heap. */
+} CyFxTestHeap_t;
+
+static void *glTestBlock[CY_FX_TEST_BLOCKS];            /* Blocks allocated from the heap under test. */
+static void *glTestBadBlock = 0;                        /* Block last reported by the corruption callback. */
+static uint32_t glTestBadCnt = 0;                       /* Number of corruption callbacks. */
+
+static void
+CyFxTestBadCb (
+        void *mem_p)
+{
+    glTestBadBlock = mem_p;
+    glTestBadCnt++;
+}
+
+static void *
+CyFxTestMemAlloc (
+        uint32_t size)
+{
+    return CyU3PMemAlloc (size);
+}
+
+static void *
+CyFxTestBufAlloc (
+        uint32_t size)
+{
+    return CyU3PDmaBufferAlloc ((uint16_t)size);
+}
+
+static void
+CyFxTestBufFree (
+        void *mem_p)
+{
+    CyU3PDmaBufferFree (mem_p);
+}
+
+static const CyFxTestHeap_t glTestHeaps[] = {
+    {"driver heap", CyFxTestMemAlloc, CyU3PMemFree, CyU3PMemScrubStep, CyU3PMemGetScrubStats,
+        &glMemScrubCursor, &glMemInUseList},
+    {"buffer heap", CyFxTestBufAlloc, CyFxTestBufFree, CyU3PBufScrubStep, CyU3PBufGetScrubStats,
+        &glBufScrubCursor, &glBufInUseList}
+};
+
+/* Header of the block returned to the user at mem_p. */
+static MemBlockInfo *
+CyFxTestHeader (
+        void *mem_p)
+{
+    return (MemBlockInfo *)((uint8_t *)mem_p - sizeof (MemBlockInfo));
+}
+
+/* Block that the scrubber should reach after checking count blocks from the list head. */
+static MemBlockInfo *
+CyFxTestListWalk (
+        const CyFxTestHeap_t *heap_p,
+        uint32_t              count)
+{
+    MemBlockInfo *block_p = *heap_p->list_p;
+
+    while ((count-- != 0) && (block_p != 0))
+        block_p = block_p->prev_blk;
+    return block_p;
+}
+
+/* Run steps until the scrubber reports an error, and check that the corrupted block was reported and that the
+   cursor went back to the list head. */
+static int
+CyFxTestCorrupt (
+        const CyFxTestHeap_t *heap_p,
+        const char           *what,
+        void                 *bad_p)
+{
+    CyU3PHeapScrubStats_t stats;
+    uint32_t              steps;
+
+    glTestBadBlock = 0;
+    glTestBadCnt   = 0;
+    for (steps = 0; steps < CY_FX_TEST_BLOCKS; steps++)
+    {
+        if (heap_p->step (CY_FX_TEST_SLICE) != CY_U3P_SUCCESS)
+            break;
+    }
+
+    heap_p->getStats (&stats);
+    if ((steps == CY_FX_TEST_BLOCKS) || (glTestBadCnt != 1) || (glTestBadBlock != bad_p) ||
+            (*heap_p->cursor_p != 0))
+    {
+        printf ("FAIL: %s: %s of %p: %u callbacks, reported %p, cursor %p\n", heap_p->name, what, bad_p,
+                glTestBadCnt, glTestBadBlock, (void *)*heap_p->cursor_p);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int
+CyFxTestHeap (
+        const CyFxTestHeap_t *heap_p)
+{
+    CyU3PHeapScrubStats_t before, after;
+    MemBlockInfo         *expect_p, *block_p, *initial_p = *heap_p->list_p;
+    uint32_t              i, live, scanned, victim;
+    uint32_t             *footer_p;
+    uint64_t              t0, t1;
+
+    for (i = 0; i < CY_FX_TEST_BLOCKS; i++)
+    {
+        glTestBlock[i] = heap_p->alloc (32 + 8 * i);
+        if (glTestBlock[i] == 0)
+        {
+            printf ("FAIL: %s: allocation %u failed\n", heap_p->name, i);
+            return 1;
+        }
+    }
+
+    /* The heap may hold blocks allocated during initialisation, which are checked as well. */
+    for (live = 0, block_p = *heap_p->list_p; block_p != 0; block_p = block_p->prev_blk)
+        live++;
+
+    /* Each step moves the cursor on by CY_FX_TEST_SLICE blocks. */
+    heap_p->getStats (&before);
+    for (i = 1; i <= 2; i++)
+    {
+        if (heap_p->step (CY_FX_TEST_SLICE) != CY_U3P_SUCCESS)
+        {
+            printf ("FAIL: %s: step %u reported corruption\n", heap_p->name, i);
+            return 1;
+        }
+
+        expect_p = CyFxTestListWalk (heap_p, i * CY_FX_TEST_SLICE);
+        if (*heap_p->cursor_p != expect_p)
+        {
+            printf ("FAIL: %s: cursor %p after step %u, expected %p\n", heap_p->name, (void *)*heap_p->cursor_p,
+                    i, (void *)expect_p);
+            return 1;
+        }
+    }
+
+    /* Free the block under the cursor: the cursor moves to the next block in the list. */
+    block_p  = *heap_p->cursor_p;
+    expect_p = block_p->prev_blk;
+    for (victim = 0; CyFxTestHeader (glTestBlock[victim]) != block_p; victim++)
+        ;
+    heap_p->free (glTestBlock[victim]);
+    glTestBlock[victim] = 0;
+    live--;
+    if (*heap_p->cursor_p != expect_p)
+    {
+        printf ("FAIL: %s: cursor %p after freeing the block under it, expected %p\n", heap_p->name,
+                (void *)*heap_p->cursor_p, (void *)expect_p);
+        return 1;
+    }
+
+    /* Complete the pass. It covers every block that is still allocated exactly once. */
+    heap_p->getStats (&after);
+    while (after.passes == before.passes)
+    {
+        heap_p->step (CY_FX_TEST_SLICE);
+        heap_p->getStats (&after);
+    }
+
+    scanned = after.blocksScanned - before.blocksScanned;
+    if ((scanned != live) || (*heap_p->cursor_p != 0) || (after.errors != before.errors))
+    {
+        printf ("FAIL: %s: pass checked %u of %u blocks, cursor %p, %u errors\n", heap_p->name, scanned, live,
+                (void *)*heap_p->cursor_p, after.errors - before.errors);
+        return 1;
+    }
+
+    /* A corrupted footer is reported, and the next step starts again from the list head. */
+    victim   = (victim + CY_FX_TEST_BLOCKS / 2) % CY_FX_TEST_BLOCKS;
+    block_p  = CyFxTestHeader (glTestBlock[victim]);
+    footer_p = (uint32_t *)((uint8_t *)block_p + block_p->alloc_size - sizeof (uint32_t));
+    *footer_p ^= 0x00010000;
+    if (CyFxTestCorrupt (heap_p, "footer", glTestBlock[victim]) != 0)
+        return 1;
+    *footer_p ^= 0x00010000;
+
+    heap_p->step (1);
+    if (*heap_p->cursor_p != CyFxTestListWalk (heap_p, 1))
+    {
+        printf ("FAIL: %s: step after the error did not start from the list head\n", heap_p->name);
+        return 1;
+    }
+
+    /* A corrupted header is reported as well. */
+    block_p->start_sig ^= 0x80;
+    if (CyFxTestCorrupt (heap_p, "header", glTestBlock[victim]) != 0)
+        return 1;
+    block_p->start_sig ^= 0x80;
+
+    /* Time the steps. */
+    heap_p->getStats (&before);
+    t0 = CyFxHostTimeNs ();
+    for (i = 0; i < CY_FX_TEST_BENCH_LOOPS; i++)
+        heap_p->step (CY_FX_TEST_SLICE);
+    t1 = CyFxHostTimeNs ();
+    heap_p->getStats (&after);
+    if (after.errors != before.errors)
+    {
+        printf ("FAIL: %s: errors reported on an intact heap\n", heap_p->name);
+        return 1;
+    }
+
+    printf ("bench %-12s %u blocks: %6.1f ns per step of %u blocks, %5.2f ns per block\n", heap_p->name, live,
+            (double)(t1 - t0) / CY_FX_TEST_BENCH_LOOPS, CY_FX_TEST_SLICE,
+            (double)(t1 - t0) / (after.blocksScanned - before.blocksScanned));
+
+    for (i = 0; i < CY_FX_TEST_BLOCKS; i++)
+    {
+        if (glTestBlock[i] != 0)
+            heap_p->free (glTestBlock[i]);
+    }
+
+    if (*heap_p->list_p != initial_p)
+    {
+        printf ("FAIL: %s: in-use list not back to its initial state after freeing all blocks\n", heap_p->name);
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+main (
+        void)
+{
+    uint32_t i;
+
+    CyFxHostRamMap ();
+    CyU3PMemEnableChecks (CyTrue, CyFxTestBadCb);
+    CyU3PBufEnableChecks (CyTrue, CyFxTestBadCb);
+    CyU3PMemInit ();
+    CyU3PDmaBufferInit ();
+
+    for (i = 0; i < sizeof (glTestHeaps) / sizeof (glTestHeaps[0]); i++)
+    {
+        if (CyFxTestHeap (&glTestHeaps[i]) != 0)
+            return 1;
+    }
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
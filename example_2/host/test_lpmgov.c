@@ -0,0 +1,197 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_lpmgov.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test for the LPM governor in cyfxlpmgov.c.
+ *
+ * - The transitions are blocked on the first tick that sees DMA activity, and not blocked again while
+ *   the activity continues.
+ * - For a range of tick periods and idle timeouts, the transitions are allowed again on the first idle
+ *   tick at which the idle time reaches the timeout rounded up to a whole number of periods, and never
+ *   before; activity during the idle count restarts it.
+ * - A random activity pattern is checked tick by tick against a reference model, which blocks while the
+ *   last active tick is fewer than ceil (idleTimeout / period) ticks ago.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fx3hoststub.h"
+#include "cyfxlpmgov.h"
+
+#define CY_FX_TEST_RANDOM_TICKS         (100000)        /* Ticks in the random activity test. */
+
+/* Number of idle ticks after which the transitions should be allowed again. */
+static uint32_t
+CyFxTestIdleTicks (
+        uint32_t period,
+        uint32_t idleTimeout)
+{
+    uint32_t ticks = (idleTimeout + period - 1) / period;
+
+    return (ticks == 0) ? 1 : ticks;
+}
+
+/* Block the transitions, then count idle ticks until they are allowed again. */
+static int
+CyFxTestTimeout (
+        uint32_t period,
+        uint32_t idleTimeout)
+{
+    CyFxLpmGov_t gov;
+    uint32_t     expect = CyFxTestIdleTicks (period, idleTimeout);
+    uint32_t     action, tick;
+
+    CyFxLpmGovInit (&gov, period, idleTimeout);
+    if (CyFxLpmGovTick (&gov) != CY_FX_LPM_GOV_NONE)
+    {
+        printf ("FAIL: period %u timeout %u: action without activity\n", period, idleTimeout);
+        return 1;
+    }
+
+    CyFxLpmGovActivity (&gov);
+    if (CyFxLpmGovTick (&gov) != CY_FX_LPM_GOV_BLOCK)
+    {
+        printf ("FAIL: period %u timeout %u: activity did not block the transitions\n", period, idleTimeout);
+        return 1;
+    }
+
+    /* Continued activity keeps the transitions blocked without further actions. */
+    CyFxLpmGovActivity (&gov);
+    if (CyFxLpmGovTick (&gov) != CY_FX_LPM_GOV_NONE)
+    {
+        printf ("FAIL: period %u timeout %u: blocked twice\n", period, idleTimeout);
+        return 1;
+    }
+
+    /* Activity part way through the idle count restarts it. */
+    if (expect > 1)
+    {
+        for (tick = 1; tick < expect; tick++)
+            CyFxLpmGovTick (&gov);
+        CyFxLpmGovActivity (&gov);
+        if (CyFxLpmGovTick (&gov) != CY_FX_LPM_GOV_NONE)
+        {
+            printf ("FAIL: period %u timeout %u: action on activity while blocked\n", period, idleTimeout);
+            return 1;
+        }
+    }
+
+    for (tick = 1; ; tick++)
+    {
+        action = CyFxLpmGovTick (&gov);
+        if (action != CY_FX_LPM_GOV_NONE)
+            break;
+        if (tick > expect)
+            break;
+    }
+
+    if ((action != CY_FX_LPM_GOV_ALLOW) || (tick != expect) || (gov.idleTime < idleTimeout) ||
+            (gov.idleTime != expect * period))
+    {
+        printf ("FAIL: period %u timeout %u: action %u after %u idle ticks (%u ms), expected allow after %u\n",
+                period, idleTimeout, action, tick, gov.idleTime, expect);
+        return 1;
+    }
+
+    if (CyFxLpmGovTick (&gov) != CY_FX_LPM_GOV_NONE)
+    {
+        printf ("FAIL: period %u timeout %u: allowed twice\n", period, idleTimeout);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Random activity, checked against the reference model on every tick. */
+static int
+CyFxTestRandom (
+        uint32_t period,
+        uint32_t idleTimeout)
+{
+    CyFxLpmGov_t gov;
+    uint32_t     idleTicks = CyFxTestIdleTicks (period, idleTimeout);
+    uint32_t     tick, lastActive = 0, action, expect, blocks = 0, allows = 0;
+    CyBool_t     active, seenActive = CyFalse, blocked = CyFalse, refBlocked;
+
+    srand (period * 1000 + idleTimeout);
+    CyFxLpmGovInit (&gov, period, idleTimeout);
+
+    for (tick = 0; tick < CY_FX_TEST_RANDOM_TICKS; tick++)
+    {
+        /* Bursts of activity separated by idle gaps of random length. */
+        active = (((uint32_t)rand () % 4) == 0) && ((tick / 64) % 2 == 0);
+        if (active)
+        {
+            CyFxLpmGovActivity (&gov);
+            lastActive = tick;
+            seenActive = CyTrue;
+        }
+
+        action     = CyFxLpmGovTick (&gov);
+        refBlocked = (seenActive) && ((tick - lastActive) < idleTicks);
+        expect     = (refBlocked == blocked) ? CY_FX_LPM_GOV_NONE :
+            ((refBlocked) ? CY_FX_LPM_GOV_BLOCK : CY_FX_LPM_GOV_ALLOW);
+        if (action != expect)
+        {
+            printf ("FAIL: period %u timeout %u: tick %u action %u, expected %u\n", period, idleTimeout, tick,
+                    action, expect);
+            return 1;
+        }
+
+        if (action == CY_FX_LPM_GOV_BLOCK)
+            blocks++;
+        else if (action == CY_FX_LPM_GOV_ALLOW)
+            allows++;
+        blocked = refBlocked;
+    }
+
+    if ((blocks == 0) || (allows + 1 < blocks))
+    {
+        printf ("FAIL: period %u timeout %u: %u blocks and %u allows\n", period, idleTimeout, blocks, allows);
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+main (
+        void)
+{
+    static const uint32_t periods[]  = {1, 10, 16};
+    static const uint32_t timeouts[] = {0, 1, 5, 9, 10, 11, 95, 100, 101, 1000};
+    uint32_t p, t;
+
+    for (p = 0; p < sizeof (periods) / sizeof (periods[0]); p++)
+    {
+        for (t = 0; t < sizeof (timeouts) / sizeof (timeouts[0]); t++)
+        {
+            if ((CyFxTestTimeout (periods[p], timeouts[t]) != 0) || (CyFxTestRandom (periods[p], timeouts[t]) != 0))
+                return 1;
+        }
+    }
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,310 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_memops.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test and benchmark for the CyU3PMemSet, CyU3PMemCopy and CyU3PMemCmp functions in cyfxtx.
+ *
+ * The functions are checked against the C library on random offsets, lengths and overlaps, including
+ * the overlapping copies in both directions that CyU3PMemCopy has to handle. They are then timed
+ * against the original byte at a time implementations, which are kept here as a reference. The test
+ * is built without auto-vectorization, as the ARM926EJ-S has no SIMD unit, and without inlining so
+ * that both implementations are timed as function calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx3hoststub.h"
+
+#include "cyfxtx.c"
+
+#define CY_FX_TEST_BUF_SIZE             (0x8000)        /* Size of the test buffers, as used by the source sink app. */
+#define CY_FX_TEST_ITERATIONS           (500000)        /* Number of random operations checked. */
+#define CY_FX_TEST_MAX_LEN              (600)           /* Largest length used by the random operations. */
+#define CY_FX_TEST_MAX_OFFSET           (64)            /* Offsets cover all word and cache line alignments. */
+
+static uint8_t glTestBuf[CY_FX_TEST_BUF_SIZE]    __attribute__ ((aligned (32)));
+static uint8_t glTestRef[CY_FX_TEST_BUF_SIZE]    __attribute__ ((aligned (32)));
+static uint8_t glTestOther[CY_FX_TEST_BUF_SIZE]  __attribute__ ((aligned (32)));
+
+/* Original byte at a time implementation of CyU3PMemSet. */
+static void
+CyFxRefMemSet (
+        uint8_t *ptr,
+        uint8_t  data,
+        uint32_t count)
+{
+    while (count >> 3)
+    {
+        ptr[0] = data;
+        ptr[1] = data;
+        ptr[2] = data;
+        ptr[3] = data;
+        ptr[4] = data;
+        ptr[5] = data;
+        ptr[6] = data;
+        ptr[7] = data;
+
+        count -= 8;
+        ptr += 8;
+    }
+
+    while (count--)
+    {
+        *ptr = data;
+        ptr++;
+    }
+}
+
+/* Original byte at a time implementation of CyU3PMemCopy. */
+static void
+CyFxRefMemCopy (
+        uint8_t  *dest,
+        uint8_t  *src,
+        uint32_t  count)
+{
+    if (dest > src)
+    {
+        dest += count;
+        src  += count;
+
+        while (count >= 8)
+        {
+            dest  -= 8;
+            src   -= 8;
+            count -= 8;
+
+            dest[7] = src[7];
+            dest[6] = src[6];
+            dest[5] = src[5];
+            dest[4] = src[4];
+            dest[3] = src[3];
+            dest[2] = src[2];
+            dest[1] = src[1];
+            dest[0] = src[0];
+        }
+
+        while (count > 0)
+        {
+            dest--;
+            src--;
+            count--;
+
+            *dest = *src;
+        }
+    }
+    else
+    {
+        while (count >= 8)
+        {
+            dest[0] = src[0];
+            dest[1] = src[1];
+            dest[2] = src[2];
+            dest[3] = src[3];
+            dest[4] = src[4];
+            dest[5] = src[5];
+            dest[6] = src[6];
+            dest[7] = src[7];
+
+            dest  += 8;
+            src   += 8;
+            count -= 8;
+        }
+
+        while (count > 0)
+        {
+            *dest = *src;
+
+            dest++;
+            src++;
+            count--;
+        }
+    }
+}
+
+/* Original byte at a time implementation of CyU3PMemCmp. */
+static int32_t
+CyFxRefMemCmp (
+        const void *s1,
+        const void *s2,
+        uint32_t    n)
+{
+    const uint8_t *ptr1 = (const uint8_t *)s1, *ptr2 = (const uint8_t *)s2;
+
+    while (n--)
+    {
+        if (*ptr1 != *ptr2)
+        {
+            return *ptr1 - *ptr2;
+        }
+
+        ptr1++;
+        ptr2++;
+    }
+
+    return 0;
+}
+
+static void
+CyFxTestRandomFill (
+        uint8_t *buf_p,
+        uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+        buf_p[i] = (uint8_t)rand ();
+}
+
+static int
+CyFxTestSign (
+        int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+/* Check the functions against the C library on random offsets, lengths and overlaps. */
+static int
+CyFxTestCompare (
+        void)
+{
+    const uint32_t span = 2 * CY_FX_TEST_MAX_OFFSET + CY_FX_TEST_MAX_LEN;
+    uint32_t iter, op, off1, off2, len, pos;
+    uint8_t  data;
+    int      ret1, ret2;
+
+    for (iter = 0; iter < CY_FX_TEST_ITERATIONS; iter++)
+    {
+        CyFxTestRandomFill (glTestBuf, span);
+        memcpy (glTestRef, glTestBuf, span);
+
+        op   = (uint32_t)rand () % 3;
+        off1 = (uint32_t)rand () % CY_FX_TEST_MAX_OFFSET;
+        off2 = (uint32_t)rand () % CY_FX_TEST_MAX_OFFSET;
+        len  = ((rand () % 4) == 0) ? ((uint32_t)rand () % 16) : ((uint32_t)rand () % CY_FX_TEST_MAX_LEN);
+
+        switch (op)
+        {
+        case 0:
+            /* Copy within the same buffer, so that the source and destination overlap in most cases. */
+            CyU3PMemCopy (glTestBuf + off1, glTestBuf + off2, len);
+            memmove (glTestRef + off1, glTestRef + off2, len);
+            if (memcmp (glTestBuf, glTestRef, span) != 0)
+            {
+                printf ("FAIL: CyU3PMemCopy (+%u, +%u, %u)\n", off1, off2, len);
+                return 1;
+            }
+            break;
+
+        case 1:
+            data = (uint8_t)rand ();
+            CyU3PMemSet (glTestBuf + off1, data, len);
+            memset (glTestRef + off1, data, len);
+            if (memcmp (glTestBuf, glTestRef, span) != 0)
+            {
+                printf ("FAIL: CyU3PMemSet (+%u, 0x%02X, %u)\n", off1, data, len);
+                return 1;
+            }
+            break;
+
+        default:
+            /* Compare against a copy, with one byte changed in half of the cases. */
+            memcpy (glTestOther + off2, glTestBuf + off1, len);
+            if ((len != 0) && ((rand () % 2) == 0))
+            {
+                pos = (uint32_t)rand () % len;
+                glTestOther[off2 + pos] ^= (uint8_t)(1 + (rand () % 255));
+            }
+
+            ret1 = CyU3PMemCmp (glTestBuf + off1, glTestOther + off2, len);
+            ret2 = memcmp (glTestBuf + off1, glTestOther + off2, len);
+            if (CyFxTestSign (ret1) != CyFxTestSign (ret2))
+            {
+                printf ("FAIL: CyU3PMemCmp (+%u, +%u, %u) returned %d, memcmp %d\n", off1, off2, len, ret1, ret2);
+                return 1;
+            }
+            break;
+        }
+    }
+
+    printf ("compare: %u random operations matched the C library\n", CY_FX_TEST_ITERATIONS);
+    return 0;
+}
+
+/* Time one call of each implementation, averaged over loops calls. */
+#define CY_FX_TEST_BENCH(name, loops, newCall, refCall)                                         \
+    do {                                                                                        \
+        uint64_t t0, t1, t2;                                                                    \
+        uint32_t i;                                                                             \
+        t0 = CyFxHostTimeNs ();                                                                 \
+        for (i = 0; i < (loops); i++) { newCall; __asm__ __volatile__ ("" : : : "memory"); }    \
+        t1 = CyFxHostTimeNs ();                                                                 \
+        for (i = 0; i < (loops); i++) { refCall; __asm__ __volatile__ ("" : : : "memory"); }    \
+        t2 = CyFxHostTimeNs ();                                                                 \
+        printf ("bench %-30s new %9.1f ns, byte loop %9.1f ns\n", (name),                      \
+                (double)(t1 - t0) / (loops), (double)(t2 - t1) / (loops));                      \
+    } while (0)
+
+int
+main (
+        void)
+{
+    volatile int32_t sink = 0;
+    int              ret;
+
+    srand (5);
+    ret = CyFxTestCompare ();
+    if (ret != 0)
+        return ret;
+
+    CyFxTestRandomFill (glTestOther, CY_FX_TEST_BUF_SIZE);
+
+    CY_FX_TEST_BENCH ("set 32 KB aligned", 2000,
+            CyU3PMemSet (glTestBuf, 0xAA, CY_FX_TEST_BUF_SIZE),
+            CyFxRefMemSet (glTestBuf, 0xAA, CY_FX_TEST_BUF_SIZE));
+    CY_FX_TEST_BENCH ("copy 32 KB aligned", 2000,
+            CyU3PMemCopy (glTestBuf, glTestOther, CY_FX_TEST_BUF_SIZE),
+            CyFxRefMemCopy (glTestBuf, glTestOther, CY_FX_TEST_BUF_SIZE));
+    CY_FX_TEST_BENCH ("copy 1 KB, src +1 dst +1", 50000,
+            CyU3PMemCopy (glTestBuf + 1, glTestOther + 1, 1024),
+            CyFxRefMemCopy (glTestBuf + 1, glTestOther + 1, 1024));
+    CY_FX_TEST_BENCH ("copy 1 KB overlapping, dst +8", 50000,
+            CyU3PMemCopy (glTestBuf + 8, glTestBuf, 1024),
+            CyFxRefMemCopy (glTestBuf + 8, glTestBuf, 1024));
+    CY_FX_TEST_BENCH ("copy 1 KB, src +1 dst +2", 50000,
+            CyU3PMemCopy (glTestBuf + 2, glTestOther + 1, 1024),
+            CyFxRefMemCopy (glTestBuf + 2, glTestOther + 1, 1024));
+    CY_FX_TEST_BENCH ("copy 64 B aligned", 500000,
+            CyU3PMemCopy (glTestBuf, glTestOther, 64),
+            CyFxRefMemCopy (glTestBuf, glTestOther, 64));
+
+    memcpy (glTestBuf, glTestOther, CY_FX_TEST_BUF_SIZE);
+    CY_FX_TEST_BENCH ("compare 4 KB equal, aligned", 20000,
+            sink += CyU3PMemCmp (glTestBuf, glTestOther, 4096),
+            sink += CyFxRefMemCmp (glTestBuf, glTestOther, 4096));
+    (void) sink;
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
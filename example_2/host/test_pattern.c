@@ -0,0 +1,359 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_pattern.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test for the source data patterns in cyfxpattern.c.
+ *
+ * - CyFxPatternPrbsStep is compared with a bit-serial PRBS31 (x^31 + x^28 + 1) reference LFSR, from the
+ *   standard seed and from random seeds.
+ * - PRBS31 and COUNTER buffers filled one after the other, with sizes that do not line up with the byte
+ *   step or the word size, continue the sequence across the buffer boundaries.
+ * - The stamps write the sequence number and its complement (SEQNUM), the sequence number alone (PRBS31),
+ *   and nothing for CONST and COUNTER.
+ * - CyFxPatternPrbsCheck accepts stamped PRBS31 buffers and reports the offset of a flipped bit.
+ * The PRBS31 fill rate is then measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx3hoststub.h"
+#include "cyfxpattern.h"
+
+#define CY_FX_TEST_STREAM               (4096)          /* Bytes of reference sequence compared. */
+#define CY_FX_TEST_BUF_SIZE             (1024)          /* Size of the stamped buffers. */
+#define CY_FX_TEST_BENCH_LOOPS          (2000)          /* Number of buffers filled in the benchmark. */
+
+static uint8_t  glTestStream[CY_FX_TEST_STREAM];        /* Reference PRBS31 bytes. */
+static uint32_t glTestBuf[CY_FX_TEST_BUF_SIZE / 4];     /* Word aligned buffer for the stamp tests. */
+
+/* CyU3PMemSet is provided by cyfxtx in the firmware. */
+void
+CyU3PMemSet (
+        uint8_t  *ptr,
+        uint8_t   data,
+        uint32_t  count)
+{
+    memset (ptr, data, count);
+}
+
+/* Bit-serial reference: the new bit is the XOR of the bits generated 31 and 28 steps ago, and the bits are
+ * packed MSB first. */
+static void
+CyFxTestPrbsRef (
+        uint32_t  seed,
+        uint8_t  *out_p,
+        uint32_t  count)
+{
+    uint32_t reg = seed & 0x7FFFFFFF, bit, i, j;
+
+    for (i = 0; i < count; i++)
+    {
+        out_p[i] = 0;
+        for (j = 0; j < 8; j++)
+        {
+            bit = ((reg >> 30) ^ (reg >> 27)) & 1;
+            reg = ((reg << 1) | bit) & 0x7FFFFFFF;
+            out_p[i] = (uint8_t)((out_p[i] << 1) | bit);
+        }
+    }
+}
+
+static int
+CyFxTestPrbsStep (
+        void)
+{
+    uint8_t  ref[256];
+    uint32_t seed, prbs, i, n;
+
+    for (n = 0; n < 64; n++)
+    {
+        seed = (n == 0) ? CY_FX_PATTERN_PRBS_SEED : (((uint32_t)rand () << 16) ^ (uint32_t)rand ()) & 0x7FFFFFFF;
+        if (seed == 0)
+            seed = 1;
+
+        CyFxTestPrbsRef (seed, ref, sizeof (ref));
+        prbs = seed;
+        for (i = 0; i < sizeof (ref); i++)
+        {
+            if (CyFxPatternPrbsStep (&prbs) != ref[i])
+            {
+                printf ("FAIL: PRBS31 step from seed %08x differs from the reference at byte %u\n", seed, i);
+                return 1;
+            }
+        }
+    }
+
+    /* The sequence does not repeat within the bytes compared. */
+    CyFxTestPrbsRef (CY_FX_PATTERN_PRBS_SEED, glTestStream, sizeof (glTestStream));
+    if (memcmp (glTestStream, glTestStream + 4, sizeof (glTestStream) - 4) == 0)
+    {
+        printf ("FAIL: PRBS31 reference is periodic\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Fill buffers of the given sizes one after the other from a single generator, and check that together they
+ * hold the reference sequence. */
+static int
+CyFxTestFillAcross (
+        const uint32_t *sizes,
+        uint32_t        count)
+{
+    CyFxPatternGen_t gen;
+    uint32_t         i, j, pos;
+    uint32_t        *words_p;
+    uint8_t         *buf_p;
+
+    CyFxPatternInit (&gen, CY_FX_PATTERN_PRBS31, 0xAA);
+    for (i = 0, pos = 0; i < count; pos += sizes[i], i++)
+    {
+        buf_p = (uint8_t *)malloc (sizes[i] + 1);
+        buf_p[sizes[i]] = 0x5C;
+        CyFxPatternFill (&gen, buf_p, sizes[i]);
+        if ((memcmp (buf_p, glTestStream + pos, sizes[i]) != 0) || (buf_p[sizes[i]] != 0x5C))
+        {
+            printf ("FAIL: PRBS31 buffer %u of %u bytes at stream offset %u\n", i, sizes[i], pos);
+            free (buf_p);
+            return 1;
+        }
+        free (buf_p);
+    }
+
+    /* COUNTER continues from one buffer to the next, and a size which is not a multiple of four is rounded
+       down without touching the last bytes. */
+    CyFxPatternInit (&gen, CY_FX_PATTERN_COUNTER, 0xAA);
+    for (i = 0, pos = 0; i < count; i++)
+    {
+        words_p = (uint32_t *)malloc (sizes[i] + 4);
+        memset (words_p, 0x5C, sizes[i] + 4);
+        CyFxPatternFill (&gen, (uint8_t *)words_p, sizes[i]);
+        for (j = 0; j < sizes[i] / 4; j++, pos++)
+        {
+            if (words_p[j] != pos)
+            {
+                printf ("FAIL: COUNTER buffer %u word %u is %u, expected %u\n", i, j, words_p[j], pos);
+                free (words_p);
+                return 1;
+            }
+        }
+        for (j = (sizes[i] & ~3u); j < sizes[i] + 4; j++)
+        {
+            if (((uint8_t *)words_p)[j] != 0x5C)
+            {
+                printf ("FAIL: COUNTER buffer %u of %u bytes written at byte %u\n", i, sizes[i], j);
+                free (words_p);
+                return 1;
+            }
+        }
+        free (words_p);
+    }
+
+    return 0;
+}
+
+static int
+CyFxTestBufferBoundaries (
+        void)
+{
+    static const uint32_t odd[]  = {1, 3, 7, 9, 13, 100, 511, 2, 5, 17, 33, 1000, 6};
+    static const uint32_t full[] = {512, 512, 1024, 1024, 1024};
+
+    if (CyFxTestFillAcross (odd, sizeof (odd) / sizeof (odd[0])) != 0)
+        return 1;
+    return CyFxTestFillAcross (full, sizeof (full) / sizeof (full[0]));
+}
+
+/* Stamp the same buffer a number of times and check the header and the body after each stamp. */
+static int
+CyFxTestStamp (
+        uint32_t    pattern,
+        const char *name)
+{
+    CyFxPatternGen_t gen;
+    uint8_t          body[CY_FX_TEST_BUF_SIZE];
+    uint8_t         *buf_p = (uint8_t *)glTestBuf;
+    uint32_t         seq, hdr;
+
+    CyFxPatternInit (&gen, pattern, 0xAA);
+    CyFxPatternFill (&gen, buf_p, CY_FX_TEST_BUF_SIZE);
+    memcpy (body, buf_p, CY_FX_TEST_BUF_SIZE);
+
+    /* The body of the CONST and SEQNUM patterns is the constant byte. */
+    for (seq = 0; (seq < CY_FX_TEST_BUF_SIZE) && ((pattern == CY_FX_PATTERN_CONST) ||
+                (pattern == CY_FX_PATTERN_SEQNUM)); seq++)
+    {
+        if (body[seq] != 0xAA)
+        {
+            printf ("FAIL: %s: body byte %u is %02x\n", name, seq, body[seq]);
+            return 1;
+        }
+    }
+
+    for (seq = 0; seq < 5; seq++)
+    {
+        CyFxPatternStamp (&gen, buf_p);
+
+        switch (pattern)
+        {
+        case CY_FX_PATTERN_SEQNUM:
+            hdr = 8;
+            break;
+        case CY_FX_PATTERN_PRBS31:
+            hdr = 4;
+            break;
+        default:
+            hdr = 0;
+            break;
+        }
+
+        /* The header is little-endian, as on the FX3. */
+        if (((hdr >= 4) && ((buf_p[0] != (uint8_t)seq) || (buf_p[1] != 0) || (buf_p[2] != 0) || (buf_p[3] != 0))) ||
+                ((hdr == 8) && ((buf_p[4] != (uint8_t)~seq) || (buf_p[5] != 0xFF) || (buf_p[6] != 0xFF) ||
+                                (buf_p[7] != 0xFF))))
+        {
+            printf ("FAIL: %s: header of stamp %u is %02x%02x%02x%02x %02x%02x%02x%02x\n", name, seq, buf_p[3],
+                    buf_p[2], buf_p[1], buf_p[0], buf_p[7], buf_p[6], buf_p[5], buf_p[4]);
+            return 1;
+        }
+        if (memcmp (buf_p + hdr, body + hdr, CY_FX_TEST_BUF_SIZE - hdr) != 0)
+        {
+            printf ("FAIL: %s: stamp %u wrote past the %u byte header\n", name, seq, hdr);
+            return 1;
+        }
+    }
+
+    if (gen.seqNum != 5)
+    {
+        printf ("FAIL: %s: sequence number %u after five stamps\n", name, gen.seqNum);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int
+CyFxTestStamps (
+        void)
+{
+    if ((CyFxTestStamp (CY_FX_PATTERN_CONST, "CONST") != 0) ||
+            (CyFxTestStamp (CY_FX_PATTERN_COUNTER, "COUNTER") != 0) ||
+            (CyFxTestStamp (CY_FX_PATTERN_SEQNUM, "SEQNUM") != 0) ||
+            (CyFxTestStamp (CY_FX_PATTERN_PRBS31, "PRBS31") != 0))
+        return 1;
+
+    return 0;
+}
+
+static int
+CyFxTestPrbsCheck (
+        void)
+{
+    CyFxPatternGen_t gen;
+    uint8_t         *buf_p = (uint8_t *)glTestBuf;
+    uint32_t         n, offset, bit, result;
+    int              bad;
+
+    /* Stamped buffers at any point of the sequence pass, since the second word seeds the checker. */
+    CyFxPatternInit (&gen, CY_FX_PATTERN_PRBS31, 0xAA);
+    for (n = 0; n < 8; n++)
+    {
+        CyFxPatternFill (&gen, buf_p, CY_FX_TEST_BUF_SIZE - n);
+        CyFxPatternStamp (&gen, buf_p);
+        offset = CyFxPatternPrbsCheck (buf_p, CY_FX_TEST_BUF_SIZE - n);
+        if (offset != CY_FX_PATTERN_CHECK_GOOD)
+        {
+            printf ("FAIL: PRBS31 buffer %u reported bad at offset %u\n", n, offset);
+            return 1;
+        }
+    }
+
+    /* A flipped bit is reported at its byte offset. The first word is not checked, and the top bit of the seed
+       word is not part of the 31 bit state. Any other bit flipped in the seed word changes one of the first
+       31 bits generated, in the first four bytes checked. */
+    for (n = 0; n < 400; n++)
+    {
+        offset = (uint32_t)rand () % CY_FX_TEST_BUF_SIZE;
+        bit    = 1u << ((uint32_t)rand () % 8);
+        buf_p[offset] ^= bit;
+        result = CyFxPatternPrbsCheck (buf_p, CY_FX_TEST_BUF_SIZE - 7);
+        if ((offset < 4) || ((offset == 4) && (bit == 0x80)) || (offset >= CY_FX_TEST_BUF_SIZE - 7))
+            bad = (result != CY_FX_PATTERN_CHECK_GOOD);
+        else if (offset < 8)
+            bad = ((result < 8) || (result > 11));
+        else
+            bad = (result != offset);
+        if (bad)
+        {
+            printf ("FAIL: bit %02x flipped at offset %u reported at %u\n", bit, offset, result);
+            return 1;
+        }
+        buf_p[offset] ^= bit;
+    }
+
+    /* Buffers of up to eight bytes hold no checked data. */
+    memset (buf_p, 0xFF, 16);
+    for (n = 0; n <= 8; n++)
+    {
+        if (CyFxPatternPrbsCheck (buf_p, n) != CY_FX_PATTERN_CHECK_GOOD)
+        {
+            printf ("FAIL: %u byte buffer reported bad\n", n);
+            return 1;
+        }
+    }
+    if (CyFxPatternPrbsCheck (buf_p, 9) != 8)
+    {
+        printf ("FAIL: 0xFF filled buffer not reported at offset 8\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+main (
+        void)
+{
+    CyFxPatternGen_t gen;
+    uint64_t         t0, t1;
+    uint32_t         i;
+
+    srand (1);
+    if ((CyFxTestPrbsStep () != 0) || (CyFxTestBufferBoundaries () != 0) || (CyFxTestStamps () != 0) ||
+            (CyFxTestPrbsCheck () != 0))
+        return 1;
+
+    CyFxPatternInit (&gen, CY_FX_PATTERN_PRBS31, 0xAA);
+    t0 = CyFxHostTimeNs ();
+    for (i = 0; i < CY_FX_TEST_BENCH_LOOPS; i++)
+        CyFxPatternFill (&gen, (uint8_t *)glTestBuf, CY_FX_TEST_BUF_SIZE);
+    t1 = CyFxHostTimeNs ();
+    printf ("bench PRBS31 fill: %5.2f ns per byte\n",
+            (double)(t1 - t0) / ((double)CY_FX_TEST_BENCH_LOOPS * CY_FX_TEST_BUF_SIZE));
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
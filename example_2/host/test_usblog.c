@@ -0,0 +1,167 @@
+/*
+ ## Cypress FX3 Host Test Source File (test_usblog.c)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* Host test for the 0x8B USB driver log decoder in fx3usblogdec.c.
+ *
+ * A sequence of responses is built the way the demo_c firmware returns them, and decoded in order: a
+ * first read, a read that follows on, a read where the device skipped overwritten bytes, a read across
+ * a gap of unknown size, and a read after the device log restarted. The decoded positions, gap types
+ * and totals are checked, and so is the rejection of malformed or inconsistent responses.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fx3usblogdec.h"
+
+static uint8_t glTestRsp[CY_FX_USBLOG_HDR_SIZE + 512];
+
+static void
+CyFxTestPutLe32 (
+        uint8_t  *p,
+        uint32_t  value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+/* Build a response in glTestRsp, with the data bytes set to the low byte of their log position. */
+static uint32_t
+CyFxTestBuildRsp (
+        uint32_t readPos,
+        uint32_t writePos,
+        uint32_t lostCnt,
+        uint32_t length)
+{
+    uint32_t i;
+
+    CyFxTestPutLe32 (glTestRsp, readPos);
+    CyFxTestPutLe32 (glTestRsp + 4, writePos);
+    CyFxTestPutLe32 (glTestRsp + 8, lostCnt);
+    CyFxTestPutLe32 (glTestRsp + 12, length);
+    for (i = 0; i < length; i++)
+        glTestRsp[CY_FX_USBLOG_HDR_SIZE + i] = (uint8_t)(readPos + i);
+
+    return (CY_FX_USBLOG_HDR_SIZE + length);
+}
+
+/* Decode a response and check the result. */
+static int
+CyFxTestDecode (
+        CyFxUsbLogDecoder_t *dec_p,
+        const char          *name,
+        uint32_t             readPos,
+        uint32_t             writePos,
+        uint32_t             lostCnt,
+        uint32_t             length,
+        uint32_t             gap)
+{
+    CyFxUsbLogChunk_t chunk;
+    uint32_t          len = CyFxTestBuildRsp (readPos, writePos, lostCnt, length);
+
+    if (CyFxUsbLogDecodeChunk (dec_p, glTestRsp, len, &chunk) != 0)
+    {
+        printf ("FAIL: %s: response rejected\n", name);
+        return 1;
+    }
+
+    if ((chunk.readPos != readPos) || (chunk.length != length) || (chunk.gap != gap) ||
+            (dec_p->nextPos != readPos + length) || ((length != 0) && (chunk.data_p[0] != (uint8_t)readPos)))
+    {
+        printf ("FAIL: %s: readPos %u length %u gap %u next %u, expected %u %u %u %u\n", name, chunk.readPos,
+                chunk.length, chunk.gap, dec_p->nextPos, readPos, length, gap, readPos + length);
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+main (
+        void)
+{
+    CyFxUsbLogDecoder_t dec;
+    CyFxUsbLogChunk_t   chunk;
+    int                 fail = 0;
+
+    CyFxUsbLogDecoderInit (&dec);
+
+    fail |= CyFxTestDecode (&dec, "first read", 0, 700, 0, 512, CY_FX_USBLOG_GAP_NONE);
+    fail |= CyFxTestDecode (&dec, "continued read", 512, 700, 0, 188, CY_FX_USBLOG_GAP_NONE);
+    fail |= CyFxTestDecode (&dec, "caught up", 700, 700, 0, 0, CY_FX_USBLOG_GAP_NONE);
+
+    /* The reader fell behind by more than a ring: the device skips to the oldest byte it holds. */
+    fail |= CyFxTestDecode (&dec, "known loss", 700 + 3000, 700 + 8000, 3000, 512, CY_FX_USBLOG_GAP_LOST);
+
+    /* The firmware could not rule out a wrap of the ring, so the number of bytes missed is not known. */
+    fail |= CyFxTestDecode (&dec, "unknown gap", 9000, 9100, CY_FX_USBLOG_LOST_UNKNOWN, 100,
+            CY_FX_USBLOG_GAP_UNKNOWN);
+    fail |= CyFxTestDecode (&dec, "after unknown gap", 9100, 9100, 0, 0, CY_FX_USBLOG_GAP_NONE);
+
+    /* The device was reset: the requested position is ahead of its log. */
+    fail |= CyFxTestDecode (&dec, "restart", 0, 40, 0, 40, CY_FX_USBLOG_GAP_RESTART);
+
+    /* Positions wrap at 2^32. */
+    dec.nextPos = 0xFFFFFF00;
+    fail |= CyFxTestDecode (&dec, "position wrap", 0xFFFFFF00, 0x100, 0, 512, CY_FX_USBLOG_GAP_NONE);
+
+    if (fail != 0)
+        return 1;
+
+    if ((dec.lostBytes != 3000) || (dec.unknownGaps != 1) || (dec.restarts != 1) ||
+            (dec.bytes != 512 + 188 + 512 + 100 + 40 + 512))
+    {
+        printf ("FAIL: totals: %llu bytes, %llu lost, %u unknown gaps, %u restarts\n",
+                (unsigned long long)dec.bytes, (unsigned long long)dec.lostBytes, dec.unknownGaps, dec.restarts);
+        return 1;
+    }
+
+    /* Malformed and inconsistent responses. */
+    CyFxUsbLogDecoderInit (&dec);
+    if (CyFxUsbLogDecodeChunk (&dec, glTestRsp, CY_FX_USBLOG_HDR_SIZE - 1, &chunk) == 0)
+    {
+        printf ("FAIL: short header accepted\n");
+        return 1;
+    }
+    if (CyFxUsbLogDecodeChunk (&dec, glTestRsp, CyFxTestBuildRsp (0, 100, 0, 64) - 1, &chunk) == 0)
+    {
+        printf ("FAIL: truncated data accepted\n");
+        return 1;
+    }
+    if (CyFxUsbLogDecodeChunk (&dec, glTestRsp, CyFxTestBuildRsp (0, 32, 0, 64), &chunk) == 0)
+    {
+        printf ("FAIL: data past the write position accepted\n");
+        return 1;
+    }
+    if (CyFxUsbLogDecodeChunk (&dec, glTestRsp, CyFxTestBuildRsp (5000, 6000, 100, 64), &chunk) == 0)
+    {
+        printf ("FAIL: lostCnt not matching the skipped positions accepted\n");
+        return 1;
+    }
+
+    printf ("PASS\n");
+    return 0;
+}
+
+/*[]*/
@@ -0,0 +1,163 @@
+/*
+ ## Cypress FX3 Firmware Header File (cyfxtx.h)
+ ## ===========================
+ ##
+ ##  Copyright Cypress Semiconductor Corporation, 2010-2023,
+ ##  All Rights Reserved
+ ##  UNPUBLISHED, LICENSED SOFTWARE.
+ ##
+ ##  CONFIDENTIAL AND PROPRIETARY INFORMATION
+ ##  WHICH IS THE PROPERTY OF CYPRESS.
+ ##
+ ##  Use of this file is governed
+ ##  by the license agreement included in the file
+ ##
+ ##     <install>/license/license.txt
+ ##
+ ##  where <install> is the Cypress software
+ ##  installation root directory path.
+ ##
+ ## ===========================
+*/
+
+/* This file contains the definitions for the optional heap management features implemented in
+ * the cyfxtx source file, in addition to the standard allocator functions declared in cyu3os.h.
+ */
+
+#ifndef _INCLUDED_CYFXTX_H_
+#define _INCLUDED_CYFXTX_H_
+
+#include "cyu3types.h"
+#include "cyu3externcstart.h"
+
+/* Usage statistics for the driver heap or the buffer heap. All sizes are in bytes, and include the
+   allocator overheads for each block. */
+typedef struct CyU3PHeapStats_t
+{
+    uint32_t heapSize;                  /* Total size of the heap. */
+    uint32_t curBytes;                  /* Space currently allocated. */
+    uint32_t peakBytes;                 /* Highest value reached by curBytes since the heap was initialized. */
+    uint32_t freeBytes;                 /* Space currently available for allocation. */
+    uint32_t largestFree;               /* Size of the largest block that can currently be allocated. */
+    uint32_t fragPermille;              /* Fragmentation index: 1000 * (1 - largestFree / freeBytes). */
+    uint32_t failCnt;                   /* Number of allocation requests that could not be satisfied. */
+} CyU3PHeapStats_t;
+
+/* Get the usage statistics for the driver heap used by CyU3PMemAlloc. */
+extern CyU3PReturnStatus_t
+CyU3PMemGetStats (
+        CyU3PHeapStats_t *stats_p);
+
+/* Get the usage statistics for the buffer heap used by CyU3PDmaBufferAlloc. */
+extern CyU3PReturnStatus_t
+CyU3PBufGetStats (
+        CyU3PHeapStats_t *stats_p);
+
+/* Allocate memory which is never freed, such as thread stacks, from the boot time arena at the
+   top of the buffer heap. The blocks are cache line aligned and have no allocator overhead. */
+extern void *
+CyU3PMemArenaAlloc (
+        uint32_t size);
+
+/* Block any further boot time arena allocations, and return the final size of the arena in bytes. */
+extern uint32_t
+CyU3PMemArenaSeal (
+        void);
+
+/* Statistics for the incremental heap corruption checks. The scan rate and the time taken by each
+   check can be derived by sampling these values along with the time of day. */
+typedef struct CyU3PHeapScrubStats_t
+{
+    uint32_t slices;                    /* Number of CyU3PMemScrubStep / CyU3PBufScrubStep calls. */
+    uint32_t blocksScanned;             /* Total number of blocks checked. */
+    uint32_t passes;                    /* Number of complete passes through the in-use list. */
+    uint32_t errors;                    /* Number of times corruption was detected. */
+} CyU3PHeapScrubStats_t;
+
+/* Check up to maxBlocks in-use driver heap blocks for corruption, resuming from the previous call.
+   Only available if the memory checks are supported by the SDK version in use. */
+extern CyU3PReturnStatus_t
+CyU3PMemScrubStep (
+        uint32_t maxBlocks);
+
+/* Check up to maxBlocks in-use buffer heap blocks for corruption, resuming from the previous call.
+   Only available if the memory checks are supported by the SDK version in use. */
+extern CyU3PReturnStatus_t
+CyU3PBufScrubStep (
+        uint32_t maxBlocks);
+
+/* Get the statistics for the incremental driver heap checks. */
+extern void
+CyU3PMemGetScrubStats (
+        CyU3PHeapScrubStats_t *stats_p);
+
+/* Get the statistics for the incremental buffer heap checks. */
+extern void
+CyU3PBufGetScrubStats (
+        CyU3PHeapScrubStats_t *stats_p);
+
+/* Get the number of DMA buffer frees deferred from interrupt context, and the number of these
+   that have been completed. */
+extern void
+CyU3PBufGetDeferredCounts (
+        uint32_t *deferredCnt_p,                /* Parameter to be filled with the number of deferred frees. */
+        uint32_t *drainedCnt_p                  /* Parameter to be filled with the number of completed frees. */
+        );
+
+/*
+   Enable this definition (or pass it on the compiler command line) to place per size class slabs
+   in front of the DMA buffer heap. The blocks of the most commonly used sizes are carved out of the
+   buffer heap at init, and are then allocated and freed with interrupts locked out for a few
+   instructions, without searching the buffer heap status array or taking the buffer manager lock.
+   With the leak checks enabled, the lock is still taken to maintain the list of blocks in use.
+ */
+/* #define CYFXTX_BUF_SLAB_ENABLE */
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+
+/* Number of size classes maintained by the DMA buffer slabs: 64, 512, 1024, 16384 and 32768 bytes. */
+#define CY_U3P_BUF_SLAB_NUM_CLASSES     (5)
+
+/* Number of blocks carved at init for each of the 64, 512 and 1024 byte classes. */
+#ifndef CY_U3P_BUF_SLAB_DEPTH
+#define CY_U3P_BUF_SLAB_DEPTH           (8)
+#endif
+
+/* Number of blocks carved at init for each of the 16 KB and 32 KB classes. These take up a large part of
+   the buffer heap, and are only carved if this is set; to the number of buffers in the bulk channels for
+   example. */
+#ifndef CY_U3P_BUF_SLAB_BURST_DEPTH
+#define CY_U3P_BUF_SLAB_BURST_DEPTH     (0)
+#endif
+
+/* Occupancy information for one size class of the DMA buffer slabs. */
+typedef struct CyU3PBufSlabStats_t
+{
+    uint32_t blkSize;                   /* Size of the blocks in this class in bytes. */
+    uint32_t carved;                    /* Number of blocks carved for this class, 0 if it has no slab. */
+    uint32_t inUse;                     /* Number of blocks of this size currently allocated. */
+    uint32_t cached;                    /* Number of free blocks currently held in the slab. */
+    uint32_t hits;                      /* Number of allocations served from the slab. */
+    uint32_t misses;                    /* Number of allocations that had to search the buffer heap. */
+} CyU3PBufSlabStats_t;
+
+/* Get the occupancy information for one size class of the DMA buffer slabs. */
+extern CyU3PReturnStatus_t
+CyU3PBufGetSlabStats (
+        uint32_t             classIdx,          /* Size class index: 0 to CY_U3P_BUF_SLAB_NUM_CLASSES - 1. */
+        CyU3PBufSlabStats_t *stats_p            /* Structure to be filled with the class information. */
+        );
+
+/* Return the slabs that have all of their blocks free to the DMA buffer heap. */
+extern void
+CyU3PBufSlabFlush (
+        void);
+
+#endif /* CYFXTX_BUF_SLAB_ENABLE */
+
+#include "cyu3externcend.h"
+
+#endif /* _INCLUDED_CYFXTX_H_ */
+
+/*[]*/
+
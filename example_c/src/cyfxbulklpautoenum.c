@@ -33,7 +33,10 @@
    CPU is not involved in the data transfer.
 
    The DMA buffer size is defined based on the USB speed. 64 for full speed, 512 for high speed and 1024
-   for super speed. CY_FX_BULKLP_DMA_BUF_COUNT in the header file defines the number of DMA buffers.
+   for super speed, multiplied by CY_FX_EP_BURST_LENGTH and CY_FX_DMA_SIZE_MULTIPLIER so that each
+   buffer holds several bursts. CY_FX_BULKLP_DMA_BUF_COUNT in the header file defines the number of
+   DMA buffers. A buffer is only sent back once it is full or ends with a short packet, so a single full
+   sized packet is not echoed on its own unless the buffer holds one packet (see the header file).
  */
 
 #include "cyu3system.h"
@@ -44,6 +47,7 @@
 #include "cyu3usb.h"
 #include "cyu3uart.h"
 #include "cyu3utils.h"
+#include "cyfxtx.h"
 
 CyU3PThread     BulkLpAppThread;	/* Bulk loop application thread structure */
 CyU3PDmaChannel glChHandleBulkLp;       /* DMA Channel handle */
@@ -166,7 +170,8 @@ CyFxBulkLpApplnStart (
     CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
     epCfg.enable   = CyTrue;
     epCfg.epType   = CY_U3P_USB_EP_BULK;
-    epCfg.burstLen = 1;
+    epCfg.burstLen = (usbSpeed == CY_U3P_SUPER_SPEED) ?
+        (CY_FX_EP_BURST_LENGTH) : 1;
     epCfg.streams  = 0;
     epCfg.pcktSize = size;
 
@@ -187,8 +192,9 @@ CyFxBulkLpApplnStart (
     }
 
     /* Create a DMA Auto Channel between two sockets of the U port.
-     * DMA size is set based on the USB speed. */
-    dmaCfg.size           = size;
+     * DMA size is set based on the USB speed, and holds CY_FX_DMA_SIZE_MULTIPLIER
+     * bursts so that the channel does not stall the endpoint between bursts. */
+    dmaCfg.size           = (size * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER);
     dmaCfg.count          = CY_FX_BULKLP_DMA_BUF_COUNT;
     dmaCfg.prodSckId      = CY_FX_EP_PRODUCER_SOCKET;
     dmaCfg.consSckId      = CY_FX_EP_CONSUMER_SOCKET;
@@ -825,6 +831,9 @@ BulkLpAppThread_Entry (
 
     /* Initialize the bulk loop application */
     CyFxBulkLpApplnInit();
+
+    /* All permanent allocations have been made. Return the unused arena space to the buffer heap. */
+    CyU3PDebugPrint (4, "Boot arena size = %d bytes\r\n", CyU3PMemArenaSeal ());
     // 中文
     for (;;)
     {
@@ -851,8 +860,10 @@ CyFxApplicationDefine (
     void *ptr = NULL;
     uint32_t retThrdCreate = CY_U3P_SUCCESS;
 
-    /* Allocate the memory for the threads */
-    ptr = CyU3PMemAlloc (CY_FX_BULKLP_THREAD_STACK);
+    /* Allocate the memory for the threads. The stack is never freed, so take it from the boot time arena. */
+    ptr = CyU3PMemArenaAlloc (CY_FX_BULKLP_THREAD_STACK);
+    if (ptr == NULL)
+        ptr = CyU3PMemAlloc (CY_FX_BULKLP_THREAD_STACK);
 
     /* Create the thread for the application */
     retThrdCreate = CyU3PThreadCreate (&BulkLpAppThread,           /* Bulk loop App Thread structure */
@@ -40,6 +40,8 @@
 # - Project with enabled C++:
 #   - cyfxtx.cpp            - can be overriden via FX3_CORE_CXX_SRC variable
 #   - cyfxcppsyscall.cpp    - can be overriden via FX3_CORE_CXX_SRC variable
+#   - cyfxcppnew.cpp        - operator new/delete on top of CyU3PMemAlloc, can be overriden via
+#                             FX3_CORE_CXX_SRC variable (drop it to use the libstdc++/newlib versions)
 #
 # All files above can be found at the SDK installation directory: FX3_INSTALL_PATH/firmware/common and
 # should be distributed with your project.
@@ -223,6 +225,7 @@ if ("${FX3_CORE_CXX_SRC}" STREQUAL "")
     set(FX3_CORE_CXX_SRC
         ${CMAKE_SOURCE_DIR}/cyfxtx.cpp
         ${CMAKE_SOURCE_DIR}/cyfxcppsyscall.cpp
+        ${CMAKE_SOURCE_DIR}/cyfxcppnew.cpp
     )
 endif()
 
@@ -37,6 +37,7 @@
 #include <cyu3utils.h>
 #include <cyu3error.h>
 #include <cyfxversion.h>
+#include "cyfxtx.h"
 
 /* Memory error detection is supported in SDK 1.3.3 and later. */
 #if ((CYFX_VERSION_MINOR > 3) || ((CYFX_VERSION_MINOR == 3) && (CYFX_VERSION_PATCH >= 3)))
@@ -88,6 +89,11 @@
 #define CY_U3P_BUFFER_ALLOC_TIMEOUT     (10)
 #define CY_U3P_MEM_ALLOC_TIMEOUT        (10)
 
+/* Byte pool blocks walked with interrupts locked out when measuring the free space, and the number of
+   attempts made at the walk before giving up. */
+#define CY_U3P_MEM_WALK_CHUNK           (16)
+#define CY_U3P_MEM_WALK_RETRIES         (4)
+
 #define CY_U3P_MEM_START_SIG            (0x4658334D)
 #define CY_U3P_MEM_END_SIG              (0x454E444D)
 
@@ -98,10 +104,84 @@
 /* Cache line size for FX3. */
 #define FX3_CACHE_LINE_SZ               (32)
 
+/* 32 bit type used by the memory primitives to access buffers of any type one word at a time. */
+typedef uint32_t __attribute__ ((__may_alias__)) CyU3PMemWord_t;
+
 static CyBool_t         glMemPoolInit   = CyFalse;              /* Whether the memory allocator has been initialized. */
+#ifndef CYFXTX_MEM_USE_TLSF
 static CyU3PBytePool    glMemBytePool;                          /* ThreadX Byte pool used in the CyU3PMem* functions. */
+static volatile uint32_t glMemPoolGen = 0;                      /* Changed before and after each byte pool operation. */
+#endif
 static CyU3PDmaBufMgr_t glBufferManager = {{0}, 0, 0, 0, 0, 0}; /* Buffer manager used in the buffer alloc functions. */
 
+/*
+   List of DMA buffers whose free had to be deferred because the buffer manager lock could not be
+   obtained. The list is linked through the first word of each buffer, and is drained by the next
+   CyU3PDmaBufferAlloc or CyU3PDmaBufferFree call made from thread context.
+ */
+static volatile uint32_t glBufDeferredList  = 0;                /* Head of the deferred free list. */
+static volatile uint32_t glBufDeferredCnt   = 0;                /* Number of frees that were deferred. */
+static uint32_t          glBufDrainedCnt    = 0;                /* Number of deferred frees completed. */
+
+/*
+   Usage statistics for the driver and buffer heaps. The byte counts include the allocator overheads,
+   so that the peak values can be compared directly with the heap sizes.
+ */
+static uint32_t          glMemCurBytes      = 0;                /* Driver heap bytes currently allocated. */
+static uint32_t          glMemPeakBytes     = 0;                /* Highest value reached by glMemCurBytes. */
+static uint32_t          glMemFailCnt       = 0;                /* Number of failed driver heap allocations. */
+static uint32_t          glBufCurBytes      = 0;                /* Buffer heap bytes currently allocated. */
+static uint32_t          glBufPeakBytes     = 0;                /* Highest value reached by glBufCurBytes. */
+static uint32_t          glBufFailCnt       = 0;                /* Number of failed buffer heap allocations. */
+
+/*
+   Boot time arena for memory that is allocated once and never freed, such as thread stacks. The
+   arena grows down from the top of the buffer heap, and takes cache lines from the buffer heap in
+   chunks of CY_U3P_MEM_ARENA_CHUNK bytes. Blocks carry no header, and are cache line aligned so
+   that they can be used for DMA as well.
+ */
+#define CY_U3P_MEM_ARENA_CHUNK          (0x400)
+
+static uint32_t          glMemArenaPtr      = 0;                /* Start of the last block allocated from the arena. */
+static uint32_t          glMemArenaLimit    = 0;                /* Start of the buffer heap space held by the arena. */
+static CyBool_t          glMemArenaSealed   = CyFalse;          /* Whether the arena has been sealed. */
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+
+/*
+   Slab of DMA buffers for one size class. The blocks are carved out of the buffer heap at init as a
+   single region, which stays marked as occupied in the buffer heap status array. The free blocks are
+   kept on a list linked through their first word. The list and the counters are only accessed with
+   interrupts locked out, so that blocks can be taken and returned without the buffer manager lock.
+ */
+typedef struct CyU3PBufSlabClass_t
+{
+    uint32_t numLines;                          /* Number of cache lines spanned by each block. */
+    uint32_t regionStart;                       /* Start address of the region carved for the class. */
+    uint32_t regionEnd;                         /* End address of the region, or 0 if none was carved. */
+    uint32_t freeList;                          /* Address of the first free block, or 0 if there is none. */
+    uint32_t count;                             /* Number of free blocks in the slab. */
+    uint32_t carved;                            /* Number of blocks carved for the class. */
+    uint32_t inUse;                             /* Number of blocks of this class currently allocated. */
+    uint32_t hits;                              /* Number of allocations served from the slab. */
+    uint32_t misses;                            /* Number of allocations that required a heap search. */
+} CyU3PBufSlabClass_t;
+
+/* Block sizes handled by the slabs: EP0 and full speed packets, high speed and super speed packets,
+   and the burst multiplied buffers used by the bulk transfer channels. */
+static const uint32_t      glBufSlabClassSize[CY_U3P_BUF_SLAB_NUM_CLASSES] = {64, 512, 1024, 16384, 32768};
+static const uint32_t      glBufSlabClassDepth[CY_U3P_BUF_SLAB_NUM_CLASSES] = {
+    CY_U3P_BUF_SLAB_DEPTH, CY_U3P_BUF_SLAB_DEPTH, CY_U3P_BUF_SLAB_DEPTH,
+    CY_U3P_BUF_SLAB_BURST_DEPTH, CY_U3P_BUF_SLAB_BURST_DEPTH
+};
+static CyU3PBufSlabClass_t glBufSlab[CY_U3P_BUF_SLAB_NUM_CLASSES];
+
+static void
+CyU3PDmaBufSlabInit (
+        void);
+
+#endif
+
 #ifdef CYFXTX_ERRORDETECTION
 
 /*
@@ -124,6 +204,15 @@ static uint32_t         glBufFreeCnt         = 0;               /* Number of fre
 static MemBlockInfo    *glBufInUseList       = 0;               /* List of all memory blocks in use. */
 static CyU3PMemCorruptCallback glBufBadCb    = 0;               /* Callback for notification of corrupted memory. */
 
+/*
+   State of the incremental corruption checks done using CyU3PMemScrubStep and CyU3PBufScrubStep. The
+   cursor points to the next in-use block to be checked, and is moved on if that block is freed.
+ */
+static MemBlockInfo          *glMemScrubCursor = 0;             /* Next driver heap block to be checked. */
+static CyU3PHeapScrubStats_t  glMemScrubStats;                  /* Driver heap scrub statistics. */
+static MemBlockInfo          *glBufScrubCursor = 0;             /* Next buffer heap block to be checked. */
+static CyU3PHeapScrubStats_t  glBufScrubStats;                  /* Buffer heap scrub statistics. */
+
 #endif
 
 /**********************************************************************
@@ -235,13 +324,509 @@ CyU3PMemEnableChecks (
 
 #endif
 
+/* Function    : CyU3PMemIrqLock
+ * Description : Disable the IRQ and FIQ interrupts and return the previous CPSR value.
+ *               The driver heap can be accessed from interrupt context, so the short and
+ *               bounded operations on the heap structures lock out interrupts instead of
+ *               using a mutex.
+ */
+static inline uint32_t
+CyU3PMemIrqLock (
+        void)
+{
+#if defined (__arm__)
+    uint32_t cpsr, tmp;
+
+    __asm__ __volatile__ (
+            "mrs %0, cpsr\n\t"
+            "orr %1, %0, #0xC0\n\t"
+            "msr cpsr_c, %1"
+            : "=r" (cpsr), "=r" (tmp) : : "memory");
+    return cpsr;
+#else
+    /* Host builds of the heap tests have no interrupts to lock out. */
+    return 0;
+#endif
+}
+
+/* Function    : CyU3PMemIrqUnlock
+ * Description : Restore the interrupt state saved by CyU3PMemIrqLock.
+ */
+static inline void
+CyU3PMemIrqUnlock (
+        uint32_t cpsr)
+{
+#if defined (__arm__)
+    __asm__ __volatile__ ("msr cpsr_c, %0" : : "r" (cpsr) : "memory");
+#else
+    (void) cpsr;
+#endif
+}
+
+#ifdef CYFXTX_MEM_USE_TLSF
+
+/*
+   Two level segregated fit (TLSF) allocator which can be used for the driver heap instead of the
+   ThreadX byte pool. Free blocks are kept in lists indexed by a first level (power of two) and a
+   second level (linear sub-division of the power of two range) size class. Bitmaps of the non-empty
+   lists allow both alloc and free to complete in constant time irrespective of the heap state.
+
+   Each block has an 8 byte header holding a pointer to the physically preceding block and the size
+   of the block payload. Free blocks also store the free list links in the first 8 bytes of the payload.
+   The header and link sizes are given in pointers, so that the heap tests can also be run on a 64 bit
+   host.
+   The heap is terminated with a zero sized block that is never freed.
+ */
+#define CY_U3P_TLSF_ALIGN               (8)                             /* Block size granularity. */
+#define CY_U3P_TLSF_HDR_SIZE            (2 * sizeof (void *))           /* Size of the block header. */
+#define CY_U3P_TLSF_MIN_SIZE            (2 * sizeof (void *))           /* Minimum block payload size. */
+#define CY_U3P_TLSF_SL_LOG2             (4)                             /* Log2 of the second level list count. */
+#define CY_U3P_TLSF_SL_COUNT            (1 << CY_U3P_TLSF_SL_LOG2)      /* Number of second level lists. */
+#define CY_U3P_TLSF_FL_SHIFT            (CY_U3P_TLSF_SL_LOG2 + 3)       /* Sizes below 128 bytes map to first level 0. */
+#define CY_U3P_TLSF_SMALL_SIZE          (1 << CY_U3P_TLSF_FL_SHIFT)
+#define CY_U3P_TLSF_FL_COUNT            (10)                            /* Number of first level lists. */
+#define CY_U3P_TLSF_BLOCK_FREE          (0x00000001U)                   /* Size field flag marking a free block. */
+#define CY_U3P_TLSF_SIZE_MASK           (0xFFFFFFF8U)                   /* Size field mask for the payload size. */
+
+#if (CY_U3P_MEM_HEAP_SIZE >= 0x10000)
+#error "CY_U3P_TLSF_FL_COUNT needs to be increased for driver heaps of 64 KB or more."
+#endif
+
+typedef struct CyU3PTlsfBlock_t
+{
+    struct CyU3PTlsfBlock_t *prevPhys;          /* Block which physically precedes this one. */
+    uint32_t                 size;              /* Payload size in bytes, and the free flag. */
+    struct CyU3PTlsfBlock_t *nextFree;          /* Next block in the free list. Only valid for free blocks. */
+    struct CyU3PTlsfBlock_t *prevFree;          /* Previous block in the free list. Only valid for free blocks. */
+} CyU3PTlsfBlock_t;
+
+static uint32_t          glTlsfFlBitmap = 0;                                            /* Non-empty first level classes. */
+static uint32_t          glTlsfSlBitmap[CY_U3P_TLSF_FL_COUNT];                          /* Non-empty second level lists. */
+static CyU3PTlsfBlock_t *glTlsfFreeList[CY_U3P_TLSF_FL_COUNT][CY_U3P_TLSF_SL_COUNT];    /* Free list heads. */
+static uint32_t          glTlsfFreeBytes = 0;                                           /* Total payload size of the free blocks. */
+
+/* Function    : CyU3PTlsfFls
+ * Description : Returns the position of the most significant set bit in a non-zero word.
+ */
+static inline uint32_t
+CyU3PTlsfFls (
+        uint32_t value)
+{
+    return (31 - __builtin_clz (value));
+}
+
+/* Function    : CyU3PTlsfFfs
+ * Description : Returns the position of the least significant set bit in a non-zero word.
+ */
+static inline uint32_t
+CyU3PTlsfFfs (
+        uint32_t value)
+{
+    return CyU3PTlsfFls (value & (0 - value));
+}
+
+/* Function    : CyU3PTlsfMapping
+ * Description : Compute the first and second level list indices for a block size.
+ */
+static void
+CyU3PTlsfMapping (
+        uint32_t  size,
+        uint32_t *fl_p,
+        uint32_t *sl_p)
+{
+    uint32_t msb;
+
+    if (size < CY_U3P_TLSF_SMALL_SIZE)
+    {
+        *fl_p = 0;
+        *sl_p = size / CY_U3P_TLSF_ALIGN;
+    }
+    else
+    {
+        msb   = CyU3PTlsfFls (size);
+        *sl_p = (size >> (msb - CY_U3P_TLSF_SL_LOG2)) ^ CY_U3P_TLSF_SL_COUNT;
+        *fl_p = msb - CY_U3P_TLSF_FL_SHIFT + 1;
+    }
+}
+
+/* Function    : CyU3PTlsfNextPhys
+ * Description : Returns the block which physically follows the given block.
+ */
+static inline CyU3PTlsfBlock_t *
+CyU3PTlsfNextPhys (
+        CyU3PTlsfBlock_t *block_p)
+{
+    return (CyU3PTlsfBlock_t *)((uint8_t *)block_p + CY_U3P_TLSF_HDR_SIZE + (block_p->size & CY_U3P_TLSF_SIZE_MASK));
+}
+
+/* Function    : CyU3PTlsfInsert
+ * Description : Mark a block as free and add it to the head of its free list.
+ */
+static void
+CyU3PTlsfInsert (
+        CyU3PTlsfBlock_t *block_p)
+{
+    uint32_t fl, sl;
+
+    CyU3PTlsfMapping (block_p->size & CY_U3P_TLSF_SIZE_MASK, &fl, &sl);
+
+    block_p->size     |= CY_U3P_TLSF_BLOCK_FREE;
+    block_p->prevFree  = 0;
+    block_p->nextFree  = glTlsfFreeList[fl][sl];
+    if (block_p->nextFree != 0)
+        block_p->nextFree->prevFree = block_p;
+
+    glTlsfFreeList[fl][sl] = block_p;
+    glTlsfFlBitmap        |= (1 << fl);
+    glTlsfSlBitmap[fl]    |= (1 << sl);
+    glTlsfFreeBytes       += (block_p->size & CY_U3P_TLSF_SIZE_MASK);
+}
+
+/* Function    : CyU3PTlsfRemove
+ * Description : Remove a block from its free list and mark it as in use.
+ */
+static void
+CyU3PTlsfRemove (
+        CyU3PTlsfBlock_t *block_p)
+{
+    uint32_t fl, sl;
+
+    CyU3PTlsfMapping (block_p->size & CY_U3P_TLSF_SIZE_MASK, &fl, &sl);
+
+    if (block_p->nextFree != 0)
+        block_p->nextFree->prevFree = block_p->prevFree;
+
+    if (block_p->prevFree != 0)
+    {
+        block_p->prevFree->nextFree = block_p->nextFree;
+    }
+    else
+    {
+        /* This block was the list head. Update the bitmaps if the list is now empty. */
+        glTlsfFreeList[fl][sl] = block_p->nextFree;
+        if (block_p->nextFree == 0)
+        {
+            glTlsfSlBitmap[fl] &= ~(1 << sl);
+            if (glTlsfSlBitmap[fl] == 0)
+                glTlsfFlBitmap &= ~(1 << fl);
+        }
+    }
+
+    block_p->size   &= CY_U3P_TLSF_SIZE_MASK;
+    glTlsfFreeBytes -= block_p->size;
+}
+
+/* Function    : CyU3PTlsfInit
+ * Description : Initialize the driver heap as a single free block followed by the
+ *               zero sized terminating block.
+ */
+static void
+CyU3PTlsfInit (
+        void)
+{
+    CyU3PTlsfBlock_t *block_p = (CyU3PTlsfBlock_t *)CY_U3P_MEM_HEAP_BASE;
+    CyU3PTlsfBlock_t *last_p;
+
+    CyU3PMemSet ((uint8_t *)glTlsfSlBitmap, 0, sizeof (glTlsfSlBitmap));
+    CyU3PMemSet ((uint8_t *)glTlsfFreeList, 0, sizeof (glTlsfFreeList));
+    glTlsfFlBitmap  = 0;
+    glTlsfFreeBytes = 0;
+
+    block_p->prevPhys = 0;
+    block_p->size     = CY_U3P_MEM_HEAP_SIZE - 2 * CY_U3P_TLSF_HDR_SIZE;
+
+    last_p = CyU3PTlsfNextPhys (block_p);
+    last_p->prevPhys = block_p;
+    last_p->size     = 0;
+
+    CyU3PTlsfInsert (block_p);
+}
+
+/* Function    : CyU3PTlsfAlloc
+ * Description : Allocate a block from the driver heap in constant time. The request is
+ *               rounded up to the next list boundary, so that any block in the first
+ *               non-empty list found is large enough. The unused part of the block is
+ *               split off and returned to the free lists.
+ * Return Value: Pointer to the block payload, or NULL if no block is available.
+ */
+static void *
+CyU3PTlsfAlloc (
+        uint32_t size)
+{
+    CyU3PTlsfBlock_t *block_p, *rem_p;
+    uint32_t fl, sl, map, search, intMask;
+
+    size = ROUND_UP (size, CY_U3P_TLSF_ALIGN);
+    if (size < CY_U3P_TLSF_MIN_SIZE)
+        size = CY_U3P_TLSF_MIN_SIZE;
+
+    search = size;
+    if (search >= CY_U3P_TLSF_SMALL_SIZE)
+        search += (1 << (CyU3PTlsfFls (search) - CY_U3P_TLSF_SL_LOG2)) - 1;
+
+    CyU3PTlsfMapping (search, &fl, &sl);
+    if (fl >= CY_U3P_TLSF_FL_COUNT)
+        return 0;
+
+    intMask = CyU3PMemIrqLock ();
+
+    /* Look for a non-empty list in the same first level class, then in the larger ones. */
+    map = glTlsfSlBitmap[fl] & (0xFFFFFFFFU << sl);
+    if (map == 0)
+    {
+        map = glTlsfFlBitmap & (0xFFFFFFFFU << (fl + 1));
+        if (map == 0)
+        {
+            CyU3PMemIrqUnlock (intMask);
+            return 0;
+        }
+
+        fl  = CyU3PTlsfFfs (map);
+        map = glTlsfSlBitmap[fl];
+    }
+
+    sl      = CyU3PTlsfFfs (map);
+    block_p = glTlsfFreeList[fl][sl];
+    CyU3PTlsfRemove (block_p);
+
+    /* Return the unused part of the block to the heap if it is large enough to be used. */
+    if (block_p->size >= (size + CY_U3P_TLSF_HDR_SIZE + CY_U3P_TLSF_MIN_SIZE))
+    {
+        rem_p           = (CyU3PTlsfBlock_t *)((uint8_t *)block_p + CY_U3P_TLSF_HDR_SIZE + size);
+        rem_p->prevPhys = block_p;
+        rem_p->size     = block_p->size - size - CY_U3P_TLSF_HDR_SIZE;
+        CyU3PTlsfNextPhys (rem_p)->prevPhys = rem_p;
+        block_p->size   = size;
+        CyU3PTlsfInsert (rem_p);
+    }
+
+    CyU3PMemIrqUnlock (intMask);
+    return (void *)((uint8_t *)block_p + CY_U3P_TLSF_HDR_SIZE);
+}
+
+/* Function    : CyU3PTlsfFree
+ * Description : Return a block to the driver heap in constant time, merging it with
+ *               the physically adjacent blocks if they are free.
+ */
+static void
+CyU3PTlsfFree (
+        void *mem_p)
+{
+    CyU3PTlsfBlock_t *block_p = (CyU3PTlsfBlock_t *)((uint8_t *)mem_p - CY_U3P_TLSF_HDR_SIZE);
+    CyU3PTlsfBlock_t *next_p, *prev_p;
+    uint32_t intMask;
+
+    intMask = CyU3PMemIrqLock ();
+
+    /* Ignore blocks which are already free. */
+    if ((block_p->size & CY_U3P_TLSF_BLOCK_FREE) != 0)
+    {
+        CyU3PMemIrqUnlock (intMask);
+        return;
+    }
+
+    next_p = CyU3PTlsfNextPhys (block_p);
+    if ((next_p->size & CY_U3P_TLSF_BLOCK_FREE) != 0)
+    {
+        CyU3PTlsfRemove (next_p);
+        block_p->size += CY_U3P_TLSF_HDR_SIZE + next_p->size;
+        CyU3PTlsfNextPhys (block_p)->prevPhys = block_p;
+    }
+
+    prev_p = block_p->prevPhys;
+    if ((prev_p != 0) && ((prev_p->size & CY_U3P_TLSF_BLOCK_FREE) != 0))
+    {
+        CyU3PTlsfRemove (prev_p);
+        prev_p->size += CY_U3P_TLSF_HDR_SIZE + block_p->size;
+        CyU3PTlsfNextPhys (prev_p)->prevPhys = prev_p;
+        block_p = prev_p;
+    }
+
+    CyU3PTlsfInsert (block_p);
+    CyU3PMemIrqUnlock (intMask);
+}
+
+#else
+
+/*
+   Layout of the ThreadX byte pool blocks. Each block starts with a pointer to the physically
+   following block, and a word which holds the owning pool for allocated blocks or a marker
+   for free blocks. The last block in the pool links back to the start of the pool.
+ */
+#define CY_U3P_MEM_POOL_BLOCK_HDR       (8)                             /* Size of the block header. */
+#define CY_U3P_MEM_POOL_BLOCK_FREE      (0xFFFFEEEEU)                   /* Marker for free blocks. */
+
+#endif
+
+/* Function    : CyU3PMemBlockSize
+ * Description : Returns the number of driver heap bytes taken up by an allocated block,
+ *               including the allocator header.
+ */
+static inline uint32_t
+CyU3PMemBlockSize (
+        void *mem_p)
+{
+#ifdef CYFXTX_MEM_USE_TLSF
+    CyU3PTlsfBlock_t *block_p = (CyU3PTlsfBlock_t *)((uint8_t *)mem_p - CY_U3P_TLSF_HDR_SIZE);
+
+    return (CY_U3P_TLSF_HDR_SIZE + (block_p->size & CY_U3P_TLSF_SIZE_MASK));
+#else
+    uint32_t block = (uint32_t)mem_p - CY_U3P_MEM_POOL_BLOCK_HDR;
+
+    return (*((uint32_t *)block) - block);
+#endif
+}
+
+#ifndef CYFXTX_MEM_USE_TLSF
+/* Function    : CyU3PMemPoolGenBump
+ * Description : Marks the start or the end of a byte pool operation. The generation count
+ *               is odd while an operation is in progress, and CyU3PMemFreeSpace starts its
+ *               walk again if the count changes under it.
+ */
+static inline void
+CyU3PMemPoolGenBump (
+        void)
+{
+    uint32_t intMask = CyU3PMemIrqLock ();
+
+    glMemPoolGen++;
+    CyU3PMemIrqUnlock (intMask);
+}
+#endif
+
+/* Function    : CyU3PMemFreeSpace
+ * Description : Finds the size of the largest block that can be allocated from the
+ *               driver heap, and the total free space. With the TLSF allocator this
+ *               should be called with interrupts locked.
+ *               The byte pool only merges adjacent free blocks while searching for
+ *               space, so the blocks are walked and the free runs are merged here. The
+ *               walk is done CY_U3P_MEM_WALK_CHUNK blocks at a time with interrupts
+ *               locked, and is started again if the pool is changed in between.
+ * Return Value : CyTrue if the free space was measured, CyFalse if the byte pool kept
+ *               changing during the walk.
+ */
+static CyBool_t
+CyU3PMemFreeSpace (
+        uint32_t *largest_p,
+        uint32_t *freeBytes_p)
+{
+#ifdef CYFXTX_MEM_USE_TLSF
+    CyU3PTlsfBlock_t *block_p;
+    uint32_t fl, sl, largest = 0;
+
+    /* The largest free block is in the highest non-empty list. */
+    if (glTlsfFlBitmap != 0)
+    {
+        fl = CyU3PTlsfFls (glTlsfFlBitmap);
+        sl = CyU3PTlsfFls (glTlsfSlBitmap[fl]);
+        for (block_p = glTlsfFreeList[fl][sl]; block_p != 0; block_p = block_p->nextFree)
+        {
+            if ((block_p->size & CY_U3P_TLSF_SIZE_MASK) > largest)
+                largest = (block_p->size & CY_U3P_TLSF_SIZE_MASK);
+        }
+    }
+
+    *largest_p   = largest;
+    *freeBytes_p = glTlsfFreeBytes;
+    return CyTrue;
+#else
+    uint32_t block, next, run, total, largest;
+    uint32_t gen, count, tries, intMask;
+    CyBool_t done = CyFalse;
+
+    for (tries = 0; (tries < CY_U3P_MEM_WALK_RETRIES) && (!done); tries++)
+    {
+        /* A thread that was pre-empted in the middle of a pool operation has to complete it first. */
+        gen = glMemPoolGen;
+        if ((gen & 1) != 0)
+        {
+            if (CyU3PThreadIdentify ())
+                CyU3PThreadSleep (1);
+            continue;
+        }
+
+        block   = CY_U3P_MEM_HEAP_BASE;
+        run     = 0;
+        total   = 0;
+        largest = 0;
+        count   = 0;
+
+        intMask = CyU3PMemIrqLock ();
+        for (;;)
+        {
+            next = *((uint32_t *)block);
+            if ((((uint32_t *)block)[1] == CY_U3P_MEM_POOL_BLOCK_FREE) && (next > block) &&
+                    (next <= (CY_U3P_MEM_HEAP_BASE + CY_U3P_MEM_HEAP_SIZE)))
+            {
+                run += (next - block);
+            }
+            else
+            {
+                /* A run of free blocks ends here. It can be merged into one block with a single header. */
+                if (run != 0)
+                {
+                    total += run - CY_U3P_MEM_POOL_BLOCK_HDR;
+                    if ((run - CY_U3P_MEM_POOL_BLOCK_HDR) > largest)
+                        largest = run - CY_U3P_MEM_POOL_BLOCK_HDR;
+                    run = 0;
+                }
+
+                /* The last block in the pool links back to the start of the pool. */
+                if ((next <= block) || (next > (CY_U3P_MEM_HEAP_BASE + CY_U3P_MEM_HEAP_SIZE)))
+                {
+                    done = CyTrue;
+                    break;
+                }
+            }
+
+            block = next;
+
+            /* Let interrupts in now and then. The block reached is only valid if the pool is unchanged. */
+            if (++count == CY_U3P_MEM_WALK_CHUNK)
+            {
+                count = 0;
+                CyU3PMemIrqUnlock (intMask);
+                intMask = CyU3PMemIrqLock ();
+                if (glMemPoolGen != gen)
+                    break;
+            }
+        }
+        CyU3PMemIrqUnlock (intMask);
+    }
+
+    if (!done)
+        return CyFalse;
+
+    *largest_p   = largest;
+    *freeBytes_p = total;
+    return CyTrue;
+#endif
+}
+
+/* Function    : CyU3PHeapFragIndex
+ * Description : Computes the fragmentation index of a heap in parts per thousand. This is
+ *               zero when all of the free space is contiguous, and approaches 1000 as the
+ *               free space is split into many small blocks.
+ */
+static inline uint32_t
+CyU3PHeapFragIndex (
+        uint32_t largestFree,
+        uint32_t freeBytes)
+{
+    if (freeBytes == 0)
+        return 0;
+
+    return (1000 - ((largestFree * 1000) / freeBytes));
+}
+
 /* Function    : CyU3PMemInit
  * Description : This function initializes the custom heap for OS specific dynamic
  *               memory allocation.
  *               The function should not be explicitly invoked, and is called from the 
  *               API library. The minimum required size for the heap is 20 KB.
  *               The default implementation makes use of the Byte Pool services provided
- *               by ThreadX.
+ *               by ThreadX. A TLSF allocator is used instead if CYFXTX_MEM_USE_TLSF is
+ *               defined.
  * Parameters  : None
  */
 void
@@ -252,7 +837,11 @@ CyU3PMemInit (
     if (!glMemPoolInit)
     {
 	glMemPoolInit = CyTrue;
+#ifdef CYFXTX_MEM_USE_TLSF
+        CyU3PTlsfInit ();
+#else
 	CyU3PBytePoolCreate (&glMemBytePool, (void *)CY_U3P_MEM_HEAP_BASE, CY_U3P_MEM_HEAP_SIZE);
+#endif
     }
 }
 
@@ -260,7 +849,8 @@ CyU3PMemInit (
  * Description  : This function allocates memory required for various OS objects in the
  *                firmware application. This function is used by the SDK internal drivers
  *                in addition to the application code itself.
- *                The default implementation makes use of the ThreadX byte pool services.
+ *                The default implementation makes use of the ThreadX byte pool services;
+ *                or the TLSF allocator if CYFXTX_MEM_USE_TLSF is defined.
  *                If memory leak and corruption checking is enabled, the implementation
  *                adds a 20 byte header and a 4 byte footer around the memory block.
  * Parameters   :
@@ -273,6 +863,8 @@ CyU3PMemAlloc (
 {
     void         *ret_p;
     uint32_t      status;
+    uint32_t      blkSize;
+    uint32_t      intMask;
 
 #ifdef CYFXTX_ERRORDETECTION
     MemBlockInfo *block_p;
@@ -287,6 +879,12 @@ CyU3PMemAlloc (
         size += sizeof (MemBlockInfo) + sizeof (uint32_t);
 #endif
 
+#ifdef CYFXTX_MEM_USE_TLSF
+    ret_p  = CyU3PTlsfAlloc (size);
+    status = (ret_p != 0) ? CY_U3P_SUCCESS : CY_U3P_ERROR_MEMORY_ERROR;
+#else
+    CyU3PMemPoolGenBump ();
+
     /* Cannot wait in interrupt context */
     if (CyU3PThreadIdentify ())
     {
@@ -297,8 +895,19 @@ CyU3PMemAlloc (
         status = CyU3PByteAlloc (&glMemBytePool, (void **)&ret_p, size, CYU3P_NO_WAIT);
     }
 
+    CyU3PMemPoolGenBump ();
+#endif
+
     if (status == CY_U3P_SUCCESS)
     {
+        /* Update the usage statistics. */
+        blkSize = CyU3PMemBlockSize (ret_p);
+        intMask = CyU3PMemIrqLock ();
+        glMemCurBytes += blkSize;
+        if (glMemCurBytes > glMemPeakBytes)
+            glMemPeakBytes = glMemCurBytes;
+        CyU3PMemIrqUnlock (intMask);
+
 #ifdef CYFXTX_ERRORDETECTION
         if (glMemEnableChecks)
         {
@@ -306,15 +915,20 @@ CyU3PMemAlloc (
             block_p = (MemBlockInfo *)ret_p;
             block_p->alloc_id        = glMemAllocCnt++;
             block_p->alloc_size      = size;
-            block_p->prev_blk        = glMemInUseList;
             block_p->next_blk        = 0;
             block_p->start_sig       = CY_U3P_MEM_START_SIG;
+
+            /* Add the end block signature as a footer. This has to be in place before the block is linked,
+               as the block can be checked by CyU3PMemScrubStep as soon as it is in the list. */
+            ((uint32_t *)block_p)[BYTE_TO_DWORD (size) - 1] = CY_U3P_MEM_END_SIG;
+
+            /* The list update is protected against a concurrent CyU3PMemScrubStep call. */
+            intMask = CyU3PMemIrqLock ();
+            block_p->prev_blk        = glMemInUseList;
             if (glMemInUseList != 0)
                 glMemInUseList->next_blk = block_p;
             glMemInUseList           = block_p;
-
-            /* Add the end block signature as a footer. */
-            ((uint32_t *)block_p)[BYTE_TO_DWORD (size) - 1] = CY_U3P_MEM_END_SIG;
+            CyU3PMemIrqUnlock (intMask);
 
             /* Update the return pointer to skip the header created. */
             ret_p = (void *)((uint8_t *)block_p + sizeof (MemBlockInfo));
@@ -324,6 +938,7 @@ CyU3PMemAlloc (
         return ret_p;
     }
 
+    glMemFailCnt++;
     return (NULL);
 }
 
@@ -336,6 +951,9 @@ void
 CyU3PMemFree (
         void *mem_p)
 {
+    uint32_t      blkSize;
+    uint32_t      intMask;
+
 #ifdef CYFXTX_ERRORDETECTION
     MemBlockInfo *block_p;
     uint32_t     *endsig_p;
@@ -363,6 +981,7 @@ CyU3PMemFree (
         glMemFreeCnt++;
 
         /* Update the in-use linked list to drop the freed-up block. */
+        intMask = CyU3PMemIrqLock ();
         if (block_p->next_blk != 0)
             block_p->next_blk->prev_blk = block_p->prev_blk;
         if (block_p->prev_blk != 0)
@@ -372,11 +991,84 @@ CyU3PMemFree (
             glMemInUseList = block_p->prev_blk;
         }
 
+        /* Move the scrubber on if it was due to check this block. */
+        if (glMemScrubCursor == block_p)
+        {
+            glMemScrubCursor = block_p->prev_blk;
+        }
+        CyU3PMemIrqUnlock (intMask);
+
         mem_p = (void *)block_p;
     }
 #endif
 
+    blkSize = CyU3PMemBlockSize (mem_p);
+
+#ifdef CYFXTX_MEM_USE_TLSF
+    CyU3PTlsfFree (mem_p);
+#else
+    CyU3PMemPoolGenBump ();
     CyU3PByteFree (mem_p);
+    CyU3PMemPoolGenBump ();
+#endif
+
+    intMask = CyU3PMemIrqLock ();
+    glMemCurBytes -= blkSize;
+    CyU3PMemIrqUnlock (intMask);
+}
+
+/* Function     : CyU3PMemGetStats
+ * Description  : Get the usage statistics for the driver heap. The current and peak usage
+ *                are updated on every alloc and free call, while the free space is
+ *                measured when this function is called. With the TLSF allocator this
+ *                only looks at the free lists, and interrupts are locked out while it is
+ *                done. With the ThreadX byte pool it involves a walk through all blocks,
+ *                which lets interrupts in every CY_U3P_MEM_WALK_CHUNK blocks, and is
+ *                started again if the pool is changed by another thread or an interrupt
+ *                in the meantime.
+ * Parameters   :
+ *                stats_p : Structure to be filled with the statistics.
+ * Return Value : CY_U3P_SUCCESS if the statistics were returned.
+ *                CY_U3P_ERROR_BAD_ARGUMENT if the pointer is invalid.
+ *                CY_U3P_ERROR_NOT_STARTED if the driver heap has not been initialized.
+ *                CY_U3P_ERROR_TIMEOUT if the byte pool kept changing during the walk.
+ */
+CyU3PReturnStatus_t
+CyU3PMemGetStats (
+        CyU3PHeapStats_t *stats_p)
+{
+    uint32_t intMask;
+
+    if (stats_p == 0)
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    if (!glMemPoolInit)
+    {
+        return CY_U3P_ERROR_NOT_STARTED;
+    }
+
+#ifdef CYFXTX_MEM_USE_TLSF
+    intMask = CyU3PMemIrqLock ();
+    CyU3PMemFreeSpace (&stats_p->largestFree, &stats_p->freeBytes);
+#else
+    if (!CyU3PMemFreeSpace (&stats_p->largestFree, &stats_p->freeBytes))
+    {
+        return CY_U3P_ERROR_TIMEOUT;
+    }
+
+    intMask = CyU3PMemIrqLock ();
+#endif
+    stats_p->curBytes    = glMemCurBytes;
+    stats_p->peakBytes   = glMemPeakBytes;
+    stats_p->failCnt     = glMemFailCnt;
+    CyU3PMemIrqUnlock (intMask);
+
+    stats_p->heapSize     = CY_U3P_MEM_HEAP_SIZE;
+    stats_p->fragPermille = CyU3PHeapFragIndex (stats_p->largestFree, stats_p->freeBytes);
+
+    return CY_U3P_SUCCESS;
 }
 
 #ifdef CYFXTX_ERRORDETECTION
@@ -460,42 +1152,170 @@ CyU3PMemCorruptionCheck (
     return CY_U3P_SUCCESS;
 }
 
-#endif
-
-/* Function     : CyU3PMemSet
- * Description  : memset equivalent function to initialize a memory block.
- *                This function assumes that the memory block may not be DWORD
- *                aligned; and performs a byte-by-byte memset.
- *                No checks are performed on the parameters because even a NULL-pointer
- *                is valid on the FX3 device.
- * Parameters   :
- *                ptr   : Pointer to memory block to be initialized.
- *                data  : Value that should be set at each byte.
- *                count : Size of memory block.
- * Return Value : None
+/* Function    : CyU3PHeapScrubSlice
+ * Description : Helper function for the incremental corruption checks. Checks up to
+ *               maxBlocks blocks of an in-use list, starting from the saved cursor or
+ *               from the list head if the cursor is NULL; and saves the position
+ *               reached. Should be called with the lock protecting the list held.
+ * Return Value: CY_U3P_SUCCESS or CY_U3P_ERROR_FAILURE depending on whether
+ *               corruption is found or not.
  */
-void
+static CyU3PReturnStatus_t
+CyU3PHeapScrubSlice (
+        MemBlockInfo          **cursor_p,
+        MemBlockInfo           *head_p,
+        uint32_t                maxBlocks,
+        uint32_t                heapBase,
+        uint32_t                heapTop,
+        CyU3PMemCorruptCallback badCb,
+        CyU3PHeapScrubStats_t  *stats_p)
+{
+    MemBlockInfo *block_p = *cursor_p;
+    uint32_t     *mem_p;
+
+    if (block_p == 0)
+    {
+        block_p = head_p;
+    }
+
+    stats_p->slices++;
+    while ((block_p != 0) && (maxBlocks != 0))
+    {
+        if (((uint32_t)block_p < heapBase) || ((uint32_t)block_p >= heapTop) ||
+                (block_p->alloc_size > (heapTop - (uint32_t)block_p)))
+        {
+            *cursor_p = 0;
+            stats_p->errors++;
+            return CY_U3P_ERROR_FAILURE;
+        }
+
+        mem_p = (uint32_t *)((uint8_t *)block_p + block_p->alloc_size - sizeof (uint32_t));
+        if ((block_p->start_sig != CY_U3P_MEM_START_SIG) || (*mem_p != CY_U3P_MEM_END_SIG))
+        {
+            if (badCb != 0)
+                badCb ((void *)((uint8_t *)block_p + sizeof (MemBlockInfo)));
+
+            /* Once we find any corruption, we cannot rely on the list pointers any more.
+               Start over from the list head on the next call. */
+            *cursor_p = 0;
+            stats_p->errors++;
+            return CY_U3P_ERROR_FAILURE;
+        }
+
+        stats_p->blocksScanned++;
+        maxBlocks--;
+
+        block_p = block_p->prev_blk;
+        if (block_p == 0)
+        {
+            stats_p->passes++;
+        }
+    }
+
+    *cursor_p = block_p;
+    return CY_U3P_SUCCESS;
+}
+
+/* Function     : CyU3PMemScrubStep
+ * Description  : Incremental version of CyU3PMemCorruptionCheck. Checks up to maxBlocks
+ *                in-use blocks of the driver heap, resuming from where the previous call
+ *                stopped. Interrupts are locked out while the blocks are checked, so the
+ *                time taken by each call is bounded by maxBlocks. This can be called
+ *                periodically from a low priority thread to keep checking the heap in
+ *                the field.
+ * Parameters   :
+ *                maxBlocks : Maximum number of blocks to check in this call.
+ * Return Value : CY_U3P_SUCCESS or CY_U3P_ERROR_FAILURE depending on whether
+ *                corruption is found or not.
+ */
+CyU3PReturnStatus_t
+CyU3PMemScrubStep (
+        uint32_t maxBlocks)
+{
+    CyU3PReturnStatus_t status;
+    uint32_t            intMask;
+
+    intMask = CyU3PMemIrqLock ();
+    status  = CyU3PHeapScrubSlice (&glMemScrubCursor, glMemInUseList, maxBlocks, CY_U3P_MEM_HEAP_BASE,
+            CY_U3P_BUFFER_HEAP_BASE, glMemBadCb, &glMemScrubStats);
+    CyU3PMemIrqUnlock (intMask);
+
+    return status;
+}
+
+/* Function     : CyU3PMemGetScrubStats
+ * Description  : Get the statistics for the incremental driver heap checks.
+ * Parameters   :
+ *                stats_p : Structure to be filled with the statistics.
+ * Return Value : None
+ */
+void
+CyU3PMemGetScrubStats (
+        CyU3PHeapScrubStats_t *stats_p)
+{
+    if (stats_p != 0)
+        *stats_p = glMemScrubStats;
+}
+
+#endif
+
+/* Function     : CyU3PMemSet
+ * Description  : memset equivalent function to initialize a memory block.
+ *                The memory block may not be DWORD aligned. Any unaligned bytes at the
+ *                start and end of the block are set one at a time, and the rest of the
+ *                block is set a word at a time with 32 bytes per loop iteration.
+ *                No checks are performed on the parameters because even a NULL-pointer
+ *                is valid on the FX3 device.
+ * Parameters   :
+ *                ptr   : Pointer to memory block to be initialized.
+ *                data  : Value that should be set at each byte.
+ *                count : Size of memory block.
+ * Return Value : None
+ */
+void
 CyU3PMemSet (
         uint8_t *ptr,
         uint8_t  data,
         uint32_t count)
 {
-    /* Loop unrolling for faster operation */
-    while (count >> 3)
+    CyU3PMemWord_t *wptr;
+    uint32_t        word;
+
+    /* Set bytes until the pointer is DWORD aligned. */
+    while ((count != 0) && (((uint32_t)ptr & 3) != 0))
+    {
+        *ptr = data;
+        ptr++;
+        count--;
+    }
+
+    word = (uint32_t)data * 0x01010101U;
+    wptr = (CyU3PMemWord_t *)ptr;
+
+    /* Loop unrolling for faster operation. This allows the compiler to use multiple register stores. */
+    while (count >= 32)
     {
-        ptr[0] = data;
-        ptr[1] = data;
-        ptr[2] = data;
-        ptr[3] = data;
-        ptr[4] = data;
-        ptr[5] = data;
-        ptr[6] = data;
-        ptr[7] = data;
+        wptr[0] = word;
+        wptr[1] = word;
+        wptr[2] = word;
+        wptr[3] = word;
+        wptr[4] = word;
+        wptr[5] = word;
+        wptr[6] = word;
+        wptr[7] = word;
+
+        count -= 32;
+        wptr  += 8;
+    }
 
-        count -= 8;
-        ptr += 8;
+    while (count >= 4)
+    {
+        *wptr = word;
+        wptr++;
+        count -= 4;
     }
 
+    ptr = (uint8_t *)wptr;
     while (count--)
     {
         *ptr = data;
@@ -505,8 +1325,12 @@ CyU3PMemSet (
 
 /* Function     : CyU3PMemCopy
  * Description  : memcpy equivalent function to copy one memory block to another.
- *                This function assumes that the memory block may not be DWORD
- *                aligned; and performs a byte-by-byte copy.
+ *                The memory blocks may not be DWORD aligned. If the source and destination
+ *                have the same alignment, the unaligned bytes at the ends of the block
+ *                are copied one at a time and the rest of the block is copied a word at a
+ *                time with 32 bytes per loop iteration. Otherwise a byte-by-byte copy is
+ *                performed.
+ *                The copy is done in the direction which allows the blocks to overlap.
  *                No checks are performed on the parameters because even a NULL-pointer
  *                is valid on the FX3 device.
  * Parameters   :
@@ -521,12 +1345,61 @@ CyU3PMemCopy (
         uint8_t  *src,
         uint32_t  count)
 {
+    CyU3PMemWord_t *wdest, *wsrc;
+    CyBool_t        isAligned = ((((uint32_t)dest ^ (uint32_t)src) & 3) == 0);
+
     if (dest > src)
     {
         /* Destination buffer is above source buffer. Copy from end of the buffer back to the start. */
         dest += count;
         src  += count;
 
+        if (isAligned)
+        {
+            /* Copy bytes until the end pointers are DWORD aligned. */
+            while ((count > 0) && (((uint32_t)dest & 3) != 0))
+            {
+                dest--;
+                src--;
+                count--;
+
+                *dest = *src;
+            }
+
+            wdest = (CyU3PMemWord_t *)dest;
+            wsrc  = (CyU3PMemWord_t *)src;
+
+            /* Loop unrolling for faster operation. This allows the compiler to use multiple register
+               loads and stores. */
+            while (count >= 32)
+            {
+                wdest -= 8;
+                wsrc  -= 8;
+                count -= 32;
+
+                wdest[7] = wsrc[7];
+                wdest[6] = wsrc[6];
+                wdest[5] = wsrc[5];
+                wdest[4] = wsrc[4];
+                wdest[3] = wsrc[3];
+                wdest[2] = wsrc[2];
+                wdest[1] = wsrc[1];
+                wdest[0] = wsrc[0];
+            }
+
+            while (count >= 4)
+            {
+                wdest--;
+                wsrc--;
+                count -= 4;
+
+                *wdest = *wsrc;
+            }
+
+            dest = (uint8_t *)wdest;
+            src  = (uint8_t *)wsrc;
+        }
+
         /* Loop unrolling for faster operation */
         while (count >= 8)
         {
@@ -557,6 +1430,52 @@ CyU3PMemCopy (
     {
         /* Destination buffer is below source buffer. Copy from start to end of the buffer. */
 
+        if (isAligned)
+        {
+            /* Copy bytes until the pointers are DWORD aligned. */
+            while ((count > 0) && (((uint32_t)dest & 3) != 0))
+            {
+                *dest = *src;
+
+                dest++;
+                src++;
+                count--;
+            }
+
+            wdest = (CyU3PMemWord_t *)dest;
+            wsrc  = (CyU3PMemWord_t *)src;
+
+            /* Loop unrolling for faster operation. This allows the compiler to use multiple register
+               loads and stores. */
+            while (count >= 32)
+            {
+                wdest[0] = wsrc[0];
+                wdest[1] = wsrc[1];
+                wdest[2] = wsrc[2];
+                wdest[3] = wsrc[3];
+                wdest[4] = wsrc[4];
+                wdest[5] = wsrc[5];
+                wdest[6] = wsrc[6];
+                wdest[7] = wsrc[7];
+
+                wdest += 8;
+                wsrc  += 8;
+                count -= 32;
+            }
+
+            while (count >= 4)
+            {
+                *wdest = *wsrc;
+
+                wdest++;
+                wsrc++;
+                count -= 4;
+            }
+
+            dest = (uint8_t *)wdest;
+            src  = (uint8_t *)wsrc;
+        }
+
         /* Loop unrolling for faster operation */
         while (count >= 8)
         {
@@ -587,8 +1506,9 @@ CyU3PMemCopy (
 
 /* Function     : CyU3PMemCmp
  * Description  : Compare the contents of two memory blocks.
- *                This function assumes that the memory block may not be DWORD
- *                aligned; and performs a byte-by-byte comparison.
+ *                The memory blocks may not be DWORD aligned. If both blocks have the same
+ *                alignment, matching data is skipped a word at a time; and the bytes of
+ *                the first differing word are then compared individually.
  * Parameters   :
  *                s1  : Pointer to the first memory block.
  *                s2  : Pointer to the second memory block.
@@ -604,6 +1524,30 @@ CyU3PMemCmp (
 {
     const uint8_t *ptr1 = (const uint8_t *)s1, *ptr2 = (const uint8_t *)s2;
 
+    if ((((uint32_t)ptr1 ^ (uint32_t)ptr2) & 3) == 0)
+    {
+        /* Compare bytes until the pointers are DWORD aligned. */
+        while ((n != 0) && (((uint32_t)ptr1 & 3) != 0))
+        {
+            if (*ptr1 != *ptr2)
+            {
+                return *ptr1 - *ptr2;
+            }
+
+            ptr1++;
+            ptr2++;
+            n--;
+        }
+
+        /* Skip over identical words. Any difference is located by the byte loop below. */
+        while ((n >= 4) && (*(const CyU3PMemWord_t *)ptr1 == *(const CyU3PMemWord_t *)ptr2))
+        {
+            ptr1 += 4;
+            ptr2 += 4;
+            n    -= 4;
+        }
+    }
+
     while (n--)
     {
         if (*ptr1 != *ptr2)
@@ -652,6 +1596,24 @@ CyU3PBufEnableChecks (
 
 #endif
 
+/* Function    : CyU3PDmaBufMgrAddUsage
+ * Description : Helper function for the DMA buffer manager. Adds to the number of bytes
+ *               allocated from the buffer heap, or takes away for a negative value, and
+ *               updates the peak. The slab blocks are allocated and freed without the buffer
+ *               manager lock, so the counters are updated with interrupts locked out.
+ */
+static void
+CyU3PDmaBufMgrAddUsage (
+        int32_t bytes)
+{
+    uint32_t intMask = CyU3PMemIrqLock ();
+
+    glBufCurBytes += (uint32_t)bytes;
+    if (glBufCurBytes > glBufPeakBytes)
+        glBufPeakBytes = glBufCurBytes;
+    CyU3PMemIrqUnlock (intMask);
+}
+
 /* Function    : CyU3PDmaBufferInit
  * Description : This function initializes the custom heap used for DMA buffer allocation.
  *               These functions use a home-grown allocator in order to ensure that all
@@ -709,6 +1671,11 @@ CyU3PDmaBufferInit (
     glBufferManager.regionSize = CY_U3P_BUFFER_HEAP_SIZE;
     glBufferManager.statusSize = size;
     glBufferManager.searchPos  = 0;
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+    /* Carve the slabs out of the empty heap. */
+    CyU3PDmaBufSlabInit ();
+#endif
 }
 
 /* Function    : CyU3PDmaBufferDeInit
@@ -745,11 +1712,29 @@ CyU3PDmaBufferDeInit (
     glBufferManager.regionSize = 0;
     glBufferManager.statusSize = 0;
 
+    /* Any frees that are still pending are dropped along with the status array. */
+    glBufDeferredList = 0;
+
+    glBufCurBytes  = 0;
+    glBufPeakBytes = 0;
+    glBufFailCnt   = 0;
+
+    /* The arena space is dropped along with the rest of the buffer heap. */
+    glMemArenaPtr    = 0;
+    glMemArenaLimit  = 0;
+    glMemArenaSealed = CyFalse;
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+    /* Drop the slabs along with the status array. */
+    CyU3PMemSet ((uint8_t *)glBufSlab, 0, sizeof (glBufSlab));
+#endif
+
 #ifdef CYFXTX_ERRORDETECTION
     /* Clear status tracking variables. */
-    glBufAllocCnt  = 0;
-    glBufFreeCnt   = 0;
-    glBufInUseList = 0;
+    glBufAllocCnt    = 0;
+    glBufFreeCnt     = 0;
+    glBufInUseList   = 0;
+    glBufScrubCursor = 0;
 #endif
 
     /* Free up and destroy the mutex variable. */
@@ -806,181 +1791,475 @@ CyU3PDmaBufMgrSetStatus (
     }
 }
 
-/* Function     : CyU3PDmaBufferAlloc
- * Description  : This function allocates memory required for DMA buffers required by the
- *                firmware application. This function is used by the SDK internal drivers
- *                in addition to the application code itself.
- *                If memory leak and corruption checking is enabled, the implementation
- *                adds a 20 byte header and a 4 byte footer around each memory block.
- * Parameters   :
- *                size : Size of memory required in bytes.
- * Return Value : Pointer to the allocated memory block.
+/* Function    : CyU3PDmaBufMgrCtz
+ * Description : Helper function for the DMA buffer manager. Returns the number of
+ *               trailing zero bits in a non-zero word. The ARM926EJ-S only has a
+ *               count leading zeros instruction, so the lowest set bit is isolated
+ *               first and its position is derived using CLZ.
  */
-void *
-CyU3PDmaBufferAlloc (
-        uint16_t size)
+static inline uint32_t
+CyU3PDmaBufMgrCtz (
+        uint32_t value)
 {
-#ifdef CYFXTX_ERRORDETECTION
-    MemBlockInfo *block_p;
-#endif
+    return (31 - __builtin_clz (value & (0 - value)));
+}
 
-    uint32_t tmp;
-    uint32_t wordnum, bitnum;
-    uint32_t count, start = 0;
-    uint32_t blk_size = (uint32_t)size;
-    void *ptr = 0;
+/* Function    : CyU3PDmaBufMgrHasRun
+ * Description : Helper function for the DMA buffer manager. Checks whether a word has a
+ *               run of at least numBits consecutive one bits. Each step ANDs the word with
+ *               a shifted copy of itself, which shortens every run of ones by the shift
+ *               count; so only log2 (numBits) steps are needed.
+ */
+static inline CyBool_t
+CyU3PDmaBufMgrHasRun (
+        uint32_t value,
+        uint32_t numBits)
+{
+    uint32_t shift;
 
-    /* Get the lock for the buffer manager. */
-    if (CyU3PThreadIdentify ())
+    if (numBits > 32)
     {
-        tmp = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
-    }
-    else
-    {
-        tmp = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+        return CyFalse;
     }
 
-    if (tmp != CY_U3P_SUCCESS)
+    while ((numBits > 1) && (value != 0))
     {
-        return ptr;
+        shift    = (numBits >> 1);
+        value   &= (value >> shift);
+        numBits -= shift;
     }
 
-    /* Make sure the buffer manager has been initialized. */
-    if ((glBufferManager.startAddr == 0) || (glBufferManager.regionSize == 0))
-    {
-        CyU3PMutexPut (&glBufferManager.lock);
-        return ptr;
-    }
+    return (value != 0);
+}
 
-#ifdef CYFXTX_ERRORDETECTION
-    if (glBufMgrEnableChecks)
+/* Function    : CyU3PDmaBufMgrFindFree
+ * Description : Helper function for the DMA buffer manager. Searches the status array
+ *               for the first run of numBits zero bits, starting at word searchPos.
+ *               A run cannot wrap from the end of the array back to the start.
+ *               The array is processed a word at a time. The free run at the bottom of
+ *               each word extends the run carried over from the previous word, and the
+ *               free run at the top starts the run carried into the next word. The runs
+ *               in between are only measured one at a time using CLZ if the word holds a
+ *               run that is long enough, so that fully occupied and finely fragmented
+ *               words are both skipped in constant time.
+ * Return Value: Bit position of the last zero in the run, or 0xFFFFFFFF if no run of
+ *               the required length is found. The position of the first zero in the
+ *               run is returned through runStart_p.
+ */
+static uint32_t
+CyU3PDmaBufMgrFindFree (
+        uint32_t  numBits,
+        uint32_t *runStart_p)
+{
+    uint32_t wordnum = glBufferManager.searchPos;
+    uint32_t count   = 0;
+    uint32_t tmp, word, pos, run;
+
+    for (tmp = 0; tmp < glBufferManager.statusSize; tmp++)
     {
-        /* Using a 32-bit variable here to allow for addition of header on top of a maximum sized allocation. */
-        blk_size  = ROUND_UP (blk_size, 4);
-        blk_size += sizeof (MemBlockInfo) + sizeof (uint32_t);
-    }
-#endif
+        word = glBufferManager.usedStatus[wordnum];
 
-    /* Find the number of cache lines required. The minimum size that can be handled is 2 cache lines. */
-    size = (blk_size <= FX3_CACHE_LINE_SZ) ? 2 : ((blk_size + FX3_CACHE_LINE_SZ - 1) / FX3_CACHE_LINE_SZ);
+        /* Length of the run of free cache lines at the bottom of the word. */
+        run = (word == 0) ? 32 : CyU3PDmaBufMgrCtz (word);
+        if (run != 0)
+        {
+            if (count == 0)
+            {
+                *runStart_p = (wordnum << 5);
+            }
+
+            if ((count + run) >= numBits)
+            {
+                return ((wordnum << 5) + (numBits - count) - 1);
+            }
 
-    /* Search through the status array to find the first block that fits the need. */
-    wordnum = glBufferManager.searchPos;
-    bitnum  = 0;
-    count   = 0;
-    tmp     = 0;
+            count += run;
+        }
 
-    /* Stop searching once we have checked all of the words. */
-    while (tmp < glBufferManager.statusSize)
-    {
-        if ((glBufferManager.usedStatus[wordnum] & (1 << bitnum)) == 0)
+        if (run != 32)
         {
-            if (count == 0)
+            pos = run;
+            if (CyU3PDmaBufMgrHasRun (~word >> pos, numBits))
             {
-                start = (wordnum << 5) + bitnum + 1;
+                /* The first run in the rest of the word that is long enough is the one to be used. As
+                   there is such a run, the loop always returns before reaching the top of the word. */
+                while (pos < 32)
+                {
+                    /* Skip over the run of occupied cache lines starting at pos. */
+                    pos += CyU3PDmaBufMgrCtz (~(word >> pos));
+
+                    /* Length of the run of free cache lines starting at pos. */
+                    run = ((word >> pos) == 0) ? (32 - pos) : CyU3PDmaBufMgrCtz (word >> pos);
+                    if (run >= numBits)
+                    {
+                        *runStart_p = (wordnum << 5) + pos;
+                        return ((wordnum << 5) + pos + numBits - 1);
+                    }
+
+                    pos += run;
+                }
             }
-            count++;
-            if (count == (uint16_t)(size + 1))
+
+            /* The run of free cache lines at the top of the word is carried into the next word. */
+            count = __builtin_clz (word);
+            if (count != 0)
             {
-                /* The last bit corresponding to the allocated memory is left as zero.
-                   This allows us to identify the end of the allocated block while freeing
-                   the memory. We need to search for one additional zero while allocating
-                   to account for this hack. */
-                glBufferManager.searchPos = wordnum;
-                break;
+                *runStart_p = (wordnum << 5) + 32 - count;
             }
         }
-        else
+
+        wordnum++;
+        if (wordnum == glBufferManager.statusSize)
         {
-            count = 0;
+            /* Wrap back to the top of the array. */
+            wordnum = 0;
+            count   = 0;
         }
+    }
+
+    return 0xFFFFFFFFU;
+}
+
+/* Function    : CyU3PDmaBufMgrUsedCount
+ * Description : Helper function for the DMA buffer manager. Returns the number of
+ *               consecutive one bits in the status array starting at startPos.
+ *               This is the number of status bits set by the allocation of the
+ *               block starting at that position.
+ */
+static uint32_t
+CyU3PDmaBufMgrUsedCount (
+        uint32_t startPos)
+{
+    uint32_t wordnum = (startPos >> 5);
+    uint32_t bitnum  = (startPos & 31);
+    uint32_t count   = 0;
+    uint32_t word, run;
 
-        bitnum++;
-        if (bitnum == 32)
+    while (wordnum < glBufferManager.statusSize)
+    {
+        /* Invert the bits so that the run of ones becomes a run of trailing zeros. Bits shifted
+           in at the top become ones, which terminates the run at the end of the word. */
+        word = ~(glBufferManager.usedStatus[wordnum] >> bitnum);
+        if (word == 0)
+        {
+            count += 32;
+        }
+        else
         {
-            bitnum = 0;
-            wordnum++;
-            tmp++;
-            if (wordnum == glBufferManager.statusSize)
+            run    = CyU3PDmaBufMgrCtz (word);
+            count += run;
+            if (run < (32 - bitnum))
             {
-                /* Wrap back to the top of the array. */
-                wordnum = 0;
-                count   = 0;
+                break;
             }
         }
+
+        wordnum++;
+        bitnum = 0;
     }
 
-    if (count == (uint16_t)(size + 1))
-    {
-        /* Mark the memory region identified as occupied and return the pointer. */
-        CyU3PDmaBufMgrSetStatus (start, size - 1, CyTrue);
-        ptr = (void *)(glBufferManager.startAddr + (start << 5));
+    return count;
+}
 
-#ifdef CYFXTX_ERRORDETECTION
-        if (glBufMgrEnableChecks)
+/* Function    : CyU3PDmaBufMgrFreeSpace
+ * Description : Helper function for the DMA buffer manager. Returns the number of cache
+ *               lines in the largest block that can be allocated, and the total number of
+ *               free cache lines through freeLines_p. The first zero in each run of zero
+ *               bits may be the end marker of the preceding block, and is not counted.
+ *               Blocks held in the DMA buffer cache are counted as occupied.
+ */
+static uint32_t
+CyU3PDmaBufMgrFreeSpace (
+        uint32_t *freeLines_p)
+{
+    uint32_t count = 0, total = 0, largest = 0;
+    uint32_t wordnum, word, pos, run;
+
+    for (wordnum = 0; wordnum <= glBufferManager.statusSize; wordnum++)
+    {
+        /* A fully occupied word is used after the end of the array to terminate the last run. */
+        word = (wordnum < glBufferManager.statusSize) ? glBufferManager.usedStatus[wordnum] : 0xFFFFFFFFU;
+        pos  = 0;
+        while (pos < 32)
         {
-            /* Store the header information used for leak and corruption checks. */
-            block_p = (MemBlockInfo *)ptr;
-            block_p->alloc_id        = glBufAllocCnt++;
-            block_p->alloc_size      = blk_size;
-            block_p->prev_blk        = glBufInUseList;
-            block_p->next_blk        = 0;
-            block_p->start_sig       = CY_U3P_MEM_START_SIG;
-            if (glBufInUseList != 0)
-                glBufInUseList->next_blk = block_p;
-            glBufInUseList           = block_p;
+            run    = ((word >> pos) == 0) ? (32 - pos) : CyU3PDmaBufMgrCtz (word >> pos);
+            count += run;
+            pos   += run;
+            if (pos == 32)
+            {
+                break;
+            }
 
-            /* Add the end block signature as a footer. */
-            ((uint32_t *)block_p)[BYTE_TO_DWORD (blk_size) - 1] = CY_U3P_MEM_END_SIG;
+            /* A run of free cache lines ends at pos. */
+            if (count > 1)
+            {
+                total += count - 1;
+                if ((count - 1) > largest)
+                    largest = count - 1;
+            }
 
-            /* Update the return pointer to skip the header created. */
-            ptr = (void *)((uint8_t *)block_p + sizeof (MemBlockInfo));
+            /* Skip over the run of occupied cache lines starting at pos, or move on to the next
+               word if the rest of this one is occupied. */
+            count = 0;
+            if ((word >> pos) == (0xFFFFFFFFU >> pos))
+            {
+                break;
+            }
+            pos += CyU3PDmaBufMgrCtz (~(word >> pos));
         }
-#endif
     }
 
-    CyU3PMutexPut (&glBufferManager.lock);
-    return (ptr);
+    *freeLines_p = total;
+    return largest;
 }
 
-/* Function     : CyU3PDmaBufferFree
- * Description  : This function frees memory previously allocated using CyU3PDmaBufferAlloc.
- * Parameters   :
- *                buffer : Pointer to memory block to be freed.
- * Return Value : 0 if free is successful, non-zero error code in case of mutex failure.
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+
+/* Function    : CyU3PDmaBufSlabInit
+ * Description : Helper function for the DMA buffer slabs. Carves CY_U3P_BUF_SLAB_DEPTH or
+ *               CY_U3P_BUF_SLAB_BURST_DEPTH blocks for each size class out of the buffer
+ *               heap as a single occupied region, and puts all of them on the free list of
+ *               the class. A class for which the heap has no room is left without a slab.
+ *               Called from CyU3PDmaBufferInit before any threads are running.
  */
-int
-CyU3PDmaBufferFree (
-        void *buffer)
+static void
+CyU3PDmaBufSlabInit (
+        void)
 {
+    uint32_t cls, size, lines, start = 0, i;
+
+    CyU3PMemSet ((uint8_t *)glBufSlab, 0, sizeof (glBufSlab));
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        /* Compute the number of cache lines used by the blocks of each size class. */
+        size = glBufSlabClassSize[cls];
 #ifdef CYFXTX_ERRORDETECTION
-    MemBlockInfo *block_p;
-    uint32_t     *sig_p;
+        if (glBufMgrEnableChecks)
+            size += sizeof (MemBlockInfo) + sizeof (uint32_t);
 #endif
+        glBufSlab[cls].numLines = (size + FX3_CACHE_LINE_SZ - 1) / FX3_CACHE_LINE_SZ;
 
-    uint32_t status, start, count;
-    uint32_t wordnum, bitnum;
-    int      retVal = -1;
+        lines = glBufSlab[cls].numLines * glBufSlabClassDepth[cls];
+        if ((lines == 0) || (CyU3PDmaBufMgrFindFree (lines + 1, &start) == 0xFFFFFFFFU))
+        {
+            continue;
+        }
 
-    /* Validity check for the pointer. */
-    if ((uint32_t)buffer < CY_U3P_BUFFER_HEAP_BASE)
-        return retVal;
+        /* The region is marked like a single allocated block. */
+        start++;
+        CyU3PDmaBufMgrSetStatus (start, lines - 1, CyTrue);
+        glBufSlab[cls].regionStart = glBufferManager.startAddr + (start << 5);
+        glBufSlab[cls].regionEnd   = glBufSlab[cls].regionStart + (lines << 5);
+        glBufSlab[cls].carved      = glBufSlabClassDepth[cls];
+        glBufSlab[cls].count       = glBufSlabClassDepth[cls];
 
-    /* Get the lock for the buffer manager. */
-    if (CyU3PThreadIdentify ())
-    {
-        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+        for (i = glBufSlabClassDepth[cls]; i != 0; i--)
+        {
+            start = glBufSlab[cls].regionStart + ((i - 1) * glBufSlab[cls].numLines << 5);
+            *((uint32_t *)start)    = glBufSlab[cls].freeList;
+            glBufSlab[cls].freeList = start;
+        }
+    }
+}
+
+/* Function    : CyU3PDmaBufSlabGetClass
+ * Description : Helper function for the DMA buffer slabs. Returns the size class
+ *               for blocks spanning numLines cache lines, or CY_U3P_BUF_SLAB_NUM_CLASSES
+ *               if the block size has no slab.
+ */
+static uint32_t
+CyU3PDmaBufSlabGetClass (
+        uint32_t numLines)
+{
+    uint32_t cls;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        if (glBufSlab[cls].numLines == numLines)
+        {
+            break;
+        }
+    }
+
+    return cls;
+}
+
+/* Function    : CyU3PDmaBufSlabPop
+ * Description : Helper function for the DMA buffer slabs. Takes a free block from the
+ *               slab of the given class with interrupts locked out, and counts a hit;
+ *               or counts a miss if the slab is empty. Does not need the buffer manager
+ *               lock, and can be called from any context.
+ * Return Value: Start address of the block, or 0 if the slab is empty or the class is
+ *               not cached.
+ */
+static void *
+CyU3PDmaBufSlabPop (
+        uint32_t cls)
+{
+    uint32_t block = 0, intMask;
+
+    if (cls >= CY_U3P_BUF_SLAB_NUM_CLASSES)
+    {
+        return 0;
+    }
+
+    intMask = CyU3PMemIrqLock ();
+    block   = glBufSlab[cls].freeList;
+    if (block != 0)
+    {
+        glBufSlab[cls].freeList = *((uint32_t *)block);
+        glBufSlab[cls].count--;
+        glBufSlab[cls].inUse++;
+        glBufSlab[cls].hits++;
+        glBufCurBytes += (glBufSlab[cls].numLines << 5);
+        if (glBufCurBytes > glBufPeakBytes)
+            glBufPeakBytes = glBufCurBytes;
     }
     else
     {
-        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+        glBufSlab[cls].misses++;
     }
+    CyU3PMemIrqUnlock (intMask);
 
-    if (status != CY_U3P_SUCCESS)
+    return (void *)block;
+}
+
+/* Function    : CyU3PDmaBufSlabPush
+ * Description : Helper function for the DMA buffer slabs. Returns a block to the slab
+ *               whose region holds it, with interrupts locked out. Does not need the
+ *               buffer manager lock, and can be called from any context.
+ * Return Value: 0 if the block was returned to a slab, -1 if it is not in a slab region.
+ */
+static int
+CyU3PDmaBufSlabPush (
+        uint32_t block)
+{
+    uint32_t cls, intMask;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
     {
-        return retVal;
+        if ((block >= glBufSlab[cls].regionStart) && (block < glBufSlab[cls].regionEnd))
+        {
+            intMask = CyU3PMemIrqLock ();
+            *((uint32_t *)block)    = glBufSlab[cls].freeList;
+            glBufSlab[cls].freeList = block;
+            glBufSlab[cls].count++;
+            glBufSlab[cls].inUse--;
+            glBufCurBytes -= (glBufSlab[cls].numLines << 5);
+            CyU3PMemIrqUnlock (intMask);
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/* Function    : CyU3PDmaBufSlabRelease
+ * Description : Helper function for the DMA buffer slabs. Returns the region of every
+ *               slab whose blocks are all free to the buffer heap. The slab is emptied
+ *               with interrupts locked out, so that no block can be taken from it while
+ *               its region is released. Should be called with the buffer manager lock held.
+ * Return Value: Number of regions released.
+ */
+static uint32_t
+CyU3PDmaBufSlabRelease (
+        void)
+{
+    uint32_t cls, start, lines, intMask, released = 0;
+
+    for (cls = 0; cls < CY_U3P_BUF_SLAB_NUM_CLASSES; cls++)
+    {
+        start   = 0;
+        intMask = CyU3PMemIrqLock ();
+        if ((glBufSlab[cls].carved != 0) && (glBufSlab[cls].count == glBufSlab[cls].carved))
+        {
+            start = glBufSlab[cls].regionStart;
+            lines = (glBufSlab[cls].regionEnd - start) >> 5;
+            glBufSlab[cls].regionStart = 0;
+            glBufSlab[cls].regionEnd   = 0;
+            glBufSlab[cls].freeList    = 0;
+            glBufSlab[cls].count       = 0;
+            glBufSlab[cls].carved      = 0;
+        }
+        CyU3PMemIrqUnlock (intMask);
+
+        if (start != 0)
+        {
+            CyU3PDmaBufMgrSetStatus ((start - glBufferManager.startAddr) >> 5, lines - 1, CyFalse);
+            released++;
+        }
+    }
+
+    if (released != 0)
+    {
+        glBufferManager.searchPos = 0;
     }
 
+    return released;
+}
+
+#endif
+
+/* Function    : CyU3PDmaBufAtomicSwap
+ * Description : Helper function for the DMA buffer manager. Atomically stores value
+ *               at the given address and returns the previous content. The ARM926EJ-S
+ *               does not support LDREX/STREX, and the SWP instruction is used instead.
+ */
+static inline uint32_t
+CyU3PDmaBufAtomicSwap (
+        volatile uint32_t *addr_p,
+        uint32_t           value)
+{
+    uint32_t prev;
+
+#if defined (__arm__)
+    __asm__ __volatile__ ("swp %0, %2, [%1]" : "=&r" (prev) : "r" (addr_p), "r" (value) : "memory");
+#else
+    /* Host builds of the heap tests run the interrupt side in a signal handler. */
+    prev = __atomic_exchange_n (addr_p, value, __ATOMIC_SEQ_CST);
+#endif
+    return prev;
+}
+
+/* Function    : CyU3PDmaBufMgrDefer
+ * Description : Helper function for the DMA buffer manager. Adds a buffer to the
+ *               deferred free list without taking the lock. Only called from interrupt
+ *               context. The link is written after the buffer has been made the list
+ *               head. This is safe because the list is only drained from thread context,
+ *               which cannot run until the interrupt handler has returned.
+ */
+static void
+CyU3PDmaBufMgrDefer (
+        void *buffer)
+{
+    uint32_t next;
+
+    next = CyU3PDmaBufAtomicSwap (&glBufDeferredList, (uint32_t)buffer);
+    *((volatile uint32_t *)buffer) = next;
+    glBufDeferredCnt++;
+}
+
+/* Function    : CyU3PDmaBufMgrRelease
+ * Description : Helper function for the DMA buffer manager. Returns a buffer to the
+ *               buffer heap. Should be called with the buffer manager lock held.
+ * Return Value: 0 if the buffer was freed, -1 if the address is not in the buffer heap.
+ */
+static int
+CyU3PDmaBufMgrRelease (
+        void *buffer)
+{
+#ifdef CYFXTX_ERRORDETECTION
+    MemBlockInfo *block_p;
+    uint32_t     *sig_p;
+#endif
+
+    uint32_t start, count;
+    int      retVal = -1;
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+    uint32_t cls, intMask;
+#endif
+
 #ifdef CYFXTX_ERRORDETECTION
     /* Update the structures used for leak checking. */
     if (glBufMgrEnableChecks)
@@ -1006,45 +2285,615 @@ CyU3PDmaBufferFree (
             glBufInUseList = block_p->prev_blk;
         }
 
+        /* Move the scrubber on if it was due to check this block. */
+        if (glBufScrubCursor == block_p)
+        {
+            glBufScrubCursor = block_p->prev_blk;
+        }
+
         buffer = (void *)block_p;
     }
 #endif
 
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+    /* Blocks carved for a slab go back to it. */
+    if (CyU3PDmaBufSlabPush ((uint32_t)buffer) == 0)
+    {
+        return 0;
+    }
+#endif
+
     /* If the buffer address is within the range specified, count the number of consecutive ones and
        clear them. */
     start = (uint32_t)buffer;
     if ((start > glBufferManager.startAddr) && (start < (glBufferManager.startAddr + glBufferManager.regionSize)))
     {
         start = ((start - glBufferManager.startAddr) >> 5);
+        count = CyU3PDmaBufMgrUsedCount (start);
+        retVal = 0;
 
-        wordnum = (start >> 5);
-        bitnum  = (start & 0x1F);
-        count   = 0;
+        /* The block spans one more cache line than the number of status bits set. */
+        CyU3PDmaBufMgrAddUsage (-(int32_t)((count + 1) * FX3_CACHE_LINE_SZ));
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+        /* A block of a slab size that was allocated from the heap when its slab was empty. */
+        cls = CyU3PDmaBufSlabGetClass (count + 1);
+        if (cls < CY_U3P_BUF_SLAB_NUM_CLASSES)
+        {
+            intMask = CyU3PMemIrqLock ();
+            glBufSlab[cls].inUse--;
+            CyU3PMemIrqUnlock (intMask);
+        }
+#endif
+
+        if (count != 0)
+        {
+            CyU3PDmaBufMgrSetStatus (start, count, CyFalse);
+
+            /* Start the next buffer search at the top of the heap. This can help reduce fragmentation in cases where
+               most of the heap is allocated and then freed as a whole. */
+            glBufferManager.searchPos = 0;
+        }
+    }
+
+    return retVal;
+}
+
+/* Function    : CyU3PDmaBufMgrDrain
+ * Description : Helper function for the DMA buffer manager. Completes all frees that
+ *               were deferred from interrupt context. Should be called from thread
+ *               context with the buffer manager lock held.
+ */
+static void
+CyU3PDmaBufMgrDrain (
+        void)
+{
+    uint32_t buffer, next;
+
+    if (glBufDeferredList == 0)
+    {
+        return;
+    }
+
+    /* Detach the whole list at once; new entries can be added while it is processed. */
+    buffer = CyU3PDmaBufAtomicSwap (&glBufDeferredList, 0);
+    while (buffer != 0)
+    {
+        next = *((uint32_t *)buffer);
+        CyU3PDmaBufMgrRelease ((void *)buffer);
+        glBufDrainedCnt++;
+        buffer = next;
+    }
+}
 
-        while ((wordnum < glBufferManager.statusSize) && ((glBufferManager.usedStatus[wordnum] & (1 << bitnum)) != 0))
+/* Function     : CyU3PDmaBufferAlloc
+ * Description  : This function allocates memory required for DMA buffers required by the
+ *                firmware application. This function is used by the SDK internal drivers
+ *                in addition to the application code itself.
+ *                If memory leak and corruption checking is enabled, the implementation
+ *                adds a 20 byte header and a 4 byte footer around each memory block.
+ * Parameters   :
+ *                size : Size of memory required in bytes.
+ * Return Value : Pointer to the allocated memory block.
+ */
+void *
+CyU3PDmaBufferAlloc (
+        uint16_t size)
+{
+#ifdef CYFXTX_ERRORDETECTION
+    MemBlockInfo *block_p;
+#endif
+
+    uint32_t tmp;
+    uint32_t start = 0;
+    uint32_t blk_size = (uint32_t)size;
+    void *ptr = 0;
+    CyBool_t isThread;
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+    uint32_t cls;
+#endif
+
+#ifdef CYFXTX_ERRORDETECTION
+    if (glBufMgrEnableChecks)
+    {
+        /* Using a 32-bit variable here to allow for addition of header on top of a maximum sized allocation. */
+        blk_size  = ROUND_UP (blk_size, 4);
+        blk_size += sizeof (MemBlockInfo) + sizeof (uint32_t);
+    }
+#endif
+
+    /* Find the number of cache lines required. The minimum size that can be handled is 2 cache lines. */
+    size = (blk_size <= FX3_CACHE_LINE_SZ) ? 2 : ((blk_size + FX3_CACHE_LINE_SZ - 1) / FX3_CACHE_LINE_SZ);
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+    /* Take a block from the slab of its size class without the buffer manager lock. With the leak
+       checks enabled, the block also has to be linked into the in-use list under the lock. */
+    cls = CyU3PDmaBufSlabGetClass (size);
+#ifdef CYFXTX_ERRORDETECTION
+    if (!glBufMgrEnableChecks)
+#endif
+    {
+        ptr = CyU3PDmaBufSlabPop (cls);
+        if (ptr != 0)
         {
-            count++;
-            bitnum++;
-            if (bitnum == 32)
+            return ptr;
+        }
+    }
+#endif
+
+    /* Get the lock for the buffer manager. */
+    isThread = (CyU3PThreadIdentify () != 0);
+    if (isThread)
+    {
+        tmp = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+    else
+    {
+        tmp = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+    }
+
+    if (tmp != CY_U3P_SUCCESS)
+    {
+        return ptr;
+    }
+
+    /* Make sure the buffer manager has been initialized. */
+    if ((glBufferManager.startAddr == 0) || (glBufferManager.regionSize == 0))
+    {
+        CyU3PMutexPut (&glBufferManager.lock);
+        return ptr;
+    }
+
+    /* Complete any frees that were deferred from interrupt context. */
+    if (isThread)
+    {
+        CyU3PDmaBufMgrDrain ();
+    }
+
+#if (defined (CYFXTX_BUF_SLAB_ENABLE) && defined (CYFXTX_ERRORDETECTION))
+    if (glBufMgrEnableChecks)
+    {
+        ptr = CyU3PDmaBufSlabPop (cls);
+    }
+#endif
+
+    if (ptr == 0)
+    {
+        /* Search through the status array to find the first block that fits the need.
+           The last bit corresponding to the allocated memory is left as zero. This allows us
+           to identify the end of the allocated block while freeing the memory. We need to
+           search for one additional zero while allocating to account for this hack. The
+           first zero in the run separates this block from the previous one. */
+        tmp = CyU3PDmaBufMgrFindFree ((uint32_t)size + 1, &start);
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+        /* If the heap is too fragmented, return the regions of the unused slabs and try again. */
+        if ((tmp == 0xFFFFFFFFU) && (CyU3PDmaBufSlabRelease () != 0))
+        {
+            tmp = CyU3PDmaBufMgrFindFree ((uint32_t)size + 1, &start);
+        }
+#endif
+
+        if (tmp != 0xFFFFFFFFU)
+        {
+            glBufferManager.searchPos = (tmp >> 5);
+            start++;
+
+            /* Mark the memory region identified as occupied. */
+            CyU3PDmaBufMgrSetStatus (start, size - 1, CyTrue);
+            ptr = (void *)(glBufferManager.startAddr + (start << 5));
+            CyU3PDmaBufMgrAddUsage ((int32_t)size * FX3_CACHE_LINE_SZ);
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+            if (cls < CY_U3P_BUF_SLAB_NUM_CLASSES)
             {
-                bitnum = 0;
-                wordnum++;
+                tmp = CyU3PMemIrqLock ();
+                glBufSlab[cls].inUse++;
+                CyU3PMemIrqUnlock (tmp);
             }
+#endif
         }
+    }
+
+    if (ptr != 0)
+    {
+#ifdef CYFXTX_ERRORDETECTION
+        if (glBufMgrEnableChecks)
+        {
+            /* Store the header information used for leak and corruption checks. */
+            block_p = (MemBlockInfo *)ptr;
+            block_p->alloc_id        = glBufAllocCnt++;
+            block_p->alloc_size      = blk_size;
+            block_p->prev_blk        = glBufInUseList;
+            block_p->next_blk        = 0;
+            block_p->start_sig       = CY_U3P_MEM_START_SIG;
 
-        CyU3PDmaBufMgrSetStatus (start, count, CyFalse);
+            /* Add the end block signature as a footer, before the block is linked into the in-use list. */
+            ((uint32_t *)block_p)[BYTE_TO_DWORD (blk_size) - 1] = CY_U3P_MEM_END_SIG;
 
-        /* Start the next buffer search at the top of the heap. This can help reduce fragmentation in cases where
-           most of the heap is allocated and then freed as a whole. */
-        glBufferManager.searchPos = 0;
-        retVal = 0;
+            if (glBufInUseList != 0)
+                glBufInUseList->next_blk = block_p;
+            glBufInUseList           = block_p;
+
+            /* Update the return pointer to skip the header created. */
+            ptr = (void *)((uint8_t *)block_p + sizeof (MemBlockInfo));
+        }
+#endif
+    }
+    else
+    {
+        glBufFailCnt++;
+    }
+
+    CyU3PMutexPut (&glBufferManager.lock);
+    return (ptr);
+}
+
+/* Function     : CyU3PDmaBufferFree
+ * Description  : This function frees memory previously allocated using CyU3PDmaBufferAlloc.
+ *                If the buffer manager lock cannot be obtained when called from interrupt
+ *                or callback context, the buffer is queued on a deferred free list which
+ *                does not require the lock; and the free is completed by the next alloc or
+ *                free call made from thread context. Blocks carved for the DMA buffer slabs
+ *                are returned to their slab without the lock, unless the leak checks are
+ *                enabled.
+ * Parameters   :
+ *                buffer : Pointer to memory block to be freed.
+ * Return Value : 0 if free is successful or has been deferred, non-zero error code in case of
+ *                mutex failure in thread context or an invalid pointer.
+ */
+int
+CyU3PDmaBufferFree (
+        void *buffer)
+{
+    uint32_t status;
+    int      retVal = -1;
+    CyBool_t isThread;
+
+    /* Validity check for the pointer. */
+    if (((uint32_t)buffer < CY_U3P_BUFFER_HEAP_BASE) || ((uint32_t)buffer >= CY_U3P_SYS_MEM_TOP))
+        return retVal;
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+#ifdef CYFXTX_ERRORDETECTION
+    if (!glBufMgrEnableChecks)
+#endif
+    {
+        if (CyU3PDmaBufSlabPush ((uint32_t)buffer) == 0)
+        {
+            return 0;
+        }
     }
+#endif
+
+    /* Get the lock for the buffer manager. */
+    isThread = (CyU3PThreadIdentify () != 0);
+    if (isThread)
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+    else
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+    }
+
+    if (status != CY_U3P_SUCCESS)
+    {
+        /* Interrupt and callback context cannot wait for the lock. Queue the buffer to be
+           freed later instead of losing it. */
+        if (!isThread)
+        {
+            CyU3PDmaBufMgrDefer (buffer);
+            retVal = 0;
+        }
+
+        return retVal;
+    }
+
+    if (isThread)
+    {
+        CyU3PDmaBufMgrDrain ();
+    }
+
+    retVal = CyU3PDmaBufMgrRelease (buffer);
 
     /* Free the lock before we go. */
     CyU3PMutexPut (&glBufferManager.lock);
     return retVal;
 }
 
+/* Function     : CyU3PBufGetDeferredCounts
+ * Description  : Get the number of DMA buffer frees that had to be deferred because the
+ *                buffer manager lock was not available, and the number of these that have
+ *                since been completed.
+ * Parameters   :
+ *                deferredCnt_p : Parameter to be filled with the number of deferred frees.
+ *                drainedCnt_p  : Parameter to be filled with the number of completed deferred frees.
+ * Return Value : None
+ */
+void
+CyU3PBufGetDeferredCounts (
+        uint32_t *deferredCnt_p,
+        uint32_t *drainedCnt_p)
+{
+    if (deferredCnt_p != 0)
+        *deferredCnt_p = glBufDeferredCnt;
+    if (drainedCnt_p != 0)
+        *drainedCnt_p = glBufDrainedCnt;
+}
+
+/* Function     : CyU3PBufGetStats
+ * Description  : Get the usage statistics for the buffer heap. The current and peak usage
+ *                are updated on every alloc and free call, while the free space is
+ *                measured from the status array when this function is called.
+ *                Free blocks held in the DMA buffer slabs are not counted as allocated,
+ *                but do not count as free space either.
+ * Parameters   :
+ *                stats_p : Structure to be filled with the statistics.
+ * Return Value : CY_U3P_SUCCESS if the statistics were returned.
+ *                CY_U3P_ERROR_BAD_ARGUMENT if the pointer is invalid.
+ *                CY_U3P_ERROR_NOT_STARTED if the buffer heap has not been initialized.
+ *                CY_U3P_ERROR_TIMEOUT if the buffer manager lock could not be obtained.
+ */
+CyU3PReturnStatus_t
+CyU3PBufGetStats (
+        CyU3PHeapStats_t *stats_p)
+{
+    CyU3PReturnStatus_t status;
+    uint32_t largest, freeLines;
+
+    if (stats_p == 0)
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    if (CyU3PThreadIdentify ())
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+    else
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+    }
+
+    if (status != CY_U3P_SUCCESS)
+    {
+        return CY_U3P_ERROR_TIMEOUT;
+    }
+
+    if ((glBufferManager.startAddr == 0) || (glBufferManager.regionSize == 0))
+    {
+        CyU3PMutexPut (&glBufferManager.lock);
+        return CY_U3P_ERROR_NOT_STARTED;
+    }
+
+    largest = CyU3PDmaBufMgrFreeSpace (&freeLines);
+
+    stats_p->heapSize     = glBufferManager.regionSize;
+    stats_p->curBytes     = glBufCurBytes;
+    stats_p->peakBytes    = glBufPeakBytes;
+    stats_p->freeBytes    = freeLines * FX3_CACHE_LINE_SZ;
+    stats_p->largestFree  = largest * FX3_CACHE_LINE_SZ;
+    stats_p->fragPermille = CyU3PHeapFragIndex (stats_p->largestFree, stats_p->freeBytes);
+    stats_p->failCnt      = glBufFailCnt;
+
+    CyU3PMutexPut (&glBufferManager.lock);
+    return CY_U3P_SUCCESS;
+}
+
+/* Function    : CyU3PDmaBufMgrArenaResize
+ * Description : Helper function for the boot time arena. Moves the start of the buffer heap
+ *               space held by the arena to newLimit, by marking the cache lines between the
+ *               old and new limits as occupied (when growing) or free (when shrinking). The
+ *               arena can only grow into cache lines that are free.
+ * Return Value: CyTrue if the arena space was updated, CyFalse otherwise.
+ */
+static CyBool_t
+CyU3PDmaBufMgrArenaResize (
+        uint32_t newLimit)
+{
+    uint32_t status, start, end, pos;
+    CyBool_t retVal = CyTrue;
+
+    if (CyU3PThreadIdentify ())
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+    else
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+    }
+
+    if (status != CY_U3P_SUCCESS)
+    {
+        return CyFalse;
+    }
+
+    if (newLimit < glMemArenaLimit)
+    {
+        start = ((newLimit - glBufferManager.startAddr) >> 5);
+        end   = ((glMemArenaLimit - glBufferManager.startAddr) >> 5);
+
+        /* The lines are free if their status bits are clear, and the line just below them is
+           not the end of an allocated block. The last line of a block also has a clear bit, so
+           the bit below the range needs to be clear as well. */
+        for (pos = ((start != 0) ? (start - 1) : 0); pos < end; pos++)
+        {
+            if ((glBufferManager.usedStatus[pos >> 5] & (1U << (pos & 31))) != 0)
+            {
+                retVal = CyFalse;
+                break;
+            }
+        }
+
+        if (retVal)
+        {
+            CyU3PDmaBufMgrSetStatus (start, end - start, CyTrue);
+            CyU3PDmaBufMgrAddUsage ((int32_t)(glMemArenaLimit - newLimit));
+            glMemArenaLimit = newLimit;
+        }
+    }
+    else if (newLimit > glMemArenaLimit)
+    {
+        start = ((glMemArenaLimit - glBufferManager.startAddr) >> 5);
+        end   = ((newLimit - glBufferManager.startAddr) >> 5);
+
+        CyU3PDmaBufMgrSetStatus (start, end - start, CyFalse);
+        CyU3PDmaBufMgrAddUsage (-(int32_t)(newLimit - glMemArenaLimit));
+        glMemArenaLimit = newLimit;
+        glBufferManager.searchPos = 0;
+    }
+
+    CyU3PMutexPut (&glBufferManager.lock);
+    return retVal;
+}
+
+/* Function     : CyU3PMemArenaAlloc
+ * Description  : Allocate memory that will never be freed, such as thread stacks, from the
+ *                boot time arena. The arena is meant for use from CyFxApplicationDefine and
+ *                the application initialization code, and is not protected against concurrent
+ *                calls. Allocations only take the buffer heap lock when the arena needs to
+ *                grow; the blocks have no header and are 32 byte (cache line) aligned.
+ *                The blocks must not be passed to CyU3PMemFree or CyU3PDmaBufferFree.
+ * Parameters   :
+ *                size : Size of memory required in bytes.
+ * Return Value : Pointer to the allocated memory block, or NULL if the arena has been sealed
+ *                or the buffer heap does not have enough free space at the top.
+ */
+void *
+CyU3PMemArenaAlloc (
+        uint32_t size)
+{
+    uint32_t ptr, limit;
+
+    if ((glMemArenaSealed) || (glBufferManager.startAddr == 0) || (glBufferManager.regionSize == 0))
+    {
+        return NULL;
+    }
+
+    if (glMemArenaPtr == 0)
+    {
+        glMemArenaPtr   = glBufferManager.startAddr + glBufferManager.regionSize;
+        glMemArenaLimit = glMemArenaPtr;
+    }
+
+    if (size > (glMemArenaPtr - glBufferManager.startAddr))
+    {
+        return NULL;
+    }
+
+    ptr = (glMemArenaPtr - size) & ~(FX3_CACHE_LINE_SZ - 1);
+    if (ptr < glMemArenaLimit)
+    {
+        /* Take space from the buffer heap a chunk at a time, or just what is needed if a full
+           chunk is not available. */
+        limit = ptr & ~(CY_U3P_MEM_ARENA_CHUNK - 1);
+        if ((limit < glBufferManager.startAddr) || (!CyU3PDmaBufMgrArenaResize (limit)))
+        {
+            if (!CyU3PDmaBufMgrArenaResize (ptr))
+            {
+                return NULL;
+            }
+        }
+    }
+
+    glMemArenaPtr = ptr;
+    return (void *)ptr;
+}
+
+/* Function     : CyU3PMemArenaSeal
+ * Description  : Seal the boot time arena once the application has been initialized. Any
+ *                further CyU3PMemArenaAlloc calls will fail, and the unused part of the last
+ *                chunk taken by the arena is returned to the buffer heap.
+ * Parameters   : None
+ * Return Value : Final size of the arena in bytes.
+ */
+uint32_t
+CyU3PMemArenaSeal (
+        void)
+{
+    if (glMemArenaPtr == 0)
+    {
+        glMemArenaSealed = CyTrue;
+        return 0;
+    }
+
+    if (!glMemArenaSealed)
+    {
+        glMemArenaSealed = CyTrue;
+        CyU3PDmaBufMgrArenaResize (glMemArenaPtr);
+    }
+
+    return (glBufferManager.startAddr + glBufferManager.regionSize - glMemArenaLimit);
+}
+
+#ifdef CYFXTX_BUF_SLAB_ENABLE
+
+/* Function     : CyU3PBufSlabFlush
+ * Description  : Return the region of every DMA buffer slab that has all of its blocks free
+ *                to the buffer heap. The blocks of these sizes are then allocated from the
+ *                heap. This is done automatically when an allocation fails, and can be called
+ *                by the application before allocating blocks of uncommon sizes.
+ * Parameters   : None
+ * Return Value : None
+ */
+void
+CyU3PBufSlabFlush (
+        void)
+{
+    uint32_t status;
+
+    if (CyU3PThreadIdentify ())
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+    else
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+    }
+
+    if (status == CY_U3P_SUCCESS)
+    {
+        CyU3PDmaBufSlabRelease ();
+        CyU3PMutexPut (&glBufferManager.lock);
+    }
+}
+
+/* Function     : CyU3PBufGetSlabStats
+ * Description  : Get the occupancy counters for one size class of the DMA buffer slabs.
+ * Parameters   :
+ *                classIdx : Index of the size class to query.
+ *                stats_p  : Structure to be filled with the class information.
+ * Return Value : CY_U3P_SUCCESS if the counters were returned.
+ *                CY_U3P_ERROR_BAD_ARGUMENT if the class index or the pointer is invalid.
+ */
+CyU3PReturnStatus_t
+CyU3PBufGetSlabStats (
+        uint32_t             classIdx,
+        CyU3PBufSlabStats_t *stats_p)
+{
+    uint32_t intMask;
+
+    if ((classIdx >= CY_U3P_BUF_SLAB_NUM_CLASSES) || (stats_p == 0))
+    {
+        return CY_U3P_ERROR_BAD_ARGUMENT;
+    }
+
+    intMask = CyU3PMemIrqLock ();
+    stats_p->blkSize = glBufSlabClassSize[classIdx];
+    stats_p->carved  = glBufSlab[classIdx].carved;
+    stats_p->inUse   = glBufSlab[classIdx].inUse;
+    stats_p->cached  = glBufSlab[classIdx].count;
+    stats_p->hits    = glBufSlab[classIdx].hits;
+    stats_p->misses  = glBufSlab[classIdx].misses;
+    CyU3PMemIrqUnlock (intMask);
+
+    return CY_U3P_SUCCESS;
+}
+
+#endif
+
 /* Function    : CyU3PFreeHeaps
  * Description : This function de-initializes both driver and buffer heap allocators.
  *               This is called from the SDK library and is not expected to be called
@@ -1058,14 +2907,21 @@ CyU3PFreeHeaps (
     /* Free up the mem and buffer heaps. */
     CyU3PDmaBufferDeInit ();
 
+#ifndef CYFXTX_MEM_USE_TLSF
     CyU3PBytePoolDestroy (&glMemBytePool);
+#endif
     glMemPoolInit = CyFalse;
 
+    glMemCurBytes  = 0;
+    glMemPeakBytes = 0;
+    glMemFailCnt   = 0;
+
 #ifdef CYFXTX_ERRORDETECTION
     /* Clear status tracking variables. */
-    glMemAllocCnt  = 0;
-    glMemFreeCnt   = 0;
-    glMemInUseList = 0;
+    glMemAllocCnt    = 0;
+    glMemFreeCnt     = 0;
+    glMemInUseList   = 0;
+    glMemScrubCursor = 0;
 #endif
 }
 
@@ -1148,6 +3004,57 @@ CyU3PBufCorruptionCheck (
     return CY_U3P_SUCCESS;
 }
 
+/* Function     : CyU3PBufScrubStep
+ * Description  : Incremental version of CyU3PBufCorruptionCheck. Checks up to maxBlocks
+ *                in-use blocks of the buffer heap, resuming from where the previous call
+ *                stopped. The buffer manager lock is held while the blocks are checked.
+ * Parameters   :
+ *                maxBlocks : Maximum number of blocks to check in this call.
+ * Return Value : CY_U3P_SUCCESS or CY_U3P_ERROR_FAILURE depending on whether
+ *                corruption is found or not. CY_U3P_ERROR_TIMEOUT if the buffer
+ *                manager lock could not be obtained.
+ */
+CyU3PReturnStatus_t
+CyU3PBufScrubStep (
+        uint32_t maxBlocks)
+{
+    CyU3PReturnStatus_t status;
+
+    if (CyU3PThreadIdentify ())
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CY_U3P_BUFFER_ALLOC_TIMEOUT);
+    }
+    else
+    {
+        status = CyU3PMutexGet (&glBufferManager.lock, CYU3P_NO_WAIT);
+    }
+
+    if (status != CY_U3P_SUCCESS)
+    {
+        return CY_U3P_ERROR_TIMEOUT;
+    }
+
+    status = CyU3PHeapScrubSlice (&glBufScrubCursor, glBufInUseList, maxBlocks, CY_U3P_BUFFER_HEAP_BASE,
+            CY_U3P_SYS_MEM_TOP, glBufBadCb, &glBufScrubStats);
+    CyU3PMutexPut (&glBufferManager.lock);
+
+    return status;
+}
+
+/* Function     : CyU3PBufGetScrubStats
+ * Description  : Get the statistics for the incremental buffer heap checks.
+ * Parameters   :
+ *                stats_p : Structure to be filled with the statistics.
+ * Return Value : None
+ */
+void
+CyU3PBufGetScrubStats (
+        CyU3PHeapScrubStats_t *stats_p)
+{
+    if (stats_p != 0)
+        *stats_p = glBufScrubStats;
+}
+
 #endif
 
 /*[]*/
@@ -29,7 +29,6 @@
 #include "cyu3usbconst.h"
 #include "cyu3externcstart.h"
 
-#define CY_FX_BULKLP_DMA_BUF_COUNT      (8)                       /* Bulk loop channel buffer count */
 #define CY_FX_BULKLP_DMA_TX_SIZE        (0)                       /* DMA transfer size is set to infinite */
 #define CY_FX_BULKLP_THREAD_STACK       (0x1000)                  /* Bulk loop application thread stack size */
 #define CY_FX_BULKLP_THREAD_PRIORITY    (8)                       /* Bulk loop application thread priority */
@@ -51,6 +50,51 @@
 #define CY_FX_EP_PRODUCER_SOCKET        CY_U3P_UIB_SOCKET_PROD_1    /* Socket 1 is producer */
 #define CY_FX_EP_CONSUMER_SOCKET        CY_U3P_UIB_SOCKET_CONS_1    /* Socket 1 is consumer */
 
+/* Burst length, DMA buffer size multiplier and DMA buffer count for the loopback channel.
+ * Each DMA buffer holds (packet size * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER) bytes.
+ * The defaults can be overridden from the build, e.g. -DCY_FX_EP_BURST_LENGTH=8.
+ *
+ * The DMA AUTO channel only passes a buffer on to the IN endpoint when the buffer is full, or when a
+ * short packet or a zero length packet is received. A single full sized OUT packet, or any transfer that
+ * is a multiple of the packet size and smaller than the buffer, is therefore held until more data, a
+ * short packet or a ZLP arrives. Hosts that expect every packet to be echoed on its own should end each
+ * transfer with a short packet or a ZLP, or build with CY_FX_EP_BURST_LENGTH = 1 and
+ * CY_FX_DMA_SIZE_MULTIPLIER = 1, which gives one packet per buffer at the cost of throughput. */
+
+#ifdef CYMEM_256K
+
+/* Only 32 KB of DMA buffers are available on the CYUSB3011/CYUSB3012 parts. */
+#ifndef CY_FX_EP_BURST_LENGTH
+#define CY_FX_EP_BURST_LENGTH           (4)                       /* Burst length in packets, USB 3.0 only */
+#endif
+#ifndef CY_FX_DMA_SIZE_MULTIPLIER
+#define CY_FX_DMA_SIZE_MULTIPLIER       (1)                       /* Buffer size in bursts */
+#endif
+#ifndef CY_FX_BULKLP_DMA_BUF_COUNT
+#define CY_FX_BULKLP_DMA_BUF_COUNT      (2)                       /* Bulk loop channel buffer count */
+#endif
+
+#else
+
+#ifndef CY_FX_EP_BURST_LENGTH
+#define CY_FX_EP_BURST_LENGTH           (16)                      /* Burst length in packets, USB 3.0 only */
+#endif
+#ifndef CY_FX_DMA_SIZE_MULTIPLIER
+#define CY_FX_DMA_SIZE_MULTIPLIER       (2)                       /* Buffer size in bursts */
+#endif
+#ifndef CY_FX_BULKLP_DMA_BUF_COUNT
+#define CY_FX_BULKLP_DMA_BUF_COUNT      (4)                       /* Bulk loop channel buffer count */
+#endif
+
+#endif
+
+#if ((CY_FX_EP_BURST_LENGTH < 1) || (CY_FX_EP_BURST_LENGTH > 16))
+#error "CY_FX_EP_BURST_LENGTH must be between 1 and 16"
+#endif
+#if ((CY_FX_DMA_SIZE_MULTIPLIER < 1) || ((1024 * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER) > 0xFFFF))
+#error "The DMA buffer size (1024 * CY_FX_EP_BURST_LENGTH * CY_FX_DMA_SIZE_MULTIPLIER) must be less than 64 KB"
+#endif
+
 /* Extern definitions for the USB Descriptors */
 extern const uint8_t CyFxUSB20DeviceDscr[];
 extern const uint8_t CyFxUSB30DeviceDscr[];